@@ -0,0 +1,137 @@
+#include "ArrayTable.hpp"
+
+#include <sqlite3.h>
+
+namespace tsm {
+
+/***********************************************************************************/
+namespace {
+
+    constexpr int COLUMN_COUNT{ 3 };
+    // Hidden column the pointer argument is passed through.
+    constexpr int POINTER_COLUMN{ COLUMN_COUNT };
+
+    struct ArrayCursor {
+        sqlite3_vtab_cursor Base; // Must come first
+        const ArrayTableRows* Rows{ nullptr };
+        std::size_t Row{ 0 };
+    };
+
+    int arrayConnect(sqlite3* db, void*, int, const char* const*, sqlite3_vtab** vtab, char**) {
+        const auto res{ sqlite3_declare_vtab(db, "CREATE TABLE x(c0, c1, c2, ptr HIDDEN)") };
+        if (res != SQLITE_OK) {
+            return res;
+        }
+
+        *vtab = static_cast<sqlite3_vtab*>(sqlite3_malloc(sizeof(sqlite3_vtab)));
+        if (!*vtab) {
+            return SQLITE_NOMEM;
+        }
+        *(*vtab) = {};
+
+        return SQLITE_OK;
+    }
+
+    int arrayDisconnect(sqlite3_vtab* vtab) {
+        sqlite3_free(vtab);
+        return SQLITE_OK;
+    }
+
+    int arrayBestIndex(sqlite3_vtab*, sqlite3_index_info* info) {
+        for (auto i = 0; i < info->nConstraint; ++i) {
+            const auto& constraint{ info->aConstraint[i] };
+            if (constraint.iColumn == POINTER_COLUMN && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ) {
+                if (!constraint.usable) {
+                    return SQLITE_CONSTRAINT;
+                }
+                info->aConstraintUsage[i].argvIndex = 1;
+                info->aConstraintUsage[i].omit = 1;
+                info->estimatedCost = 1.0;
+                return SQLITE_OK;
+            }
+        }
+
+        // Without its argument there's nothing to scan.
+        info->estimatedCost = 1e99;
+        return SQLITE_CONSTRAINT;
+    }
+
+    int arrayOpen(sqlite3_vtab*, sqlite3_vtab_cursor** cursor) {
+        auto* c{ static_cast<ArrayCursor*>(sqlite3_malloc(sizeof(ArrayCursor))) };
+        if (!c) {
+            return SQLITE_NOMEM;
+        }
+        *c = {};
+        *cursor = &c->Base;
+
+        return SQLITE_OK;
+    }
+
+    int arrayClose(sqlite3_vtab_cursor* cursor) {
+        sqlite3_free(cursor);
+        return SQLITE_OK;
+    }
+
+    int arrayFilter(sqlite3_vtab_cursor* cursor, int, const char*, int argc, sqlite3_value** argv) {
+        auto* c{ reinterpret_cast<ArrayCursor*>(cursor) };
+        c->Rows = argc > 0 ? static_cast<const ArrayTableRows*>(sqlite3_value_pointer(argv[0], ARRAY_TABLE_POINTER_TYPE)) : nullptr;
+        c->Row = 0;
+
+        return SQLITE_OK;
+    }
+
+    int arrayNext(sqlite3_vtab_cursor* cursor) {
+        ++reinterpret_cast<ArrayCursor*>(cursor)->Row;
+        return SQLITE_OK;
+    }
+
+    int arrayEof(sqlite3_vtab_cursor* cursor) {
+        const auto* c{ reinterpret_cast<ArrayCursor*>(cursor) };
+        return !c->Rows || c->Row >= c->Rows->Rows;
+    }
+
+    int arrayColumn(sqlite3_vtab_cursor* cursor, sqlite3_context* ctx, int column) {
+        const auto* c{ reinterpret_cast<ArrayCursor*>(cursor) };
+        if (column < static_cast<int>(c->Rows->Columns) && column < COLUMN_COUNT) {
+            sqlite3_result_int64(ctx, c->Rows->Data[c->Row * c->Rows->Columns + column]);
+        }
+        else {
+            sqlite3_result_null(ctx);
+        }
+
+        return SQLITE_OK;
+    }
+
+    int arrayRowid(sqlite3_vtab_cursor* cursor, sqlite3_int64* rowid) {
+        *rowid = static_cast<sqlite3_int64>(reinterpret_cast<ArrayCursor*>(cursor)->Row);
+        return SQLITE_OK;
+    }
+
+    sqlite3_module makeArrayModule() {
+        sqlite3_module module{};
+        module.iVersion = 0;
+        module.xCreate = nullptr; // Eponymous-only: used as int64_array(?), never CREATE VIRTUAL TABLE.
+        module.xConnect = arrayConnect;
+        module.xBestIndex = arrayBestIndex;
+        module.xDisconnect = arrayDisconnect;
+        module.xDestroy = arrayDisconnect;
+        module.xOpen = arrayOpen;
+        module.xClose = arrayClose;
+        module.xFilter = arrayFilter;
+        module.xNext = arrayNext;
+        module.xEof = arrayEof;
+        module.xColumn = arrayColumn;
+        module.xRowid = arrayRowid;
+
+        return module;
+    }
+
+    const sqlite3_module ARRAY_MODULE{ makeArrayModule() };
+}
+
+/***********************************************************************************/
+bool registerArrayTable(sqlite3* db) {
+    return sqlite3_create_module(db, "int64_array", &ARRAY_MODULE, nullptr) == SQLITE_OK;
+}
+
+} // namespace tsm
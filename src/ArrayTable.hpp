@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Forward declarations
+struct sqlite3;
+
+namespace tsm {
+
+/// Pointer type tag used with sqlite3_bind_pointer() for ArrayTableRows.
+inline constexpr auto ARRAY_TABLE_POINTER_TYPE{ "tsm_int64_array" };
+
+/***********************************************************************************/
+/// Row-major block of integers exposed to SQL through the int64_array() table-valued
+/// function, so a whole batch goes through one statement instead of one per row:
+///
+///     INSERT INTO T(a, b) SELECT c0, c1 FROM int64_array(?);
+///
+/// with the ArrayTableRows bound to ? via sqlite3_bind_pointer(..., ARRAY_TABLE_POINTER_TYPE, nullptr).
+/// The rows must outlive the statement's execution.
+struct [[nodiscard]] ArrayTableRows {
+    const std::int64_t* Data{ nullptr };
+    std::size_t Rows{ 0 };
+    /// 1 to 3; columns past this read as NULL.
+    std::size_t Columns{ 1 };
+};
+
+/***********************************************************************************/
+/// Registers the int64_array table-valued function (columns c0, c1, c2) on the connection.
+[[nodiscard]] bool registerArrayTable(sqlite3* db);
+
+} // namespace tsm
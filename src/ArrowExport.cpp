@@ -0,0 +1,226 @@
+#include "ArrowExport.hpp"
+
+#include "Utils/ArrowWriter.hpp"
+#include "Utils/DeletedUniquePtr.hpp"
+#include "Utils/Trace.hpp"
+
+#include <sqlite3.h>
+
+#include <iostream>
+#include <optional>
+#include <vector>
+
+namespace tsm {
+
+/// Rows per record batch.
+constexpr std::size_t ARROW_BATCH_ROWS{ 1 << 20 };
+// How long to wait for an indexer holding the database to finish.
+constexpr int EXPORT_BUSY_TIMEOUT_MS{ 60 * 1000 };
+
+/***********************************************************************************/
+namespace {
+
+    using stmtPtr = utils::deleted_unique_ptr<sqlite3_stmt>;
+    using utils::ARROW_TYPE;
+
+    stmtPtr prepare(sqlite3* handle, const std::string& sqlStatement) {
+        sqlite3_stmt* stmt{ nullptr };
+        if (sqlite3_prepare_v2(handle, sqlStatement.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Error preparing SQL statement: " << sqlStatement << ".\n" << sqlite3_errmsg(handle) << std::endl;
+        }
+
+        return stmtPtr(stmt, [](auto* s) { sqlite3_finalize(s); });
+    }
+
+    /// The values of a dictionary-encoded column, and which of them each id is.
+    struct Dictionary {
+        utils::ArrowColumn Values{ ARROW_TYPE::UTF8 };
+        /// Indexed by id; -1 for ids that aren't in the table.
+        std::vector<std::int32_t> Index;
+    };
+
+    /// Reads "SELECT id, text ..." into a dictionary.
+    std::optional<Dictionary> readDictionary(sqlite3* handle, const std::string& query) {
+        auto stmt{ prepare(handle, query) };
+        if (!stmt) {
+            return std::nullopt;
+        }
+
+        Dictionary dictionary;
+        while (sqlite3_step(&(*stmt)) == SQLITE_ROW) {
+            const auto id{ sqlite3_column_int64(&(*stmt), 0) };
+            if (id < 0) {
+                continue;
+            }
+            const auto text{ reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), 1)) };
+            const auto length{ static_cast<std::size_t>(sqlite3_column_bytes(&(*stmt), 1)) };
+
+            if (static_cast<std::size_t>(id) >= dictionary.Index.size()) {
+                dictionary.Index.resize(static_cast<std::size_t>(id) + 1, -1);
+            }
+            dictionary.Index[static_cast<std::size_t>(id)] = static_cast<std::int32_t>(dictionary.Values.size());
+            dictionary.Values.append(std::string_view{ text ? text : "", length });
+        }
+
+        return dictionary;
+    }
+
+    /// Streams the rows of query into path, one column per field. Dictionary-encoded
+    /// fields take the next of dictionaries and read an id from their column.
+    bool exportQuery(sqlite3* handle, const fs::path& path, const std::vector<utils::ArrowField>& fields,
+                     const std::string& query, const std::vector<const Dictionary*>& dictionaries = {}) {
+        const utils::TraceSpan span{ "export", "arrow file", path };
+
+        auto stmt{ prepare(handle, query) };
+        if (!stmt) {
+            return false;
+        }
+
+        const fs::path tempPath{ path.parent_path() / ("." + path.filename().string() + ".tmp") };
+        const auto fail = [&tempPath]() {
+            std::error_code e;
+            fs::remove(tempPath, e);
+            return false;
+        };
+
+        utils::ArrowWriter writer{ tempPath, fields };
+        if (!writer.open()) {
+            return fail();
+        }
+
+        std::vector<const Dictionary*> fieldDictionaries(fields.size(), nullptr);
+        for (std::size_t i = 0, next = 0; i < fields.size(); ++i) {
+            if (fields[i].Dictionary) {
+                fieldDictionaries[i] = dictionaries.at(next);
+                if (!writer.writeDictionary(i, dictionaries.at(next)->Values)) {
+                    return fail();
+                }
+                ++next;
+            }
+        }
+
+        auto columns{ writer.makeColumns() };
+        std::size_t rows{ 0 };
+        int result;
+        while ((result = sqlite3_step(&(*stmt))) == SQLITE_ROW) {
+            for (std::size_t i = 0; i < fields.size(); ++i) {
+                const auto column{ static_cast<int>(i) };
+                if (sqlite3_column_type(&(*stmt), column) == SQLITE_NULL) {
+                    columns[i].appendNull();
+                    continue;
+                }
+
+                if (const auto* dictionary{ fieldDictionaries[i] }; dictionary) {
+                    const auto id{ sqlite3_column_int64(&(*stmt), column) };
+                    if (id < 0 || static_cast<std::size_t>(id) >= dictionary->Index.size() || dictionary->Index[static_cast<std::size_t>(id)] < 0) {
+                        columns[i].appendNull();
+                    }
+                    else {
+                        columns[i].appendIndex(dictionary->Index[static_cast<std::size_t>(id)]);
+                    }
+                    continue;
+                }
+
+                switch (fields[i].Type) {
+                    case ARROW_TYPE::INT64:
+                        columns[i].append(static_cast<std::int64_t>(sqlite3_column_int64(&(*stmt), column)));
+                        break;
+                    case ARROW_TYPE::FLOAT64:
+                        columns[i].append(sqlite3_column_double(&(*stmt), column));
+                        break;
+                    case ARROW_TYPE::UTF8:
+                        columns[i].append(std::string_view{ reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), column)),
+                                                            static_cast<std::size_t>(sqlite3_column_bytes(&(*stmt), column)) });
+                        break;
+                }
+            }
+
+            if (++rows % ARROW_BATCH_ROWS == 0) {
+                if (!writer.writeBatch(columns)) {
+                    return fail();
+                }
+                for (auto& c : columns) {
+                    c.clear();
+                }
+            }
+        }
+
+        if (result != SQLITE_DONE) {
+            std::cerr << "Error reading " << query << ": " << sqlite3_errmsg(handle) << std::endl;
+            return fail();
+        }
+        if (columns.front().size() > 0 && !writer.writeBatch(columns)) {
+            return fail();
+        }
+        if (!writer.close()) {
+            return fail();
+        }
+
+        std::error_code e;
+        fs::rename(tempPath, path, e);
+        if (e) {
+            std::cerr << "Failed to replace " << path << ": " << e.message() << std::endl;
+            return fail();
+        }
+
+        std::cout << "Wrote " << rows << " row(s) to " << path.string() << '.' << std::endl;
+
+        return true;
+    }
+}
+
+/***********************************************************************************/
+bool exportArrow(const fs::path& outputDir, const std::string& dataset) {
+    const auto databasePath{ outputDir / (dataset + ".sqlite3") };
+
+    sqlite3* handle{ nullptr };
+    if (sqlite3_open_v2(databasePath.c_str(), &handle, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to open " << databasePath << ": " << sqlite3_errmsg(handle) << std::endl;
+        sqlite3_close(handle);
+        return false;
+    }
+    const utils::deleted_unique_ptr<sqlite3> db(handle, [](auto* h) { sqlite3_close(h); });
+    sqlite3_busy_timeout(handle, EXPORT_BUSY_TIMEOUT_MS);
+
+    // One snapshot for all four files, even if an indexer commits meanwhile (WAL mode).
+    if (sqlite3_exec(handle, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to read " << databasePath << ": " << sqlite3_errmsg(handle) << std::endl;
+        return false;
+    }
+
+    const auto file = [&outputDir, &dataset](const std::string& table) {
+        return outputDir / (dataset + "_" + table + ".arrow");
+    };
+
+    auto exported{ exportQuery(handle, file("filepaths"),
+                               { { "id", ARROW_TYPE::INT64 }, { "filepath", ARROW_TYPE::UTF8 } },
+                               "SELECT id, filepath FROM Filepaths ORDER BY id;") &&
+                   exportQuery(handle, file("variables"),
+                               { { "id", ARROW_TYPE::INT64 }, { "variable", ARROW_TYPE::UTF8 },
+                                 { "units", ARROW_TYPE::UTF8, true }, { "longName", ARROW_TYPE::UTF8, true },
+                                 { "validMin", ARROW_TYPE::FLOAT64, true }, { "validMax", ARROW_TYPE::FLOAT64, true } },
+                               "SELECT id, variable, units, longName, validMin, validMax FROM Variables ORDER BY id;") &&
+                   exportQuery(handle, file("timestamps"),
+                               { { "id", ARROW_TYPE::INT64 }, { "timestamp", ARROW_TYPE::INT64 } },
+                               "SELECT id, timestamp FROM Timestamps ORDER BY id;") };
+
+    if (exported) {
+        const auto& variables{ readDictionary(handle, "SELECT id, variable FROM Variables ORDER BY id;") };
+        const auto& filepaths{ readDictionary(handle, "SELECT id, filepath FROM Filepaths ORDER BY id;") };
+
+        // In table order: sorting billions of rows would need as much temporary space again.
+        exported = variables && filepaths &&
+                   exportQuery(handle, file("index"),
+                               { { "timestamp", ARROW_TYPE::INT64, true }, { "variable", ARROW_TYPE::UTF8, true, true },
+                                 { "filepath", ARROW_TYPE::UTF8, true, true } },
+                               "SELECT t.timestamp, tvf.variable_id, tvf.filepath_id FROM TimestampVariableFilepath tvf "
+                               "LEFT JOIN Timestamps t ON t.id = tvf.timestamp_id;",
+                               { &(*variables), &(*filepaths) });
+    }
+
+    sqlite3_exec(handle, "END;", nullptr, nullptr, nullptr);
+
+    return exported;
+}
+
+} // namespace tsm
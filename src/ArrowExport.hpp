@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Filesystem.hpp"
+
+#include <string>
+
+namespace tsm {
+
+/***********************************************************************************/
+/// Writes the index of <outputDir>/<dataset>.sqlite3 as Arrow IPC files next to it
+/// (--export --format arrow), for analytics with pyarrow, polars or pandas:
+///
+///   <dataset>_filepaths.arrow    id, filepath
+///   <dataset>_variables.arrow    id, variable, units, longName, validMin, validMax
+///   <dataset>_timestamps.arrow   id, timestamp
+///   <dataset>_index.arrow        timestamp, variable, filepath   one row per join row;
+///                                variable and filepath are dictionary-encoded (categoricals)
+///
+/// All four come from one read transaction, in record batches of ARROW_BATCH_ROWS
+/// rows, so memory stays bounded by a batch and the two dictionaries. Each file is
+/// replaced atomically. False (and the error on stderr) if any of them fails.
+[[nodiscard]] bool exportArrow(const fs::path& outputDir, const std::string& dataset);
+
+} // namespace tsm
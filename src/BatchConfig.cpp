@@ -0,0 +1,334 @@
+#include "BatchConfig.hpp"
+
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace tsm::cli {
+
+/***********************************************************************************/
+namespace {
+
+    /// Just enough of a JSON reader for the batch config: one object of scalars
+    /// whose "datasets" member is an array of objects of scalars.
+    class JSONReader {
+
+    public:
+        explicit JSONReader(const std::string& text) : m_text{ text } {}
+
+        bool parse(std::vector<ConfigEntry>& datasets, ConfigEntry& defaults) {
+            if (!expect('{')) {
+                return false;
+            }
+
+            while (true) {
+                std::string key;
+                if (!readString(key) || !expect(':')) {
+                    return false;
+                }
+
+                if (key == "datasets") {
+                    if (!readDatasets(datasets)) {
+                        return false;
+                    }
+                }
+                else if (std::string value; readScalar(value)) {
+                    defaults[key] = value;
+                }
+                else {
+                    return false;
+                }
+
+                if (peek() == ',') {
+                    ++m_pos;
+                    continue;
+                }
+
+                return expect('}') && atEnd();
+            }
+        }
+
+    private:
+        bool readDatasets(std::vector<ConfigEntry>& datasets) {
+            if (!expect('[')) {
+                return false;
+            }
+            if (peek() == ']') {
+                ++m_pos;
+                return true;
+            }
+
+            while (true) {
+                ConfigEntry entry;
+                if (!readFlatObject(entry)) {
+                    return false;
+                }
+                datasets.emplace_back(std::move(entry));
+
+                if (peek() == ',') {
+                    ++m_pos;
+                    continue;
+                }
+
+                return expect(']');
+            }
+        }
+
+        bool readFlatObject(ConfigEntry& entry) {
+            if (!expect('{')) {
+                return false;
+            }
+            if (peek() == '}') {
+                ++m_pos;
+                return true;
+            }
+
+            while (true) {
+                std::string key;
+                std::string value;
+                if (!readString(key) || !expect(':') || !readScalar(value)) {
+                    return false;
+                }
+                entry[key] = value;
+
+                if (peek() == ',') {
+                    ++m_pos;
+                    continue;
+                }
+
+                return expect('}');
+            }
+        }
+
+        bool readScalar(std::string& value) {
+            if (peek() == '"') {
+                return readString(value);
+            }
+
+            // Numbers, true, false, null
+            const auto start{ m_pos };
+            while (m_pos < m_text.size() && (std::isalnum(static_cast<unsigned char>(m_text[m_pos])) || m_text[m_pos] == '.' || m_text[m_pos] == '-' || m_text[m_pos] == '+')) {
+                ++m_pos;
+            }
+            value = m_text.substr(start, m_pos - start);
+
+            return !value.empty();
+        }
+
+        bool readString(std::string& value) {
+            if (!expect('"')) {
+                return false;
+            }
+
+            value.clear();
+            while (m_pos < m_text.size()) {
+                const auto c{ m_text[m_pos++] };
+                if (c == '"') {
+                    return true;
+                }
+                if (c != '\\') {
+                    value += c;
+                    continue;
+                }
+                if (m_pos >= m_text.size()) {
+                    return false;
+                }
+                switch (const auto escaped{ m_text[m_pos++] }; escaped) {
+                    case 'n': value += '\n'; break;
+                    case 't': value += '\t'; break;
+                    case 'r': value += '\r'; break;
+                    case 'b': value += '\b'; break;
+                    case 'f': value += '\f'; break;
+                    case 'u': return false; // Not needed for paths and names.
+                    default: value += escaped; break;
+                }
+            }
+
+            return false;
+        }
+
+        char peek() {
+            skipWhitespace();
+            return m_pos < m_text.size() ? m_text[m_pos] : '\0';
+        }
+
+        bool expect(const char c) {
+            if (peek() != c) {
+                return false;
+            }
+            ++m_pos;
+            return true;
+        }
+
+        bool atEnd() {
+            return peek() == '\0';
+        }
+
+        void skipWhitespace() {
+            while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+                ++m_pos;
+            }
+        }
+
+        const std::string& m_text;
+        std::size_t m_pos{ 0 };
+    };
+
+    /// Strips comments, surrounding whitespace and quotes from a YAML scalar.
+    std::string cleanYAMLScalar(std::string value) {
+        if (const auto comment{ value.find(" #") }; comment != std::string::npos) {
+            value.erase(comment);
+        }
+
+        const auto first{ value.find_first_not_of(" \t") };
+        if (first == std::string::npos) {
+            return {};
+        }
+        const auto last{ value.find_last_not_of(" \t\r") };
+        value = value.substr(first, last - first + 1);
+
+        if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front()) {
+            value = value.substr(1, value.size() - 2);
+        }
+
+        return value;
+    }
+
+    /// Splits "key: value" and returns false if there's no separator.
+    bool splitYAMLPair(const std::string& line, std::string& key, std::string& value) {
+        const auto sep{ line.find(':') };
+        if (sep == std::string::npos) {
+            return false;
+        }
+
+        key = cleanYAMLScalar(line.substr(0, sep));
+        value = cleanYAMLScalar(line.substr(sep + 1));
+
+        return !key.empty();
+    }
+
+    std::string readFile(const fs::path& path) {
+        std::ifstream f(path);
+        std::stringstream ss;
+        ss << f.rdbuf();
+
+        return ss.str();
+    }
+}
+
+/***********************************************************************************/
+std::optional<std::vector<ConfigEntry>> parseJSONConfig(const std::string& text, ConfigEntry& defaults) {
+    std::vector<ConfigEntry> datasets;
+
+    JSONReader reader{ text };
+    if (!reader.parse(datasets, defaults)) {
+        return std::nullopt;
+    }
+
+    return datasets;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<ConfigEntry>> parseYAMLConfig(const std::string& text, ConfigEntry& defaults) {
+    std::vector<ConfigEntry> datasets;
+    std::istringstream stream(text);
+
+    auto inDatasets{ false };
+    std::string line;
+    while (std::getline(stream, line)) {
+        const auto indent{ line.find_first_not_of(' ') };
+        if (indent == std::string::npos || line[indent] == '#' || line.compare(indent, 3, "---") == 0) {
+            continue;
+        }
+
+        std::string key;
+        std::string value;
+
+        if (indent == 0) {
+            if (!splitYAMLPair(line, key, value)) {
+                return std::nullopt;
+            }
+            inDatasets = key == "datasets";
+            if (!inDatasets) {
+                defaults[key] = value;
+            }
+            continue;
+        }
+
+        if (!inDatasets) {
+            return std::nullopt;
+        }
+
+        // "- key: value" starts a new dataset, "  key: value" continues it.
+        auto content{ line.substr(indent) };
+        if (content.front() == '-') {
+            datasets.emplace_back();
+            content = content.substr(1);
+            if (cleanYAMLScalar(content).empty()) {
+                continue;
+            }
+        }
+
+        if (datasets.empty() || !splitYAMLPair(content, key, value)) {
+            return std::nullopt;
+        }
+        datasets.back()[key] = value;
+    }
+
+    return datasets;
+}
+
+/***********************************************************************************/
+std::optional<BatchConfig> readBatchConfig(const fs::path& configPath) {
+    const auto& text{ readFile(configPath) };
+    const auto& ext{ configPath.extension() };
+
+    ConfigEntry defaults;
+    std::optional<std::vector<ConfigEntry>> entries;
+    if (ext == ".json") {
+        entries = parseJSONConfig(text, defaults);
+    }
+    else if (ext == ".yaml" || ext == ".yml") {
+        entries = parseYAMLConfig(text, defaults);
+    }
+    else {
+        std::cerr << "Unsupported config file type " << ext << ". Use .json, .yaml or .yml." << std::endl;
+        return std::nullopt;
+    }
+
+    if (!entries) {
+        std::cerr << "Failed to parse " << configPath << '.' << std::endl;
+        return std::nullopt;
+    }
+
+    BatchConfig config;
+    try {
+        if (const auto jobs{ defaults.find("jobs") }; jobs != defaults.end()) {
+            config.Jobs = std::stoul(jobs->second);
+            defaults.erase(jobs);
+        }
+
+        for (auto& entry : *entries) {
+            // Dataset settings win over the top-level ones.
+            entry.insert(defaults.cbegin(), defaults.cend());
+
+            CLIOptions opts;
+            for (const auto& [option, value] : entry) {
+                if (!opts.set(option, value)) {
+                    std::cerr << "Unknown option \"" << option << "\" in " << configPath << '.' << std::endl;
+                    return std::nullopt;
+                }
+            }
+            config.Datasets.emplace_back(opts);
+        }
+    }
+    catch (const std::logic_error& e) {
+        std::cerr << "Invalid number in " << configPath << ": " << e.what() << std::endl;
+        return std::nullopt;
+    }
+
+    return config;
+}
+
+} // namespace tsm::cli
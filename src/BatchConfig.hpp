@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CLIOptions.hpp"
+#include "Filesystem.hpp"
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tsm::cli {
+
+/// Flat key/value settings of one dataset. Keys are the long command-line option names.
+using ConfigEntry = std::map<std::string, std::string>;
+
+/***********************************************************************************/
+/// Parsed --config file.
+///
+/// Both formats have the same shape: top-level settings apply to every dataset
+/// (plus "jobs"), and "datasets" is a list of per-dataset settings.
+///
+/// JSON:
+///     { "output-dir": "/db", "jobs": 8,
+///       "datasets": [ { "dataset-name": "giops_day", "input-dir": "/data/giops/day", "historical": true } ] }
+///
+/// YAML (block style only):
+///     output-dir: /db
+///     jobs: 8
+///     datasets:
+///       - dataset-name: giops_day
+///         input-dir: /data/giops/day
+///         historical: true
+struct [[nodiscard]] BatchConfig {
+    std::size_t Jobs{ 0 };
+    std::vector<CLIOptions> Datasets;
+};
+
+/***********************************************************************************/
+/// Parses a JSON document of the above shape. Returns std::nullopt on malformed input.
+[[nodiscard]] std::optional<std::vector<ConfigEntry>> parseJSONConfig(const std::string& text, ConfigEntry& defaults);
+
+/***********************************************************************************/
+/// Parses a YAML document of the above shape. Returns std::nullopt on malformed input.
+[[nodiscard]] std::optional<std::vector<ConfigEntry>> parseYAMLConfig(const std::string& text, ConfigEntry& defaults);
+
+/***********************************************************************************/
+/// Reads a .json, .yaml or .yml batch config. Errors are reported on stderr.
+[[nodiscard]] std::optional<BatchConfig> readBatchConfig(const fs::path& configPath);
+
+} // namespace tsm::cli
@@ -0,0 +1,226 @@
+#include "BatchMapper.hpp"
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace tsm {
+
+/***********************************************************************************/
+BatchMapper::BatchMapper(const cli::BatchConfig& config, const std::size_t jobs) :
+                                        m_jobs{ std::max<std::size_t>(1, jobs > 0 ? jobs : (config.Jobs > 0 ? config.Jobs : std::thread::hardware_concurrency())) } {
+    m_runs.reserve(config.Datasets.size());
+
+    for (const auto& datasetOpts : config.Datasets) {
+        DatasetRun run;
+        run.Options = datasetOpts;
+
+        if (!run.Options.verify()) {
+            std::cerr << "Skipping dataset \"" << run.Options.DatasetName << "\"." << std::endl;
+            run.Status = RUN_STATUS::INVALID;
+        }
+        else {
+            run.Mapper = std::make_unique<TimestampMapper>(run.Options);
+        }
+
+        m_runs.emplace_back(std::move(run));
+    }
+}
+
+/***********************************************************************************/
+bool BatchMapper::exec() {
+    const auto start{ std::chrono::steady_clock::now() };
+
+    std::cout << "Finding files for " << m_runs.size() << " dataset(s) using " << m_jobs << " job(s)..." << std::endl;
+    findAllFiles();
+
+    // Start the biggest datasets first so they don't end up as the long tail.
+    std::stable_sort(m_runs.begin(), m_runs.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.FilePaths.size() > rhs.FilePaths.size();
+    });
+
+    std::cout << "Indexing..." << std::endl;
+    runWorkers();
+
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start };
+    printSummary(elapsed.count());
+
+    return std::all_of(m_runs.cbegin(), m_runs.cend(), [](const auto& run) {
+        return run.Status == RUN_STATUS::SUCCEEDED;
+    });
+}
+
+/***********************************************************************************/
+void BatchMapper::findAllFiles() {
+    // Crawling is plain filesystem work, so threads are fine here.
+    // Their progress messages are dropped; errors still go to stderr.
+    std::atomic_size_t next{ 0 };
+    const auto worker = [&] {
+        // No buffer: writes only set badbit.
+        std::ostream quiet{ nullptr };
+        for (auto i{ next++ }; i < m_runs.size(); i = next++) {
+            auto& run{ m_runs[i] };
+            if (run.Status != RUN_STATUS::PENDING) {
+                continue;
+            }
+
+            if (auto filePaths{ run.Mapper->findFiles(quiet) }; filePaths) {
+                run.FilePaths = std::move(*filePaths);
+            }
+            else {
+                run.Status = RUN_STATUS::NO_FILES;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < std::min(m_jobs, m_runs.size()); ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+/***********************************************************************************/
+void BatchMapper::runWorkers() {
+    std::vector<std::chrono::steady_clock::time_point> startTimes(m_runs.size());
+    std::size_t running{ 0 };
+    std::size_t next{ 0 };
+
+    while (true) {
+        while (running < m_jobs && next < m_runs.size()) {
+            auto& run{ m_runs[next] };
+            if (run.Status != RUN_STATUS::PENDING) {
+                ++next;
+                continue;
+            }
+
+            std::cout.flush();
+            const auto pid{ fork() };
+            if (pid == 0) {
+                runDataset(run);
+            }
+            if (pid < 0) {
+                std::cerr << "Failed to start worker for \"" << run.Options.DatasetName << "\"." << std::endl;
+                run.Status = RUN_STATUS::FAILED;
+                ++next;
+                continue;
+            }
+
+            run.Pid = pid;
+            run.Status = RUN_STATUS::RUNNING;
+            startTimes[next] = std::chrono::steady_clock::now();
+            std::cout << "Started \"" << run.Options.DatasetName << "\" (" << run.FilePaths.size() << " file(s))." << std::endl;
+            ++running;
+            ++next;
+        }
+
+        if (running == 0) {
+            break;
+        }
+
+        int status{ 0 };
+        const auto pid{ waitpid(-1, &status, 0) };
+        if (pid < 0) {
+            break;
+        }
+
+        const auto it{ std::find_if(m_runs.begin(), m_runs.end(), [pid](const auto& run) { return run.Pid == pid; }) };
+        if (it == m_runs.end()) {
+            continue;
+        }
+
+        const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - startTimes[std::distance(m_runs.begin(), it)] };
+        it->Seconds = elapsed.count();
+        it->Status = (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS) ? RUN_STATUS::SUCCEEDED : RUN_STATUS::FAILED;
+        --running;
+
+        std::cout << "Finished \"" << it->Options.DatasetName << "\": " << statusName(it->Status) << '.' << std::endl;
+    }
+}
+
+/***********************************************************************************/
+void BatchMapper::runDataset(DatasetRun& run) {
+    const auto& logPath{ logFilePath(run.Options) };
+    if (const auto fd{ open(logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) }; fd >= 0) {
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+    }
+
+    const auto ok{ run.Mapper->indexFiles(std::move(run.FilePaths)) };
+
+    // Closes the database before leaving.
+    run.Mapper.reset();
+    std::cout.flush();
+    std::cerr.flush();
+
+    // Skip the parent's atexit handlers and static destructors.
+    _exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************************************/
+void BatchMapper::printSummary(const double totalSeconds) const {
+    std::size_t nameWidth{ 7 };
+    for (const auto& run : m_runs) {
+        nameWidth = std::max(nameWidth, run.Options.DatasetName.size());
+    }
+
+    std::cout << '\n' << std::left
+              << std::setw(nameWidth + 2) << "Dataset"
+              << std::setw(10) << "Files"
+              << std::setw(12) << "Status"
+              << std::setw(10) << "Time (s)"
+              << "Log" << '\n';
+
+    auto succeeded{ 0 };
+    auto datasetSeconds{ 0.0 };
+    for (const auto& run : m_runs) {
+        std::cout << std::setw(nameWidth + 2) << run.Options.DatasetName
+                  << std::setw(10) << run.FilePaths.size()
+                  << std::setw(12) << statusName(run.Status)
+                  << std::setw(10) << std::fixed << std::setprecision(1) << run.Seconds
+                  << (run.Pid > 0 ? logFilePath(run.Options).string() : "") << '\n';
+
+        succeeded += run.Status == RUN_STATUS::SUCCEEDED;
+        datasetSeconds += run.Seconds;
+    }
+
+    std::cout << '\n' << succeeded << " of " << m_runs.size() << " dataset(s) indexed in "
+              << totalSeconds << " s (" << datasetSeconds << " s of dataset time)." << std::endl;
+}
+
+/***********************************************************************************/
+fs::path BatchMapper::logFilePath(const cli::CLIOptions& opts) {
+    return fs::path(opts.OutputDir) / (opts.DatasetName + ".log");
+}
+
+/***********************************************************************************/
+std::string BatchMapper::statusName(const RUN_STATUS status) {
+    switch (status) {
+        case RUN_STATUS::PENDING:
+            return "pending";
+        case RUN_STATUS::RUNNING:
+            return "running";
+        case RUN_STATUS::SUCCEEDED:
+            return "ok";
+        case RUN_STATUS::FAILED:
+            return "failed";
+        case RUN_STATUS::INVALID:
+            return "invalid";
+        case RUN_STATUS::NO_FILES:
+            return "no files";
+    }
+
+    return "unknown";
+}
+
+} // namespace tsm
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "BatchConfig.hpp"
+#include "Filesystem.hpp"
+#include "TimestampMapper.hpp"
+
+#include <sys/types.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tsm {
+
+/// Indexes every dataset of a --config file in one run.
+///
+/// All datasets are crawled up front so the largest ones can be started first,
+/// then each dataset is read and written by its own worker process, with at
+/// most `jobs` of them running at once. Worker processes (rather than threads)
+/// are used because netCDF-C isn't thread-safe, and they keep one bad dataset
+/// from taking the others down. Each worker logs to <OutputDir>/<dataset>.log.
+class BatchMapper {
+
+public:
+    BatchMapper(const cli::BatchConfig& config, const std::size_t jobs);
+
+    /// Runs every dataset and prints a summary.
+    /// Returns true if all of them succeeded.
+    bool exec();
+
+private:
+    enum class RUN_STATUS {
+        PENDING = 0,
+        RUNNING,
+        SUCCEEDED,
+        FAILED,
+        INVALID,
+        NO_FILES
+    };
+
+    struct DatasetRun {
+        std::unique_ptr<TimestampMapper> Mapper;
+        cli::CLIOptions Options;
+        utils::PathStore FilePaths;
+        RUN_STATUS Status{ RUN_STATUS::PENDING };
+        pid_t Pid{ -1 };
+        double Seconds{ 0.0 };
+    };
+
+    ///
+    void findAllFiles();
+    ///
+    void runWorkers();
+    /// Runs in the forked worker process. Never returns.
+    [[noreturn]] void runDataset(DatasetRun& run);
+    ///
+    void printSummary(const double totalSeconds) const;
+    ///
+    [[nodiscard]] static fs::path logFilePath(const cli::CLIOptions& opts);
+    ///
+    [[nodiscard]] static std::string statusName(const RUN_STATUS status);
+
+    std::vector<DatasetRun> m_runs;
+    const std::size_t m_jobs;
+};
+
+} // namespace tsm
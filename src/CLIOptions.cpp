@@ -1,6 +1,8 @@
 #include "CLIOptions.hpp"
 
 #include "Filesystem.hpp"
+#include "Utils/FileOrder.hpp"
+#include "Utils/Logger.hpp"
 
 #include <iostream>
 #include <unordered_set>
@@ -25,6 +27,33 @@ namespace tsm::cli {
         ("r,regex", "Apply a regex pattern to the input directory to filter the scanned netcdf files.", cxxopts::value<std::string>())
         ("file-list", "File containing absolute paths to netcdf files to be indexed. The format is 1 path per line (no line-ending commas, etc). Supported file extensions are: .txt, .diff, .ll.", cxxopts::value<std::string>())
         ("keep-file-list", "Don't delete the given file list after indexing.")
+        ("wal", "Index in write-ahead-log mode with short write transactions so the database can be queried while indexing runs.")
+        ("transaction-size", "Maximum number of rows written per transaction when --wal is given (default 50000).", cxxopts::value<std::size_t>())
+        ("in-memory", "Build the database in memory, then atomically replace the output file with a compacted copy. Falls back to building on disk if the estimated size exceeds --memory-budget.")
+        ("memory-budget", "Largest estimated database size (in MB) that --in-memory will build in memory (default 4096).", cxxopts::value<std::size_t>())
+        ("config", "Batch mode: index every dataset listed in the given .json or .yaml file. Keys are the long option names of this tool. See BatchConfig.hpp for the format.", cxxopts::value<std::string>())
+        ("j,jobs", "Batch mode: maximum number of datasets indexed at once (default: number of cores).", cxxopts::value<std::size_t>())
+        ("no-progress", "Don't draw the progress bar.")
+        ("clustered-join-table", "Store the timestamp/variable/filepath join table clustered on (variable, timestamp, filepath) to speed up lookups and shrink the database. Existing databases are migrated.")
+        ("log-level", "Least severe messages to print: debug, info (default), warning or error. Files that can't be read are listed in <output-dir>/<dataset-name>_failed_files.lst, which can be given to --file-list to retry them.", cxxopts::value<std::string>())
+        ("read-timeout", "Give up on a file after this many seconds and quarantine it. Files are then read by --read-workers separate processes. 0 (default) reads them one at a time with no deadline.", cxxopts::value<std::size_t>())
+        ("read-workers", "Number of reader processes used with --read-timeout (default 4).", cxxopts::value<std::size_t>())
+        ("ignore-quarantine", "Also read files that timed out or kept failing in earlier runs, even if they haven't changed since.")
+        ("order", "Order to index files in: newest-first, oldest-first (by the date in the file name, or else the modification time) or path. Default: as found. With --wal, files are inserted in batches in this order, so newest-first makes recent data queryable first.", cxxopts::value<std::string>())
+        ("spatial-extent", "Also index the latitude/longitude bounding box of every file (FileExtents R*Tree table), so files can be looked up by region.")
+        ("coordinates", "Also index the values of every coordinate variable (depth, lat/lon, ...), stored once per distinct array, so clients can plan reads without opening files.")
+        ("serve", "Serve lookups of the --output-dir databases of --dataset-name (comma-separated for several) from memory over this UNIX domain socket, reloading each when its database changes. See LookupServer.hpp for the protocol.", cxxopts::value<std::string>())
+        ("no-crawl-cache", "List every directory of --input-dir. By default only directories whose modification time changed since the last run are listed; the others' contents come from <output-dir>/<dataset-name>_crawl_cache.tsv.")
+        ("adaptive-reads", "With --read-timeout, tune how many files are read at once between --min-read-workers and --read-workers from how long reads take (AIMD: one more while latency holds, a quarter fewer once it doubles or a read times out). Each change is logged at debug level.")
+        ("min-read-workers", "Fewest files read at once with --adaptive-reads (default 1).", cxxopts::value<std::size_t>())
+        ("catalog", "Also add the dataset to this shared catalog database once indexed, replacing what it held for the dataset. The catalog stores variables and dimensions once for all datasets and answers cross-dataset lookups. See Catalog.hpp for its tables.", cxxopts::value<std::string>())
+        ("export-from-catalog", "Write <output-dir>/<dataset-name>.sqlite3 from the --catalog instead of indexing, for clients that open per-dataset databases.")
+        ("trace", "Write a timeline of the run to this file in the Chrome trace event format (open it in chrome://tracing or https://ui.perfetto.dev): phases, directory listings, file reads (one row per reader process), SQLite transactions and index builds.", cxxopts::value<std::string>())
+        ("memory-profile", "Print the memory used by each phase of the run: peak and growth of the resident set size, and with a build made by 'make memprofile', the number and size of heap allocations and the peak heap held.")
+        ("export", "Write the index in <output-dir>/<dataset-name>.sqlite3 out in --format instead of indexing: <dataset-name>_filepaths, _variables, _timestamps and _index (one row per timestamp, variable and file) files next to it. See ArrowExport.hpp for their columns.")
+        ("format", "Format of --export. Only arrow (Arrow IPC files, for pyarrow, polars or pandas.read_feather) for now, and the default.", cxxopts::value<std::string>())
+        ("fingerprints", "Also record the device, inode, size, modification time and a hash of the first 4 KiB of every file indexed. On later runs with it, a file that was renamed or moved keeps its rows instead of being read again, and other paths to an indexed file (symlinks, hard links) are skipped. Every listed path is stat()ed for it.")
+        ("storage-layouts", "Also index the chunking, compression and fill value of every variable (Schemas, SchemaLayouts and FileSchemas tables), stored once per distinct file layout, so clients can plan reads without opening files.")
         ("dry-run", "Perform a dry-run of the tool; the list of scanned netcdf files will be output to the screen. No database changes will be made.")
         ("help", "Print help.")
         ;
@@ -61,11 +90,55 @@ std::string cleanRegexPattern(const std::string& inputPattern) {
 /***********************************************************************************/
 bool CLIOptions::verify() const {
 
+    // Each dataset in the config gets verified on its own.
+    if (!ConfigPath.empty()) {
+        if (!fs::exists(ConfigPath)) {
+            std::cerr << "Config file " << ConfigPath << " does not exist." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
     if (DatasetName.empty()) {
         std::cerr << "Dataset name is required. Use -n or --dataset-name to specify." << std::endl;
         return false;
     }
 
+    // Serving only reads existing databases.
+    if (!ServeSocket.empty()) {
+        if (OutputDir.empty() || !fs::is_directory(OutputDir)) {
+            std::cerr << "--serve needs the directory of the databases. Use -o or --output-dir to specify." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Exporting only reads the dataset database.
+    if (Export) {
+        if (ExportFormat != "arrow") {
+            std::cerr << "Unknown --format " << ExportFormat << ". Use arrow." << std::endl;
+            return false;
+        }
+        if (OutputDir.empty() || !fs::exists(fs::path(OutputDir) / (DatasetName + ".sqlite3"))) {
+            std::cerr << "--export needs the directory of an existing " << DatasetName << ".sqlite3. Use -o or --output-dir to specify." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Exporting only reads the catalog.
+    if (ExportFromCatalog) {
+        if (CatalogPath.empty() || !fs::exists(CatalogPath)) {
+            std::cerr << "--export-from-catalog needs an existing --catalog." << std::endl;
+            return false;
+        }
+        if (OutputDir.empty() || !fs::is_directory(OutputDir)) {
+            std::cerr << "--export-from-catalog needs the directory to write to. Use -o or --output-dir to specify." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
     if ( (InputDir.empty() || !fs::is_directory(InputDir)) && (FileListPath.empty() || !fs::exists(FileListPath)) ) {
         std::cerr << "Input directory and file list path were not given. One is required. Use --input-dir or --file-list to specify." << std::endl;
         return false;
@@ -81,6 +154,41 @@ bool CLIOptions::verify() const {
         return false;
     }
 
+    if (WAL && TransactionSize == 0) {
+        std::cerr << "--transaction-size must be greater than 0." << std::endl;
+        return false;
+    }
+
+    if (InMemory && WAL) {
+        std::cerr << "--in-memory and --wal can't be used together." << std::endl;
+        return false;
+    }
+
+    if (ReadTimeout > 0 && ReadWorkers == 0) {
+        std::cerr << "--read-workers must be greater than 0." << std::endl;
+        return false;
+    }
+
+    if (AdaptiveReads && ReadTimeout == 0) {
+        std::cerr << "--adaptive-reads needs --read-timeout." << std::endl;
+        return false;
+    }
+
+    if (AdaptiveReads && (MinReadWorkers == 0 || MinReadWorkers > ReadWorkers)) {
+        std::cerr << "--min-read-workers must be between 1 and --read-workers." << std::endl;
+        return false;
+    }
+
+    if (!utils::parseFileOrder(Order)) {
+        std::cerr << "Unknown order \"" << Order << "\". Use newest-first, oldest-first or path." << std::endl;
+        return false;
+    }
+
+    if (!utils::parseLogLevel(LogLevel)) {
+        std::cerr << "Unknown log level \"" << LogLevel << "\". Use debug, info, warning or error." << std::endl;
+        return false;
+    }
+
     const std::unordered_set<std::string> regexEngines{ "egrep", "basic", "extended", "grep", "awk", "ecmascript" };
     if (regexEngines.count(RegexEngine) == 0) {
         std::cerr << "The specified regex engine is not supported. Use --help flag to list what's available." << std::endl;
@@ -90,4 +198,123 @@ bool CLIOptions::verify() const {
     return true;
 }
 
+/***********************************************************************************/
+bool CLIOptions::set(const std::string& option, const std::string& value) {
+    const auto flag{ value.empty() || value == "true" };
+
+    if (option == "input-dir") {
+        InputDir = value.empty() ? value : sanitizeDirectoryPath(value);
+    }
+    else if (option == "dataset-name") {
+        DatasetName = value;
+    }
+    else if (option == "output-dir") {
+        OutputDir = value.empty() ? value : sanitizeDirectoryPath(value);
+    }
+    else if (option == "regex") {
+        RegexPattern = cleanRegexPattern(value);
+    }
+    else if (option == "file-list") {
+        FileListPath = value;
+    }
+    else if (option == "regex-engine") {
+        RegexEngine = value;
+    }
+    else if (option == "dry-run") {
+        DryRun = flag;
+    }
+    else if (option == "keep-file-list") {
+        KeepIndexFile = flag;
+    }
+    else if (option == "regen-indices") {
+        RegenIndices = flag;
+    }
+    else if (option == "forecast") {
+        Forecast = flag;
+    }
+    else if (option == "historical") {
+        Historical = flag;
+    }
+    else if (option == "wal") {
+        WAL = flag;
+    }
+    else if (option == "transaction-size") {
+        TransactionSize = std::stoul(value);
+    }
+    else if (option == "in-memory") {
+        InMemory = flag;
+    }
+    else if (option == "memory-budget") {
+        MemoryBudgetMB = std::stoul(value);
+    }
+    else if (option == "no-progress") {
+        NoProgress = flag;
+    }
+    else if (option == "clustered-join-table") {
+        ClusteredJoinTable = flag;
+    }
+    else if (option == "log-level") {
+        LogLevel = value;
+    }
+    else if (option == "read-timeout") {
+        ReadTimeout = std::stoul(value);
+    }
+    else if (option == "read-workers") {
+        ReadWorkers = std::stoul(value);
+    }
+    else if (option == "ignore-quarantine") {
+        IgnoreQuarantine = flag;
+    }
+    else if (option == "order") {
+        Order = value;
+    }
+    else if (option == "spatial-extent") {
+        SpatialExtent = flag;
+    }
+    else if (option == "coordinates") {
+        Coordinates = flag;
+    }
+    else if (option == "serve") {
+        ServeSocket = value;
+    }
+    else if (option == "no-crawl-cache") {
+        NoCrawlCache = flag;
+    }
+    else if (option == "adaptive-reads") {
+        AdaptiveReads = flag;
+    }
+    else if (option == "min-read-workers") {
+        MinReadWorkers = std::stoul(value);
+    }
+    else if (option == "catalog") {
+        CatalogPath = value;
+    }
+    else if (option == "export-from-catalog") {
+        ExportFromCatalog = flag;
+    }
+    else if (option == "trace") {
+        TracePath = value;
+    }
+    else if (option == "memory-profile") {
+        MemoryProfile = flag;
+    }
+    else if (option == "export") {
+        Export = flag;
+    }
+    else if (option == "format") {
+        ExportFormat = value;
+    }
+    else if (option == "fingerprints") {
+        Fingerprints = flag;
+    }
+    else if (option == "storage-layouts") {
+        StorageLayouts = flag;
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
 } // namespace tsm::cli
@@ -39,11 +39,42 @@ struct [[nodiscard]] CLIOptions {
                                                                 KeepIndexFile{ result.count("keep-file-list") > 0 },
                                                                 RegenIndices{ result.count("regen-indices") > 0 },
                                                                 Forecast{ result.count("forecast") > 0 },
-                                                                Historical{ result.count("historical") > 0 } {}
+                                                                Historical{ result.count("historical") > 0 },
+                                                                WAL{ result.count("wal") > 0 },
+                                                                TransactionSize{ result.count("transaction-size") > 0 ? result["transaction-size"].as<std::size_t>() : 50000 },
+                                                                InMemory{ result.count("in-memory") > 0 },
+                                                                MemoryBudgetMB{ result.count("memory-budget") > 0 ? result["memory-budget"].as<std::size_t>() : 4096 },
+                                                                ConfigPath{ result.count("config") > 0 ? result["config"].as<std::string>() : "" },
+                                                                Jobs{ result.count("jobs") > 0 ? result["jobs"].as<std::size_t>() : 0 },
+                                                                NoProgress{ result.count("no-progress") > 0 },
+                                                                ClusteredJoinTable{ result.count("clustered-join-table") > 0 },
+                                                                LogLevel{ result.count("log-level") > 0 ? result["log-level"].as<std::string>() : "info" },
+                                                                ReadTimeout{ result.count("read-timeout") > 0 ? result["read-timeout"].as<std::size_t>() : 0 },
+                                                                ReadWorkers{ result.count("read-workers") > 0 ? result["read-workers"].as<std::size_t>() : 4 },
+                                                                IgnoreQuarantine{ result.count("ignore-quarantine") > 0 },
+                                                                Order{ result.count("order") > 0 ? result["order"].as<std::string>() : "" },
+                                                                SpatialExtent{ result.count("spatial-extent") > 0 },
+                                                                Coordinates{ result.count("coordinates") > 0 },
+                                                                Fingerprints{ result.count("fingerprints") > 0 },
+                                                                StorageLayouts{ result.count("storage-layouts") > 0 },
+                                                                ServeSocket{ result.count("serve") > 0 ? result["serve"].as<std::string>() : "" },
+                                                                NoCrawlCache{ result.count("no-crawl-cache") > 0 },
+                                                                AdaptiveReads{ result.count("adaptive-reads") > 0 },
+                                                                MinReadWorkers{ result.count("min-read-workers") > 0 ? result["min-read-workers"].as<std::size_t>() : 1 },
+                                                                CatalogPath{ result.count("catalog") > 0 ? result["catalog"].as<std::string>() : "" },
+                                                                ExportFromCatalog{ result.count("export-from-catalog") > 0 },
+                                                                TracePath{ result.count("trace") > 0 ? result["trace"].as<std::string>() : "" },
+                                                                MemoryProfile{ result.count("memory-profile") > 0 },
+                                                                Export{ result.count("export") > 0 },
+                                                                ExportFormat{ result.count("format") > 0 ? result["format"].as<std::string>() : "arrow" } {}
 
     /// Validate the given inputs.
     [[nodiscard]] bool verify() const;
 
+    /// Sets an option from its long name and textual value (as found in a --config file).
+    /// Flags accept "true"/"false". Returns false for unknown options.
+    [[nodiscard]] bool set(const std::string& option, const std::string& value);
+
     std::string InputDir;
     std::string DatasetName;
     std::string OutputDir;
@@ -55,6 +86,33 @@ struct [[nodiscard]] CLIOptions {
     bool RegenIndices{ false };
     bool Forecast{ false };
     bool Historical{ false };
+    bool WAL{ false };
+    std::size_t TransactionSize{ 50000 };
+    bool InMemory{ false };
+    std::size_t MemoryBudgetMB{ 4096 };
+    std::string ConfigPath;
+    std::size_t Jobs{ 0 };
+    bool NoProgress{ false };
+    bool ClusteredJoinTable{ false };
+    std::string LogLevel{ "info" };
+    std::size_t ReadTimeout{ 0 };
+    std::size_t ReadWorkers{ 4 };
+    bool IgnoreQuarantine{ false };
+    std::string Order;
+    bool SpatialExtent{ false };
+    bool Coordinates{ false };
+    bool Fingerprints{ false };
+    bool StorageLayouts{ false };
+    std::string ServeSocket;
+    bool NoCrawlCache{ false };
+    bool AdaptiveReads{ false };
+    std::size_t MinReadWorkers{ 1 };
+    std::string CatalogPath;
+    bool ExportFromCatalog{ false };
+    std::string TracePath;
+    bool MemoryProfile{ false };
+    bool Export{ false };
+    std::string ExportFormat{ "arrow" };
 };
 
 } // namespace tsm::cli
@@ -0,0 +1,503 @@
+#include "Catalog.hpp"
+
+#include "Database.hpp"
+#include "Utils/DeletedUniquePtr.hpp"
+#include "Utils/Trace.hpp"
+
+#include <sqlite3.h>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace tsm {
+
+// How long an import waits for another one (e.g. from a parallel --config job) to commit.
+constexpr int CATALOG_BUSY_TIMEOUT_MS{ 10 * 60 * 1000 };
+
+/***********************************************************************************/
+namespace {
+
+    using stmtPtr = utils::deleted_unique_ptr<sqlite3_stmt>;
+
+    stmtPtr prepare(sqlite3* handle, const std::string& sqlStatement) {
+        sqlite3_stmt* stmt{ nullptr };
+        if (sqlite3_prepare_v2(handle, sqlStatement.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Error preparing SQL statement: " << sqlStatement << ".\n" << sqlite3_errmsg(handle) << std::endl;
+        }
+
+        return stmtPtr(stmt, [](auto* s) { sqlite3_finalize(s); });
+    }
+
+    /// Modification time (ns) of a database, counting its write-ahead log.
+    std::int64_t modificationTime(const fs::path& databasePath) {
+        std::int64_t latest{ 0 };
+        for (const auto& path : { databasePath.string(), databasePath.string() + "-wal" }) {
+            struct stat st{};
+            if (stat(path.c_str(), &st) == 0) {
+                latest = std::max(latest, static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec);
+            }
+        }
+
+        return latest;
+    }
+}
+
+/***********************************************************************************/
+Catalog::Catalog(fs::path catalogPath, const bool readOnly /* = false */) : m_catalogPath{ std::move(catalogPath) },
+                                                                              m_readOnly{ readOnly } {}
+
+/***********************************************************************************/
+Catalog::~Catalog() {
+    if (m_DBHandle) {
+        sqlite3_close(m_DBHandle);
+    }
+}
+
+/***********************************************************************************/
+bool Catalog::open() {
+    if (sqlite3_open_v2(m_catalogPath.c_str(), &m_DBHandle, m_readOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to open catalog " << m_catalogPath << ": " << sqlite3_errmsg(m_DBHandle) << std::endl;
+        sqlite3_close(m_DBHandle);
+        m_DBHandle = nullptr;
+        return false;
+    }
+
+    sqlite3_busy_timeout(m_DBHandle, CATALOG_BUSY_TIMEOUT_MS);
+
+    if (!m_readOnly) {
+        // Several indexers can share the catalog; WAL lets lookups go on while one imports.
+        execStatement("PRAGMA journal_mode = WAL;");
+        execStatement("PRAGMA synchronous = NORMAL;");
+        execStatement("PRAGMA temp_store = MEMORY;");
+        createTables();
+    }
+
+    return true;
+}
+
+/***********************************************************************************/
+void Catalog::createTables() {
+    // VarsDims used to be shared by every dataset of a variable, which mixed their
+    // dimensions together. Each dataset keeps the mix until it's imported again,
+    // which the next import does even if the dataset's database hasn't changed.
+    // Checked inside the transaction in case another indexer is at it too.
+    execStatement("BEGIN IMMEDIATE;");
+    if (hasColumn("VarsDims", "variable_id") && !hasColumn("VarsDims", "dataset_id")) {
+        const auto migrated{ execStatement(
+            "ALTER TABLE VarsDims RENAME TO VarsDimsShared;"
+            "CREATE TABLE VarsDims ("
+                "dataset_id INTEGER NOT NULL, "
+                "variable_id INTEGER NOT NULL, "
+                "dim_id INTEGER NOT NULL, "
+                "PRIMARY KEY(dataset_id, variable_id, dim_id)"
+            ") WITHOUT ROWID;"
+            "INSERT INTO VarsDims(dataset_id, variable_id, dim_id) "
+                "SELECT dv.dataset_id, vd.variable_id, vd.dim_id FROM VarsDimsShared vd "
+                "INNER JOIN DatasetVariables dv ON dv.variable_id = vd.variable_id;"
+            "DROP TABLE VarsDimsShared;"
+            "UPDATE Datasets SET source_mtime = 0;"
+        ) };
+        if (!migrated) {
+            execStatement("ROLLBACK;");
+            return;
+        }
+    }
+    execStatement("COMMIT;");
+
+    execStatement(
+        "CREATE TABLE IF NOT EXISTS Datasets ("
+            "id INTEGER PRIMARY KEY, "
+            "name TEXT UNIQUE NOT NULL, "
+            "type INTEGER NOT NULL, "
+            "source_mtime INTEGER NOT NULL DEFAULT 0, "
+            "updated INTEGER NOT NULL DEFAULT 0"
+        ");"
+        // Shared by every dataset with the same description of the variable.
+        "CREATE TABLE IF NOT EXISTS Variables ("
+            "id INTEGER PRIMARY KEY, "
+            "variable TEXT NOT NULL, "
+            "units TEXT NOT NULL, "
+            "longName TEXT NOT NULL, "
+            "validMin REAL, "
+            "validMax REAL, "
+            "UNIQUE(variable, units, longName, validMin, validMax)"
+        ");"
+        "CREATE TABLE IF NOT EXISTS Dimensions ("
+            "id INTEGER PRIMARY KEY, "
+            "name TEXT UNIQUE NOT NULL"
+        ");"
+        // Per dataset: datasets sharing a variable's description needn't share its dimensions.
+        "CREATE TABLE IF NOT EXISTS VarsDims ("
+            "dataset_id INTEGER NOT NULL, "
+            "variable_id INTEGER NOT NULL, "
+            "dim_id INTEGER NOT NULL, "
+            "PRIMARY KEY(dataset_id, variable_id, dim_id)"
+        ") WITHOUT ROWID;"
+        "CREATE TABLE IF NOT EXISTS Filepaths ("
+            "id INTEGER PRIMARY KEY, "
+            "dataset_id INTEGER NOT NULL, "
+            "filepath TEXT NOT NULL, "
+            "UNIQUE(dataset_id, filepath)"
+        ");"
+        "CREATE TABLE IF NOT EXISTS TimestampVariableFilepath ("
+            "variable_id INTEGER NOT NULL, "
+            "timestamp INTEGER NOT NULL, "
+            "dataset_id INTEGER NOT NULL, "
+            "filepath_id INTEGER NOT NULL, "
+            "PRIMARY KEY(variable_id, timestamp, dataset_id, filepath_id)"
+        ") WITHOUT ROWID;"
+        // Carries the primary key, so it also serves a dataset's rows in (variable, timestamp) order.
+        "CREATE INDEX IF NOT EXISTS idx_catalog_tvf_dataset ON TimestampVariableFilepath(dataset_id);"
+        "CREATE TABLE IF NOT EXISTS DatasetVariables ("
+            "dataset_id INTEGER NOT NULL, "
+            "variable_id INTEGER NOT NULL, "
+            "min_timestamp INTEGER NOT NULL, "
+            "max_timestamp INTEGER NOT NULL, "
+            "timestamp_count INTEGER NOT NULL, "
+            "PRIMARY KEY(dataset_id, variable_id)"
+        ") WITHOUT ROWID;"
+        "CREATE INDEX IF NOT EXISTS idx_variables_variable ON Variables(variable);"
+        "CREATE INDEX IF NOT EXISTS idx_dataset_variables_variable ON DatasetVariables(variable_id, min_timestamp, max_timestamp);"
+    );
+}
+
+/***********************************************************************************/
+bool Catalog::importDataset(const std::string& dataset, const ds::DATASET_TYPE type, const fs::path& databasePath) {
+    // ATTACH would create a missing file.
+    if (!fs::exists(databasePath)) {
+        std::cerr << "Can't add " << dataset << " to the catalog: " << databasePath << " does not exist." << std::endl;
+        return false;
+    }
+
+    const auto sourceModified{ modificationTime(databasePath) };
+    {
+        auto selectStmt{ prepare(m_DBHandle, "SELECT source_mtime FROM Datasets WHERE name = ?1;") };
+        sqlite3_bind_text(&(*selectStmt), 1, dataset.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(&(*selectStmt)) == SQLITE_ROW && sqlite3_column_int64(&(*selectStmt), 0) == sourceModified) {
+            std::cout << dataset << " is up to date in the catalog." << std::endl;
+            return true;
+        }
+    }
+
+    const utils::TraceSpan span{ "sqlite", "catalog import", dataset };
+    {
+        auto attachStmt{ prepare(m_DBHandle, "ATTACH DATABASE ?1 AS src;") };
+        sqlite3_bind_text(&(*attachStmt), 1, databasePath.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(&(*attachStmt)) != SQLITE_DONE) {
+            std::cerr << "Failed to attach " << databasePath << ": " << sqlite3_errmsg(m_DBHandle) << std::endl;
+            return false;
+        }
+    }
+
+    // Every statement takes the dataset id as ?1 (unused ones ignore it).
+    const auto run = [this](const std::string& sqlStatement, const std::int64_t datasetID) {
+        auto stmt{ prepare(m_DBHandle, sqlStatement) };
+        if (!stmt) {
+            return false;
+        }
+        if (sqlite3_bind_parameter_count(&(*stmt)) > 0) {
+            sqlite3_bind_int64(&(*stmt), 1, datasetID);
+        }
+        if (sqlite3_step(&(*stmt)) != SQLITE_DONE) {
+            std::cerr << "SQLITE Error: " << sqlite3_errmsg(m_DBHandle) << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    const auto hasSourceTable = [this](const std::string& name) {
+        auto stmt{ prepare(m_DBHandle, "SELECT 1 FROM src.sqlite_master WHERE type = 'table' AND name = ?1;") };
+        sqlite3_bind_text(&(*stmt), 1, name.c_str(), -1, SQLITE_TRANSIENT);
+        return sqlite3_step(&(*stmt)) == SQLITE_ROW;
+    };
+
+    // Timestamps of other datasets in the catalog wouldn't compare with an older encoding's.
+    if (hasSourceTable("Timestamps")) {
+        auto versionStmt{ prepare(m_DBHandle, "PRAGMA src.user_version;") };
+        if (sqlite3_step(&(*versionStmt)) != SQLITE_ROW || sqlite3_column_int(&(*versionStmt), 0) != TIMESTAMP_FORMAT_VERSION) {
+            std::cerr << "Can't add " << dataset << " to the catalog: " << databasePath << " was indexed with an older timestamp format. "
+                      << "Index the dataset again first." << std::endl;
+            versionStmt.reset();
+            execStatement("DETACH DATABASE src;");
+            return false;
+        }
+    }
+
+    // Taken right away, so parallel imports queue up here instead of deadlocking on upgrade.
+    auto ok{ execStatement("BEGIN IMMEDIATE;") };
+
+    std::int64_t datasetID{ 0 };
+    if (ok) {
+        const auto now{ std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() };
+        // Keeps the dataset's id, so nothing else has to be renumbered.
+        auto upsertStmt{ prepare(m_DBHandle, "INSERT INTO Datasets(name, type, source_mtime, updated) VALUES (?1, ?2, ?3, ?4) "
+                                             "ON CONFLICT(name) DO UPDATE SET type = excluded.type, source_mtime = excluded.source_mtime, updated = excluded.updated;") };
+        sqlite3_bind_text(&(*upsertStmt), 1, dataset.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(&(*upsertStmt), 2, static_cast<int>(type));
+        sqlite3_bind_int64(&(*upsertStmt), 3, sourceModified);
+        sqlite3_bind_int64(&(*upsertStmt), 4, now);
+        ok = sqlite3_step(&(*upsertStmt)) == SQLITE_DONE;
+
+        auto selectStmt{ prepare(m_DBHandle, "SELECT id FROM Datasets WHERE name = ?1;") };
+        sqlite3_bind_text(&(*selectStmt), 1, dataset.c_str(), -1, SQLITE_TRANSIENT);
+        ok = ok && sqlite3_step(&(*selectStmt)) == SQLITE_ROW;
+        datasetID = ok ? sqlite3_column_int64(&(*selectStmt), 0) : 0;
+    }
+
+    ok = ok && run("DELETE FROM TimestampVariableFilepath WHERE dataset_id = ?1;", datasetID)
+            && run("DELETE FROM DatasetVariables WHERE dataset_id = ?1;", datasetID)
+            && run("DELETE FROM VarsDims WHERE dataset_id = ?1;", datasetID)
+            && run("DELETE FROM Filepaths WHERE dataset_id = ?1;", datasetID);
+
+    // A dataset that had nothing indexed yet has no tables.
+    if (ok && hasSourceTable("TimestampVariableFilepath") && hasSourceTable("VarsDims")) {
+        ok = run("INSERT OR IGNORE INTO Variables(variable, units, longName, validMin, validMax) "
+                 "SELECT variable, IFNULL(units, ''), IFNULL(longName, ''), validMin, validMax FROM src.Variables;", datasetID)
+          && run("CREATE TEMP TABLE VariableMap(source_id INTEGER PRIMARY KEY, catalog_id INTEGER NOT NULL);", datasetID)
+          && run("INSERT INTO temp.VariableMap(source_id, catalog_id) "
+                 "SELECT s.id AS source_id, c.id AS catalog_id FROM src.Variables s INNER JOIN main.Variables c "
+                 "ON c.variable = s.variable AND c.units = IFNULL(s.units, '') AND c.longName = IFNULL(s.longName, '') "
+                 "AND c.validMin IS s.validMin AND c.validMax IS s.validMax;", datasetID)
+          && run("INSERT OR IGNORE INTO Dimensions(name) SELECT name FROM src.Dimensions;", datasetID)
+          && run("INSERT OR IGNORE INTO VarsDims(dataset_id, variable_id, dim_id) "
+                 "SELECT ?1, m.catalog_id, d.id FROM src.VarsDims vd INNER JOIN temp.VariableMap m ON m.source_id = vd.variable_id "
+                 "INNER JOIN src.Dimensions sd ON sd.id = vd.dim_id INNER JOIN main.Dimensions d ON d.name = sd.name;", datasetID)
+          && run("INSERT INTO Filepaths(dataset_id, filepath) SELECT ?1, filepath FROM src.Filepaths;", datasetID)
+          && run("CREATE TEMP TABLE FileMap(source_id INTEGER PRIMARY KEY, catalog_id INTEGER NOT NULL);", datasetID)
+          && run("INSERT INTO temp.FileMap(source_id, catalog_id) "
+                 "SELECT s.id AS source_id, c.id AS catalog_id FROM src.Filepaths s INNER JOIN main.Filepaths c "
+                 "ON c.dataset_id = ?1 AND c.filepath = s.filepath;", datasetID)
+          // Sorted so the clustered table is appended to in key order, like the bulk loader does.
+          && run("INSERT OR IGNORE INTO TimestampVariableFilepath(variable_id, timestamp, dataset_id, filepath_id) "
+                 "SELECT m.catalog_id, t.timestamp, ?1, f.catalog_id FROM src.TimestampVariableFilepath j "
+                 "INNER JOIN src.Timestamps t ON t.id = j.timestamp_id "
+                 "INNER JOIN temp.VariableMap m ON m.source_id = j.variable_id "
+                 "INNER JOIN temp.FileMap f ON f.source_id = j.filepath_id "
+                 "ORDER BY 1, 2, 4;", datasetID)
+          && run("INSERT INTO DatasetVariables(dataset_id, variable_id, min_timestamp, max_timestamp, timestamp_count) "
+                 "SELECT ?1, variable_id, MIN(timestamp), MAX(timestamp), COUNT(DISTINCT timestamp) "
+                 "FROM TimestampVariableFilepath WHERE dataset_id = ?1 GROUP BY variable_id;", datasetID)
+          && run("DROP TABLE temp.VariableMap;", datasetID)
+          && run("DROP TABLE temp.FileMap;", datasetID);
+    }
+
+    // Descriptions no dataset uses anymore (e.g. after a dataset's units were fixed).
+    ok = ok && run("DELETE FROM Variables WHERE id NOT IN (SELECT variable_id FROM DatasetVariables);", datasetID);
+
+    execStatement(ok ? "COMMIT;" : "ROLLBACK;");
+    execStatement("DETACH DATABASE src;");
+
+    if (!ok) {
+        std::cerr << "Failed to add " << dataset << " to the catalog " << m_catalogPath << '.' << std::endl;
+    }
+
+    return ok;
+}
+
+/***********************************************************************************/
+bool Catalog::exportDataset(const std::string& dataset, const fs::path& outputDir) {
+    auto files{ selectDatasetFiles(dataset) };
+    if (!files) {
+        return false;
+    }
+
+    // Built under a temporary name so readers of the real file never see a partial one.
+    const auto tempName{ '.' + dataset + ".export" };
+    const auto tempPath{ outputDir / (tempName + ".sqlite3") };
+    std::error_code e;
+    fs::remove(tempPath, e);
+    auto inserted{ false };
+    {
+        Database db{ outputDir, tempName };
+        inserted = db.open() && db.insertData(ds::DatasetDesc{ std::move(files->second), files->first });
+    }
+
+    const auto outputPath{ outputDir / (dataset + ".sqlite3") };
+    if (!inserted) {
+        std::cerr << "Failed to export " << dataset << ". " << outputPath << " was left untouched." << std::endl;
+        fs::remove(tempPath, e);
+        return false;
+    }
+
+    fs::rename(tempPath, outputPath, e);
+    if (e) {
+        std::cerr << "Failed to replace " << outputPath << ": " << e.message() << std::endl;
+        fs::remove(tempPath, e);
+        return false;
+    }
+
+    return true;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<std::string>> Catalog::selectDatasets() {
+    auto stmt{ prepare(m_DBHandle, "SELECT name FROM Datasets ORDER BY name;") };
+    if (!stmt) {
+        return std::nullopt;
+    }
+
+    std::vector<std::string> names;
+    while (sqlite3_step(&(*stmt)) == SQLITE_ROW) {
+        names.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), 0)));
+    }
+
+    return names;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<std::string>> Catalog::selectDatasets(const std::string& variable, const std::int64_t timestamp, const std::int64_t tolerance /* = 0 */) {
+    // One range scan of the clustered join table per description of the variable;
+    // DatasetVariables rules out datasets whose time axis can't reach.
+    auto stmt{ prepare(m_DBHandle, "SELECT name FROM Datasets d WHERE EXISTS ("
+                                       "SELECT 1 FROM Variables v "
+                                       "INNER JOIN DatasetVariables dv ON dv.variable_id = v.id AND dv.dataset_id = d.id "
+                                       "INNER JOIN TimestampVariableFilepath j ON j.variable_id = v.id AND j.timestamp BETWEEN ?2 AND ?3 AND j.dataset_id = d.id "
+                                       "WHERE v.variable = ?1 AND dv.min_timestamp <= ?3 AND dv.max_timestamp >= ?2) "
+                                   "ORDER BY name;") };
+    if (!stmt) {
+        return std::nullopt;
+    }
+    sqlite3_bind_text(&(*stmt), 1, variable.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(&(*stmt), 2, timestamp - tolerance);
+    sqlite3_bind_int64(&(*stmt), 3, timestamp + tolerance);
+
+    std::vector<std::string> names;
+    while (sqlite3_step(&(*stmt)) == SQLITE_ROW) {
+        names.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), 0)));
+    }
+
+    return names;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<Catalog::Match>> Catalog::selectFilepaths(const std::string& variable, const std::int64_t timestamp) {
+    auto stmt{ prepare(m_DBHandle, "SELECT d.name, f.filepath FROM Variables v "
+                                   "INNER JOIN TimestampVariableFilepath j ON j.variable_id = v.id AND j.timestamp = ?2 "
+                                   "INNER JOIN Datasets d ON d.id = j.dataset_id "
+                                   "INNER JOIN Filepaths f ON f.id = j.filepath_id "
+                                   "WHERE v.variable = ?1 ORDER BY d.name, f.filepath;") };
+    if (!stmt) {
+        return std::nullopt;
+    }
+    sqlite3_bind_text(&(*stmt), 1, variable.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(&(*stmt), 2, timestamp);
+
+    std::vector<Match> matches;
+    while (sqlite3_step(&(*stmt)) == SQLITE_ROW) {
+        matches.push_back({ reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), 0)),
+                            reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), 1)) });
+    }
+
+    return matches;
+}
+
+/***********************************************************************************/
+std::optional<std::pair<ds::DATASET_TYPE, std::vector<ds::DataFileDesc>>> Catalog::selectDatasetFiles(const std::string& dataset) {
+    std::int64_t datasetID{ 0 };
+    auto type{ ds::DATASET_TYPE::HISTORICAL };
+    {
+        auto stmt{ prepare(m_DBHandle, "SELECT id, type FROM Datasets WHERE name = ?1;") };
+        if (!stmt) {
+            return std::nullopt;
+        }
+        sqlite3_bind_text(&(*stmt), 1, dataset.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(&(*stmt)) != SQLITE_ROW) {
+            std::cerr << "The catalog " << m_catalogPath << " has no dataset " << dataset << '.' << std::endl;
+            return std::nullopt;
+        }
+        datasetID = sqlite3_column_int64(&(*stmt), 0);
+        type = static_cast<ds::DATASET_TYPE>(sqlite3_column_int(&(*stmt), 1));
+    }
+
+    // Dimensions of every variable of the dataset, then the variables themselves.
+    std::unordered_map<std::int64_t, std::vector<std::string>> dimensions;
+    {
+        auto stmt{ prepare(m_DBHandle, "SELECT vd.variable_id, d.name FROM VarsDims vd INNER JOIN Dimensions d ON d.id = vd.dim_id "
+                                       "WHERE vd.dataset_id = ?1;") };
+        sqlite3_bind_int64(&(*stmt), 1, datasetID);
+        while (sqlite3_step(&(*stmt)) == SQLITE_ROW) {
+            dimensions[sqlite3_column_int64(&(*stmt), 0)].emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), 1)));
+        }
+    }
+
+    std::unordered_map<std::int64_t, ds::VariableDesc> variables;
+    {
+        auto stmt{ prepare(m_DBHandle, "SELECT v.id, v.variable, v.units, v.longName, v.validMin, v.validMax FROM Variables v "
+                                       "INNER JOIN DatasetVariables dv ON dv.variable_id = v.id AND dv.dataset_id = ?1;") };
+        sqlite3_bind_int64(&(*stmt), 1, datasetID);
+        while (sqlite3_step(&(*stmt)) == SQLITE_ROW) {
+            const auto id{ sqlite3_column_int64(&(*stmt), 0) };
+            variables.emplace(id, ds::VariableDesc{ reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), 1)),
+                                                    reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), 2)),
+                                                    reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), 3)),
+                                                    static_cast<float>(sqlite3_column_double(&(*stmt), 4)),
+                                                    static_cast<float>(sqlite3_column_double(&(*stmt), 5)),
+                                                    dimensions[id] });
+        }
+    }
+
+    // Each file's timestamps and variables; the per-dataset schema stores their product.
+    struct File {
+        std::set<ds::timestamp_t> Timestamps;
+        std::set<std::int64_t> Variables;
+    };
+    std::map<std::string, File> byPath;
+    {
+        auto stmt{ prepare(m_DBHandle, "SELECT f.filepath, j.timestamp, j.variable_id FROM TimestampVariableFilepath j "
+                                       "INNER JOIN Filepaths f ON f.id = j.filepath_id WHERE j.dataset_id = ?1;") };
+        sqlite3_bind_int64(&(*stmt), 1, datasetID);
+        while (sqlite3_step(&(*stmt)) == SQLITE_ROW) {
+            auto& file{ byPath[reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), 0))] };
+            file.Timestamps.insert(static_cast<ds::timestamp_t>(sqlite3_column_int64(&(*stmt), 1)));
+            file.Variables.insert(sqlite3_column_int64(&(*stmt), 2));
+        }
+    }
+
+    std::vector<ds::DataFileDesc> files;
+    files.reserve(byPath.size());
+    for (const auto& [path, file] : byPath) {
+        std::vector<ds::VariableDesc> fileVariables;
+        for (const auto id : file.Variables) {
+            if (const auto variable{ variables.find(id) }; variable != variables.cend()) {
+                fileVariables.push_back(variable->second);
+            }
+        }
+        files.emplace_back(std::vector<ds::timestamp_t>(file.Timestamps.cbegin(), file.Timestamps.cend()), fileVariables, path);
+    }
+
+    return std::make_pair(type, std::move(files));
+}
+
+/***********************************************************************************/
+bool Catalog::hasColumn(const std::string& table, const std::string& column) {
+    auto stmt{ prepare(m_DBHandle, "PRAGMA table_info(" + table + ");") };
+    while (stmt && sqlite3_step(&(*stmt)) == SQLITE_ROW) {
+        if (column == reinterpret_cast<const char*>(sqlite3_column_text(&(*stmt), 1))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/***********************************************************************************/
+bool Catalog::execStatement(const std::string& sqlStatement) {
+    char* errorMsg{ nullptr };
+    sqlite3_exec(m_DBHandle, sqlStatement.c_str(), nullptr, nullptr, &errorMsg);
+
+    if (errorMsg) {
+        std::cerr << "SQLITE Error: " << errorMsg << std::endl;
+        sqlite3_free(errorMsg);
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace tsm
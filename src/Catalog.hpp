@@ -0,0 +1,87 @@
+#pragma once
+
+#include "DataFileDesc.hpp"
+#include "DatasetDesc.hpp"
+#include "Filesystem.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Forward declarations
+struct sqlite3;
+
+namespace tsm {
+
+/***********************************************************************************/
+/// One database for many datasets (--catalog), so "which datasets have variable X
+/// near time T" is one query instead of one per dataset file.
+///
+/// Each dataset is still indexed into its own <dataset>.sqlite3 first (that's
+/// where quarantine, fingerprints and the other bookkeeping live); importDataset()
+/// then replaces the dataset's rows in the catalog with the contents of that file.
+/// Variables and dimension names are stored once for all datasets that share them:
+///
+///   Datasets(id, name, type, source_mtime, updated)
+///   Variables(id, variable, units, longName, validMin, validMax)   one row per distinct description
+///   Dimensions(id, name), VarsDims(dataset_id, variable_id, dim_id)
+///   Filepaths(id, dataset_id, filepath)
+///   TimestampVariableFilepath(variable_id, timestamp, dataset_id, filepath_id)
+///       WITHOUT ROWID, so a variable's rows for a time range, across all datasets, are one range scan.
+///   DatasetVariables(dataset_id, variable_id, min_timestamp, max_timestamp, timestamp_count)
+///
+/// exportDataset() writes a dataset back out as a regular <dataset>.sqlite3.
+class Catalog {
+
+public:
+    /// A file of a dataset found by a cross-dataset lookup.
+    struct Match {
+        std::string Dataset;
+        std::string Filepath;
+    };
+
+    ///
+    explicit Catalog(fs::path catalogPath, const bool readOnly = false);
+    ///
+    ~Catalog();
+
+    Catalog(const Catalog&) = delete;
+    Catalog& operator=(const Catalog&) = delete;
+
+    /// Opens (and creates, unless read-only) the catalog.
+    [[nodiscard]] bool open();
+
+    /// Replaces everything the catalog holds for dataset with the contents of databasePath.
+    /// Skipped if databasePath hasn't been modified since it was last imported.
+    /// The dataset database must not be open in another connection that holds an exclusive lock.
+    [[nodiscard]] bool importDataset(const std::string& dataset, const ds::DATASET_TYPE type, const fs::path& databasePath);
+    /// Writes dataset to <outputDir>/<dataset>.sqlite3, replacing the file atomically.
+    [[nodiscard]] bool exportDataset(const std::string& dataset, const fs::path& outputDir);
+
+    // Lookups. Each returns std::nullopt if the query fails.
+
+    /// Every dataset, sorted.
+    [[nodiscard]] std::optional<std::vector<std::string>> selectDatasets();
+    /// Datasets with variable at a timestamp within tolerance of timestamp, sorted.
+    [[nodiscard]] std::optional<std::vector<std::string>> selectDatasets(const std::string& variable, const std::int64_t timestamp, const std::int64_t tolerance = 0);
+    /// Files of any dataset holding variable at timestamp, sorted by dataset, then path.
+    [[nodiscard]] std::optional<std::vector<Match>> selectFilepaths(const std::string& variable, const std::int64_t timestamp);
+
+private:
+    ///
+    void createTables();
+    /// Whether the catalog's table has the column.
+    [[nodiscard]] bool hasColumn(const std::string& table, const std::string& column);
+    /// Runs one or more statements. False (and the error on stderr) if one fails.
+    bool execStatement(const std::string& sqlStatement);
+    /// The files of dataset as they were read, and its type.
+    [[nodiscard]] std::optional<std::pair<ds::DATASET_TYPE, std::vector<ds::DataFileDesc>>> selectDatasetFiles(const std::string& dataset);
+
+    const fs::path m_catalogPath;
+    const bool m_readOnly;
+    sqlite3* m_DBHandle{ nullptr };
+};
+
+} // namespace tsm
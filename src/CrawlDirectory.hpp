@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Utils/DirectoryCache.hpp"
 #include "Utils/HashString.hpp"
 #include "Filesystem.hpp"
 
@@ -9,8 +10,8 @@
 
 namespace tsm::utils {
 
-///
-static inline auto crawlDirectory(const fs::path& inputDirOrIndexFile, const std::string& regex, const std::string& engine) {
+/// With a cache, only the directories that changed since the cache was written get listed.
+static inline auto crawlDirectory(const fs::path& inputDirOrIndexFile, const std::string& regex, const std::string& engine, DirectoryCache* cache = nullptr) {
     using recursive_dir_iterator = fs::recursive_directory_iterator;
 
     std::vector<fs::path> paths;
@@ -50,6 +51,15 @@ static inline auto crawlDirectory(const fs::path& inputDirOrIndexFile, const std
     try {
         const std::regex r(regex, std::regex::optimize | engineType);
 
+        if (cache) {
+            for (auto& file : cache->crawl(inputDirOrIndexFile)) {
+                if (std::regex_match(file.string(), r)) {
+                    paths.emplace_back(std::move(file));
+                }
+            }
+            return paths;
+        }
+
         for (const auto& file : recursive_dir_iterator(inputDirOrIndexFile, options)) {
             if (fs::path(file).extension() == ".nc" && std::regex_match(fs::path(file).string(), r)) {
                 paths.emplace_back(file);
@@ -5,16 +5,51 @@
 
 #include "VariableDesc.hpp"
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 
 namespace tsm::ds {
 
+/// Latitude/longitude extent, in degrees. Longitudes are in [-180, 180].
+struct [[nodiscard]] BoundingBox {
+    double MinLat{ 0.0 };
+    double MaxLat{ 0.0 };
+    double MinLon{ 0.0 };
+    double MaxLon{ 0.0 };
+};
+
+/// Length of one of a file's dimensions.
+struct [[nodiscard]] DimensionDesc {
+    std::string Name;
+    std::size_t Size{ 0 };
+};
+
+/// Values of a coordinate variable (depth, lat/lon grid, ...). Thousands of
+/// files usually share one axis, so they share the values, identified by Hash.
+struct [[nodiscard]] CoordinateDesc {
+    std::string Name;
+    std::vector<std::string> Dimensions;
+    /// Of the values and the shape (utils::hashValues).
+    std::uint64_t Hash{ 0 };
+    std::shared_ptr<const std::vector<double>> Values;
+};
+
 struct [[nodiscard]] DataFileDesc {
     ///
     DataFileDesc() noexcept = default;
     ///
-    DataFileDesc(const std::vector<timestamp_t>& timestamps, const std::vector<VariableDesc>& variables, const fs::path& path) :  Timestamps{timestamps},
-                                                                                                                                            Variables{variables},
-                                                                                                                                            NCFilePath{path} {}
+    DataFileDesc(const std::vector<timestamp_t>& timestamps, const std::vector<VariableDesc>& variables, const fs::path& path,
+                 const std::optional<BoundingBox>& extent = std::nullopt,
+                 const std::vector<DimensionDesc>& dimensions = {},
+                 const std::vector<CoordinateDesc>& coordinates = {},
+                 const std::string& format = {}) :  Timestamps{timestamps},
+                                                    Variables{variables},
+                                                    NCFilePath{path},
+                                                    Extent{extent},
+                                                    Dimensions{dimensions},
+                                                    Coordinates{coordinates},
+                                                    Format{format} {}
 
     DataFileDesc(const DataFileDesc&) = default;
     DataFileDesc(DataFileDesc&&) = default;
@@ -30,9 +65,17 @@ struct [[nodiscard]] DataFileDesc {
         return !operator bool();
     }
 
-    const std::vector<timestamp_t> Timestamps;
-    const std::vector<VariableDesc> Variables;
-    const fs::path NCFilePath;
+    // Not const, so a desc handed from the readers to DatasetDesc is moved rather than copied.
+    std::vector<timestamp_t> Timestamps;
+    std::vector<VariableDesc> Variables;
+    fs::path NCFilePath;
+    /// Only read with --spatial-extent, and only if the file has lat/lon coordinates.
+    std::optional<BoundingBox> Extent;
+    std::vector<DimensionDesc> Dimensions;
+    /// Only read with --coordinates. The time axis is in Timestamps instead.
+    std::vector<CoordinateDesc> Coordinates;
+    /// On-disk format, e.g. "netCDF-4" or "classic".
+    std::string Format;
 };
 
 } // namespace tsm
@@ -1,18 +1,153 @@
 #include "Database.hpp"
 
+#include "ArrayTable.hpp"
 #include "DatasetDesc.hpp"
 
 #include <sqlite3.h>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Utils/Fingerprint.hpp"
+#include "Utils/MemoryProfile.hpp"
+#include "Utils/RadixSort.hpp"
+#include "Utils/Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
 #include <stdexcept>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <unordered_map>
 #include <unordered_set>
 
 // Required queries:
 // SELECT filepath FROM Timestamps INNER JOIN Filepaths WHERE timestamp='2193091200';
+//
+// With --clustered-join-table the join table is ordered by (variable_id, timestamp_id, filepath_id),
+// so "files for variable and timestamp" is a single range scan of the table itself, and
+// "files for timestamp" is a range scan of idx_tvf_timestamp (which covers the whole row).
 
 namespace tsm {
 
+// Per-row cost of each table once its indices are counted. Deliberately on
+// the high side so --memory-budget errs towards building on disk.
+constexpr std::size_t BYTES_PER_JOIN_ROW{ 64 };
+constexpr std::size_t BYTES_PER_TIMESTAMP_ROW{ 32 };
+// Join rows sorted per chunk by the bulk loader (512 MB of packed keys).
+constexpr std::size_t BULK_LOAD_CHUNK_ROWS{ std::size_t{ 1 } << 26 };
+// Join rows handed to SQLite per int64_array() statement.
+constexpr std::size_t BULK_INSERT_BLOCK_ROWS{ 8192 };
+// Failed reads of an unchanged file before it gets skipped. A timeout skips it right away.
+constexpr std::int64_t QUARANTINE_AFTER_FAILURES{ 3 };
+
+/***********************************************************************************/
+namespace {
+
+    /// Modification time in nanoseconds, or nothing if the file is gone.
+    std::optional<std::int64_t> modificationTime(const fs::path& path) {
+        struct stat st{};
+        if (stat(path.c_str(), &st) != 0) {
+            return std::nullopt;
+        }
+
+        return static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    }
+
+    /// A VariableCoverage row while it's being updated.
+    struct CoverageRow {
+        std::int64_t Min{ 0 };
+        std::int64_t Max{ 0 };
+        std::int64_t Count{ 0 };
+        /// Greatest common divisor of the distances between the timestamps.
+        std::int64_t Spacing{ 0 };
+    };
+
+    /// Adds a timestamp that row doesn't cover yet.
+    void addTimestamp(CoverageRow& row, const std::int64_t timestamp) {
+        if (row.Count == 0) {
+            row.Min = row.Max = timestamp;
+        }
+        // The gcd of the distances to any one timestamp is the gcd of all of them.
+        row.Spacing = std::gcd(row.Spacing, timestamp - row.Min);
+        row.Min = std::min(row.Min, timestamp);
+        row.Max = std::max(row.Max, timestamp);
+        ++row.Count;
+    }
+
+    /// The axis is regular when no multiple of the spacing between Min and Max is missing.
+    std::optional<std::int64_t> regularStep(const CoverageRow& row) {
+        if (row.Count < 2 || (row.Max - row.Min) / row.Spacing + 1 != row.Count) {
+            return std::nullopt;
+        }
+
+        return row.Spacing;
+    }
+
+    constexpr auto INSERT_COVERAGE_QUERY{
+        "INSERT OR REPLACE INTO VariableCoverage(variable_id, min_timestamp, max_timestamp, timestamp_count, spacing, step) "
+        "VALUES (@VR, @MN, @MX, @CT, @SP, @ST);"
+    };
+
+    void writeCoverage(sqlite3_stmt* insertStmt, const std::int64_t variableID, const CoverageRow& row) {
+        sqlite3_bind_int64(insertStmt, 1, variableID);
+        sqlite3_bind_int64(insertStmt, 2, row.Min);
+        sqlite3_bind_int64(insertStmt, 3, row.Max);
+        sqlite3_bind_int64(insertStmt, 4, row.Count);
+        sqlite3_bind_int64(insertStmt, 5, row.Spacing);
+        if (const auto step{ regularStep(row) }; step) {
+            sqlite3_bind_int64(insertStmt, 6, *step);
+        }
+        sqlite3_step(insertStmt);
+        sqlite3_clear_bindings(insertStmt);
+        sqlite3_reset(insertStmt);
+    }
+
+    std::string joinChunkSizes(const std::vector<std::size_t>& sizes) {
+        std::string text;
+        for (const auto size : sizes) {
+            text += (text.empty() ? "" : ",") + std::to_string(size);
+        }
+
+        return text;
+    }
+
+    /// Canonical text of a file's format and variable layouts: equal for files with the same schema.
+    /// Compared as text rather than hashed, so two schemas can never be mixed up.
+    std::string schemaSignature(const ds::DataFileDesc& ncFile) {
+        std::vector<const ds::VariableDesc*> variables;
+        for (const auto& variable : ncFile.Variables) {
+            if (variable.Layout) {
+                variables.push_back(&variable);
+            }
+        }
+        std::sort(variables.begin(), variables.end(), [](const auto* lhs, const auto* rhs) {
+            return lhs->Name < rhs->Name;
+        });
+
+        std::ostringstream signature;
+        signature << std::setprecision(17) << ncFile.Format;
+        for (const auto* variable : variables) {
+            const auto& layout{ *variable->Layout };
+            signature << '\n' << variable->Name << ' ' << layout.Storage << ' ' << joinChunkSizes(layout.ChunkSizes) << ' '
+                      << layout.DeflateLevel << ' ' << layout.Shuffle << ' ';
+            if (layout.FillValue) {
+                signature << *layout.FillValue;
+            }
+        }
+
+        return signature.str();
+    }
+}
+
 /***********************************************************************************/
 /// Convert numeric value to std::string properly
 template<typename T,
@@ -26,8 +161,9 @@ auto toString(const T numeric) {
 }
 
 /***********************************************************************************/
-Database::Database(const fs::path& outputPath, const std::string& datasetName) :
-                                                                                m_outputFilePath{ outputPath / (datasetName + ".sqlite3")} {
+Database::Database(const fs::path& outputPath, const std::string& datasetName, const DatabaseOptions& options /* = {} */) :
+                                                                                m_outputFilePath{ outputPath / (datasetName + ".sqlite3")},
+                                                                                m_options{ options } {
 
     configureSQLITE();
 }
@@ -42,7 +178,7 @@ bool Database::open() {
 
     const auto result { sqlite3_open_v2(m_outputFilePath.c_str(),
                                         &m_DBHandle,
-                                        SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                                        m_options.ReadOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
                                         nullptr)
                         };
     if (result != SQLITE_OK) {
@@ -53,104 +189,1208 @@ bool Database::open() {
 
     configureDBConnection();
 
+    if (!registerArrayTable(m_DBHandle)) {
+        printErrorMsg();
+        closeConnection();
+        return false;
+    }
+
+    if (!m_options.ReadOnly && !checkTimestampFormat()) {
+        closeConnection();
+        return false;
+    }
+
     return true;
 }
 
 /***********************************************************************************/
-void Database::insertData(const ds::DatasetDesc& datasetDesc) {
+bool Database::insertData(const ds::DatasetDesc& datasetDesc) {
+    const utils::TraceSpan span{ "phase", "insert" };
+    const utils::MemoryPhase phase{ "Database insert" };
 
     if (datasetDesc.isHistorical()) {
-        insertHistorical(datasetDesc);
-        return;
+        if (!m_options.WAL) {
+            // Held until the connection closes; nobody can read a half-loaded database anyway.
+            execStatement("PRAGMA locking_mode = EXCLUSIVE");
+        }
+
+        auto buildInMemory{ false };
+        if (m_options.InMemory) {
+            const auto estimateMB{ estimateSizeBytes(datasetDesc) / (1024 * 1024) };
+            if (estimateMB > m_options.MemoryBudgetMB) {
+                std::cout << "Estimated database size of " << estimateMB << " MB exceeds the memory budget of "
+                          << m_options.MemoryBudgetMB << " MB. Building on disk instead." << std::endl;
+            }
+            else {
+                buildInMemory = moveToMemory();
+            }
+        }
+
+        if (!insertHistorical(datasetDesc)) {
+            std::cerr << "Failed to insert the files into " << m_outputFilePath << '.' << std::endl;
+            if (buildInMemory) {
+                std::cerr << "The in-memory database was not published; " << m_outputFilePath << " was left untouched." << std::endl;
+            }
+            return false;
+        }
+
+        if (buildInMemory) {
+            std::cout << "Publishing in-memory database to " << m_outputFilePath << "..." << std::endl;
+            const utils::MemoryPhase publishPhase{ "publish from memory" };
+            if (!publishFromMemory()) {
+                std::cerr << "Failed to publish the in-memory database. " << m_outputFilePath << " was left untouched." << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // Fold the whole log back into the main file now that the load is done.
+        checkpointWAL(SQLITE_CHECKPOINT_TRUNCATE);
+        return true;
     }
 
     if (datasetDesc.isForecast()) {
-        return;
+        return true;
     }
 
     std::cout << "Nothing done." << std::endl;
+
+    return true;
 }
 
 /***********************************************************************************/
-void Database::configureSQLITE() {
-    sqlite3_config(SQLITE_CONFIG_LOG, [](void* pArg, int iErrCode, const char* zMsg) {
-        std::cerr << "SQLITE Error: "  << iErrCode << " " << zMsg << std::endl;
+std::unordered_set<std::string> Database::selectQuarantinedFiles() {
+    createQuarantineTable();
+
+    auto selectStmt{ prepareStatement("SELECT filepath, mtime FROM Quarantine WHERE timeouts > 0 OR failures >= @FL;") };
+    sqlite3_bind_int64(&(*selectStmt), 1, QUARANTINE_AFTER_FAILURES);
+
+    std::unordered_set<std::string> quarantined;
+    while (sqlite3_step(&(*selectStmt)) == SQLITE_ROW) {
+        const std::string path{ reinterpret_cast<const char*>(sqlite3_column_text(&(*selectStmt), 0)) };
+
+        // A file that changed since gets another chance.
+        if (modificationTime(path) == sqlite3_column_int64(&(*selectStmt), 1)) {
+            quarantined.emplace(path);
+        }
+    }
+
+    return quarantined;
+}
+
+/***********************************************************************************/
+FingerprintMatches Database::applyFingerprints(utils::PathStore& paths) {
+    const utils::TraceSpan span{ "phase", "match fingerprints" };
+    createFingerprintsTable();
+
+    struct Indexed {
+        std::int64_t ID{ 0 };
+        std::string Path;
+        utils::Fingerprint Fingerprint;
+        /// Claimed by a rename in this run.
+        bool Moved{ false };
+    };
+
+    std::vector<Indexed> indexed;
+    {
+        auto selectStmt{ prepareStatement("SELECT f.id, f.filepath, fp.device, fp.inode, fp.size, fp.mtime, fp.header_hash \
+                                           FROM FileFingerprints fp INNER JOIN Filepaths f ON f.id = fp.filepath_id;") };
+        while (selectStmt && sqlite3_step(&(*selectStmt)) == SQLITE_ROW) {
+            Indexed file;
+            file.ID = sqlite3_column_int64(&(*selectStmt), 0);
+            file.Path = reinterpret_cast<const char*>(sqlite3_column_text(&(*selectStmt), 1));
+            file.Fingerprint.Device = static_cast<std::uint64_t>(sqlite3_column_int64(&(*selectStmt), 2));
+            file.Fingerprint.Inode = static_cast<std::uint64_t>(sqlite3_column_int64(&(*selectStmt), 3));
+            file.Fingerprint.Size = sqlite3_column_int64(&(*selectStmt), 4);
+            file.Fingerprint.ModifiedNs = sqlite3_column_int64(&(*selectStmt), 5);
+            file.Fingerprint.HeaderHash = static_cast<std::uint64_t>(sqlite3_column_int64(&(*selectStmt), 6));
+            indexed.push_back(std::move(file));
+        }
+    }
+
+    std::unordered_set<std::string> indexedPaths;
+    std::map<std::pair<std::uint64_t, std::uint64_t>, std::size_t> byInode;
+    std::multimap<std::pair<std::int64_t, std::int64_t>, std::size_t> bySizeAndTime;
+    for (std::size_t i = 0; i < indexed.size(); ++i) {
+        const auto& fp{ indexed[i].Fingerprint };
+        indexedPaths.insert(indexed[i].Path);
+        byInode.emplace(std::make_pair(fp.Device, fp.Inode), i);
+        bySizeAndTime.emplace(std::make_pair(fp.Size, fp.ModifiedNs), i);
+    }
+
+    // The indexed file is only gone if its path no longer leads to it.
+    const auto isGone = [](const Indexed& file) {
+        const auto current{ utils::fingerprint(file.Path, false) };
+        return !current || !current->sameInode(file.Fingerprint);
+    };
+
+    auto renameStmt{ prepareStatement("UPDATE Filepaths SET filepath = @PT WHERE id = @ID;") };
+    auto updateStmt{ prepareStatement("UPDATE FileFingerprints SET device = @DV, inode = @IN WHERE filepath_id = @ID;") };
+
+    beginTransaction();
+
+    FingerprintMatches matches;
+    std::set<std::pair<std::uint64_t, std::uint64_t>> listed;
+    utils::PathStore toRead;
+
+    paths.forEach([&](const std::string_view listedPath) {
+        const fs::path path{ listedPath };
+        const auto fp{ utils::fingerprint(path, false) };
+        // Left to the reader to fail on.
+        if (!fp) {
+            toRead.add(listedPath);
+            return;
+        }
+
+        if (!listed.emplace(fp->Device, fp->Inode).second) {
+            ++matches.Duplicates;
+            return;
+        }
+        if (indexedPaths.count(path.string()) > 0) {
+            toRead.add(listedPath);
+            return;
+        }
+
+        // Same inode: a rename if the old path is gone, else another way to the same file.
+        std::optional<std::size_t> renamed;
+        if (const auto it{ byInode.find({ fp->Device, fp->Inode }) }; it != byInode.cend() && !indexed[it->second].Moved) {
+            auto& file{ indexed[it->second] };
+            if (!isGone(file)) {
+                ++matches.Duplicates;
+                return;
+            }
+            if (file.Fingerprint.Size == fp->Size && file.Fingerprint.ModifiedNs == fp->ModifiedNs) {
+                renamed = it->second;
+            }
+        }
+
+        // Moved across filesystems (e.g. rsync -a, cp -p): same size, mtime and header.
+        if (!renamed) {
+            const auto [first, last]{ bySizeAndTime.equal_range({ fp->Size, fp->ModifiedNs }) };
+            std::optional<std::uint64_t> hash;
+            for (auto it = first; it != last && !renamed; ++it) {
+                auto& file{ indexed[it->second] };
+                if (file.Moved) {
+                    continue;
+                }
+                if (!hash) {
+                    hash = utils::headerHash(path);
+                }
+                if (hash && *hash == file.Fingerprint.HeaderHash && isGone(file)) {
+                    renamed = it->second;
+                }
+            }
+        }
+
+        if (!renamed) {
+            toRead.add(listedPath);
+            return;
+        }
+
+        auto& file{ indexed[*renamed] };
+        file.Moved = true;
+
+        sqlite3_bind_text(&(*renameStmt), 1, path.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(&(*renameStmt), 2, file.ID);
+        sqlite3_step(&(*renameStmt));
+        sqlite3_clear_bindings(&(*renameStmt));
+        sqlite3_reset(&(*renameStmt));
+
+        sqlite3_bind_int64(&(*updateStmt), 1, static_cast<sqlite3_int64>(fp->Device));
+        sqlite3_bind_int64(&(*updateStmt), 2, static_cast<sqlite3_int64>(fp->Inode));
+        sqlite3_bind_int64(&(*updateStmt), 3, file.ID);
+        sqlite3_step(&(*updateStmt));
+        sqlite3_clear_bindings(&(*updateStmt));
+        sqlite3_reset(&(*updateStmt));
+
+        ++matches.Renamed;
     });
+
+    endTransaction();
+
+    paths = std::move(toRead);
+
+    return matches;
+}
+
+/***********************************************************************************/
+FingerprintMatches Database::applyFingerprints(std::vector<fs::path>& paths) {
+    auto store{ utils::toPathStore(paths) };
+    // Listed twice under the same path.
+    const auto listedTwice{ store.duplicates() };
+
+    auto matches{ applyFingerprints(store) };
+    matches.Duplicates += listedTwice;
+    paths = store.toPaths();
+
+    return matches;
+}
+
+/***********************************************************************************/
+void Database::updateQuarantine(const ds::DatasetDesc& datasetDesc) {
+    createQuarantineTable();
+
+    // Counts start over whenever the file has changed.
+    auto upsertStmt{ prepareStatement("INSERT INTO Quarantine(filepath, mtime, failures, timeouts) VALUES (@PT, @MT, @FL, @TO) \
+                                       ON CONFLICT(filepath) DO UPDATE SET \
+                                       failures = CASE WHEN mtime = excluded.mtime THEN failures + excluded.failures ELSE excluded.failures END, \
+                                       timeouts = CASE WHEN mtime = excluded.mtime THEN timeouts + excluded.timeouts ELSE excluded.timeouts END, \
+                                       mtime = excluded.mtime;") };
+    auto deleteStmt{ prepareStatement("DELETE FROM Quarantine WHERE filepath = @PT;") };
+
+    std::unordered_set<std::string> listed;
+    {
+        auto selectStmt{ prepareStatement("SELECT filepath FROM Quarantine;") };
+        while (sqlite3_step(&(*selectStmt)) == SQLITE_ROW) {
+            listed.emplace(reinterpret_cast<const char*>(sqlite3_column_text(&(*selectStmt), 0)));
+        }
+    }
+
+    const std::unordered_set<std::string> timedOut(datasetDesc.timedOutFiles().cbegin(), datasetDesc.timedOutFiles().cend());
+
+    beginTransaction();
+
+    for (const auto& path : datasetDesc.failedFiles()) {
+        const auto mtime{ modificationTime(path) };
+        const auto isTimeout{ timedOut.count(path) > 0 };
+
+        sqlite3_bind_text(&(*upsertStmt), 1, path.c_str(), -1, SQLITE_TRANSIENT);
+        mtime ? sqlite3_bind_int64(&(*upsertStmt), 2, *mtime) : sqlite3_bind_null(&(*upsertStmt), 2);
+        sqlite3_bind_int64(&(*upsertStmt), 3, isTimeout ? 0 : 1);
+        sqlite3_bind_int64(&(*upsertStmt), 4, isTimeout ? 1 : 0);
+        sqlite3_step(&(*upsertStmt));
+        sqlite3_clear_bindings(&(*upsertStmt));
+        sqlite3_reset(&(*upsertStmt));
+    }
+
+    for (const auto& ncFile : datasetDesc.m_ncFiles) {
+        if (listed.count(ncFile.NCFilePath) == 0) {
+            continue;
+        }
+
+        sqlite3_bind_text(&(*deleteStmt), 1, ncFile.NCFilePath.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(&(*deleteStmt));
+        sqlite3_clear_bindings(&(*deleteStmt));
+        sqlite3_reset(&(*deleteStmt));
+    }
+
+    endTransaction();
+}
+
+/***********************************************************************************/
+std::optional<std::vector<std::string>> Database::selectFilepaths(const std::string& variable, const std::int64_t timestamp) {
+    auto selectStmt{ prepareStatement("SELECT f.filepath FROM TimestampVariableFilepath tvf \
+                                       INNER JOIN Variables v ON v.id = tvf.variable_id \
+                                       INNER JOIN Timestamps t ON t.id = tvf.timestamp_id \
+                                       INNER JOIN Filepaths f ON f.id = tvf.filepath_id \
+                                       WHERE v.variable = @VR AND t.timestamp = @TS ORDER BY f.filepath;") };
+    if (!selectStmt) {
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(&(*selectStmt), 1, variable.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(&(*selectStmt), 2, timestamp);
+
+    std::vector<std::string> filepaths;
+    while (sqlite3_step(&(*selectStmt)) == SQLITE_ROW) {
+        filepaths.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(&(*selectStmt), 0)));
+    }
+
+    return filepaths;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<std::string>> Database::selectFilepaths(const std::string& variable, const std::int64_t timestamp, const ds::BoundingBox& region) {
+    if (!hasTable("FileExtents")) {
+        return std::nullopt;
+    }
+
+    // The R*Tree narrows the files down without opening any of them.
+    auto selectStmt{ prepareStatement("SELECT f.filepath FROM FileExtents e \
+                                       INNER JOIN TimestampVariableFilepath tvf ON tvf.filepath_id = e.id \
+                                       INNER JOIN Variables v ON v.id = tvf.variable_id \
+                                       INNER JOIN Timestamps t ON t.id = tvf.timestamp_id \
+                                       INNER JOIN Filepaths f ON f.id = e.id \
+                                       WHERE e.max_lat >= @S AND e.min_lat <= @N AND e.max_lon >= @W AND e.min_lon <= @E \
+                                       AND v.variable = @VR AND t.timestamp = @TS ORDER BY f.filepath;") };
+    if (!selectStmt) {
+        return std::nullopt;
+    }
+
+    sqlite3_bind_double(&(*selectStmt), 1, region.MinLat);
+    sqlite3_bind_double(&(*selectStmt), 2, region.MaxLat);
+    sqlite3_bind_double(&(*selectStmt), 3, region.MinLon);
+    sqlite3_bind_double(&(*selectStmt), 4, region.MaxLon);
+    sqlite3_bind_text(&(*selectStmt), 5, variable.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(&(*selectStmt), 6, timestamp);
+
+    std::vector<std::string> filepaths;
+    while (sqlite3_step(&(*selectStmt)) == SQLITE_ROW) {
+        filepaths.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(&(*selectStmt), 0)));
+    }
+
+    return filepaths;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<std::int64_t>> Database::selectTimestamps(const std::string& variable) {
+    // A regular axis is spelled out from its coverage instead of scanning the join table.
+    if (const auto& coverage{ selectCoverage(variable) }; coverage && coverage->Step) {
+        std::vector<std::int64_t> timestamps;
+        timestamps.reserve(coverage->Count);
+        for (auto timestamp = coverage->Min; timestamp <= coverage->Max; timestamp += *coverage->Step) {
+            timestamps.push_back(timestamp);
+        }
+
+        return timestamps;
+    }
+
+    auto selectStmt{ prepareStatement("SELECT DISTINCT t.timestamp FROM TimestampVariableFilepath tvf \
+                                       INNER JOIN Variables v ON v.id = tvf.variable_id \
+                                       INNER JOIN Timestamps t ON t.id = tvf.timestamp_id \
+                                       WHERE v.variable = @VR ORDER BY t.timestamp;") };
+    if (!selectStmt) {
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(&(*selectStmt), 1, variable.c_str(), -1, SQLITE_TRANSIENT);
+
+    std::vector<std::int64_t> timestamps;
+    while (sqlite3_step(&(*selectStmt)) == SQLITE_ROW) {
+        timestamps.push_back(sqlite3_column_int64(&(*selectStmt), 0));
+    }
+
+    return timestamps;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<ds::DimensionDesc>> Database::selectDimensionSizes(const std::string& filepath) {
+    if (!hasTable("FileDimensions")) {
+        return std::nullopt;
+    }
+
+    auto selectStmt{ prepareStatement("SELECT d.name, fd.size FROM FileDimensions fd \
+                                       INNER JOIN Filepaths f ON f.id = fd.filepath_id \
+                                       INNER JOIN Dimensions d ON d.id = fd.dim_id \
+                                       WHERE f.filepath = @PT ORDER BY d.name;") };
+    if (!selectStmt) {
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(&(*selectStmt), 1, filepath.c_str(), -1, SQLITE_TRANSIENT);
+
+    std::vector<ds::DimensionDesc> dimensions;
+    while (sqlite3_step(&(*selectStmt)) == SQLITE_ROW) {
+        dimensions.push_back({ reinterpret_cast<const char*>(sqlite3_column_text(&(*selectStmt), 0)),
+                               static_cast<std::size_t>(sqlite3_column_int64(&(*selectStmt), 1)) });
+    }
+
+    return dimensions;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<double>> Database::selectCoordinateValues(const std::string& filepath, const std::string& name) {
+    if (!hasTable("FileCoordinates")) {
+        return std::nullopt;
+    }
+
+    auto selectStmt{ prepareStatement("SELECT c.count, c.vals FROM FileCoordinates fc \
+                                       INNER JOIN Filepaths f ON f.id = fc.filepath_id \
+                                       INNER JOIN CoordinateArrays c ON c.id = fc.array_id \
+                                       WHERE f.filepath = @PT AND fc.name = @NM;") };
+    if (!selectStmt) {
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(&(*selectStmt), 1, filepath.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(&(*selectStmt), 2, name.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(&(*selectStmt)) != SQLITE_ROW) {
+        return std::nullopt;
+    }
+
+    const auto count{ static_cast<std::size_t>(sqlite3_column_int64(&(*selectStmt), 0)) };
+    const auto* blob{ sqlite3_column_blob(&(*selectStmt), 1) };
+    if (static_cast<std::size_t>(sqlite3_column_bytes(&(*selectStmt), 1)) != count * sizeof(double)) {
+        return std::nullopt;
+    }
+
+    std::vector<double> values(count);
+    if (count > 0) {
+        std::memcpy(values.data(), blob, count * sizeof(double));
+    }
+
+    return values;
+}
+
+/***********************************************************************************/
+std::optional<ds::StorageLayout> Database::selectStorageLayout(const std::string& filepath, const std::string& variable) {
+    if (!hasTable("FileSchemas")) {
+        return std::nullopt;
+    }
+
+    auto selectStmt{ prepareStatement("SELECT l.storage, l.chunk_sizes, l.deflate_level, l.shuffle, l.fill_value FROM FileSchemas fs \
+                                       INNER JOIN Filepaths f ON f.id = fs.filepath_id \
+                                       INNER JOIN SchemaLayouts l ON l.schema_id = fs.schema_id \
+                                       INNER JOIN Variables v ON v.id = l.variable_id \
+                                       WHERE f.filepath = @PT AND v.variable = @VR;") };
+    if (!selectStmt) {
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(&(*selectStmt), 1, filepath.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(&(*selectStmt), 2, variable.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(&(*selectStmt)) != SQLITE_ROW) {
+        return std::nullopt;
+    }
+
+    ds::StorageLayout layout;
+    layout.Storage = reinterpret_cast<const char*>(sqlite3_column_text(&(*selectStmt), 0));
+    std::istringstream chunkSizes{ reinterpret_cast<const char*>(sqlite3_column_text(&(*selectStmt), 1)) };
+    for (std::string size; std::getline(chunkSizes, size, ',');) {
+        layout.ChunkSizes.push_back(std::stoull(size));
+    }
+    layout.DeflateLevel = sqlite3_column_int(&(*selectStmt), 2);
+    layout.Shuffle = sqlite3_column_int(&(*selectStmt), 3) != 0;
+    if (sqlite3_column_type(&(*selectStmt), 4) != SQLITE_NULL) {
+        layout.FillValue = sqlite3_column_double(&(*selectStmt), 4);
+    }
+
+    return layout;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<std::string>> Database::selectVariables() {
+    auto selectStmt{ prepareStatement("SELECT variable FROM Variables ORDER BY variable;") };
+    if (!selectStmt) {
+        return std::nullopt;
+    }
+
+    std::vector<std::string> variables;
+    while (sqlite3_step(&(*selectStmt)) == SQLITE_ROW) {
+        variables.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(&(*selectStmt), 0)));
+    }
+
+    return variables;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<std::pair<std::int64_t, std::string>>> Database::selectVariableNames() {
+    return selectIDPairs("SELECT id, variable FROM Variables;");
+}
+
+/***********************************************************************************/
+std::optional<std::vector<std::pair<std::int64_t, std::string>>> Database::selectFilepathNames() {
+    return selectIDPairs("SELECT id, filepath FROM Filepaths;");
+}
+
+/***********************************************************************************/
+bool Database::scanJoinTable(const std::function<void(std::int64_t, std::int64_t, std::int64_t)>& onRow) {
+    auto selectStmt{ prepareStatement("SELECT tvf.variable_id, t.timestamp, tvf.filepath_id FROM TimestampVariableFilepath tvf \
+                                       INNER JOIN Timestamps t ON t.id = tvf.timestamp_id;") };
+    if (!selectStmt) {
+        return false;
+    }
+
+    auto res{ SQLITE_ROW };
+    while ((res = sqlite3_step(&(*selectStmt))) == SQLITE_ROW) {
+        onRow(sqlite3_column_int64(&(*selectStmt), 0), sqlite3_column_int64(&(*selectStmt), 1), sqlite3_column_int64(&(*selectStmt), 2));
+    }
+    if (res != SQLITE_DONE) {
+        printErrorMsg();
+        return false;
+    }
+
+    return true;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<std::pair<std::int64_t, std::string>>> Database::selectIDPairs(const std::string& sqlStatement) {
+    auto selectStmt{ prepareStatement(sqlStatement) };
+    if (!selectStmt) {
+        return std::nullopt;
+    }
+
+    std::vector<std::pair<std::int64_t, std::string>> pairs;
+    auto res{ SQLITE_ROW };
+    while ((res = sqlite3_step(&(*selectStmt))) == SQLITE_ROW) {
+        pairs.emplace_back(sqlite3_column_int64(&(*selectStmt), 0), reinterpret_cast<const char*>(sqlite3_column_text(&(*selectStmt), 1)));
+    }
+    if (res != SQLITE_DONE) {
+        printErrorMsg();
+        return std::nullopt;
+    }
+
+    return pairs;
+}
+
+/***********************************************************************************/
+std::optional<VariableCoverage> Database::selectCoverage(const std::string& variable) {
+    if (!hasTable("VariableCoverage")) {
+        return std::nullopt;
+    }
+
+    auto selectStmt{ prepareStatement("SELECT c.min_timestamp, c.max_timestamp, c.timestamp_count, c.step FROM VariableCoverage c \
+                                       INNER JOIN Variables v ON v.id = c.variable_id WHERE v.variable = @VR;") };
+    if (!selectStmt) {
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(&(*selectStmt), 1, variable.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(&(*selectStmt)) != SQLITE_ROW) {
+        return std::nullopt;
+    }
+
+    VariableCoverage coverage;
+    coverage.Min = sqlite3_column_int64(&(*selectStmt), 0);
+    coverage.Max = sqlite3_column_int64(&(*selectStmt), 1);
+    coverage.Count = static_cast<std::size_t>(sqlite3_column_int64(&(*selectStmt), 2));
+    if (sqlite3_column_type(&(*selectStmt), 3) != SQLITE_NULL) {
+        coverage.Step = sqlite3_column_int64(&(*selectStmt), 3);
+    }
+
+    return coverage;
+}
+
+/***********************************************************************************/
+void Database::configureSQLITE() {
+    // sqlite3_config is variadic, so the lambda has to be converted to a plain
+    // function pointer by hand and followed by the (unused) pArg.
+    // It also only works before sqlite is initialized, i.e. once per process.
+    using logCallback_t = void(*)(void*, int, const char*);
+    static const auto configured{ [] {
+        const logCallback_t logCallback{ [](void* pArg, int iErrCode, const char* zMsg) {
+            std::cerr << "SQLITE Error: "  << iErrCode << " " << zMsg << std::endl;
+        } };
+        return sqlite3_config(SQLITE_CONFIG_LOG, logCallback, nullptr) == SQLITE_OK;
+    }() };
 }
 
 /***********************************************************************************/
 void Database::configureDBConnection() {
+    if (m_options.ReadOnly) {
+        // Wait out the indexer's commits instead of failing.
+        execStatement("PRAGMA busy_timeout = 5000");
+        return;
+    }
+
+    if (m_options.WAL) {
+        // Readers keep querying their own snapshot while we append to the log.
+        // Checkpoints are run by hand between transactions (see checkpointWAL).
+        execStatement("PRAGMA journal_mode = WAL");
+        execStatement("PRAGMA synchronous = NORMAL");
+        execStatement("PRAGMA wal_autocheckpoint = 0");
+        execStatement("PRAGMA busy_timeout = 5000");
+        execStatement("PRAGMA temp_store = MEMORY");
+        execStatement("PRAGMA foreign_keys = ON;");
+        execStatement("PRAGMA locking_mode = NORMAL");
+        return;
+    }
+
     execStatement("PRAGMA journal_mode = MEMORY");
     execStatement("PRAGMA temp_store = MEMORY");
     execStatement("PRAGMA synchronous = OFF");
     execStatement("PRAGMA foreign_keys = ON;");
-    execStatement("PRAGMA locking_mode = EXCLUSIVE");
+    // EXCLUSIVE only once the insert starts (see insertData). The quarantine and
+    // fingerprint writes before reading would otherwise lock readers out for the
+    // whole read phase.
+    execStatement("PRAGMA locking_mode = NORMAL");
+}
+
+/***********************************************************************************/
+void Database::closeConnection() {
+    if (m_DBHandle) {
+        if (!m_options.ReadOnly) {
+            const utils::TraceSpan span{ "index", "optimize" };
+            execStatement("PRAGMA optimize");
+        }
+        sqlite3_close(m_DBHandle);
+        m_DBHandle = nullptr;
+    }
+}
+
+/***********************************************************************************/
+void Database::execStatement(const std::string& sqlStatement, int (*callback)(void *, int, char **, char **) /* = nullptr */) {
+
+    char* errorMsg{ nullptr };
+    sqlite3_exec(m_DBHandle,
+                 sqlStatement.c_str(),
+                 callback,
+                 nullptr,
+                 &errorMsg);
+
+    if (errorMsg) {
+        std::cerr << "SQLITE Error: " << errorMsg << std::endl;
+        sqlite3_free(errorMsg);
+    }
+}
+
+/***********************************************************************************/
+Database::stmtPtr Database::prepareStatement(const std::string& sqlStatement) {
+    sqlite3_stmt* stmt{ nullptr };
+
+    const auto res{ 
+        sqlite3_prepare_v2(m_DBHandle, sqlStatement.data(), sqlStatement.length(), &stmt, nullptr)
+    };
+
+    if (res != SQLITE_OK) {
+        std::cerr << "Error preparing SQL statement: " << sqlStatement << ".\n Error code " << res << '\n';
+        printErrorMsg();
+        std::cerr << "https://www.sqlite.org/c3ref/c_abort.html" << '\n';
+    }
+
+    return stmtPtr(stmt, [](auto* s) { sqlite3_finalize(s); });
+}
+
+/***********************************************************************************/
+void Database::beginTransaction() {
+    execStatement("BEGIN TRANSACTION");
+    m_rowsInTransaction = 0;
+    m_transactionBegin = std::chrono::steady_clock::now();
+}
+
+/***********************************************************************************/
+void Database::endTransaction() {
+    execStatement("END TRANSACTION");
+
+    if (auto& tracer{ utils::Tracer::instance() }; tracer.enabled()) {
+        tracer.complete("sqlite", "transaction", m_transactionBegin, std::chrono::steady_clock::now(),
+                        m_rowsInTransaction > 0 ? std::to_string(m_rowsInTransaction) + " row(s)" : std::string{});
+    }
+    m_rowsInTransaction = 0;
+}
+
+/***********************************************************************************/
+void Database::commitIfTransactionFull(const std::size_t rowsWritten) {
+    m_rowsInTransaction += rowsWritten;
+
+    if (m_options.TransactionSize == 0 || m_rowsInTransaction < m_options.TransactionSize) {
+        return;
+    }
+
+    endTransaction();
+    checkpointWAL(SQLITE_CHECKPOINT_PASSIVE);
+    beginTransaction();
+}
+
+/***********************************************************************************/
+std::size_t Database::estimateSizeBytes(const ds::DatasetDesc& datasetDesc) const {
+    std::error_code e;
+    const auto existingSize{ fs::file_size(m_outputFilePath, e) };
+    std::size_t bytes{ e ? 0 : static_cast<std::size_t>(existingSize) };
+
+    for (const auto& ncFile : datasetDesc.m_ncFiles) {
+        // Filepaths table + its index.
+        bytes += 2 * ncFile.NCFilePath.native().size();
+        bytes += ncFile.Timestamps.size() * BYTES_PER_TIMESTAMP_ROW;
+        bytes += ncFile.Timestamps.size() * ncFile.Variables.size() * BYTES_PER_JOIN_ROW;
+    }
+
+    return bytes;
+}
+
+/***********************************************************************************/
+bool Database::moveToMemory() {
+    sqlite3* memHandle{ nullptr };
+    if (sqlite3_open(":memory:", &memHandle) != SQLITE_OK) {
+        std::cerr << sqlite3_errmsg(memHandle) << std::endl;
+        sqlite3_close(memHandle);
+        return false;
+    }
+
+    // Start from whatever is already on disk so an incremental run still adds to it.
+    auto* backup{ sqlite3_backup_init(memHandle, "main", m_DBHandle, "main") };
+    if (!backup) {
+        std::cerr << sqlite3_errmsg(memHandle) << std::endl;
+        sqlite3_close(memHandle);
+        return false;
+    }
+    sqlite3_backup_step(backup, -1);
+    if (sqlite3_backup_finish(backup) != SQLITE_OK) {
+        std::cerr << sqlite3_errmsg(memHandle) << std::endl;
+        sqlite3_close(memHandle);
+        return false;
+    }
+
+    if (!registerArrayTable(memHandle)) {
+        std::cerr << sqlite3_errmsg(memHandle) << std::endl;
+        sqlite3_close(memHandle);
+        return false;
+    }
+
+    // Readers keep using the old file until it gets replaced.
+    sqlite3_close(m_DBHandle);
+    m_DBHandle = memHandle;
+
+    execStatement("PRAGMA journal_mode = OFF");
+    execStatement("PRAGMA synchronous = OFF");
+    execStatement("PRAGMA temp_store = MEMORY");
+    execStatement("PRAGMA foreign_keys = ON;");
+
+    return true;
+}
+
+/***********************************************************************************/
+bool Database::publishFromMemory() {
+    const utils::TraceSpan span{ "sqlite", "publish from memory" };
+    const fs::path tempPath{ m_outputFilePath.string() + ".tmp" };
+    std::error_code e;
+    fs::remove(tempPath, e);
+
+    execStatement("PRAGMA optimize");
+
+    // VACUUM INTO writes a compact, defragmented copy instead of a page-for-page one.
+    auto vacuumStmt{ prepareStatement("VACUUM INTO @PT;") };
+    sqlite3_bind_text(&(*vacuumStmt), 1, tempPath.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(&(*vacuumStmt)) != SQLITE_DONE) {
+        printErrorMsg();
+        fs::remove(tempPath, e);
+        return false;
+    }
+
+    // Make sure the data is durable before it becomes visible under the real name.
+    const auto fd{ ::open(tempPath.c_str(), O_RDONLY) };
+    if (fd < 0 || ::fsync(fd) != 0) {
+        std::cerr << "Failed to sync " << tempPath << std::endl;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fs::remove(tempPath, e);
+        return false;
+    }
+    ::close(fd);
+
+    // SQLite would replay a WAL left by the old database into the new one. A
+    // non-empty one holds commits not checkpointed yet (a crash, or a writer
+    // still at it), so it's not ours to delete.
+    const fs::path walPath{ m_outputFilePath.string() + "-wal" };
+    const fs::path shmPath{ m_outputFilePath.string() + "-shm" };
+    if (const auto walSize{ fs::file_size(walPath, e) }; !e && walSize > 0) {
+        std::cerr << walPath << " holds changes to the old database. Open it once with sqlite3 to checkpoint them, "
+                  << "or remove it, then run again." << std::endl;
+        fs::remove(tempPath, e);
+        return false;
+    }
+    fs::remove(walPath, e);
+    fs::remove(shmPath, e);
+
+    fs::rename(tempPath, m_outputFilePath, e);
+    if (e) {
+        std::cerr << e.message() << std::endl;
+        fs::remove(tempPath, e);
+        return false;
+    }
+
+    // The rename itself is only durable once the directory is.
+    auto directory{ m_outputFilePath.parent_path() };
+    if (directory.empty()) {
+        directory = ".";
+    }
+    const auto dirFd{ ::open(directory.c_str(), O_RDONLY | O_DIRECTORY) };
+    if (dirFd < 0 || ::fsync(dirFd) != 0) {
+        std::cerr << "Failed to sync " << directory << std::endl;
+        if (dirFd >= 0) {
+            ::close(dirFd);
+        }
+        return false;
+    }
+    ::close(dirFd);
+
+    return true;
+}
+
+/***********************************************************************************/
+void Database::checkpointWAL(const int mode) {
+    if (!m_options.WAL) {
+        return;
+    }
+
+    // SQLITE_BUSY only means a reader is still on an older snapshot; the frames
+    // it pins get checkpointed on a later pass.
+    const auto res{ sqlite3_wal_checkpoint_v2(m_DBHandle, nullptr, mode, nullptr, nullptr) };
+    if (res != SQLITE_OK && res != SQLITE_BUSY) {
+        printErrorMsg();
+    }
+}
+
+/***********************************************************************************/
+bool Database::insertHistorical(const ds::DatasetDesc& datasetDesc) {
+
+    createHistoricalTable();
+    createVariableCoverageTable();
+
+    // Which timestamps are new can only be told before they go in.
+    const auto& newTimestamps{ selectNewTimestamps(datasetDesc) };
+
+    // WAL readers must never see half a file, so they get the file-at-a-time loader.
+    {
+        const utils::TraceSpan span{ "index", "join table" };
+        const utils::MemoryPhase phase{ "join table" };
+        if (m_options.WAL) {
+            insertHistoricalByFile(datasetDesc);
+        }
+        else if (!bulkLoadHistorical(datasetDesc)) {
+            return false;
+        }
+    }
+
+    {
+        const utils::TraceSpan span{ "index", "file extents" };
+        const utils::MemoryPhase phase{ "file extents" };
+        insertFileExtents(datasetDesc);
+    }
+    {
+        const utils::TraceSpan span{ "index", "dimensions and coordinates" };
+        const utils::MemoryPhase phase{ "dimensions and coordinates" };
+        insertDimensionsAndCoordinates(datasetDesc);
+    }
+    {
+        const utils::TraceSpan span{ "index", "storage layouts" };
+        const utils::MemoryPhase phase{ "storage layouts" };
+        insertStorageLayouts(datasetDesc);
+    }
+    if (m_options.Fingerprints) {
+        const utils::TraceSpan span{ "index", "fingerprints" };
+        const utils::MemoryPhase phase{ "fingerprints" };
+        insertFingerprints(datasetDesc);
+    }
+
+    // Committed after the rows, so a reader's coverage never runs ahead of the index.
+    const utils::TraceSpan span{ "index", "variable coverage" };
+    const utils::MemoryPhase phase{ "variable coverage" };
+    updateVariableCoverage(newTimestamps);
+
+    return true;
 }
 
-/***********************************************************************************/
-void Database::closeConnection() {
-    if (m_DBHandle) {
-        execStatement("PRAGMA optimize");
-        sqlite3_close(m_DBHandle);
-        m_DBHandle = nullptr;
+/***********************************************************************************/
+void Database::insertDimensionsAndCoordinates(const ds::DatasetDesc& datasetDesc) {
+    const auto hasDimensions{ std::any_of(datasetDesc.m_ncFiles.cbegin(), datasetDesc.m_ncFiles.cend(), [](const auto& ncFile) {
+        return !ncFile.Dimensions.empty();
+    }) };
+    if (!hasDimensions) {
+        return;
+    }
+
+    execStatement("CREATE TABLE IF NOT EXISTS FileDimensions ("
+                      "filepath_id INTEGER NOT NULL, "
+                      "dim_id INTEGER NOT NULL, "
+                      "size INTEGER NOT NULL, "
+                      "FOREIGN KEY (filepath_id) REFERENCES Filepaths(id), "
+                      "FOREIGN KEY (dim_id) REFERENCES Dimensions(id), "
+                      "PRIMARY KEY(filepath_id, dim_id)"
+                  ") WITHOUT ROWID;");
+    // One row per distinct array, however many files share it. vals holds count native doubles.
+    // hash only narrows the search; two arrays with the same hash are still two rows.
+    execStatement("CREATE TABLE IF NOT EXISTS CoordinateArrays ("
+                      "id INTEGER PRIMARY KEY, "
+                      "hash INTEGER NOT NULL, "
+                      "count INTEGER NOT NULL, "
+                      "vals BLOB NOT NULL"
+                  ");");
+    execStatement("CREATE INDEX IF NOT EXISTS IdxCoordinateArraysHash ON CoordinateArrays(hash);");
+    // dimensions is the comma-separated dimension names; their lengths are in FileDimensions.
+    execStatement("CREATE TABLE IF NOT EXISTS FileCoordinates ("
+                      "filepath_id INTEGER NOT NULL, "
+                      "name TEXT NOT NULL, "
+                      "dimensions TEXT NOT NULL, "
+                      "array_id INTEGER NOT NULL, "
+                      "FOREIGN KEY (filepath_id) REFERENCES Filepaths(id), "
+                      "FOREIGN KEY (array_id) REFERENCES CoordinateArrays(id), "
+                      "PRIMARY KEY(filepath_id, name)"
+                  ") WITHOUT ROWID;");
+
+    auto selectFilePathIDStmt{ prepareStatement("SELECT id FROM Filepaths WHERE filepath = @PT;") };
+    auto insertDimStmt{ prepareStatement("INSERT OR IGNORE INTO Dimensions(name) VALUES (@DM);") };
+    auto insertFileDimStmt{ prepareStatement("INSERT OR REPLACE INTO FileDimensions(filepath_id, dim_id, size) \
+                                              SELECT @FP, id, @SZ FROM Dimensions WHERE name = @DM;") };
+    auto selectArraysStmt{ prepareStatement("SELECT id, count, vals FROM CoordinateArrays WHERE hash = @HS;") };
+    auto insertArrayStmt{ prepareStatement("INSERT INTO CoordinateArrays(hash, count, vals) VALUES (@HS, @CT, @VL);") };
+    auto insertFileCoordStmt{ prepareStatement("INSERT OR REPLACE INTO FileCoordinates(filepath_id, name, dimensions, array_id) VALUES (@FP, @NM, @DS, @AR);") };
+
+    const auto sameValues = [](const std::vector<double>& values, const void* bytes, const std::size_t size) {
+        return size == values.size() * sizeof(double) && (size == 0 || std::memcmp(bytes, values.data(), size) == 0);
+    };
+
+    // Arrays already stored, by hash. A hash hit only counts if the values match too.
+    std::unordered_map<std::uint64_t, std::vector<std::pair<const std::vector<double>*, sqlite3_int64>>> storedArrays;
+    const auto arrayID = [&](const ds::CoordinateDesc& coordinate) -> sqlite3_int64 {
+        const auto& values{ *coordinate.Values };
+        auto& candidates{ storedArrays[coordinate.Hash] };
+        for (const auto& [stored, id] : candidates) {
+            if (stored == &values || sameValues(*stored, values.data(), values.size() * sizeof(double))) {
+                return id;
+            }
+        }
+
+        // Stored by an earlier run?
+        const auto hash{ static_cast<sqlite3_int64>(coordinate.Hash) };
+        sqlite3_int64 id{ 0 };
+        sqlite3_bind_int64(&(*selectArraysStmt), 1, hash);
+        while (id == 0 && sqlite3_step(&(*selectArraysStmt)) == SQLITE_ROW) {
+            if (sqlite3_column_int64(&(*selectArraysStmt), 1) == static_cast<sqlite3_int64>(values.size()) &&
+                sameValues(values, sqlite3_column_blob(&(*selectArraysStmt), 2), static_cast<std::size_t>(sqlite3_column_bytes(&(*selectArraysStmt), 2)))) {
+                id = sqlite3_column_int64(&(*selectArraysStmt), 0);
+            }
+        }
+        sqlite3_clear_bindings(&(*selectArraysStmt));
+        sqlite3_reset(&(*selectArraysStmt));
+
+        if (id == 0) {
+            sqlite3_bind_int64(&(*insertArrayStmt), 1, hash);
+            sqlite3_bind_int64(&(*insertArrayStmt), 2, static_cast<sqlite3_int64>(values.size()));
+            sqlite3_bind_blob64(&(*insertArrayStmt), 3, values.data(), values.size() * sizeof(double), SQLITE_STATIC);
+            if (sqlite3_step(&(*insertArrayStmt)) == SQLITE_DONE) {
+                id = sqlite3_last_insert_rowid(m_DBHandle);
+            }
+            sqlite3_clear_bindings(&(*insertArrayStmt));
+            sqlite3_reset(&(*insertArrayStmt));
+        }
+
+        if (id != 0) {
+            candidates.emplace_back(&values, id);
+        }
+
+        return id;
+    };
+
+    beginTransaction();
+
+    std::unordered_set<std::string> insertedDimensions;
+    for (const auto& ncFile : datasetDesc.m_ncFiles) {
+        sqlite3_bind_text(&(*selectFilePathIDStmt), 1, ncFile.NCFilePath.c_str(), -1, SQLITE_TRANSIENT);
+        const auto fileID{ sqlite3_step(&(*selectFilePathIDStmt)) == SQLITE_ROW ? sqlite3_column_int64(&(*selectFilePathIDStmt), 0) : 0 };
+        sqlite3_clear_bindings(&(*selectFilePathIDStmt));
+        sqlite3_reset(&(*selectFilePathIDStmt));
+        if (fileID == 0) {
+            continue;
+        }
+
+        for (const auto& dimension : ncFile.Dimensions) {
+            if (insertedDimensions.insert(dimension.Name).second) {
+                sqlite3_bind_text(&(*insertDimStmt), 1, dimension.Name.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_step(&(*insertDimStmt));
+                sqlite3_clear_bindings(&(*insertDimStmt));
+                sqlite3_reset(&(*insertDimStmt));
+            }
+
+            sqlite3_bind_int64(&(*insertFileDimStmt), 1, fileID);
+            sqlite3_bind_int64(&(*insertFileDimStmt), 2, static_cast<sqlite3_int64>(dimension.Size));
+            sqlite3_bind_text(&(*insertFileDimStmt), 3, dimension.Name.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_step(&(*insertFileDimStmt));
+            sqlite3_clear_bindings(&(*insertFileDimStmt));
+            sqlite3_reset(&(*insertFileDimStmt));
+        }
+
+        for (const auto& coordinate : ncFile.Coordinates) {
+            const auto id{ arrayID(coordinate) };
+            if (id == 0) {
+                continue;
+            }
+
+            std::string dimensions;
+            for (const auto& dimension : coordinate.Dimensions) {
+                dimensions += (dimensions.empty() ? "" : ",") + dimension;
+            }
+
+            sqlite3_bind_int64(&(*insertFileCoordStmt), 1, fileID);
+            sqlite3_bind_text(&(*insertFileCoordStmt), 2, coordinate.Name.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(&(*insertFileCoordStmt), 3, dimensions.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(&(*insertFileCoordStmt), 4, id);
+            sqlite3_step(&(*insertFileCoordStmt));
+            sqlite3_clear_bindings(&(*insertFileCoordStmt));
+            sqlite3_reset(&(*insertFileCoordStmt));
+        }
+    }
+
+    endTransaction();
+}
+
+/***********************************************************************************/
+void Database::insertFingerprints(const ds::DatasetDesc& datasetDesc) {
+    createFingerprintsTable();
+
+    auto insertStmt{ prepareStatement("INSERT OR REPLACE INTO FileFingerprints(filepath_id, device, inode, size, mtime, header_hash) \
+                                       SELECT id, @DV, @IN, @SZ, @MT, @HH FROM Filepaths WHERE filepath = @PT;") };
+
+    beginTransaction();
+
+    for (const auto& ncFile : datasetDesc.m_ncFiles) {
+        // The file was just read, so its first bytes are still in the page cache.
+        const auto fp{ utils::fingerprint(ncFile.NCFilePath, true) };
+        if (!fp) {
+            continue;
+        }
+
+        sqlite3_bind_int64(&(*insertStmt), 1, static_cast<sqlite3_int64>(fp->Device));
+        sqlite3_bind_int64(&(*insertStmt), 2, static_cast<sqlite3_int64>(fp->Inode));
+        sqlite3_bind_int64(&(*insertStmt), 3, fp->Size);
+        sqlite3_bind_int64(&(*insertStmt), 4, fp->ModifiedNs);
+        sqlite3_bind_int64(&(*insertStmt), 5, static_cast<sqlite3_int64>(fp->HeaderHash));
+        sqlite3_bind_text(&(*insertStmt), 6, ncFile.NCFilePath.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(&(*insertStmt));
+        sqlite3_clear_bindings(&(*insertStmt));
+        sqlite3_reset(&(*insertStmt));
+    }
+
+    endTransaction();
+}
+
+/***********************************************************************************/
+void Database::insertStorageLayouts(const ds::DatasetDesc& datasetDesc) {
+    const auto hasLayout{ std::any_of(datasetDesc.m_ncFiles.cbegin(), datasetDesc.m_ncFiles.cend(), [](const auto& ncFile) {
+        return std::any_of(ncFile.Variables.cbegin(), ncFile.Variables.cend(), [](const auto& variable) {
+            return variable.Layout.has_value();
+        });
+    }) };
+    if (!hasLayout) {
+        return;
+    }
+
+    // A dataset usually has a handful of schemas however many files it has,
+    // so the layouts are stored once per schema and each file points at its own.
+    execStatement("CREATE TABLE IF NOT EXISTS Schemas ("
+                      "id INTEGER PRIMARY KEY, "
+                      "signature TEXT UNIQUE NOT NULL, "
+                      "format TEXT NOT NULL"
+                  ");");
+    // chunk_sizes is comma-separated, one per dimension, and empty unless storage is "chunked".
+    execStatement("CREATE TABLE IF NOT EXISTS SchemaLayouts ("
+                      "schema_id INTEGER NOT NULL, "
+                      "variable_id INTEGER NOT NULL, "
+                      "storage TEXT NOT NULL, "
+                      "chunk_sizes TEXT NOT NULL, "
+                      "deflate_level INTEGER NOT NULL, "
+                      "shuffle INTEGER NOT NULL, "
+                      "fill_value REAL, "
+                      "FOREIGN KEY (schema_id) REFERENCES Schemas(id), "
+                      "FOREIGN KEY (variable_id) REFERENCES Variables(id), "
+                      "PRIMARY KEY(schema_id, variable_id)"
+                  ") WITHOUT ROWID;");
+    execStatement("CREATE TABLE IF NOT EXISTS FileSchemas ("
+                      "filepath_id INTEGER PRIMARY KEY, "
+                      "schema_id INTEGER NOT NULL, "
+                      "FOREIGN KEY (filepath_id) REFERENCES Filepaths(id), "
+                      "FOREIGN KEY (schema_id) REFERENCES Schemas(id)"
+                  ");");
+
+    const auto& variableIDs{ selectVariableIDs() };
+
+    auto selectFilePathIDStmt{ prepareStatement("SELECT id FROM Filepaths WHERE filepath = @PT;") };
+    auto insertSchemaStmt{ prepareStatement("INSERT OR IGNORE INTO Schemas(signature, format) VALUES (@SG, @FM);") };
+    auto selectSchemaStmt{ prepareStatement("SELECT id FROM Schemas WHERE signature = @SG;") };
+    auto insertLayoutStmt{ prepareStatement("INSERT OR REPLACE INTO SchemaLayouts(schema_id, variable_id, storage, chunk_sizes, deflate_level, shuffle, fill_value) \
+                                             VALUES (@SC, @VR, @ST, @CS, @DL, @SH, @FV);") };
+    auto insertFileSchemaStmt{ prepareStatement("INSERT OR REPLACE INTO FileSchemas(filepath_id, schema_id) VALUES (@FP, @SC);") };
+
+    beginTransaction();
+
+    std::unordered_map<std::string, sqlite3_int64> schemaIDs;
+    for (const auto& ncFile : datasetDesc.m_ncFiles) {
+        sqlite3_bind_text(&(*selectFilePathIDStmt), 1, ncFile.NCFilePath.c_str(), -1, SQLITE_TRANSIENT);
+        const auto fileID{ sqlite3_step(&(*selectFilePathIDStmt)) == SQLITE_ROW ? sqlite3_column_int64(&(*selectFilePathIDStmt), 0) : 0 };
+        sqlite3_clear_bindings(&(*selectFilePathIDStmt));
+        sqlite3_reset(&(*selectFilePathIDStmt));
+        if (fileID == 0) {
+            continue;
+        }
+
+        const auto& signature{ schemaSignature(ncFile) };
+        auto schema{ schemaIDs.find(signature) };
+        if (schema == schemaIDs.end()) {
+            sqlite3_bind_text(&(*insertSchemaStmt), 1, signature.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(&(*insertSchemaStmt), 2, ncFile.Format.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_step(&(*insertSchemaStmt));
+            const auto isNew{ sqlite3_changes(m_DBHandle) > 0 };
+            sqlite3_clear_bindings(&(*insertSchemaStmt));
+            sqlite3_reset(&(*insertSchemaStmt));
+
+            sqlite3_bind_text(&(*selectSchemaStmt), 1, signature.c_str(), -1, SQLITE_TRANSIENT);
+            const auto schemaID{ sqlite3_step(&(*selectSchemaStmt)) == SQLITE_ROW ? sqlite3_column_int64(&(*selectSchemaStmt), 0) : 0 };
+            sqlite3_clear_bindings(&(*selectSchemaStmt));
+            sqlite3_reset(&(*selectSchemaStmt));
+            if (schemaID == 0) {
+                continue;
+            }
+            schema = schemaIDs.emplace(signature, schemaID).first;
+
+            // Schemas from earlier runs already have their layouts.
+            for (const auto& variable : ncFile.Variables) {
+                const auto variableID{ variableIDs.find(variable.Name) };
+                if (!isNew || !variable.Layout || variableID == variableIDs.cend()) {
+                    continue;
+                }
+
+                const auto& layout{ *variable.Layout };
+                const auto& chunkSizes{ joinChunkSizes(layout.ChunkSizes) };
+                sqlite3_bind_int64(&(*insertLayoutStmt), 1, schemaID);
+                sqlite3_bind_int64(&(*insertLayoutStmt), 2, variableID->second);
+                sqlite3_bind_text(&(*insertLayoutStmt), 3, layout.Storage.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_text(&(*insertLayoutStmt), 4, chunkSizes.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_int(&(*insertLayoutStmt), 5, layout.DeflateLevel);
+                sqlite3_bind_int(&(*insertLayoutStmt), 6, layout.Shuffle ? 1 : 0);
+                if (layout.FillValue) {
+                    sqlite3_bind_double(&(*insertLayoutStmt), 7, *layout.FillValue);
+                }
+                sqlite3_step(&(*insertLayoutStmt));
+                sqlite3_clear_bindings(&(*insertLayoutStmt));
+                sqlite3_reset(&(*insertLayoutStmt));
+            }
+        }
+
+        sqlite3_bind_int64(&(*insertFileSchemaStmt), 1, fileID);
+        sqlite3_bind_int64(&(*insertFileSchemaStmt), 2, schema->second);
+        sqlite3_step(&(*insertFileSchemaStmt));
+        sqlite3_clear_bindings(&(*insertFileSchemaStmt));
+        sqlite3_reset(&(*insertFileSchemaStmt));
     }
+
+    endTransaction();
 }
 
 /***********************************************************************************/
-void Database::execStatement(const std::string& sqlStatement, int (*callback)(void *, int, char **, char **) /* = nullptr */) {
+void Database::insertFileExtents(const ds::DatasetDesc& datasetDesc) {
+    const auto hasExtent{ std::any_of(datasetDesc.m_ncFiles.cbegin(), datasetDesc.m_ncFiles.cend(), [](const auto& ncFile) {
+        return ncFile.Extent.has_value();
+    }) };
+    if (!hasExtent) {
+        return;
+    }
 
-    char* errorMsg{ nullptr };
-    sqlite3_exec(m_DBHandle,
-                 sqlStatement.c_str(),
-                 callback,
-                 nullptr,
-                 &errorMsg);
+    // id is Filepaths.id. R*Tree coordinates are 32-bit floats, rounded outwards.
+    execStatement("CREATE VIRTUAL TABLE IF NOT EXISTS FileExtents USING rtree(id, min_lat, max_lat, min_lon, max_lon);");
 
-    if (errorMsg) {
-        std::cerr << "SQLITE Error: " << errorMsg << std::endl;
-        sqlite3_free(errorMsg);
-    }
-}
+    auto insertExtentStmt{ prepareStatement("INSERT OR REPLACE INTO FileExtents(id, min_lat, max_lat, min_lon, max_lon) \
+                                             SELECT id, @S, @N, @W, @E FROM Filepaths WHERE filepath = @PT;") };
 
-/***********************************************************************************/
-Database::stmtPtr Database::prepareStatement(const std::string& sqlStatement) {
-    sqlite3_stmt* stmt{ nullptr };
+    beginTransaction();
 
-    const auto res{ 
-        sqlite3_prepare_v2(m_DBHandle, sqlStatement.data(), sqlStatement.length(), &stmt, nullptr)
-    };
+    for (const auto& ncFile : datasetDesc.m_ncFiles) {
+        if (!ncFile.Extent) {
+            continue;
+        }
 
-    if (res != SQLITE_OK) {
-        std::cerr << "Error preparing SQL statement: " << sqlStatement << ".\n Error code " << res << '\n';
-        printErrorMsg();
-        std::cerr << "https://www.sqlite.org/c3ref/c_abort.html" << '\n';
+        sqlite3_bind_double(&(*insertExtentStmt), 1, ncFile.Extent->MinLat);
+        sqlite3_bind_double(&(*insertExtentStmt), 2, ncFile.Extent->MaxLat);
+        sqlite3_bind_double(&(*insertExtentStmt), 3, ncFile.Extent->MinLon);
+        sqlite3_bind_double(&(*insertExtentStmt), 4, ncFile.Extent->MaxLon);
+        sqlite3_bind_text(&(*insertExtentStmt), 5, ncFile.NCFilePath.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(&(*insertExtentStmt));
+        sqlite3_clear_bindings(&(*insertExtentStmt));
+        sqlite3_reset(&(*insertExtentStmt));
     }
 
-    return stmtPtr(stmt, [](auto* s) { sqlite3_finalize(s); });
+    endTransaction();
 }
 
 /***********************************************************************************/
-void Database::insertHistorical(const ds::DatasetDesc& datasetDesc) {
-
-    createHistoricalTable();
-    auto insertFilePathStmt{ prepareStatement("INSERT OR IGNORE INTO Filepaths(filepath) VALUES (@PT);") };
+std::unordered_set<ds::VariableDesc> Database::insertVariables(const ds::DatasetDesc& datasetDesc) {
     auto insertVariableStmt{ prepareStatement("INSERT OR IGNORE INTO Variables(variable, units, longName, validMin, validMax) VALUES (@VS, @UT, @LN, @VN, @VX);") };
-    auto insertTimestampStmt{ prepareStatement("INSERT OR IGNORE INTO Timestamps(timestamp) VALUES (@TS);") };
     auto insertDimStmt{ prepareStatement("INSERT OR IGNORE INTO Dimensions(name) VALUES (@DM);") };
 
-    std::unordered_set<ds::timestamp_t> insertedTimestamps;
     std::unordered_set<std::string> insertedDimensions;
     std::unordered_set<ds::VariableDesc> insertedVariables;
 
-    execStatement("BEGIN TRANSACTION");
     for (const auto& ncFile : datasetDesc.m_ncFiles) {
-
-        // Insert filepath into its table to auto-generate the filepath_id.
-        sqlite3_bind_text(&(*insertFilePathStmt), 1, ncFile.NCFilePath.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(&(*insertFilePathStmt)); // Execute statement
-        sqlite3_clear_bindings(&(*insertFilePathStmt));
-        sqlite3_reset(&(*insertFilePathStmt));
-
         // Insert variables into their table
         for (const auto& variable : ncFile.Variables) {
             if (insertedVariables.count(variable) > 0) { // skip already inserted variables
@@ -179,25 +1419,264 @@ void Database::insertHistorical(const ds::DatasetDesc& datasetDesc) {
             
             insertedVariables.insert(variable);
         }
+    }
+
+    return insertedVariables;
+}
+
+/***********************************************************************************/
+void Database::insertHistoricalByFile(const ds::DatasetDesc& datasetDesc) {
+    auto insertFilePathStmt{ prepareStatement("INSERT OR IGNORE INTO Filepaths(filepath) VALUES (@PT);") };
+    auto selectFilePathIDStmt{ prepareStatement("SELECT id FROM Filepaths WHERE filepath = @PT;") };
+    // A file's whole time axis goes in with one statement.
+    auto insertTimestampsStmt{ prepareStatement("INSERT OR IGNORE INTO Timestamps(timestamp) SELECT c0 FROM int64_array(@TS);") };
+    // One statement per file and variable instead of one per timestamp.
+    auto insertJoinTableStmt{ prepareStatement("INSERT OR IGNORE INTO TimestampVariableFilepath(filepath_id, variable_id, timestamp_id) \
+                                                SELECT @FP, @VR, t.id FROM int64_array(@TS) a INNER JOIN Timestamps t ON t.timestamp = a.c0;") };
+
+    beginTransaction();
+    const auto& insertedVariables{ insertVariables(datasetDesc) };
+    const auto& variableIDs{ selectVariableIDs() };
+
+    // A file's join rows go in with its Filepaths and Timestamps rows, and
+    // commitIfTransactionFull() only commits between files, so readers never
+    // see a file without its rows.
+    std::vector<std::int64_t> timestamps;
+    for (const auto& ncFile : datasetDesc.m_ncFiles) {
+        // Insert filepath into its table to auto-generate the filepath_id.
+        sqlite3_bind_text(&(*insertFilePathStmt), 1, ncFile.NCFilePath.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(&(*insertFilePathStmt)); // Execute statement
+        sqlite3_clear_bindings(&(*insertFilePathStmt));
+        sqlite3_reset(&(*insertFilePathStmt));
+
+        sqlite3_bind_text(&(*selectFilePathIDStmt), 1, ncFile.NCFilePath.c_str(), -1, SQLITE_TRANSIENT);
+        const auto fileID{ sqlite3_step(&(*selectFilePathIDStmt)) == SQLITE_ROW ? sqlite3_column_int64(&(*selectFilePathIDStmt), 0) : 0 };
+        sqlite3_clear_bindings(&(*selectFilePathIDStmt));
+        sqlite3_reset(&(*selectFilePathIDStmt));
+
+        // Insert timestamps
+        timestamps.assign(ncFile.Timestamps.cbegin(), ncFile.Timestamps.cend());
+        const ArrayTableRows rows{ timestamps.data(), timestamps.size(), 1 };
+        sqlite3_bind_pointer(&(*insertTimestampsStmt), 1, const_cast<ArrayTableRows*>(&rows), ARRAY_TABLE_POINTER_TYPE, nullptr);
+        sqlite3_step(&(*insertTimestampsStmt));
+        sqlite3_clear_bindings(&(*insertTimestampsStmt));
+        sqlite3_reset(&(*insertTimestampsStmt));
+
+        for (const auto& variable : ncFile.Variables) {
+            const auto variableID{ variableIDs.find(variable.Name) };
+            if (fileID == 0 || variableID == variableIDs.end()) {
+                continue;
+            }
+
+            sqlite3_bind_int64(&(*insertJoinTableStmt), 1, fileID);
+            sqlite3_bind_int64(&(*insertJoinTableStmt), 2, variableID->second);
+            sqlite3_bind_pointer(&(*insertJoinTableStmt), 3, const_cast<ArrayTableRows*>(&rows), ARRAY_TABLE_POINTER_TYPE, nullptr);
+            sqlite3_step(&(*insertJoinTableStmt)); // Execute statement
+            sqlite3_clear_bindings(&(*insertJoinTableStmt));
+            sqlite3_reset(&(*insertJoinTableStmt));
+        }
+
+        commitIfTransactionFull(1 + timestamps.size() * (1 + ncFile.Variables.size()));
+    }
+    endTransaction();
+
+    populateVarsDimTable(insertedVariables);
+}
+
+/***********************************************************************************/
+bool Database::bulkLoadHistorical(const ds::DatasetDesc& datasetDesc) {
+    auto insertFilePathStmt{ prepareStatement("INSERT OR IGNORE INTO Filepaths(filepath) VALUES (@PT);") };
+    auto selectFilePathIDStmt{ prepareStatement("SELECT id FROM Filepaths WHERE filepath = @PT;") };
+    // Timestamps and join rows go in whole blocks at a time through int64_array().
+    auto insertTimestampsStmt{ prepareStatement("INSERT OR IGNORE INTO Timestamps(timestamp) SELECT c0 FROM int64_array(@TS);") };
+    auto selectTimestampIDsStmt{ prepareStatement("SELECT t.id FROM int64_array(@TS) a INNER JOIN Timestamps t ON t.timestamp = a.c0 ORDER BY t.timestamp;") };
+    auto insertJoinTableStmt{ prepareStatement("INSERT OR IGNORE INTO TimestampVariableFilepath(filepath_id, variable_id, timestamp_id) SELECT c0, c1, c2 FROM int64_array(@RW);") };
+
+    const auto selectID = [](sqlite3_stmt* stmt) {
+        sqlite3_int64 id{ 0 };
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            id = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_clear_bindings(stmt);
+        sqlite3_reset(stmt);
+
+        return id;
+    };
+
+    beginTransaction();
+    const auto& insertedVariables{ insertVariables(datasetDesc) };
+
+    // Filepaths and timestamps go in sorted, so the ids come out in the same
+    // order as the values and every unique index is appended to, not split.
+    std::vector<const ds::DataFileDesc*> files;
+    files.reserve(datasetDesc.m_ncFiles.size());
+    std::size_t totalTimestamps{ 0 };
+    for (const auto& ncFile : datasetDesc.m_ncFiles) {
+        files.push_back(&ncFile);
+        totalTimestamps += ncFile.Timestamps.size();
+    }
+    std::sort(files.begin(), files.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->NCFilePath < rhs->NCFilePath;
+    });
+
+    std::vector<sqlite3_int64> fileIDs(files.size());
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        sqlite3_bind_text(&(*insertFilePathStmt), 1, files[i]->NCFilePath.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(&(*insertFilePathStmt)); // Execute statement
+        sqlite3_clear_bindings(&(*insertFilePathStmt));
+        sqlite3_reset(&(*insertFilePathStmt));
+
+        sqlite3_bind_text(&(*selectFilePathIDStmt), 1, files[i]->NCFilePath.c_str(), -1, SQLITE_TRANSIENT);
+        fileIDs[i] = selectID(&(*selectFilePathIDStmt));
+    }
+
+    std::vector<ds::timestamp_t> timestamps;
+    timestamps.reserve(totalTimestamps);
+    for (const auto* ncFile : files) {
+        timestamps.insert(timestamps.end(), ncFile->Timestamps.cbegin(), ncFile->Timestamps.cend());
+    }
+    std::sort(timestamps.begin(), timestamps.end());
+    timestamps.erase(std::unique(timestamps.begin(), timestamps.end()), timestamps.end());
+
+    // Sorted and unique, so the ids come back in the same order as the values.
+    const std::vector<std::int64_t> timestampValues(timestamps.cbegin(), timestamps.cend());
+    const ArrayTableRows timestampRows{ timestampValues.data(), timestampValues.size(), 1 };
+
+    sqlite3_bind_pointer(&(*insertTimestampsStmt), 1, const_cast<ArrayTableRows*>(&timestampRows), ARRAY_TABLE_POINTER_TYPE, nullptr);
+    sqlite3_step(&(*insertTimestampsStmt));
+    sqlite3_reset(&(*insertTimestampsStmt));
+
+    std::vector<sqlite3_int64> timestampIDs;
+    timestampIDs.reserve(timestamps.size());
+    sqlite3_bind_pointer(&(*selectTimestampIDsStmt), 1, const_cast<ArrayTableRows*>(&timestampRows), ARRAY_TABLE_POINTER_TYPE, nullptr);
+    while (sqlite3_step(&(*selectTimestampIDsStmt)) == SQLITE_ROW) {
+        timestampIDs.push_back(sqlite3_column_int64(&(*selectTimestampIDsStmt), 0));
+    }
+    sqlite3_reset(&(*selectTimestampIDsStmt));
+
+    // Join rows look their timestamp id up by position; one missing id would shift all the rest.
+    if (timestampIDs.size() != timestamps.size()) {
+        std::cerr << "Read back " << timestampIDs.size() << " timestamp id(s) for " << timestamps.size()
+                  << " timestamp(s). Nothing was inserted." << std::endl;
+        execStatement("ROLLBACK TRANSACTION");
+        return false;
+    }
+
+    const auto& variableIDs{ selectVariableIDs() };
+
+    // Pack each (filepath, variable, timestamp) id tuple into one integer whose
+    // order matches the join table's primary key, then radix sort those.
+    const auto maxOf = [](const auto& ids) {
+        sqlite3_int64 max{ 0 };
+        for (const auto id : ids) {
+            max = std::max(max, id);
+        }
+        return max;
+    };
+    const auto fpBits{ utils::bitWidth(maxOf(fileIDs)) };
+    const auto tsBits{ utils::bitWidth(maxOf(timestampIDs)) };
+    std::uint64_t maxVariableID{ 0 };
+    for (const auto& [name, id] : variableIDs) {
+        maxVariableID = std::max<std::uint64_t>(maxVariableID, id);
+    }
+    const auto varBits{ utils::bitWidth(maxVariableID) };
+    const auto keyBits{ fpBits + tsBits + varBits };
+
+    // Sorted rows are staged here and written a block at a time.
+    std::vector<std::int64_t> block;
+    block.reserve(3 * BULK_INSERT_BLOCK_ROWS);
+    const auto writeBlock = [&] {
+        const ArrayTableRows rows{ block.data(), block.size() / 3, 3 };
+        sqlite3_bind_pointer(&(*insertJoinTableStmt), 1, const_cast<ArrayTableRows*>(&rows), ARRAY_TABLE_POINTER_TYPE, nullptr);
+        sqlite3_step(&(*insertJoinTableStmt)); // Execute statement
+        sqlite3_reset(&(*insertJoinTableStmt));
+        block.clear();
+    };
+    const auto insertJoinRow = [&](const std::int64_t fp, const std::int64_t var, const std::int64_t ts) {
+        block.insert(block.end(), { fp, var, ts });
+        if (block.size() == 3 * BULK_INSERT_BLOCK_ROWS) {
+            writeBlock();
+        }
+    };
+
+    // Primary key order, most significant first.
+    const auto clustered{ m_clusteredJoinTable };
+    const auto pack = [&](const std::uint64_t fp, const std::uint64_t var, const std::uint64_t ts) -> std::uint64_t {
+        return clustered ? (var << (tsBits + fpBits)) | (ts << fpBits) | fp
+                         : (fp << (varBits + tsBits)) | (var << tsBits) | ts;
+    };
+    const auto unpackAndInsert = [&](const std::uint64_t key) {
+        const auto fpMask{ (std::uint64_t{ 1 } << fpBits) - 1 };
+        const auto tsMask{ (std::uint64_t{ 1 } << tsBits) - 1 };
+        const auto varMask{ (std::uint64_t{ 1 } << varBits) - 1 };
+        if (clustered) {
+            insertJoinRow(key & fpMask, key >> (tsBits + fpBits), (key >> fpBits) & tsMask);
+        }
+        else {
+            insertJoinRow(key >> (varBits + tsBits), (key >> tsBits) & varMask, key & tsMask);
+        }
+    };
+
+    // Ids this large don't happen in practice, but keep going if they do.
+    using idTuple = std::array<sqlite3_int64, 3>;
+    const auto packable{ keyBits <= 64 };
+
+    std::vector<std::uint64_t> keys;
+    std::vector<idTuple> tuples;
+    const auto flush = [&] {
+        if (packable) {
+            utils::radixSort(keys, keyBits);
+            keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+            for (const auto key : keys) {
+                unpackAndInsert(key);
+            }
+            writeBlock();
+            keys.clear();
+            return;
+        }
+
+        std::sort(tuples.begin(), tuples.end());
+        tuples.erase(std::unique(tuples.begin(), tuples.end()), tuples.end());
+        for (const auto& tuple : tuples) {
+            clustered ? insertJoinRow(tuple[2], tuple[0], tuple[1]) : insertJoinRow(tuple[0], tuple[1], tuple[2]);
+        }
+        writeBlock();
+        tuples.clear();
+    };
+
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const auto fp{ fileIDs[i] };
 
-         // Insert timestamps
-        for (const auto ts : ncFile.Timestamps) {
-            if (insertedTimestamps.count(ts) > 0) {
+        for (const auto& variable : files[i]->Variables) {
+            const auto var{ variableIDs.find(variable.Name) };
+            if (var == variableIDs.end()) {
                 continue;
             }
 
-            sqlite3_bind_text(&(*insertTimestampStmt), 1, toString(ts).c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_step(&(*insertTimestampStmt));
-            sqlite3_clear_bindings(&(*insertTimestampStmt));
-            sqlite3_reset(&(*insertTimestampStmt));
+            for (const auto ts : files[i]->Timestamps) {
+                const auto tsID{ timestampIDs[std::distance(timestamps.cbegin(), std::lower_bound(timestamps.cbegin(), timestamps.cend(), ts))] };
+
+                if (packable) {
+                    keys.push_back(pack(fp, var->second, tsID));
+                }
+                else {
+                    clustered ? tuples.push_back({ var->second, tsID, fp }) : tuples.push_back({ fp, var->second, tsID });
+                }
+            }
+        }
 
-            insertedTimestamps.insert(ts);
+        // Bounds memory on huge loads; each chunk is still written in key order.
+        if (keys.size() + tuples.size() >= BULK_LOAD_CHUNK_ROWS) {
+            flush();
         }
     }
-    execStatement("END TRANSACTION");
+    flush();
+
+    endTransaction();
 
-    populateHistoricalJoinTable(datasetDesc);
     populateVarsDimTable(insertedVariables);
+
+    return true;
 }
 
 /***********************************************************************************/
@@ -254,31 +1733,16 @@ void Database::createVariablesDimensionsTable() {
 }
 
 /***********************************************************************************/
-void Database::populateHistoricalJoinTable(const ds::DatasetDesc& datasetDesc) {
-    auto insertJoinTableStmt{ prepareStatement("INSERT OR IGNORE INTO TimestampVariableFilepath(filepath_id, variable_id, timestamp_id) VALUES ((SELECT id FROM Filepaths WHERE filepath = @PT), \
-                                                                                                                                    (SELECT id FROM Variables WHERE variable = @VR), \
-                                                                                                                                    (SELECT id from Timestamps WHERE timestamp = @TS)); \
-                                                ")};
-
-    execStatement("BEGIN TRANSACTION");
+std::unordered_map<std::string, std::int64_t> Database::selectVariableIDs() {
+    auto selectVariableIDsStmt{ prepareStatement("SELECT id, variable FROM Variables;") };
 
-    for (const auto& ncFile : datasetDesc.m_ncFiles) {
-        for (const auto& variable : ncFile.Variables) {
-            for (const auto ts : ncFile.Timestamps) {
-                std::stringstream ss;
-                ss << ts;
-
-                sqlite3_bind_text(&(*insertJoinTableStmt), 1, ncFile.NCFilePath.c_str(), -1, SQLITE_TRANSIENT);
-                sqlite3_bind_text(&(*insertJoinTableStmt), 2, variable.Name.c_str(), -1, SQLITE_TRANSIENT);
-                sqlite3_bind_text(&(*insertJoinTableStmt), 3, ss.str().c_str(), -1, SQLITE_TRANSIENT);
-                sqlite3_step(&(*insertJoinTableStmt)); // Execute statement
-                sqlite3_clear_bindings(&(*insertJoinTableStmt));
-                sqlite3_reset(&(*insertJoinTableStmt));
-            }
-        }
+    std::unordered_map<std::string, std::int64_t> variableIDs;
+    while (sqlite3_step(&(*selectVariableIDsStmt)) == SQLITE_ROW) {
+        variableIDs.emplace(reinterpret_cast<const char*>(sqlite3_column_text(&(*selectVariableIDsStmt), 1)),
+                            sqlite3_column_int64(&(*selectVariableIDsStmt), 0));
     }
 
-    execStatement("END TRANSACTION");
+    return variableIDs;
 }
 
 /***********************************************************************************/
@@ -303,6 +1767,195 @@ void Database::populateVarsDimTable(const std::unordered_set<ds::VariableDesc>&
     execStatement("END TRANSACTION");
 }
 
+/***********************************************************************************/
+void Database::createFingerprintsTable() {
+    // header_hash is the hash of the file's first bytes (see utils::Fingerprint).
+    execStatement("CREATE TABLE IF NOT EXISTS FileFingerprints ("
+                      "filepath_id INTEGER PRIMARY KEY, "
+                      "device INTEGER NOT NULL, "
+                      "inode INTEGER NOT NULL, "
+                      "size INTEGER NOT NULL, "
+                      "mtime INTEGER NOT NULL, "
+                      "header_hash INTEGER NOT NULL, "
+                      "FOREIGN KEY (filepath_id) REFERENCES Filepaths(id)"
+                  ");");
+}
+
+/***********************************************************************************/
+void Database::createQuarantineTable() {
+    // Files are kept by path here rather than in Filepaths, since they were never indexed.
+    const auto createQuarantineTableQuery{
+        "CREATE TABLE IF NOT EXISTS Quarantine ("
+            "filepath TEXT PRIMARY KEY, "
+            "mtime INTEGER, "
+            "failures INTEGER NOT NULL DEFAULT 0, "
+            "timeouts INTEGER NOT NULL DEFAULT 0"
+        ");"
+    };
+
+    execStatement(createQuarantineTableQuery);
+}
+
+/***********************************************************************************/
+void Database::createVariableCoverageTable() {
+    const auto existed{ hasTable("VariableCoverage") };
+
+    // spacing is kept even when the axis has gaps, so filling them in makes it regular again.
+    const auto createVariableCoverageTableQuery{
+        "CREATE TABLE IF NOT EXISTS VariableCoverage ("
+            "variable_id INTEGER PRIMARY KEY, "
+            "min_timestamp INTEGER NOT NULL, "
+            "max_timestamp INTEGER NOT NULL, "
+            "timestamp_count INTEGER NOT NULL, "
+            "spacing INTEGER NOT NULL, "
+            "step INTEGER, "
+            "FOREIGN KEY (variable_id) REFERENCES Variables(id)"
+        ");"
+    };
+
+    execStatement(createVariableCoverageTableQuery);
+
+    if (existed || querySingleValue("SELECT EXISTS (SELECT 1 FROM TimestampVariableFilepath);") != "1") {
+        return;
+    }
+
+    // A database indexed before the table existed: one pass over the join table.
+    std::cout << "Building VariableCoverage from the existing index..." << std::endl;
+    const utils::TraceSpan span{ "index", "backfill variable coverage" };
+
+    auto selectStmt{ prepareStatement("SELECT DISTINCT tvf.variable_id, t.timestamp FROM TimestampVariableFilepath tvf \
+                                       INNER JOIN Timestamps t ON t.id = tvf.timestamp_id \
+                                       WHERE tvf.variable_id IS NOT NULL ORDER BY tvf.variable_id, t.timestamp;") };
+    auto insertStmt{ prepareStatement(INSERT_COVERAGE_QUERY) };
+
+    beginTransaction();
+
+    std::optional<std::int64_t> variableID;
+    CoverageRow row;
+    while (sqlite3_step(&(*selectStmt)) == SQLITE_ROW) {
+        const auto id{ sqlite3_column_int64(&(*selectStmt), 0) };
+        if (variableID && *variableID != id) {
+            writeCoverage(&(*insertStmt), *variableID, row);
+            row = {};
+        }
+        variableID = id;
+        addTimestamp(row, sqlite3_column_int64(&(*selectStmt), 1));
+    }
+    if (variableID) {
+        writeCoverage(&(*insertStmt), *variableID, row);
+    }
+
+    endTransaction();
+}
+
+/***********************************************************************************/
+std::unordered_map<std::string, std::vector<std::int64_t>> Database::selectNewTimestamps(const ds::DatasetDesc& datasetDesc) {
+    std::unordered_map<std::string, std::vector<std::int64_t>> timestamps;
+    for (const auto& ncFile : datasetDesc.m_ncFiles) {
+        for (const auto& variable : ncFile.Variables) {
+            auto& variableTimestamps{ timestamps[variable.Name] };
+            variableTimestamps.insert(variableTimestamps.end(), ncFile.Timestamps.cbegin(), ncFile.Timestamps.cend());
+        }
+    }
+
+    const auto& variableIDs{ selectVariableIDs() };
+    auto selectIndexedStmt{ prepareStatement("SELECT a.c0 FROM int64_array(@TS) a INNER JOIN Timestamps t ON t.timestamp = a.c0 \
+                                              WHERE EXISTS (SELECT 1 FROM TimestampVariableFilepath tvf WHERE tvf.variable_id = @VR AND tvf.timestamp_id = t.id) \
+                                              ORDER BY a.c0;") };
+
+    std::vector<std::int64_t> indexed;
+    std::vector<std::int64_t> added;
+    for (auto& [name, variableTimestamps] : timestamps) {
+        std::sort(variableTimestamps.begin(), variableTimestamps.end());
+        variableTimestamps.erase(std::unique(variableTimestamps.begin(), variableTimestamps.end()), variableTimestamps.end());
+
+        // A new variable has nothing indexed yet.
+        const auto variableID{ variableIDs.find(name) };
+        if (variableID == variableIDs.end()) {
+            continue;
+        }
+
+        const ArrayTableRows rows{ variableTimestamps.data(), variableTimestamps.size(), 1 };
+        sqlite3_bind_pointer(&(*selectIndexedStmt), 1, const_cast<ArrayTableRows*>(&rows), ARRAY_TABLE_POINTER_TYPE, nullptr);
+        sqlite3_bind_int64(&(*selectIndexedStmt), 2, variableID->second);
+
+        indexed.clear();
+        while (sqlite3_step(&(*selectIndexedStmt)) == SQLITE_ROW) {
+            indexed.push_back(sqlite3_column_int64(&(*selectIndexedStmt), 0));
+        }
+        sqlite3_clear_bindings(&(*selectIndexedStmt));
+        sqlite3_reset(&(*selectIndexedStmt));
+
+        if (indexed.empty()) {
+            continue;
+        }
+
+        added.clear();
+        std::set_difference(variableTimestamps.cbegin(), variableTimestamps.cend(), indexed.cbegin(), indexed.cend(), std::back_inserter(added));
+        variableTimestamps.swap(added);
+    }
+
+    return timestamps;
+}
+
+/***********************************************************************************/
+void Database::updateVariableCoverage(const std::unordered_map<std::string, std::vector<std::int64_t>>& newTimestamps) {
+    const auto& variableIDs{ selectVariableIDs() };
+    auto selectStmt{ prepareStatement("SELECT min_timestamp, max_timestamp, timestamp_count, spacing FROM VariableCoverage WHERE variable_id = @VR;") };
+    auto insertStmt{ prepareStatement(INSERT_COVERAGE_QUERY) };
+
+    beginTransaction();
+
+    for (const auto& [name, timestamps] : newTimestamps) {
+        const auto variableID{ variableIDs.find(name) };
+        if (timestamps.empty() || variableID == variableIDs.end()) {
+            continue;
+        }
+
+        CoverageRow row;
+        sqlite3_bind_int64(&(*selectStmt), 1, variableID->second);
+        if (sqlite3_step(&(*selectStmt)) == SQLITE_ROW) {
+            row.Min = sqlite3_column_int64(&(*selectStmt), 0);
+            row.Max = sqlite3_column_int64(&(*selectStmt), 1);
+            row.Count = sqlite3_column_int64(&(*selectStmt), 2);
+            row.Spacing = sqlite3_column_int64(&(*selectStmt), 3);
+        }
+        sqlite3_clear_bindings(&(*selectStmt));
+        sqlite3_reset(&(*selectStmt));
+
+        for (const auto timestamp : timestamps) {
+            addTimestamp(row, timestamp);
+        }
+        writeCoverage(&(*insertStmt), variableID->second, row);
+    }
+
+    endTransaction();
+}
+
+/***********************************************************************************/
+bool Database::checkTimestampFormat() {
+    const auto version{ querySingleValue("PRAGMA user_version;") };
+    if (version == std::to_string(TIMESTAMP_FORMAT_VERSION)) {
+        return true;
+    }
+
+    if (!hasTable("Timestamps")) {
+        execStatement("PRAGMA user_version = " + std::to_string(TIMESTAMP_FORMAT_VERSION) + ';');
+        return true;
+    }
+
+    std::cerr << m_outputFilePath << " holds timestamps in format " << version << ", not " << TIMESTAMP_FORMAT_VERSION
+              << " (seconds since 1950-01-01 decoded from the time units), so new files can't be added to it. "
+              << "Remove it and index the dataset again. If its files' times were all in seconds since 1950-01-01 "
+              << "already, PRAGMA user_version = " << TIMESTAMP_FORMAT_VERSION << " marks it as up to date instead." << std::endl;
+    return false;
+}
+
+/***********************************************************************************/
+bool Database::hasTable(const std::string& name) {
+    return querySingleValue("SELECT name FROM sqlite_master WHERE type = 'table' AND name = '" + name + "';") == name;
+}
+
 /***********************************************************************************/
 void Database::createHistoricalTable() {
     createDimensionsTable();
@@ -323,6 +1976,62 @@ void Database::createHistoricalTable() {
         ");"
     };
 
+    const auto createTimestampIndexQuery{
+        "CREATE INDEX IF NOT EXISTS idx_timestamp ON Timestamps(timestamp);"
+    };
+
+    const auto createFilePathIndexQuery{
+        "CREATE INDEX IF NOT EXISTS idx_filepath ON Filepaths(filepath);"
+    };
+
+    // No need to create an index on the Variables.variable column since it's
+    // always very small (i.e. < 30 rows).
+
+    execStatement(createFilepathsTableQuery);
+    execStatement(createTimestampTableQuery);
+    execStatement(createTimestampIndexQuery);
+    execStatement(createFilePathIndexQuery);
+
+    // Once a database has been clustered it stays that way.
+    const auto& joinTableSQL{ querySingleValue("SELECT sql FROM sqlite_master WHERE type = 'table' AND name = 'TimestampVariableFilepath';") };
+    const auto isClustered{ joinTableSQL.find("WITHOUT ROWID") != std::string::npos };
+
+    if (m_options.ClusteredJoinTable && !joinTableSQL.empty() && !isClustered) {
+        migrateToClusteredJoinTable();
+        m_clusteredJoinTable = true;
+        return;
+    }
+
+    m_clusteredJoinTable = m_options.ClusteredJoinTable || isClustered;
+    createJoinTable(m_clusteredJoinTable);
+}
+
+/***********************************************************************************/
+void Database::createJoinTable(const bool clustered) {
+    if (clustered) {
+        const auto createClusteredJoinTableQuery{
+            "CREATE TABLE IF NOT EXISTS TimestampVariableFilepath ("
+                "filepath_id INTEGER NOT NULL, "
+                "variable_id INTEGER NOT NULL, "
+                "timestamp_id INTEGER NOT NULL, "
+                "FOREIGN KEY (timestamp_id) REFERENCES Timestamps(id), "
+                "FOREIGN KEY (filepath_id) REFERENCES Filepaths(id), "
+                "FOREIGN KEY (variable_id) REFERENCES Variables(id), "
+                "PRIMARY KEY(variable_id, timestamp_id, filepath_id)"
+            ") WITHOUT ROWID;"
+        };
+
+        // Secondary indices of a WITHOUT ROWID table carry the whole primary key,
+        // so this one covers timestamp-only lookups without touching the table.
+        const auto createTimestampIndexQuery{
+            "CREATE INDEX IF NOT EXISTS idx_tvf_timestamp ON TimestampVariableFilepath(timestamp_id);"
+        };
+
+        execStatement(createClusteredJoinTableQuery);
+        execStatement(createTimestampIndexQuery);
+        return;
+    }
+
     const auto createJoinTableQuery{
         "CREATE TABLE IF NOT EXISTS TimestampVariableFilepath ("
             "filepath_id INTEGER, "
@@ -347,25 +2056,52 @@ void Database::createHistoricalTable() {
         "CREATE INDEX IF NOT EXISTS idx_foreign_key_time ON TimestampVariableFilepath(timestamp_id);"
     };
 
-    const auto createTimestampIndexQuery{
-        "CREATE INDEX IF NOT EXISTS idx_timestamp ON Timestamps(timestamp);"
-    };
-
-    const auto createFilePathIndexQuery{
-        "CREATE INDEX IF NOT EXISTS idx_filepath ON Filepaths(filepath);"
-    };
-
-    // No need to create an index on the Variables.variable column since it's
-    // always very small (i.e. < 30 rows).
-
-    execStatement(createFilepathsTableQuery);
-    execStatement(createTimestampTableQuery);
     execStatement(createJoinTableQuery);
     execStatement(createForeignKeyIndexFPQuery);
     execStatement(createForeignKeyIndexVarQuery);
     execStatement(createForeignKeyTimestampIndexQuery);
-    execStatement(createTimestampIndexQuery);
-    execStatement(createFilePathIndexQuery);
+}
+
+/***********************************************************************************/
+void Database::migrateToClusteredJoinTable() {
+    const utils::TraceSpan span{ "index", "cluster join table" };
+    std::cout << "Migrating TimestampVariableFilepath to the clustered layout..." << std::endl;
+
+    beginTransaction();
+
+    execStatement("ALTER TABLE TimestampVariableFilepath RENAME TO TimestampVariableFilepath_rowid;");
+    // The old indices follow the renamed table, and their names are needed below.
+    execStatement("DROP INDEX IF EXISTS idx_foreign_key_fp;");
+    execStatement("DROP INDEX IF EXISTS idx_foreign_key_var;");
+    execStatement("DROP INDEX IF EXISTS idx_foreign_key_time;");
+
+    createJoinTable(true);
+
+    // Rows that failed an id lookup were stored with NULLs; they never matched any query.
+    execStatement("INSERT OR IGNORE INTO TimestampVariableFilepath(filepath_id, variable_id, timestamp_id) "
+                  "SELECT filepath_id, variable_id, timestamp_id FROM TimestampVariableFilepath_rowid "
+                  "WHERE filepath_id IS NOT NULL AND variable_id IS NOT NULL AND timestamp_id IS NOT NULL "
+                  "ORDER BY variable_id, timestamp_id, filepath_id;");
+    execStatement("DROP TABLE TimestampVariableFilepath_rowid;");
+
+    endTransaction();
+
+    // Hand the old table's pages back to the filesystem.
+    std::cout << "Compacting database..." << std::endl;
+    execStatement("VACUUM;");
+}
+
+/***********************************************************************************/
+std::string Database::querySingleValue(const std::string& sqlStatement) {
+    auto stmt{ prepareStatement(sqlStatement) };
+
+    if (sqlite3_step(&(*stmt)) != SQLITE_ROW) {
+        return {};
+    }
+
+    const auto* text{ sqlite3_column_text(&(*stmt), 0) };
+
+    return text ? reinterpret_cast<const char*>(text) : std::string();
 }
 
 /***********************************************************************************/
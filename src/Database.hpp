@@ -1,11 +1,20 @@
 #pragma once
 
 #include "Utils/DeletedUniquePtr.hpp"
+#include "Utils/PathStore.hpp"
+#include "DataFileDesc.hpp"
 #include "Filesystem.hpp"
 #include "VariableDesc.hpp"
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 // Forward declarations
 struct sqlite3;
@@ -16,51 +25,203 @@ class DatasetDesc;
 
 namespace tsm {
 
+/// How the Timestamps table encodes time, kept in the database's user_version.
+///  0: the time coordinate's raw values, whatever their units (before CF decoding).
+///  1: seconds since 1950-01-01 UTC, decoded from the units and calendar (see CFTime.hpp).
+/// Databases that mix the two can't be queried, so open() won't add to a database of another version.
+constexpr int TIMESTAMP_FORMAT_VERSION{ 1 };
+
+/***********************************************************************************/
+struct [[nodiscard]] DatabaseOptions {
+    /// Use WAL journaling with NORMAL locking so readers can query while indexing.
+    bool WAL{ false };
+    /// Maximum number of rows per write transaction (0 = a single transaction).
+    std::size_t TransactionSize{ 0 };
+    /// Build in an in-memory database and publish it over the output file when done.
+    bool InMemory{ false };
+    /// Largest estimated database size (in MB) that will be built in memory.
+    std::size_t MemoryBudgetMB{ 4096 };
+    /// Store TimestampVariableFilepath as a WITHOUT ROWID table clustered on
+    /// (variable_id, timestamp_id, filepath_id). Existing databases get migrated.
+    bool ClusteredJoinTable{ false };
+    /// Open for lookups only: read-only, and without locking writers out.
+    bool ReadOnly{ false };
+    /// Record a fingerprint of every file inserted (see applyFingerprints()). Costs
+    /// a read of each new file's first bytes.
+    bool Fingerprints{ false };
+};
+
+/***********************************************************************************/
+/// Time axis of one variable, as kept in the VariableCoverage table.
+struct [[nodiscard]] VariableCoverage {
+    std::int64_t Min{ 0 };
+    std::int64_t Max{ 0 };
+    /// Distinct timestamps.
+    std::size_t Count{ 0 };
+    /// Set when the timestamps are exactly Min, Min + Step, ..., Max.
+    std::optional<std::int64_t> Step;
+};
+
+/***********************************************************************************/
+/// What Database::applyFingerprints() found.
+struct [[nodiscard]] FingerprintMatches {
+    /// Indexed files found under a new path; their rows were moved to it.
+    std::size_t Renamed{ 0 };
+    /// Paths of a file that's indexed (or listed) under another path as well.
+    std::size_t Duplicates{ 0 };
+};
+
 class Database {
     using stmtPtr = utils::deleted_unique_ptr<sqlite3_stmt>;
 
 public:
 
-    Database(const fs::path& outputPath, const std::string& datasetName);
+    Database(const fs::path& outputPath, const std::string& datasetName, const DatabaseOptions& options = {});
     ~Database();
 
-    /// Opens database.
+    /// Opens database. Fails (unless ReadOnly) if its timestamps aren't in TIMESTAMP_FORMAT_VERSION.
     [[nodiscard]] bool open();
-    ///
-    void insertData(const ds::DatasetDesc& datasetDesc);
+    /// Close connection to database. Also done on destruction; needed earlier to let
+    /// another connection at a database opened in exclusive locking mode.
+    void closeConnection();
+    /// False if the data didn't make it into the database file, e.g. the in-memory
+    /// build couldn't be published.
+    [[nodiscard]] bool insertData(const ds::DatasetDesc& datasetDesc);
+    /// Files to skip: they timed out, or failed QUARANTINE_AFTER_FAILURES runs in a row,
+    /// and haven't been modified since.
+    [[nodiscard]] std::unordered_set<std::string> selectQuarantinedFiles();
+    /// Records the files datasetDesc failed to read and releases the quarantined ones it did read.
+    void updateQuarantine(const ds::DatasetDesc& datasetDesc);
+    /// Takes out of paths the files that needn't be read, by their fingerprints:
+    ///  - another path to a file listed earlier or indexed under a path that still exists
+    ///    (same device and inode, i.e. a symlink or hardlink),
+    ///  - an indexed file whose old path is gone (same inode, or same size, mtime and
+    ///    header hash if it moved across filesystems). Its Filepaths row is moved to the
+    ///    new path, so everything indexed for it stays.
+    FingerprintMatches applyFingerprints(utils::PathStore& paths);
+    /// Same, for a list that isn't in a PathStore yet.
+    FingerprintMatches applyFingerprints(std::vector<fs::path>& paths);
+
+    // Lookups. Each returns std::nullopt if the query fails (e.g. nothing was indexed yet).
+
+    /// Paths of the files holding variable at timestamp, sorted.
+    [[nodiscard]] std::optional<std::vector<std::string>> selectFilepaths(const std::string& variable, const std::int64_t timestamp);
+    /// Same, restricted to files whose extent intersects region. Needs a database indexed with --spatial-extent.
+    [[nodiscard]] std::optional<std::vector<std::string>> selectFilepaths(const std::string& variable, const std::int64_t timestamp, const ds::BoundingBox& region);
+    /// Every timestamp of variable, ascending.
+    [[nodiscard]] std::optional<std::vector<std::int64_t>> selectTimestamps(const std::string& variable);
+    /// Dimension lengths of a file, sorted by name.
+    [[nodiscard]] std::optional<std::vector<ds::DimensionDesc>> selectDimensionSizes(const std::string& filepath);
+    /// Values of a file's coordinate variable. Needs a database indexed with --coordinates.
+    [[nodiscard]] std::optional<std::vector<double>> selectCoordinateValues(const std::string& filepath, const std::string& name);
+    /// Chunking, compression and fill value of variable in a file, as recorded for the file's schema.
+    /// Needs a database indexed with --storage-layouts.
+    [[nodiscard]] std::optional<ds::StorageLayout> selectStorageLayout(const std::string& filepath, const std::string& variable);
+    /// Every variable name, sorted.
+    [[nodiscard]] std::optional<std::vector<std::string>> selectVariables();
+    /// Time coverage of variable; a single row lookup. Nothing if the variable
+    /// isn't covered (unknown, or indexed before the table existed).
+    [[nodiscard]] std::optional<VariableCoverage> selectCoverage(const std::string& variable);
+
+    // Bulk reads, for building an in-memory copy of the index (see LookupIndex).
+
+    /// Id and name of every variable.
+    [[nodiscard]] std::optional<std::vector<std::pair<std::int64_t, std::string>>> selectVariableNames();
+    /// Id and path of every file.
+    [[nodiscard]] std::optional<std::vector<std::pair<std::int64_t, std::string>>> selectFilepathNames();
+    /// Calls onRow(variable id, timestamp, filepath id) for every row of the join table, in table order.
+    [[nodiscard]] bool scanJoinTable(const std::function<void(std::int64_t, std::int64_t, std::int64_t)>& onRow);
 
 private:
     ///
     void configureSQLITE();
     ///
     void configureDBConnection();
-    /// Close connection to database.
-    void closeConnection();
     /// Ideal for 1-shot SQL statements (like setting PRAGMAs, etc.).
     void execStatement(const std::string& sqlStatement, int (*callback)(void*, int, char**, char**) = nullptr);
     /// Ideal for repetitive SQL statements.
     stmtPtr prepareStatement(const std::string& sqlStatement);
     ///
-    void insertHistoricalCombined(const ds::DatasetDesc& datasetDesc);
+    void beginTransaction();
+    ///
+    void endTransaction();
+    /// Commits and starts a new transaction once TransactionSize rows have been written.
+    /// Only call this between files so readers never see a partially indexed file.
+    void commitIfTransactionFull(const std::size_t rowsWritten);
+    /// Rough upper bound of the database size (in bytes) once datasetDesc is inserted.
+    [[nodiscard]] std::size_t estimateSizeBytes(const ds::DatasetDesc& datasetDesc) const;
+    /// Copies the opened database into a :memory: connection and switches to it.
+    [[nodiscard]] bool moveToMemory();
+    /// Writes the in-memory database to a temp file under the output dir, then renames it over the output file.
+    [[nodiscard]] bool publishFromMemory();
+    /// Runs a WAL checkpoint with the given SQLITE_CHECKPOINT_* mode. No-op outside WAL mode.
+    void checkpointWAL(const int mode);
     ///
-    void insertHistorical(const ds::DatasetDesc& datasetDesc);
+    void insertHistoricalCombined(const ds::DatasetDesc& datasetDesc);
+    /// False if the join table couldn't be loaded; nothing of datasetDesc is written then.
+    [[nodiscard]] bool insertHistorical(const ds::DatasetDesc& datasetDesc);
+    /// Inserts the variables (and their dimensions) of every file. Returns the ones inserted.
+    std::unordered_set<ds::VariableDesc> insertVariables(const ds::DatasetDesc& datasetDesc);
+    /// Inserts file after file, committing at file boundaries (used in WAL mode).
+    void insertHistoricalByFile(const ds::DatasetDesc& datasetDesc);
+    /// Resolves every row to its ids first and inserts them sorted in primary key order.
+    /// False (and nothing written) if the ids can't be resolved.
+    [[nodiscard]] bool bulkLoadHistorical(const ds::DatasetDesc& datasetDesc);
     ///
     void createDimensionsTable();
     ///
     void createVariablesTable();
     ///
     void createVariablesDimensionsTable();
-    ///
-    void populateHistoricalJoinTable(const ds::DatasetDesc& datasetDesc);
+    /// Maps every variable name to its id.
+    [[nodiscard]] std::unordered_map<std::string, std::int64_t> selectVariableIDs();
     ///
     void populateVarsDimTable(const std::unordered_set<ds::VariableDesc>& insertedVariables);
     ///
+    void createQuarantineTable();
+    /// Creates VariableCoverage, filling it in from the join table if the database predates it.
+    void createVariableCoverageTable();
+    /// Distinct timestamps of each variable in datasetDesc that aren't indexed for it yet, sorted.
+    /// Must run before datasetDesc is inserted.
+    [[nodiscard]] std::unordered_map<std::string, std::vector<std::int64_t>> selectNewTimestamps(const ds::DatasetDesc& datasetDesc);
+    /// Stores each file's dimension lengths, and its coordinate arrays once per distinct hash.
+    void insertDimensionsAndCoordinates(const ds::DatasetDesc& datasetDesc);
+    /// Stores the fingerprint of every file in datasetDesc, for applyFingerprints() next time.
+    /// Only with DatabaseOptions::Fingerprints.
+    void insertFingerprints(const ds::DatasetDesc& datasetDesc);
+    ///
+    void createFingerprintsTable();
+    /// Stores each distinct schema (format and variable layouts) once, and which schema each file has.
+    void insertStorageLayouts(const ds::DatasetDesc& datasetDesc);
+    /// Stores the extent of every file that has one in the FileExtents R*Tree.
+    void insertFileExtents(const ds::DatasetDesc& datasetDesc);
+    /// Folds the timestamps from selectNewTimestamps into VariableCoverage.
+    void updateVariableCoverage(const std::unordered_map<std::string, std::vector<std::int64_t>>& newTimestamps);
+    /// Records TIMESTAMP_FORMAT_VERSION in a database with nothing indexed yet; false
+    /// (and why on stderr) if the database holds timestamps of another version.
+    [[nodiscard]] bool checkTimestampFormat();
+    /// Whether the database has a table called name.
+    [[nodiscard]] bool hasTable(const std::string& name);
+    ///
     void createHistoricalTable();
     ///
+    void createJoinTable(const bool clustered);
+    /// Rewrites an existing rowid join table into the clustered layout.
+    void migrateToClusteredJoinTable();
+    /// (id, text) of every row of a two-column query.
+    [[nodiscard]] std::optional<std::vector<std::pair<std::int64_t, std::string>>> selectIDPairs(const std::string& sqlStatement);
+    /// Returns the first column of the first row of the query, or an empty string.
+    [[nodiscard]] std::string querySingleValue(const std::string& sqlStatement);
+    ///
     void printErrorMsg();
 
     sqlite3* m_DBHandle{ nullptr };
     const fs::path m_outputFilePath;
+    const DatabaseOptions m_options;
+    std::size_t m_rowsInTransaction{ 0 };
+    /// When the open transaction began, for --trace.
+    std::chrono::steady_clock::time_point m_transactionBegin;
+    bool m_clusteredJoinTable{ false };
 };
 
 } // namespace tsm
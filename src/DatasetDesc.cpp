@@ -1,24 +1,123 @@
 #include "DatasetDesc.hpp"
 #include "FileReaders/NCFileReader.hpp"
+#include "FileReaders/ReaderPool.hpp"
 
+#include "Utils/IOCounters.hpp"
 #include "Utils/ProgressBar.hpp"
+#include "Utils/Trace.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <unordered_map>
 
 namespace tsm::ds {
 
 /***********************************************************************************/
-DatasetDesc::DatasetDesc(const std::vector<fs::path>& filePaths, const DATASET_TYPE type) : m_datasetType{ type } {
+namespace {
+
+    /// Values read so far, by hash. Arrays whose hashes collide are kept side by side.
+    using SharedValues = std::unordered_map<std::uint64_t, std::vector<std::shared_ptr<const std::vector<double>>>>;
+
+    /// Points desc's coordinates at the values already read with the same hash and
+    /// contents, so thousands of files with one depth axis or grid keep one copy of it in memory.
+    DataFileDesc shareCoordinates(DataFileDesc&& desc, SharedValues& shared) {
+        for (auto& coordinate : desc.Coordinates) {
+            const auto& values{ *coordinate.Values };
+            auto& candidates{ shared[coordinate.Hash] };
+            const auto match{ std::find_if(candidates.cbegin(), candidates.cend(), [&values](const auto& candidate) {
+                return candidate->size() == values.size() && (values.empty() || std::memcmp(candidate->data(), values.data(), values.size() * sizeof(double)) == 0);
+            }) };
+
+            if (match != candidates.cend()) {
+                coordinate.Values = *match;
+            }
+            else {
+                candidates.push_back(coordinate.Values);
+            }
+        }
+
+        return std::move(desc);
+    }
+}
+
+/***********************************************************************************/
+DatasetDesc::DatasetDesc(const std::vector<fs::path>& filePaths, const DATASET_TYPE type, const bool showProgress /* = true */, const ReadOptions& readOptions /* = {} */) : m_datasetType{ type } {
     m_ncFiles.reserve(filePaths.size());
+    const utils::TraceSpan batchSpan{ "phase", "read files", std::to_string(filePaths.size()) + " file(s)" };
+
+    std::optional<tsm::utils::ProgressBar> ownBar;
+    if (showProgress && !readOptions.Progress) {
+        ownBar.emplace(filePaths.size());
+    }
+    auto* pb{ readOptions.Progress ? readOptions.Progress : (ownBar ? &(*ownBar) : nullptr) };
+
+    std::size_t filesDone{ 0 };
+    // The readers report what they read, so the MB/s costs no extra stat() per file.
+    const auto tick = [&](const std::uint64_t bytesRead) {
+        if (readOptions.OnProgress) {
+            readOptions.OnProgress(++filesDone, filePaths.size());
+        }
+        if (pb) {
+            pb->addBytes(bytesRead);
+            ++(*pb);
+        }
+    };
+
+    const ReadFlags flags{ readOptions.SpatialExtent, readOptions.Coordinates, readOptions.StorageLayouts };
+    SharedValues sharedValues;
+
+    if (readOptions.Timeout.count() > 0) {
+        // Results arrive in completion order; keep the files in the order they were given.
+        std::vector<std::optional<DataFileDesc>> descs(filePaths.size());
+
+        ReaderPool pool{ readOptions.Workers, readOptions.Timeout, ReaderPool::ncFileReader(flags), readOptions.Concurrency };
+        pool.readAll(filePaths, [&](const std::size_t index, const READ_STATUS status, DataFileDesc&& desc, const std::uint64_t bytesRead) {
+            switch (status) {
+                case READ_STATUS::OK:
+                    descs[index].emplace(shareCoordinates(std::move(desc), sharedValues));
+                    break;
+                case READ_STATUS::TIMED_OUT:
+                    m_timedOutFiles.emplace_back(filePaths[index]);
+                    m_failedFiles.emplace_back(filePaths[index]);
+                    break;
+                case READ_STATUS::FAILED:
+                    m_failedFiles.emplace_back(filePaths[index]);
+                    break;
+            }
+            tick(bytesRead);
+        });
+
+        for (auto& desc : descs) {
+            if (desc) {
+                m_ncFiles.emplace_back(std::move(*desc));
+            }
+        }
+        return;
+    }
 
-    tsm::utils::ProgressBar pb{ filePaths.size() };
     for (auto i = 0; i < filePaths.size(); ++i) {
         //createAndAppendDataFileDesc(filePaths[i]);
-        NCFileReader r{ filePaths[i] };
-        if (const auto& desc{ r.getDataFileDesc() }; desc) {
-            m_ncFiles.emplace_back(desc);
+        const auto readBefore{ utils::threadBytesRead() };
+        {
+            const utils::TraceSpan span{ "read", "read file", filePaths[i] };
+            NCFileReader r{ filePaths[i], flags };
+            if (auto desc{ r.getDataFileDesc() }; desc) {
+                m_ncFiles.emplace_back(shareCoordinates(std::move(desc), sharedValues));
+            }
+            else {
+                m_failedFiles.emplace_back(filePaths[i]);
+            }
         }
 
-        ++pb;
+        tick(utils::threadBytesRead() - readBefore);
     }
 }
 
+/***********************************************************************************/
+DatasetDesc::DatasetDesc(std::vector<DataFileDesc>&& ncFiles, const DATASET_TYPE type) : m_ncFiles{ std::move(ncFiles) },
+                                                                                        m_datasetType{ type } {}
+
 } // namespace tsm::ds
@@ -7,11 +7,17 @@
 //#include <boost/date_time/gregorian/gregorian.hpp>
 //#include <boost/date_time/posix_time/posix_time.hpp>
 
+#include <chrono>
+#include <functional>
 #include <vector>
 
 namespace tsm {
 class Database;
 }
+namespace tsm::utils {
+class ConcurrencyController;
+class ProgressBar;
+}
 
 namespace tsm::ds {
 
@@ -20,13 +26,37 @@ enum DATASET_TYPE {
     FORECAST
 };
 
+/// Called from the reading thread after each file.
+using ProgressCallback = std::function<void(const std::size_t filesDone, const std::size_t filesTotal)>;
+
+struct [[nodiscard]] ReadOptions {
+    /// Deadline for reading one file. 0 reads every file in this process, one after the other.
+    std::chrono::seconds Timeout{ 0 };
+    /// Number of reader processes when Timeout is set (see ReaderPool).
+    std::size_t Workers{ 4 };
+    /// Decides how many of the Workers read at once. Kept by the caller, so what it learnt carries over between batches.
+    utils::ConcurrencyController* Concurrency{ nullptr };
+    ///
+    ProgressCallback OnProgress;
+    /// Bar to tick instead of drawing one per DatasetDesc (when reading in batches).
+    utils::ProgressBar* Progress{ nullptr };
+    /// Also read each file's lat/lon bounding box.
+    bool SpatialExtent{ false };
+    /// Also read the values of each file's coordinate variables.
+    bool Coordinates{ false };
+    /// Also read the storage layout of each file's variables.
+    bool StorageLayouts{ false };
+};
+
 class DatasetDesc {
 
 friend class ::tsm::Database;
 
 public:
     ///
-    DatasetDesc(const std::vector<fs::path>& filePaths, const DATASET_TYPE type);
+    DatasetDesc(const std::vector<fs::path>& filePaths, const DATASET_TYPE type, const bool showProgress = true, const ReadOptions& readOptions = {});
+    /// Wraps file descriptions that have already been read.
+    DatasetDesc(std::vector<DataFileDesc>&& ncFiles, const DATASET_TYPE type);
 
     explicit operator bool() const noexcept {
         return !m_ncFiles.empty();
@@ -44,9 +74,19 @@ public:
     inline auto isForecast() const noexcept {
         return m_datasetType == DATASET_TYPE::FORECAST;
     }
+    /// Files that couldn't be read and were left out.
+    inline const auto& failedFiles() const noexcept {
+        return m_failedFiles;
+    }
+    /// The failedFiles() that missed their read deadline.
+    inline const auto& timedOutFiles() const noexcept {
+        return m_timedOutFiles;
+    }
 
 private:
     std::vector<DataFileDesc> m_ncFiles;
+    std::vector<fs::path> m_failedFiles;
+    std::vector<fs::path> m_timedOutFiles;
 
     const DATASET_TYPE m_datasetType;
 };
@@ -14,6 +14,16 @@
 
 namespace tsm {
 
+/// What a reader reads besides the timestamps, variables and dimension sizes.
+struct [[nodiscard]] ReadFlags {
+    /// Lat/lon bounding box (--spatial-extent).
+    bool Extent{ false };
+    /// Values of the coordinate variables (--coordinates).
+    bool Coordinates{ false };
+    /// Chunking, compression and fill value of every variable (--storage-layouts).
+    bool StorageLayouts{ false };
+};
+
 template<class ReaderSubclass>
 class FileReader {
 
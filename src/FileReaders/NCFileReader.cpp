@@ -1,14 +1,45 @@
 #include "NCFileReader.hpp"
 
+#include "../Utils/CFTime.hpp"
+#include "../Utils/CoordinateRange.hpp"
+#include "../Utils/HashString.hpp"
+#include "../Utils/Logger.hpp"
+
 #include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <sstream>
 
 #include <ncDim.h>
 #include <ncVar.h>
+#include <netcdf.h>
 
 namespace tsm {
-    
+
 /***********************************************************************************/
-NCFileReader::NCFileReader(const fs::path& path) : m_path{path} {}
+namespace {
+
+    /// CF says units or standard_name; older files only get it right in the name.
+    bool isCoordinate(const std::string& name, const std::map<std::string, netCDF::NcVarAtt>& atts, const std::string& standardName,
+                      const std::vector<std::string>& units, const std::vector<std::string>& names) {
+        for (const auto& att : { "standard_name", "units" }) {
+            if (atts.count(att) == 0) {
+                continue;
+            }
+            std::string value;
+            atts.find(att)->second.getValues(value);
+            if (value == standardName || std::find(units.cbegin(), units.cend(), value) != units.cend()) {
+                return true;
+            }
+        }
+
+        return std::find(names.cbegin(), names.cend(), name) != names.cend();
+    }
+}
+
+/***********************************************************************************/
+NCFileReader::NCFileReader(const fs::path& path, const ReadFlags& flags /* = {} */) : m_path{path}, m_flags{flags} {}
 
 /***********************************************************************************/
 ds::DataFileDesc NCFileReader::getDataFileDesc_impl() {
@@ -16,15 +47,30 @@ ds::DataFileDesc NCFileReader::getDataFileDesc_impl() {
         return ds::DataFileDesc();
     }
     
+    // getTimestampValues() logs why there are none.
     const auto& timestamps{ getTimestampValues() };
     if (timestamps.empty()) {
-        std::cerr << "Error finding time dimension in " << m_path << ". This file will NOT be indexed." << std::endl;
         return ds::DataFileDesc();
     }
 
     const auto& variables{ getNCFileVariables() };
+    if (variables.empty()) {
+        utils::logError("No variables found in " + m_path.string() + ". This file will NOT be indexed.");
+        return ds::DataFileDesc();
+    }
+
+    std::optional<ds::BoundingBox> extent;
+    std::vector<ds::CoordinateDesc> coordinates;
+    if (m_flags.Extent || m_flags.Coordinates) {
+        getCoordinates(findTimeDim(), extent, coordinates);
+    }
+
+    // A file without coordinates is still indexed, it just can't be found by region.
+    if (m_flags.Extent && !extent) {
+        utils::logDebug("No latitude/longitude coordinates in " + m_path.string() + '.');
+    }
 
-    return { timestamps, variables, m_path };
+    return { timestamps, variables, m_path, extent, getDimensionSizes(), coordinates, getFormat() };
 }
 
 /***********************************************************************************/
@@ -35,11 +81,10 @@ bool NCFileReader::open_file() {
         return true;
     }
     catch (const netCDF::exceptions::NcException& e) {
-        std::cerr << "NetCDF error in: " << m_path << std::endl;
-        std::cerr << e.what() << std::endl;
+        utils::logError("NetCDF error in " + m_path.string() + ": " + e.what());
     } 
     catch (...) {
-        std::cerr << "Unhandled exception." << std::endl;
+        utils::logError("Unhandled exception opening " + m_path.string() + '.');
     }
 
     return false;
@@ -99,18 +144,88 @@ std::vector<ds::VariableDesc> NCFileReader::getNCFileVariables() const {
         });
 
 
-        variables.emplace_back(pair.first, units, longName, validMin, validMax, dimNames); // Variable names are stored in first value.
+        const auto layout{ m_flags.StorageLayouts ? getStorageLayout(pair.second) : std::nullopt };
+        variables.emplace_back(pair.first, units, longName, validMin, validMax, dimNames, layout); // Variable names are stored in first value.
     }
 
     return variables;
 }
 
+/***********************************************************************************/
+std::optional<ds::StorageLayout> NCFileReader::getStorageLayout(const netCDF::NcVar& var) const {
+    try {
+        ds::StorageLayout layout;
+
+        netCDF::NcVar::ChunkMode chunkMode{ netCDF::NcVar::nc_CONTIGUOUS };
+        var.getChunkingParameters(chunkMode, layout.ChunkSizes);
+        switch (chunkMode) {
+            case netCDF::NcVar::nc_CHUNKED:
+                layout.Storage = "chunked";
+                break;
+            case netCDF::NcVar::nc_COMPACT:
+                layout.Storage = "compact";
+                break;
+            default:
+                layout.Storage = "contiguous";
+                break;
+        }
+        if (chunkMode != netCDF::NcVar::nc_CHUNKED) {
+            layout.ChunkSizes.clear();
+        }
+
+        auto deflate{ false };
+        var.getCompressionParameters(layout.Shuffle, deflate, layout.DeflateLevel);
+        if (!deflate) {
+            layout.DeflateLevel = 0;
+        }
+
+        // Read through the attribute: it converts to double whatever the variable's type.
+        const auto& atts{ var.getAtts() };
+        if (const auto fill{ atts.find("_FillValue") }; fill != atts.cend()) {
+            double value{ 0.0 };
+            fill->second.getValues(&value);
+            layout.FillValue = value;
+        }
+
+        return layout;
+    }
+    catch (const netCDF::exceptions::NcException& e) {
+        utils::logWarning("Error reading the storage layout of " + var.getName() + " in " + m_path.string() + ": " + e.what());
+    }
+
+    return std::nullopt;
+}
+
+/***********************************************************************************/
+std::string NCFileReader::getFormat() const {
+    int format{ 0 };
+    if (nc_inq_format(m_file.getId(), &format) != NC_NOERR) {
+        return {};
+    }
+
+    switch (format) {
+        case NC_FORMAT_CLASSIC:
+            return "classic";
+        case NC_FORMAT_64BIT_OFFSET:
+            return "64-bit offset";
+        case NC_FORMAT_64BIT_DATA:
+            return "64-bit data";
+        case NC_FORMAT_NETCDF4:
+            return "netCDF-4";
+        case NC_FORMAT_NETCDF4_CLASSIC:
+            return "netCDF-4 classic model";
+        default:
+            return "unknown";
+    }
+}
+
 /***********************************************************************************/
 std::vector<ds::timestamp_t> NCFileReader::getTimestampValues() const {
    
     try {
         auto timeDim{ findTimeDim() };
         if (timeDim.empty()) {
+            utils::logError("Error finding time dimension in " + m_path.string() + ". This file will NOT be indexed.");
             return {};
         }
 
@@ -119,25 +234,157 @@ std::vector<ds::timestamp_t> NCFileReader::getTimestampValues() const {
         netCDF::NcVar var;
         m_file.getCoordVar(timeDim, dim, var);
 
-        ds::timestamp_t* v{ (ds::timestamp_t*)calloc(sizeof(ds::timestamp_t), dim.getSize()) };
+        const auto& atts{ var.getAtts() };
+        std::string units;
+        if (atts.count("units") > 0) {
+            atts.find("units")->second.getValues(units);
+        }
+        std::string calendar;
+        if (atts.count("calendar") > 0) {
+            atts.find("calendar")->second.getValues(calendar);
+        }
 
-        var.getVar(v);
+        std::vector<ds::timestamp_t> vals(dim.getSize());
+        if (vals.empty()) {
+            utils::logError("The time dimension " + timeDim + " of " + m_path.string() + " is empty. This file will NOT be indexed.");
+            return {};
+        }
 
-        std::vector<ds::timestamp_t> vals(v, v + dim.getSize());
+        // Raw values would be indexed alongside ones in TIMESTAMP_FORMAT_VERSION, so the file is left out.
+        if (units.empty()) {
+            utils::logError("The time variable " + timeDim + " of " + m_path.string() + " has no units. This file will NOT be indexed.");
+            return {};
+        }
+        const auto& timeUnits{ utils::cachedTimeUnits(units, calendar) };
+        if (!timeUnits) {
+            utils::logError("Can't decode the time units \"" + units + "\" (calendar \"" + calendar + "\") of " + m_path.string() + ". This file will NOT be indexed.");
+            return {};
+        }
 
-        free(v);
+        // Floating-point values (e.g. fractional days) are rounded, not truncated.
+        // Read as doubles either way when the conversion fails, to tell why.
+        std::vector<double> raw(vals.size());
+        bool converted{ false };
+        if (const auto type{ var.getType().getTypeClass() }; type == netCDF::NcType::nc_FLOAT || type == netCDF::NcType::nc_DOUBLE) {
+            var.getVar(raw.data());
+            converted = utils::toCanonicalTimestamps(*timeUnits, raw.data(), raw.size(), vals.data());
+        }
+        else {
+            std::vector<std::int64_t> integers(vals.size());
+            var.getVar(integers.data());
+            converted = utils::toCanonicalTimestamps(*timeUnits, integers.data(), integers.size(), vals.data());
+            if (!converted) {
+                std::copy(integers.cbegin(), integers.cend(), raw.begin());
+            }
+        }
+        if (converted) {
+            return vals;
+        }
 
-        return vals;
+        const auto notANumber{ std::find_if(raw.cbegin(), raw.cend(), [](const double v) { return !std::isfinite(v); }) };
+        if (notANumber != raw.cend()) {
+            utils::logError("Time value " + std::to_string(notANumber - raw.cbegin()) + " of " + m_path.string() + " is " + std::to_string(*notANumber) +
+                            ". This file will NOT be indexed.");
+        }
+        else {
+            // Either the earliest is before the epoch or the latest is out of range.
+            const auto [earliest, latest]{ std::minmax_element(raw.cbegin(), raw.cend()) };
+            ds::timestamp_t ignored;
+            std::ostringstream value;
+            if (!utils::toCanonicalTimestamps(*timeUnits, &(*earliest), 1, &ignored)) {
+                value << *earliest;
+                utils::logError("The times of " + m_path.string() + " go back to " + value.str() + ' ' + units + ", before " +
+                                std::to_string(utils::CANONICAL_EPOCH_YEAR) + "-01-01, the earliest a timestamp can hold. This file will NOT be indexed.");
+            }
+            else {
+                value << *latest;
+                utils::logError("The times of " + m_path.string() + " go up to " + value.str() + ' ' + units +
+                                ", too far ahead for a timestamp. This file will NOT be indexed.");
+            }
+        }
+        return {};
     }
     catch (const netCDF::exceptions::NcException& e) {
-        std::cerr << "Error in getting time dimension values:" << std::endl;
-        std::cerr << e.what() << std::endl;
+        utils::logError("Error in getting time dimension values from " + m_path.string() + ": " + e.what() + ". This file will NOT be indexed.");
     }
     catch (...) {
-        std::cerr << "Unhandled exception." << std::endl;
+        utils::logError("Unhandled exception reading the time dimension of " + m_path.string() + ". This file will NOT be indexed.");
     }
 
     return {};
 }
 
+/***********************************************************************************/
+std::vector<ds::DimensionDesc> NCFileReader::getDimensionSizes() const {
+    std::vector<ds::DimensionDesc> dimensions;
+
+    try {
+        for (const auto& [name, dim] : m_file.getDims()) {
+            dimensions.push_back({ name, dim.getSize() });
+        }
+    }
+    catch (const netCDF::exceptions::NcException& e) {
+        utils::logWarning("Error reading the dimensions of " + m_path.string() + ": " + e.what());
+    }
+
+    return dimensions;
+}
+
+/***********************************************************************************/
+void NCFileReader::getCoordinates(const std::string& timeDim, std::optional<ds::BoundingBox>& extent, std::vector<ds::CoordinateDesc>& coordinates) const {
+    std::optional<std::pair<double, double>> latRange;
+    std::optional<std::pair<double, double>> lonRange;
+
+    try {
+        for (const auto& [name, var] : m_file.getVars()) {
+            const auto& atts{ var.getAtts() };
+            const auto& dims{ var.getDims() };
+
+            const auto isLatitude{ isCoordinate(name, atts, "latitude", { "degrees_north", "degree_north", "degrees_N", "degree_N" }, { "lat", "latitude", "nav_lat" }) };
+            const auto isLongitude{ !isLatitude && isCoordinate(name, atts, "longitude", { "degrees_east", "degree_east", "degrees_E", "degree_E" }, { "lon", "longitude", "nav_lon" }) };
+            // A CF coordinate variable has the name of its only dimension.
+            const auto isAxis{ dims.size() == 1 && dims.front().getName() == name && name != timeDim };
+
+            const auto wanted{ (m_flags.Extent && ((isLatitude && !latRange) || (isLongitude && !lonRange))) ||
+                               (m_flags.Coordinates && (isAxis || isLatitude || isLongitude)) };
+            if (!wanted || dims.empty()) {
+                continue;
+            }
+
+            std::vector<std::size_t> shape(dims.size());
+            std::transform(dims.cbegin(), dims.cend(), shape.begin(), [](const auto& dim) {
+                return dim.getSize();
+            });
+            auto values{ std::make_shared<std::vector<double>>(std::accumulate(shape.cbegin(), shape.cend(), std::size_t{ 1 }, std::multiplies<>())) };
+            if (!values->empty()) {
+                var.getVar(values->data());
+            }
+
+            if (m_flags.Extent && isLatitude && !latRange) {
+                latRange = utils::coordinateRange(*values, -90.0, 90.0);
+            }
+            if (m_flags.Extent && isLongitude && !lonRange) {
+                lonRange = utils::coordinateRange(*values, -180.0, 360.0, 180.0);
+            }
+
+            if (m_flags.Coordinates) {
+                std::vector<std::string> dimNames(dims.size());
+                std::transform(dims.cbegin(), dims.cend(), dimNames.begin(), [](const auto& dim) {
+                    return dim.getName();
+                });
+
+                const auto hash{ utils::hashValues(*values, utils::hashValues(shape)) };
+                coordinates.push_back({ name, dimNames, hash, std::move(values) });
+            }
+        }
+    }
+    catch (const netCDF::exceptions::NcException& e) {
+        utils::logWarning("Error reading the coordinates of " + m_path.string() + ": " + e.what());
+    }
+
+    if (latRange && lonRange) {
+        extent = ds::BoundingBox{ latRange->first, latRange->second, lonRange->first, lonRange->second };
+    }
+}
+
 } // namespace tsm
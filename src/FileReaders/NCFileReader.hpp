@@ -15,7 +15,7 @@ class NCFileReader : public FileReader<NCFileReader> {
 
 public:
     ///
-    explicit NCFileReader(const fs::path& path);
+    explicit NCFileReader(const fs::path& path, const ReadFlags& flags = {});
     ///
     ~NCFileReader() {
         m_file.close();
@@ -33,8 +33,18 @@ private:
     [[nodiscard]] std::vector<ds::VariableDesc> getNCFileVariables() const;
     ///
     [[nodiscard]] std::vector<ds::timestamp_t> getTimestampValues() const;
+    ///
+    [[nodiscard]] std::vector<ds::DimensionDesc> getDimensionSizes() const;
+    /// Chunking, compression and fill value of var.
+    [[nodiscard]] std::optional<ds::StorageLayout> getStorageLayout(const netCDF::NcVar& var) const;
+    ///
+    [[nodiscard]] std::string getFormat() const;
+    /// Reads the coordinate variables the flags ask for: the bounding box of the
+    /// latitude and longitude (if there are any) and/or the values of every one.
+    void getCoordinates(const std::string& timeDim, std::optional<ds::BoundingBox>& extent, std::vector<ds::CoordinateDesc>& coordinates) const;
 
     const fs::path m_path;
+    const ReadFlags m_flags;
     netCDF::NcFile m_file;
 };
 
@@ -0,0 +1,640 @@
+#include "ReaderPool.hpp"
+
+#include "NCFileReader.hpp"
+#include "../Utils/ConcurrencyController.hpp"
+#include "../Utils/IOCounters.hpp"
+#include "../Utils/Logger.hpp"
+#include "../Utils/Trace.hpp"
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace tsm {
+
+/***********************************************************************************/
+namespace {
+
+    // Messages between the pool and its workers are length-prefixed frames:
+    //   request:  index, path
+    //   response: index, ok, timestamps, variables (with storage layouts), extent, dimensions, coordinates, format,
+    //             bytes read, captured log messages
+
+    class FrameWriter {
+
+    public:
+        template<typename T>
+        void put(const T value) {
+            static_assert(std::is_arithmetic_v<T>);
+            m_bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void put(const std::string& value) {
+            put(static_cast<std::uint64_t>(value.size()));
+            m_bytes.append(value);
+        }
+
+        /// In one go: coordinate arrays run to millions of values.
+        void put(const std::vector<double>& values) {
+            put(static_cast<std::uint64_t>(values.size()));
+            m_bytes.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+        }
+
+        [[nodiscard]] const std::string& bytes() const noexcept {
+            return m_bytes;
+        }
+
+    private:
+        std::string m_bytes;
+    };
+
+    class FrameReader {
+
+    public:
+        explicit FrameReader(const std::string& bytes) : m_bytes{ bytes } {}
+
+        template<typename T>
+        [[nodiscard]] bool get(T& value) {
+            static_assert(std::is_arithmetic_v<T>);
+            if (m_bytes.size() - m_pos < sizeof(T)) {
+                return false;
+            }
+            std::memcpy(&value, m_bytes.data() + m_pos, sizeof(T));
+            m_pos += sizeof(T);
+
+            return true;
+        }
+
+        [[nodiscard]] bool get(std::string& value) {
+            std::uint64_t size{ 0 };
+            if (!get(size) || m_bytes.size() - m_pos < size) {
+                return false;
+            }
+            value.assign(m_bytes, m_pos, size);
+            m_pos += size;
+
+            return true;
+        }
+
+        [[nodiscard]] bool get(std::vector<double>& values) {
+            std::uint64_t size{ 0 };
+            if (!get(size) || (m_bytes.size() - m_pos) / sizeof(double) < size) {
+                return false;
+            }
+            values.resize(size);
+            std::memcpy(values.data(), m_bytes.data() + m_pos, size * sizeof(double));
+            m_pos += size * sizeof(double);
+
+            return true;
+        }
+
+    private:
+        const std::string& m_bytes;
+        std::size_t m_pos{ 0 };
+    };
+
+    bool sendAll(const int socket, const char* data, std::size_t size) {
+        while (size > 0) {
+            // MSG_NOSIGNAL: a dead peer is an error to handle, not a SIGPIPE.
+            const auto sent{ send(socket, data, size, MSG_NOSIGNAL) };
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent <= 0) {
+                return false;
+            }
+            data += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+
+        return true;
+    }
+
+    bool receiveAll(const int socket, char* data, std::size_t size) {
+        while (size > 0) {
+            const auto received{ recv(socket, data, size, 0) };
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                return false;
+            }
+            data += received;
+            size -= static_cast<std::size_t>(received);
+        }
+
+        return true;
+    }
+
+    bool sendFrame(const int socket, const std::string& frame) {
+        const std::uint64_t size{ frame.size() };
+
+        return sendAll(socket, reinterpret_cast<const char*>(&size), sizeof(size)) && sendAll(socket, frame.data(), frame.size());
+    }
+
+    bool receiveFrame(const int socket, std::string& frame) {
+        std::uint64_t size{ 0 };
+        if (!receiveAll(socket, reinterpret_cast<char*>(&size), sizeof(size))) {
+            return false;
+        }
+        frame.resize(size);
+
+        return receiveAll(socket, frame.data(), frame.size());
+    }
+
+    void writeStorageLayout(FrameWriter& frame, const std::optional<ds::StorageLayout>& layout) {
+        frame.put(static_cast<std::uint8_t>(layout.has_value()));
+        if (!layout) {
+            return;
+        }
+        frame.put(layout->Storage);
+        frame.put(static_cast<std::uint64_t>(layout->ChunkSizes.size()));
+        for (const auto size : layout->ChunkSizes) {
+            frame.put(static_cast<std::uint64_t>(size));
+        }
+        frame.put(static_cast<std::int32_t>(layout->DeflateLevel));
+        frame.put(static_cast<std::uint8_t>(layout->Shuffle));
+        frame.put(static_cast<std::uint8_t>(layout->FillValue.has_value()));
+        frame.put(layout->FillValue.value_or(0.0));
+    }
+
+    bool readStorageLayout(FrameReader& frame, std::optional<ds::StorageLayout>& layout) {
+        std::uint8_t hasLayout{ 0 };
+        if (!frame.get(hasLayout)) {
+            return false;
+        }
+        if (!hasLayout) {
+            return true;
+        }
+
+        layout.emplace();
+        std::uint64_t count{ 0 };
+        if (!frame.get(layout->Storage) || !frame.get(count)) {
+            return false;
+        }
+        layout->ChunkSizes.resize(count);
+        for (auto& size : layout->ChunkSizes) {
+            std::uint64_t value{ 0 };
+            if (!frame.get(value)) {
+                return false;
+            }
+            size = value;
+        }
+
+        std::int32_t deflateLevel{ 0 };
+        std::uint8_t shuffle{ 0 };
+        std::uint8_t hasFillValue{ 0 };
+        double fillValue{ 0.0 };
+        if (!frame.get(deflateLevel) || !frame.get(shuffle) || !frame.get(hasFillValue) || !frame.get(fillValue)) {
+            return false;
+        }
+        layout->DeflateLevel = deflateLevel;
+        layout->Shuffle = shuffle != 0;
+        if (hasFillValue) {
+            layout->FillValue = fillValue;
+        }
+
+        return true;
+    }
+
+    void writeDataFileDesc(FrameWriter& frame, const ds::DataFileDesc& desc) {
+        frame.put(static_cast<std::uint64_t>(desc.Timestamps.size()));
+        for (const auto timestamp : desc.Timestamps) {
+            frame.put(static_cast<std::uint64_t>(timestamp));
+        }
+
+        frame.put(static_cast<std::uint64_t>(desc.Variables.size()));
+        for (const auto& variable : desc.Variables) {
+            frame.put(variable.Name);
+            frame.put(variable.Units);
+            frame.put(variable.LongName);
+            frame.put(variable.ValidMin);
+            frame.put(variable.ValidMax);
+            frame.put(static_cast<std::uint64_t>(variable.Dimensions.size()));
+            for (const auto& dimension : variable.Dimensions) {
+                frame.put(dimension);
+            }
+            writeStorageLayout(frame, variable.Layout);
+        }
+
+        frame.put(static_cast<std::uint8_t>(desc.Extent.has_value()));
+        if (desc.Extent) {
+            frame.put(desc.Extent->MinLat);
+            frame.put(desc.Extent->MaxLat);
+            frame.put(desc.Extent->MinLon);
+            frame.put(desc.Extent->MaxLon);
+        }
+
+        frame.put(static_cast<std::uint64_t>(desc.Dimensions.size()));
+        for (const auto& dimension : desc.Dimensions) {
+            frame.put(dimension.Name);
+            frame.put(static_cast<std::uint64_t>(dimension.Size));
+        }
+
+        frame.put(static_cast<std::uint64_t>(desc.Coordinates.size()));
+        for (const auto& coordinate : desc.Coordinates) {
+            frame.put(coordinate.Name);
+            frame.put(static_cast<std::uint64_t>(coordinate.Dimensions.size()));
+            for (const auto& dimension : coordinate.Dimensions) {
+                frame.put(dimension);
+            }
+            frame.put(coordinate.Hash);
+            frame.put(*coordinate.Values);
+        }
+
+        frame.put(desc.Format);
+    }
+
+    bool readDataFileDesc(FrameReader& frame, const fs::path& path, std::optional<ds::DataFileDesc>& desc) {
+        std::uint64_t count{ 0 };
+        if (!frame.get(count)) {
+            return false;
+        }
+        std::vector<ds::timestamp_t> timestamps(count);
+        for (auto& timestamp : timestamps) {
+            std::uint64_t value{ 0 };
+            if (!frame.get(value)) {
+                return false;
+            }
+            timestamp = value;
+        }
+
+        if (!frame.get(count)) {
+            return false;
+        }
+        std::vector<ds::VariableDesc> variables;
+        variables.reserve(count);
+        for (std::uint64_t i = 0; i < count; ++i) {
+            std::string name, units, longName;
+            float validMin{ 0.0f };
+            float validMax{ 0.0f };
+            std::uint64_t dimensionCount{ 0 };
+            if (!frame.get(name) || !frame.get(units) || !frame.get(longName) ||
+                !frame.get(validMin) || !frame.get(validMax) || !frame.get(dimensionCount)) {
+                return false;
+            }
+
+            std::vector<std::string> dimensions(dimensionCount);
+            for (auto& dimension : dimensions) {
+                if (!frame.get(dimension)) {
+                    return false;
+                }
+            }
+            std::optional<ds::StorageLayout> layout;
+            if (!readStorageLayout(frame, layout)) {
+                return false;
+            }
+            variables.emplace_back(name, units, longName, validMin, validMax, dimensions, layout);
+        }
+
+        std::uint8_t hasExtent{ 0 };
+        if (!frame.get(hasExtent)) {
+            return false;
+        }
+        std::optional<ds::BoundingBox> extent;
+        if (hasExtent) {
+            extent.emplace();
+            if (!frame.get(extent->MinLat) || !frame.get(extent->MaxLat) || !frame.get(extent->MinLon) || !frame.get(extent->MaxLon)) {
+                return false;
+            }
+        }
+
+        if (!frame.get(count)) {
+            return false;
+        }
+        std::vector<ds::DimensionDesc> dimensions(count);
+        for (auto& dimension : dimensions) {
+            std::uint64_t size{ 0 };
+            if (!frame.get(dimension.Name) || !frame.get(size)) {
+                return false;
+            }
+            dimension.Size = size;
+        }
+
+        if (!frame.get(count)) {
+            return false;
+        }
+        std::vector<ds::CoordinateDesc> coordinates(count);
+        for (auto& coordinate : coordinates) {
+            std::uint64_t dimensionCount{ 0 };
+            if (!frame.get(coordinate.Name) || !frame.get(dimensionCount)) {
+                return false;
+            }
+            coordinate.Dimensions.resize(dimensionCount);
+            for (auto& dimension : coordinate.Dimensions) {
+                if (!frame.get(dimension)) {
+                    return false;
+                }
+            }
+
+            auto values{ std::make_shared<std::vector<double>>() };
+            if (!frame.get(coordinate.Hash) || !frame.get(*values)) {
+                return false;
+            }
+            coordinate.Values = std::move(values);
+        }
+
+        std::string format;
+        if (!frame.get(format)) {
+            return false;
+        }
+
+        desc.emplace(timestamps, variables, path, extent, dimensions, coordinates, format);
+
+        return true;
+    }
+}
+
+/***********************************************************************************/
+ReaderPool::ReaderPool(const std::size_t workers, const std::chrono::milliseconds deadline, ReadFunction read /* = readNCFile */,
+                       utils::ConcurrencyController* controller /* = nullptr */) :
+                                                                                        m_workerCount{ std::max<std::size_t>(1, workers) },
+                                                                                        m_deadline{ deadline },
+                                                                                        m_read{ std::move(read) },
+                                                                                        m_controller{ controller } {}
+
+/***********************************************************************************/
+ReaderPool::~ReaderPool() {
+    // Idle workers exit as soon as they see their socket close.
+    for (auto& worker : m_workers) {
+        if (worker.Pid < 0) {
+            continue;
+        }
+        close(worker.Socket);
+        waitpid(worker.Pid, nullptr, 0);
+    }
+
+    reapTerminated();
+}
+
+/***********************************************************************************/
+void ReaderPool::readAll(const std::vector<fs::path>& filePaths, const ResultHandler& onResult) {
+    // Workers stay around between calls, so this only ever grows.
+    m_workers.resize(std::max(m_workers.size(), std::min(m_workerCount, filePaths.size())));
+
+    std::size_t next{ 0 };
+    std::size_t finished{ 0 };
+
+    // Reads happen in the workers, so they're traced from here, on a timeline per worker.
+    auto& tracer{ utils::Tracer::instance() };
+    const auto trace = [&](const Worker& worker, const char* name) {
+        if (tracer.enabled()) {
+            tracer.complete("read", name, worker.Started, std::chrono::steady_clock::now(), filePaths[*worker.Job].string(), worker.Pid);
+        }
+    };
+
+    const auto fail = [&](Worker& worker, const READ_STATUS status) {
+        const auto index{ *worker.Job };
+        trace(worker, status == READ_STATUS::TIMED_OUT ? "read timed out" : "read failed");
+        terminate(worker);
+        ++finished;
+        onResult(index, status, ds::DataFileDesc(), 0);
+    };
+
+    std::vector<pollfd> pollFds;
+    std::vector<Worker*> polled;
+    std::string frame;
+
+    while (finished < filePaths.size()) {
+        // Hand out work to every idle worker, as long as the controller allows more at once.
+        auto inFlight{ static_cast<std::size_t>(std::count_if(m_workers.cbegin(), m_workers.cend(), [](const auto& w) { return w.Job.has_value(); })) };
+        for (auto& worker : m_workers) {
+            if (worker.Job || next == filePaths.size() || (m_controller && inFlight >= m_controller->limit())) {
+                continue;
+            }
+
+            if (worker.Pid < 0 && !spawn(worker)) {
+                utils::logError("Failed to start a reader process for " + filePaths[next].string() + '.');
+                ++finished;
+                onResult(next++, READ_STATUS::FAILED, ds::DataFileDesc(), 0);
+                continue;
+            }
+
+            FrameWriter request;
+            request.put(static_cast<std::uint64_t>(next));
+            request.put(filePaths[next].string());
+
+            worker.Job = next++;
+            worker.Started = std::chrono::steady_clock::now();
+            worker.Deadline = worker.Started + m_deadline;
+            if (!sendFrame(worker.Socket, request.bytes())) {
+                utils::logError("Reader process died before reading " + filePaths[*worker.Job].string() + '.');
+                fail(worker, READ_STATUS::FAILED);
+                continue;
+            }
+            ++inFlight;
+        }
+
+        // Wait for the first result, or until the nearest deadline.
+        pollFds.clear();
+        polled.clear();
+        auto nearestDeadline{ std::chrono::steady_clock::time_point::max() };
+        for (auto& worker : m_workers) {
+            if (worker.Job) {
+                pollFds.push_back({ worker.Socket, POLLIN, 0 });
+                polled.push_back(&worker);
+                nearestDeadline = std::min(nearestDeadline, worker.Deadline);
+            }
+        }
+        if (pollFds.empty()) {
+            continue;
+        }
+
+        const auto wait{ std::chrono::duration_cast<std::chrono::milliseconds>(nearestDeadline - std::chrono::steady_clock::now()).count() };
+        const auto timeout{ static_cast<int>(std::clamp<decltype(wait)>(wait, 0, std::numeric_limits<int>::max())) };
+        if (poll(pollFds.data(), pollFds.size(), timeout) < 0 && errno != EINTR) {
+            utils::logError(std::string("poll() failed while waiting for reader processes: ") + std::strerror(errno));
+            for (auto* worker : polled) {
+                fail(*worker, READ_STATUS::FAILED);
+            }
+            continue;
+        }
+
+        const auto now{ std::chrono::steady_clock::now() };
+        for (std::size_t i = 0; i < pollFds.size(); ++i) {
+            auto& worker{ *polled[i] };
+            const auto& path{ filePaths[*worker.Job] };
+
+            if (pollFds[i].revents == 0) {
+                if (now >= worker.Deadline) {
+                    utils::logError("Reading " + path.string() + " took longer than " + std::to_string(m_deadline.count()) + " ms. This file will NOT be indexed.");
+                    fail(worker, READ_STATUS::TIMED_OUT);
+                    if (m_controller) {
+                        m_controller->onTimeout(now);
+                    }
+                }
+                continue;
+            }
+
+            std::optional<ds::DataFileDesc> desc;
+            if (!receiveFrame(worker.Socket, frame)) {
+                utils::logError("Reader process crashed on " + path.string() + ". This file will NOT be indexed.");
+                fail(worker, READ_STATUS::FAILED);
+                continue;
+            }
+
+            FrameReader response{ frame };
+            std::uint64_t index{ 0 };
+            std::uint8_t ok{ 0 };
+            std::uint64_t bytesRead{ 0 };
+            std::uint64_t messageCount{ 0 };
+            if (!response.get(index) || index != *worker.Job || !response.get(ok) ||
+                (ok && !readDataFileDesc(response, path, desc)) || !response.get(bytesRead) || !response.get(messageCount)) {
+                utils::logError("Garbled response from the reader process for " + path.string() + '.');
+                fail(worker, READ_STATUS::FAILED);
+                continue;
+            }
+
+            // Whatever the worker had to say about the file gets logged here.
+            for (std::uint64_t m = 0; m < messageCount; ++m) {
+                std::uint8_t level{ 0 };
+                std::string text;
+                if (response.get(level) && response.get(text)) {
+                    utils::Logger::instance().log(static_cast<utils::LOG_LEVEL>(level), std::move(text));
+                }
+            }
+
+            trace(worker, desc && *desc ? "read file" : "read failed");
+            worker.Job.reset();
+            ++finished;
+            // Files that failed to open took as long to tell, so they count too.
+            if (m_controller) {
+                m_controller->onComplete(std::chrono::duration_cast<std::chrono::microseconds>(now - worker.Started), now);
+            }
+            if (desc && *desc) {
+                onResult(index, READ_STATUS::OK, std::move(*desc), bytesRead);
+            }
+            else {
+                onResult(index, READ_STATUS::FAILED, ds::DataFileDesc(), bytesRead);
+            }
+        }
+
+        reapTerminated();
+    }
+}
+
+/***********************************************************************************/
+ds::DataFileDesc ReaderPool::readNCFile(const fs::path& path) {
+    NCFileReader reader{ path };
+    return reader.getDataFileDesc();
+}
+
+/***********************************************************************************/
+ReaderPool::ReadFunction ReaderPool::ncFileReader(const ReadFlags& flags) {
+    return [flags](const fs::path& path) {
+        NCFileReader reader{ path, flags };
+        return reader.getDataFileDesc();
+    };
+}
+
+/***********************************************************************************/
+bool ReaderPool::spawn(Worker& worker) {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0) {
+        return false;
+    }
+
+    const auto pid{ fork() };
+    if (pid < 0) {
+        close(sockets[0]);
+        close(sockets[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        close(sockets[0]);
+        for (const auto& other : m_workers) {
+            if (other.Socket >= 0) {
+                close(other.Socket);
+            }
+        }
+        utils::Logger::instance().detachAfterFork();
+
+        runWorker(sockets[1], m_read);
+    }
+
+    close(sockets[1]);
+    if (auto& tracer{ utils::Tracer::instance() }; tracer.enabled()) {
+        tracer.setLaneName(pid, "reader " + std::to_string(pid));
+    }
+    worker.Pid = pid;
+    worker.Socket = sockets[0];
+    worker.Job.reset();
+
+    return true;
+}
+
+/***********************************************************************************/
+void ReaderPool::terminate(Worker& worker) {
+    kill(worker.Pid, SIGKILL);
+    close(worker.Socket);
+
+    // Don't wait: a process stuck in uninterruptible I/O only dies once the I/O returns.
+    if (waitpid(worker.Pid, nullptr, WNOHANG) == 0) {
+        m_terminated.push_back(worker.Pid);
+    }
+
+    worker = Worker();
+}
+
+/***********************************************************************************/
+void ReaderPool::reapTerminated() {
+    m_terminated.erase(std::remove_if(m_terminated.begin(), m_terminated.end(), [](const pid_t pid) {
+        return waitpid(pid, nullptr, WNOHANG) != 0;
+    }), m_terminated.end());
+}
+
+/***********************************************************************************/
+void ReaderPool::runWorker(const int socket, const ReadFunction& read) {
+    std::string frame;
+
+    while (receiveFrame(socket, frame)) {
+        FrameReader request{ frame };
+        std::uint64_t index{ 0 };
+        std::string path;
+        if (!request.get(index) || !request.get(path)) {
+            break;
+        }
+
+        const auto readBefore{ utils::threadBytesRead() };
+        const auto& desc{ read(path) };
+        const auto bytesRead{ utils::threadBytesRead() - readBefore };
+
+        FrameWriter response;
+        response.put(index);
+        const std::uint8_t ok{ static_cast<bool>(desc) };
+        response.put(ok);
+        if (ok) {
+            writeDataFileDesc(response, desc);
+        }
+        response.put(static_cast<std::uint64_t>(bytesRead));
+
+        const auto& messages{ utils::Logger::instance().takeCaptured() };
+        response.put(static_cast<std::uint64_t>(messages.size()));
+        for (const auto& [level, text] : messages) {
+            response.put(static_cast<std::uint8_t>(level));
+            response.put(text);
+        }
+
+        if (!sendFrame(socket, response.bytes())) {
+            break;
+        }
+    }
+
+    // Skip the parent's atexit handlers and static destructors.
+    _exit(EXIT_SUCCESS);
+}
+
+} // namespace tsm
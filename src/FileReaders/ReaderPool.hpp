@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../DataFileDesc.hpp"
+#include "../Filesystem.hpp"
+#include "FileReader.hpp"
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace tsm {
+
+namespace utils {
+    class ConcurrencyController;
+}
+
+enum class READ_STATUS {
+    OK = 0,
+    FAILED,
+    TIMED_OUT
+};
+
+/***********************************************************************************/
+/// Reads files in worker processes, each file with its own deadline.
+///
+/// A damaged file on network storage can make NcFile::open hang for minutes,
+/// and a thread stuck in there can't be cancelled. A worker process can: when
+/// it misses its deadline it gets killed and replaced, the file is reported
+/// as TIMED_OUT, and the other workers keep going. A worker that crashes on a
+/// file is replaced the same way and the file is reported as FAILED.
+/// Processes are also what netCDF-C needs to read files in parallel, since
+/// it isn't thread-safe.
+///
+/// With a ConcurrencyController, only as many files as its limit are read at once
+/// (up to the number of workers), and it's told how long each read took.
+class ReaderPool {
+
+public:
+    /// Reads one file. Runs in the worker process (a copy made by fork).
+    using ReadFunction = std::function<ds::DataFileDesc(const fs::path& path)>;
+    /// Called in the calling thread as each file finishes. desc is empty unless status is OK.
+    /// bytesRead: what the worker read for the file (see utils::threadBytesRead()); 0 if it didn't finish.
+    using ResultHandler = std::function<void(const std::size_t index, const READ_STATUS status, ds::DataFileDesc&& desc, const std::uint64_t bytesRead)>;
+
+    ///
+    ReaderPool(const std::size_t workers, const std::chrono::milliseconds deadline, ReadFunction read = readNCFile,
+               utils::ConcurrencyController* controller = nullptr);
+    ///
+    ~ReaderPool();
+
+    ReaderPool(const ReaderPool&) = delete;
+    ReaderPool& operator=(const ReaderPool&) = delete;
+
+    /// Reads every file and calls onResult once per file, in completion order.
+    void readAll(const std::vector<fs::path>& filePaths, const ResultHandler& onResult);
+
+    /// The default ReadFunction.
+    [[nodiscard]] static ds::DataFileDesc readNCFile(const fs::path& path);
+    /// Reads with NCFileReader and the given flags.
+    [[nodiscard]] static ReadFunction ncFileReader(const ReadFlags& flags);
+
+private:
+    struct Worker {
+        pid_t Pid{ -1 };
+        /// Our end of the socket pair.
+        int Socket{ -1 };
+        /// Index of the file being read, if any.
+        std::optional<std::size_t> Job;
+        std::chrono::steady_clock::time_point Started;
+        std::chrono::steady_clock::time_point Deadline;
+    };
+
+    /// Forks a new worker process into worker.
+    [[nodiscard]] bool spawn(Worker& worker);
+    /// Kills the worker without waiting for it (it may be stuck in uninterruptible I/O).
+    void terminate(Worker& worker);
+    /// Reaps killed workers that have exited since.
+    void reapTerminated();
+    /// Body of the worker process.
+    [[noreturn]] static void runWorker(const int socket, const ReadFunction& read);
+
+    const std::size_t m_workerCount;
+    const std::chrono::milliseconds m_deadline;
+    const ReadFunction m_read;
+    /// Not owned. May be null.
+    utils::ConcurrencyController* const m_controller;
+    std::vector<Worker> m_workers;
+    std::vector<pid_t> m_terminated;
+};
+
+} // namespace tsm
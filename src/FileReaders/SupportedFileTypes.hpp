@@ -1,16 +1,21 @@
 #pragma once
 
-#include <unordered_set>
+#include <algorithm>
+#include <array>
+#include <string_view>
 
 namespace tsm {
 
-/***********************************************************************************/
-static inline auto supportedFileType(const std::string& fileExtension) {
-    const static std::unordered_set<std::string> extensions {
-        ".nc"
-    };
+/// Extensions (with the dot) of the files that can be indexed.
+constexpr std::array<std::string_view, 1> SUPPORTED_FILE_EXTENSIONS{
+    ".nc"
+};
 
-    return extensions.count(fileExtension) > 0;
+/***********************************************************************************/
+/// A handful of extensions: comparing them beats hashing, which matters when
+/// checking every line of a multi-million-entry file list.
+static inline auto supportedFileType(const std::string_view fileExtension) {
+    return std::find(SUPPORTED_FILE_EXTENSIONS.cbegin(), SUPPORTED_FILE_EXTENSIONS.cend(), fileExtension) != SUPPORTED_FILE_EXTENSIONS.cend();
 }
 
 } // namespace tsm
@@ -0,0 +1,109 @@
+#include "LookupClient.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace tsm {
+
+/***********************************************************************************/
+LookupClient::~LookupClient() {
+    if (m_socket >= 0) {
+        close(m_socket);
+    }
+}
+
+/***********************************************************************************/
+bool LookupClient::connect(const fs::path& socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.string().size() >= sizeof(address.sun_path)) {
+        m_error = "Socket path " + socketPath.string() + " is too long.";
+        return false;
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_socket < 0 || ::connect(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        m_error = "Failed to connect to " + socketPath.string() + ": " + std::strerror(errno);
+        if (m_socket >= 0) {
+            close(m_socket);
+            m_socket = -1;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+/***********************************************************************************/
+std::optional<std::vector<std::string>> LookupClient::request(const std::string& line) {
+    if (m_socket < 0) {
+        m_error = "Not connected.";
+        return std::nullopt;
+    }
+
+    const auto message{ line + '\n' };
+    for (std::size_t sent = 0; sent < message.size();) {
+        const auto n{ send(m_socket, message.data() + sent, message.size() - sent, MSG_NOSIGNAL) };
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            m_error = std::string("Failed to send the request: ") + std::strerror(errno);
+            return std::nullopt;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+
+    std::string status;
+    if (!readLine(status)) {
+        return std::nullopt;
+    }
+    if (status.compare(0, 3, "OK ") != 0) {
+        m_error = status.compare(0, 4, "ERR ") == 0 ? status.substr(4) : "Unexpected response: " + status;
+        return std::nullopt;
+    }
+
+    std::vector<std::string> lines(std::stoull(status.substr(3)));
+    for (auto& responseLine : lines) {
+        if (!readLine(responseLine)) {
+            return std::nullopt;
+        }
+    }
+
+    return lines;
+}
+
+/***********************************************************************************/
+bool LookupClient::readLine(std::string& line) {
+    char buffer[64 * 1024];
+
+    auto end{ m_buffer.find('\n', m_position) };
+    while (end == std::string::npos) {
+        // Drop what's been returned before growing the buffer.
+        m_buffer.erase(0, m_position);
+        m_position = 0;
+
+        const auto received{ recv(m_socket, buffer, sizeof(buffer), 0) };
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            m_error = "Connection closed by the server.";
+            return false;
+        }
+        m_buffer.append(buffer, static_cast<std::size_t>(received));
+        end = m_buffer.find('\n');
+    }
+
+    line.assign(m_buffer, m_position, end - m_position);
+    m_position = end + 1;
+
+    return true;
+}
+
+} // namespace tsm
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Filesystem.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tsm {
+
+/***********************************************************************************/
+/// Blocking client of a LookupServer (--serve). One request at a time.
+class LookupClient {
+
+public:
+    LookupClient() = default;
+    ~LookupClient();
+
+    LookupClient(const LookupClient&) = delete;
+    LookupClient& operator=(const LookupClient&) = delete;
+
+    ///
+    [[nodiscard]] bool connect(const fs::path& socketPath);
+    /// Sends one request line (see LookupServer) and returns the lines of its response.
+    /// std::nullopt if the server answered ERR or the connection failed; see lastError().
+    [[nodiscard]] std::optional<std::vector<std::string>> request(const std::string& line);
+    ///
+    [[nodiscard]] const std::string& lastError() const noexcept {
+        return m_error;
+    }
+
+private:
+    ///
+    [[nodiscard]] bool readLine(std::string& line);
+
+    int m_socket{ -1 };
+    /// Received bytes; those before m_position were returned by readLine() already.
+    std::string m_buffer;
+    std::size_t m_position{ 0 };
+    std::string m_error;
+};
+
+} // namespace tsm
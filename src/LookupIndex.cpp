@@ -0,0 +1,134 @@
+#include "LookupIndex.hpp"
+
+#include "Database.hpp"
+#include "Utils/Logger.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+namespace tsm {
+
+/***********************************************************************************/
+std::shared_ptr<const LookupIndex> LookupIndex::load(const fs::path& outputDir, const std::string& datasetName) {
+    DatabaseOptions options;
+    options.ReadOnly = true;
+
+    Database db{ outputDir, datasetName, options };
+    if (!db.open()) {
+        return nullptr;
+    }
+
+    auto filepaths{ db.selectFilepathNames() };
+    const auto& variables{ db.selectVariableNames() };
+    if (!filepaths || !variables) {
+        return nullptr;
+    }
+    if (filepaths->size() > std::numeric_limits<std::uint32_t>::max()) {
+        utils::logError(datasetName + " has too many files to serve.");
+        return nullptr;
+    }
+
+    auto index{ std::make_shared<LookupIndex>() };
+
+    std::sort(filepaths->begin(), filepaths->end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second < rhs.second;
+    });
+    std::unordered_map<std::int64_t, std::uint32_t> fileIndices;
+    index->m_filepaths.reserve(filepaths->size());
+    for (auto& [id, path] : *filepaths) {
+        fileIndices.emplace(id, static_cast<std::uint32_t>(index->m_filepaths.size()));
+        index->m_filepaths.emplace_back(std::move(path));
+    }
+
+    std::unordered_map<std::int64_t, std::vector<std::pair<std::int64_t, std::uint32_t>>> rows;
+    for (const auto& [id, name] : *variables) {
+        rows[id];
+    }
+
+    const auto ok{ db.scanJoinTable([&](const std::int64_t variableID, const std::int64_t timestamp, const std::int64_t filepathID) {
+        const auto variable{ rows.find(variableID) };
+        const auto file{ fileIndices.find(filepathID) };
+        if (variable != rows.end() && file != fileIndices.cend()) {
+            variable->second.emplace_back(timestamp, file->second);
+        }
+    }) };
+    if (!ok) {
+        return nullptr;
+    }
+
+    for (const auto& [id, name] : *variables) {
+        auto& variableRows{ rows[id] };
+        std::sort(variableRows.begin(), variableRows.end());
+
+        auto& dest{ index->m_variables[name] };
+        dest.Timestamps.reserve(variableRows.size());
+        dest.Files.reserve(variableRows.size());
+        for (const auto& [timestamp, file] : variableRows) {
+            dest.Timestamps.push_back(timestamp);
+            dest.Files.push_back(file);
+        }
+
+        // Free each variable's rows as soon as they're copied, to keep the peak down.
+        std::vector<std::pair<std::int64_t, std::uint32_t>>().swap(variableRows);
+    }
+
+    return index;
+}
+
+/***********************************************************************************/
+std::vector<std::string_view> LookupIndex::findFiles(const std::string& variable, const std::int64_t timestamp) const {
+    const auto rows{ m_variables.find(variable) };
+    if (rows == m_variables.cend()) {
+        return {};
+    }
+
+    const auto& timestamps{ rows->second.Timestamps };
+    const auto [first, last]{ std::equal_range(timestamps.cbegin(), timestamps.cend(), timestamp) };
+
+    std::vector<std::string_view> filepaths;
+    filepaths.reserve(static_cast<std::size_t>(last - first));
+    for (auto i = first - timestamps.cbegin(); i < last - timestamps.cbegin(); ++i) {
+        filepaths.emplace_back(m_filepaths[rows->second.Files[static_cast<std::size_t>(i)]]);
+    }
+
+    return filepaths;
+}
+
+/***********************************************************************************/
+std::vector<std::int64_t> LookupIndex::timestamps(const std::string& variable) const {
+    const auto rows{ m_variables.find(variable) };
+    if (rows == m_variables.cend()) {
+        return {};
+    }
+
+    std::vector<std::int64_t> timestamps;
+    std::unique_copy(rows->second.Timestamps.cbegin(), rows->second.Timestamps.cend(), std::back_inserter(timestamps));
+
+    return timestamps;
+}
+
+/***********************************************************************************/
+std::vector<std::string> LookupIndex::variables() const {
+    std::vector<std::string> variables;
+    variables.reserve(m_variables.size());
+    for (const auto& [name, rows] : m_variables) {
+        variables.push_back(name);
+    }
+    std::sort(variables.begin(), variables.end());
+
+    return variables;
+}
+
+/***********************************************************************************/
+std::size_t LookupIndex::size() const noexcept {
+    std::size_t size{ 0 };
+    for (const auto& [name, rows] : m_variables) {
+        size += rows.Timestamps.size();
+    }
+
+    return size;
+}
+
+} // namespace tsm
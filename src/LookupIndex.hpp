@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Filesystem.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tsm {
+
+/***********************************************************************************/
+/// Read-only copy of a historical database's index, answering the same lookups
+/// as Database without SQLite: one sorted (timestamp, file) array per variable.
+/// Immutable once loaded, so it can be shared between threads and swapped out whole.
+class LookupIndex {
+
+public:
+    /// Loads <outputDir>/<datasetName>.sqlite3. Returns nullptr if it can't be read.
+    [[nodiscard]] static std::shared_ptr<const LookupIndex> load(const fs::path& outputDir, const std::string& datasetName);
+
+    /// Paths of the files holding variable at timestamp, sorted. Valid as long as the index.
+    [[nodiscard]] std::vector<std::string_view> findFiles(const std::string& variable, const std::int64_t timestamp) const;
+    /// Every timestamp of variable, ascending.
+    [[nodiscard]] std::vector<std::int64_t> timestamps(const std::string& variable) const;
+    /// Every variable name, sorted.
+    [[nodiscard]] std::vector<std::string> variables() const;
+
+    /// Number of (variable, timestamp, file) rows.
+    [[nodiscard]] std::size_t size() const noexcept;
+
+private:
+    /// Parallel arrays sorted by (timestamp, file).
+    struct VariableRows {
+        std::vector<std::int64_t> Timestamps;
+        /// Indices into m_filepaths.
+        std::vector<std::uint32_t> Files;
+    };
+
+    /// Sorted, so sorting rows by file index sorts them by path.
+    std::vector<std::string> m_filepaths;
+    std::unordered_map<std::string, VariableRows> m_variables;
+};
+
+} // namespace tsm
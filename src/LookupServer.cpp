@@ -0,0 +1,427 @@
+#include "LookupServer.hpp"
+
+#include "Utils/Logger.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+namespace tsm {
+
+/***********************************************************************************/
+namespace {
+
+    /// Stop reading from a client that doesn't read its responses.
+    constexpr std::size_t MAX_PENDING_OUTPUT_BYTES{ 16 * 1024 * 1024 };
+    /// Longest request line; anything longer isn't a request.
+    constexpr std::size_t MAX_REQUEST_BYTES{ 64 * 1024 };
+
+    LookupServer* signalTarget{ nullptr };
+
+    void onStopSignal(int) {
+        if (signalTarget) {
+            signalTarget->stop();
+        }
+    }
+
+    struct Connection {
+        int Socket{ -1 };
+        std::string Input;
+        std::string Output;
+        /// Bytes of Output already sent.
+        std::size_t Sent{ 0 };
+    };
+
+    bool setNonBlocking(const int fd) {
+        const auto flags{ fcntl(fd, F_GETFL, 0) };
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    /// A socket left behind by a server that's gone: nothing accepts connections on it.
+    bool isStaleSocket(const sockaddr_un& address) {
+        struct stat status{};
+        if (lstat(address.sun_path, &status) != 0 || !S_ISSOCK(status.st_mode)) {
+            return false;
+        }
+
+        const auto probe{ socket(AF_UNIX, SOCK_STREAM, 0) };
+        if (probe < 0) {
+            return false;
+        }
+        const auto refused{ connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 };
+        close(probe);
+
+        return refused;
+    }
+
+    std::int64_t nanoseconds(const timespec& time) {
+        return static_cast<std::int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    }
+
+    void appendError(std::string& response, const std::string& message) {
+        response += "ERR " + message + '\n';
+    }
+
+    /// Sends what it can without blocking. False if the client is gone.
+    bool flush(Connection& connection) {
+        while (connection.Sent < connection.Output.size()) {
+            const auto sent{ send(connection.Socket, connection.Output.data() + connection.Sent,
+                                  connection.Output.size() - connection.Sent, MSG_NOSIGNAL) };
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            }
+            if (sent <= 0) {
+                return false;
+            }
+            connection.Sent += static_cast<std::size_t>(sent);
+        }
+
+        connection.Output.clear();
+        connection.Sent = 0;
+
+        return true;
+    }
+}
+
+/***********************************************************************************/
+LookupServer::LookupServer(ServeOptions options) : m_options{ std::move(options) } {
+    for (const auto& name : m_options.DatasetNames) {
+        m_datasets.push_back({ name, m_options.OutputDir / (name + ".sqlite3"), {}, nullptr });
+    }
+}
+
+/***********************************************************************************/
+LookupServer::~LookupServer() {
+    if (signalTarget == this) {
+        signalTarget = nullptr;
+    }
+    for (const auto fd : m_wakePipe) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+/***********************************************************************************/
+bool LookupServer::run() {
+    if (pipe(m_wakePipe) != 0 || !setNonBlocking(m_wakePipe[0]) || !setNonBlocking(m_wakePipe[1])) {
+        utils::logError(std::string("Failed to create a pipe: ") + std::strerror(errno));
+        return false;
+    }
+
+    for (auto& dataset : m_datasets) {
+        dataset.Version = fileVersion(dataset.Path);
+        dataset.Index = LookupIndex::load(m_options.OutputDir, dataset.Name);
+        if (!dataset.Index) {
+            utils::logError("Failed to load " + dataset.Path.string() + '.');
+            return false;
+        }
+        utils::logInfo("Serving " + dataset.Name + " (" + std::to_string(dataset.Index->size()) + " rows).");
+    }
+
+    const auto listener{ listen() };
+    if (listener < 0) {
+        return false;
+    }
+    utils::logInfo("Listening on " + m_options.SocketPath.string() + '.');
+
+    std::thread reloader{ [this] { reloadChangedDatasets(); } };
+
+    std::vector<Connection> connections;
+    std::vector<pollfd> fds;
+    std::string response;
+    char buffer[64 * 1024];
+
+    while (!m_stopping) {
+        fds.clear();
+        fds.push_back({ m_wakePipe[0], POLLIN, 0 });
+        fds.push_back({ listener, POLLIN, 0 });
+        for (const auto& connection : connections) {
+            short events{ 0 };
+            if (connection.Output.size() < MAX_PENDING_OUTPUT_BYTES) {
+                events |= POLLIN;
+            }
+            if (!connection.Output.empty()) {
+                events |= POLLOUT;
+            }
+            fds.push_back({ connection.Socket, events, 0 });
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            utils::logError(std::string("poll() failed: ") + std::strerror(errno));
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            for (;;) {
+                const auto client{ accept(listener, nullptr, nullptr) };
+                if (client < 0) {
+                    break;
+                }
+                if (!setNonBlocking(client)) {
+                    close(client);
+                    continue;
+                }
+                connections.push_back({ client, {}, {}, 0 });
+            }
+        }
+
+        // fds[i + 2] is connections[i]; connections accepted above aren't polled yet.
+        const auto polled{ fds.size() - 2 };
+        for (std::size_t i = 0; i < polled; ++i) {
+            auto& connection{ connections[i] };
+            const auto revents{ fds[i + 2].revents };
+            auto alive{ (revents & (POLLERR | POLLNVAL)) == 0 };
+
+            if (alive && (revents & (POLLIN | POLLHUP))) {
+                const auto received{ recv(connection.Socket, buffer, sizeof(buffer), 0) };
+                if (received > 0) {
+                    connection.Input.append(buffer, static_cast<std::size_t>(received));
+                }
+                else if (received == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    alive = false;
+                }
+            }
+
+            std::size_t start{ 0 };
+            for (auto end{ connection.Input.find('\n') }; alive && end != std::string::npos; end = connection.Input.find('\n', start)) {
+                auto request{ connection.Input.substr(start, end - start) };
+                if (!request.empty() && request.back() == '\r') {
+                    request.pop_back();
+                }
+                response.clear();
+                handleRequest(request, response);
+                connection.Output += response;
+                start = end + 1;
+            }
+            connection.Input.erase(0, start);
+            if (connection.Input.size() > MAX_REQUEST_BYTES) {
+                alive = false;
+            }
+
+            if (alive) {
+                alive = flush(connection);
+            }
+            if (!alive) {
+                close(connection.Socket);
+                connection.Socket = -1;
+            }
+        }
+        connections.erase(std::remove_if(connections.begin(), connections.end(), [](const auto& connection) {
+            return connection.Socket < 0;
+        }), connections.end());
+    }
+
+    stop();
+    {
+        // Taken so the reloader is either waiting or yet to see m_stopping.
+        const std::lock_guard<std::mutex> lock{ m_reloadMutex };
+    }
+    m_reloadCondition.notify_all();
+    reloader.join();
+
+    for (const auto& connection : connections) {
+        close(connection.Socket);
+    }
+    close(listener);
+    std::error_code e;
+    fs::remove(m_options.SocketPath, e);
+
+    return true;
+}
+
+/***********************************************************************************/
+void LookupServer::stop() noexcept {
+    m_stopping = true;
+    if (m_wakePipe[1] >= 0) {
+        const char byte{ 0 };
+        [[maybe_unused]] const auto written{ write(m_wakePipe[1], &byte, 1) };
+    }
+}
+
+/***********************************************************************************/
+void LookupServer::stopOnSignals() {
+    signalTarget = this;
+
+    struct sigaction action{};
+    action.sa_handler = onStopSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+/***********************************************************************************/
+void LookupServer::handleRequest(const std::string& request, std::string& response) const {
+    std::istringstream words{ request };
+    std::string command, datasetName, variable;
+    words >> command;
+
+    if (command == "DATASETS") {
+        response += "OK " + std::to_string(m_datasets.size()) + '\n';
+        for (const auto& dataset : m_datasets) {
+            response += dataset.Name + '\n';
+        }
+        return;
+    }
+
+    if (!(words >> datasetName)) {
+        appendError(response, command.empty() ? "Empty request." : "Missing dataset name.");
+        return;
+    }
+    const auto* dataset{ findDataset(datasetName) };
+    if (!dataset) {
+        appendError(response, "Unknown dataset " + datasetName + '.');
+        return;
+    }
+    const auto index{ std::atomic_load(&dataset->Index) };
+
+    if (command == "VARIABLES") {
+        const auto& variables{ index->variables() };
+        response += "OK " + std::to_string(variables.size()) + '\n';
+        for (const auto& name : variables) {
+            response += name + '\n';
+        }
+        return;
+    }
+
+    if (!(words >> variable)) {
+        appendError(response, "Missing variable name.");
+        return;
+    }
+
+    if (command == "TIMESTAMPS") {
+        const auto& timestamps{ index->timestamps(variable) };
+        response += "OK " + std::to_string(timestamps.size()) + '\n';
+        for (const auto timestamp : timestamps) {
+            response += std::to_string(timestamp) + '\n';
+        }
+        return;
+    }
+
+    if (command == "FILES") {
+        std::int64_t timestamp{ 0 };
+        if (!(words >> timestamp)) {
+            appendError(response, "Missing or invalid timestamp.");
+            return;
+        }
+
+        const auto& filepaths{ index->findFiles(variable, timestamp) };
+        response += "OK " + std::to_string(filepaths.size()) + '\n';
+        for (const auto& path : filepaths) {
+            response.append(path);
+            response += '\n';
+        }
+        return;
+    }
+
+    appendError(response, "Unknown command " + command + '.');
+}
+
+/***********************************************************************************/
+LookupServer::FileVersion LookupServer::fileVersion(const fs::path& path) {
+    FileVersion version;
+
+    struct stat st{};
+    if (stat(path.c_str(), &st) == 0) {
+        version.Inode = st.st_ino;
+        version.Size = st.st_size;
+        version.ModifiedNs = nanoseconds(st.st_mtim);
+    }
+    // In WAL mode commits only touch the -wal file until a checkpoint.
+    if (stat((path.string() + "-wal").c_str(), &st) == 0) {
+        version.WALModifiedNs = nanoseconds(st.st_mtim);
+    }
+
+    return version;
+}
+
+/***********************************************************************************/
+const LookupServer::Dataset* LookupServer::findDataset(const std::string& name) const {
+    for (const auto& dataset : m_datasets) {
+        if (dataset.Name == name) {
+            return &dataset;
+        }
+    }
+
+    return nullptr;
+}
+
+/***********************************************************************************/
+void LookupServer::reloadChangedDatasets() {
+    std::unique_lock<std::mutex> lock{ m_reloadMutex };
+
+    while (!m_reloadCondition.wait_for(lock, m_options.ReloadInterval, [this] { return m_stopping.load(); })) {
+        for (auto& dataset : m_datasets) {
+            const auto version{ fileVersion(dataset.Path) };
+            if (version == dataset.Version || version.Inode == 0) {
+                continue;
+            }
+
+            // Built aside and swapped in whole; requests keep using the old index until then.
+            auto index{ LookupIndex::load(m_options.OutputDir, dataset.Name) };
+            if (!index) {
+                // Most likely locked by a running index; tried again next time round.
+                utils::logDebug("Failed to reload " + dataset.Path.string() + "; still serving the previous index.");
+                continue;
+            }
+
+            std::atomic_store(&dataset.Index, std::shared_ptr<const LookupIndex>{ std::move(index) });
+            dataset.Version = version;
+            utils::logInfo("Reloaded " + dataset.Name + " (" + std::to_string(std::atomic_load(&dataset.Index)->size()) + " rows).");
+        }
+    }
+}
+
+/***********************************************************************************/
+int LookupServer::listen() const {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (m_options.SocketPath.string().size() >= sizeof(address.sun_path)) {
+        utils::logError("Socket path " + m_options.SocketPath.string() + " is too long.");
+        return -1;
+    }
+    std::strncpy(address.sun_path, m_options.SocketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    const auto listener{ socket(AF_UNIX, SOCK_STREAM, 0) };
+    if (listener < 0 || !setNonBlocking(listener)) {
+        utils::logError(std::string("Failed to create a socket: ") + std::strerror(errno));
+        if (listener >= 0) {
+            close(listener);
+        }
+        return -1;
+    }
+
+    // A socket left behind by a previous run would make bind() fail. Anything
+    // else at the path (a file, or a server still running) is left for bind() to report.
+    if (isStaleSocket(address)) {
+        std::error_code e;
+        fs::remove(m_options.SocketPath, e);
+    }
+
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, SOMAXCONN) != 0) {
+        utils::logError("Failed to listen on " + m_options.SocketPath.string() + ": " + std::strerror(errno));
+        close(listener);
+        return -1;
+    }
+
+    return listener;
+}
+
+} // namespace tsm
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Filesystem.hpp"
+#include "LookupIndex.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tsm {
+
+/***********************************************************************************/
+struct [[nodiscard]] ServeOptions {
+    /// UNIX domain socket to listen on. Replaced if it already exists.
+    fs::path SocketPath;
+    /// Directory of the databases.
+    fs::path OutputDir;
+    /// Each is served from <OutputDir>/<name>.sqlite3.
+    std::vector<std::string> DatasetNames;
+    /// How often the databases are checked for changes.
+    std::chrono::milliseconds ReloadInterval{ 1000 };
+};
+
+/***********************************************************************************/
+/// Serves lookups from in-memory LookupIndexes over a UNIX domain socket (--serve),
+/// so worker processes share one copy of each index instead of each opening the database.
+///
+/// The protocol is line based. Each request is one line:
+///   FILES <dataset> <variable> <timestamp>
+///   TIMESTAMPS <dataset> <variable>
+///   VARIABLES <dataset>
+///   DATASETS
+/// and is answered with "OK <n>" followed by n lines (paths, timestamps or names,
+/// as LookupIndex returns them), or with a single "ERR <message>" line.
+/// Requests may be pipelined; responses come back in order.
+///
+/// A background thread reloads a dataset when its database is replaced or written to,
+/// then swaps the new index in, so a request sees either the old index or the new one.
+/// If the reload fails (e.g. the database is locked mid-index) the old index stays.
+class LookupServer {
+
+public:
+    explicit LookupServer(ServeOptions options);
+    ~LookupServer();
+
+    LookupServer(const LookupServer&) = delete;
+    LookupServer& operator=(const LookupServer&) = delete;
+
+    /// Loads every dataset, then serves until stop(). Returns false if it couldn't start.
+    [[nodiscard]] bool run();
+    /// Makes run() return. Safe to call from any thread, and from a signal handler.
+    void stop() noexcept;
+    /// Calls stop() on SIGINT and SIGTERM.
+    void stopOnSignals();
+
+    /// Answers one request line (without the line ending) into response.
+    void handleRequest(const std::string& request, std::string& response) const;
+
+private:
+    /// Identifies a version of a database file: a replaced file has a new inode,
+    /// a written one a new size or modification time (of it or its WAL).
+    struct FileVersion {
+        std::uint64_t Inode{ 0 };
+        std::int64_t Size{ 0 };
+        std::int64_t ModifiedNs{ 0 };
+        std::int64_t WALModifiedNs{ 0 };
+
+        [[nodiscard]] bool operator==(const FileVersion& other) const noexcept {
+            return Inode == other.Inode && Size == other.Size && ModifiedNs == other.ModifiedNs && WALModifiedNs == other.WALModifiedNs;
+        }
+    };
+
+    struct Dataset {
+        std::string Name;
+        fs::path Path;
+        FileVersion Version;
+        /// Only read and written through std::atomic_load/std::atomic_store.
+        std::shared_ptr<const LookupIndex> Index;
+    };
+
+    ///
+    [[nodiscard]] static FileVersion fileVersion(const fs::path& path);
+    ///
+    [[nodiscard]] const Dataset* findDataset(const std::string& name) const;
+    /// Runs on m_reloader until stop().
+    void reloadChangedDatasets();
+    ///
+    [[nodiscard]] int listen() const;
+
+    const ServeOptions m_options;
+    std::vector<Dataset> m_datasets;
+
+    std::atomic<bool> m_stopping{ false };
+    /// stop() writes to [1] to wake up poll(); written from signal handlers, so a pipe.
+    int m_wakePipe[2]{ -1, -1 };
+
+    std::mutex m_reloadMutex;
+    std::condition_variable m_reloadCondition;
+};
+
+} // namespace tsm
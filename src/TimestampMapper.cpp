@@ -1,8 +1,15 @@
 #include "TimestampMapper.hpp"
 
+#include "Catalog.hpp"
 #include "DatasetDesc.hpp"
 #include "CrawlDirectory.hpp"
-#include "FileReaders/SupportedFileTypes.hpp"
+#include "Utils/ConcurrencyController.hpp"
+#include "Utils/FileList.hpp"
+#include "Utils/FileOrder.hpp"
+#include "Utils/Logger.hpp"
+#include "Utils/MemoryProfile.hpp"
+#include "Utils/ProgressBar.hpp"
+#include "Utils/Trace.hpp"
 
 #include <exception>
 #include <iostream>
@@ -11,71 +18,280 @@
 
 namespace tsm {
 
+// Files read and inserted at a time in WAL mode.
+constexpr std::size_t WAL_BATCH_FILES{ 256 };
+
+/***********************************************************************************/
+namespace {
+
+    DatabaseOptions makeDatabaseOptions(const cli::CLIOptions& opts) {
+        DatabaseOptions options;
+        options.WAL = opts.WAL;
+        options.TransactionSize = opts.WAL ? opts.TransactionSize : 0;
+        options.InMemory = opts.InMemory;
+        options.MemoryBudgetMB = opts.MemoryBudgetMB;
+        options.ClusteredJoinTable = opts.ClusteredJoinTable;
+        options.Fingerprints = opts.Fingerprints;
+
+        return options;
+    }
+}
+
 /***********************************************************************************/
 TimestampMapper::TimestampMapper(const cli::CLIOptions& opts) : m_datasetType{ opts.Forecast ? tsm::ds::DATASET_TYPE::FORECAST : tsm::ds::DATASET_TYPE::HISTORICAL },
                                                         m_cliOptions{ opts },
                                                         m_indexFileExists{ fileOrDirExists(opts.FileListPath) },
-                                                        m_database{ opts.OutputDir, opts.DatasetName }
+                                                        m_database{ opts.OutputDir, opts.DatasetName, makeDatabaseOptions(opts) }
 {
 }
 
 /***********************************************************************************/
 bool TimestampMapper::exec() {
+    auto& profiler{ utils::MemoryProfiler::instance() };
+    if (m_cliOptions.MemoryProfile) {
+        profiler.start();
+    }
+
+    auto filePaths{ findFiles() };
+    const auto indexed{ filePaths && indexFiles(std::move(*filePaths)) };
+
+    if (m_cliOptions.MemoryProfile) {
+        profiler.stop();
+        std::cout << "\nMemory by phase:\n" << profiler.table() << std::flush;
+    }
+
+    return indexed;
+}
+
+/***********************************************************************************/
+std::optional<utils::PathStore> TimestampMapper::findFiles(std::ostream& out) {
     if (m_cliOptions.DryRun) {
-        std::cout << "---DRY RUN---\n";
+        out << "---DRY RUN---\n";
     }
 
     if (!fileOrDirExists(m_cliOptions.InputDir)) {
         std::cerr << "Input directory " << m_cliOptions.InputDir << " does not exist." << std::endl;
-        return false;
+        return std::nullopt;
     }
 
     if (!createDirectory(m_cliOptions.OutputDir)) {
         std::cerr << "Failed to create output directory " << m_cliOptions.OutputDir << std::endl;
-        return false;
+        return std::nullopt;
     }
 
     if (m_indexFileExists) {
-        std::cout << "Found list of non-indexed files. Only the files contained in this list will be indexed..." << std::endl;
+        out << "Found list of non-indexed files. Only the files contained in this list will be indexed..." << std::endl;
     }
     else {
-        std::cout << "List of non-indexed files not found. Continuing with complete indexing operation..." << std::endl;
+        out << "List of non-indexed files not found. Continuing with complete indexing operation..." << std::endl;
+    }
+
+    out << "Creating list of all .nc files in " << (m_indexFileExists ? m_cliOptions.FileListPath : m_cliOptions.InputDir) << "..." << std::endl;
+    const utils::MemoryPhase phase{ "file list" };
+    auto filePaths{ createFileList(m_indexFileExists ? m_cliOptions.FileListPath : m_cliOptions.InputDir, m_cliOptions.RegexPattern, m_cliOptions.RegexEngine, out) };
+    if (filePaths.size() == 0) {
+        out << "No .nc files found." << "\nExiting..." << std::endl;
+        return std::nullopt;
+    }
+
+    if (const auto order{ utils::parseFileOrder(m_cliOptions.Order) }; order && *order != utils::FILE_ORDER::AS_FOUND) {
+        out << "Ordering files " << m_cliOptions.Order << "..." << std::endl;
+        auto paths{ filePaths.toPaths() };
+        utils::orderFiles(paths, *order);
+        filePaths = utils::toPathStore(paths);
     }
 
-    std::cout << "Creating list of all .nc files in " << (m_indexFileExists ? m_cliOptions.FileListPath : m_cliOptions.InputDir) << "..." << std::endl;
-    const auto& filePaths{ createFileList(m_indexFileExists ? m_cliOptions.FileListPath : m_cliOptions.InputDir, m_cliOptions.RegexPattern, m_cliOptions.RegexEngine) };
-    if (filePaths.empty()) {
-        std::cout << "No .nc files found." << "\nExiting..." << std::endl;
+    return filePaths;
+}
+
+/***********************************************************************************/
+bool TimestampMapper::indexFiles(utils::PathStore filePaths) {
+    if (!insertFiles(std::move(filePaths))) {
         return false;
     }
 
-    if (m_cliOptions.DryRun) {
-        std::copy(filePaths.cbegin(), filePaths.cend(), std::ostream_iterator<std::string>(std::cout, "\n"));
-        std::cout << "Total files found: " << filePaths.size() << '\n';
+    if (m_cliOptions.CatalogPath.empty() || m_cliOptions.DryRun) {
         return true;
     }
 
-    std::cout << "Building dataset description from  " << filePaths.size() << " .nc file(s)." << std::endl;
-    const ds::DatasetDesc datasetDesc{ filePaths, m_datasetType };
-    if (!datasetDesc) {
-        std::cerr << "Failed to find the time dimension in any of the NetCDF files." << std::endl;
+    return updateCatalog();
+}
+
+/***********************************************************************************/
+bool TimestampMapper::updateCatalog() {
+    // Outside WAL mode the dataset database stays locked for as long as it's open.
+    m_database.closeConnection();
+
+    std::cout << "Adding " << m_cliOptions.DatasetName << " to the catalog " << m_cliOptions.CatalogPath << "..." << std::endl;
+    Catalog catalog{ m_cliOptions.CatalogPath };
+    if (!catalog.open()) {
         return false;
     }
 
+    return catalog.importDataset(m_cliOptions.DatasetName, m_datasetType, fs::path(m_cliOptions.OutputDir) / (m_cliOptions.DatasetName + ".sqlite3"));
+}
+
+/***********************************************************************************/
+bool TimestampMapper::insertFiles(utils::PathStore filePaths) {
+    if (m_cliOptions.DryRun) {
+        filePaths.forEach([](const std::string_view path) {
+            std::cout << path << '\n';
+        });
+        std::cout << "Total files found: " << filePaths.size() << '\n';
+        return true;
+    }
+
+    // Opened first so quarantined files can be skipped.
     std::cout << "Opening database..." << std::endl;
     if (!m_database.open()) {
         std::cerr << "Failed to open sqlite database." << std::endl;
         return false;
     }
 
-    std::cout << "Inserting new values into database..." << std::endl;
-    m_database.insertData(datasetDesc);
+    auto filesToRead{ std::move(filePaths) };
+    if (!m_cliOptions.IgnoreQuarantine) {
+        // Usually there are none, and the list needn't be gone through.
+        if (const auto& quarantined{ m_database.selectQuarantinedFiles() }; !quarantined.empty()) {
+            utils::PathStore kept;
+            filesToRead.forEach([&quarantined, &kept](const std::string_view path) {
+                if (quarantined.count(std::string{ path }) == 0) {
+                    kept.add(path);
+                }
+            });
+
+            if (const auto skipped{ filesToRead.size() - kept.size() }; skipped > 0) {
+                std::cout << "Skipping " << skipped << " quarantined file(s) that haven't changed since they failed. Use --ignore-quarantine to read them anyway." << std::endl;
+            }
+            filesToRead = std::move(kept);
+        }
+        if (filesToRead.size() == 0) {
+            std::cout << "Nothing left to index." << std::endl;
+            return true;
+        }
+    }
+
+    // Renamed files keep what's indexed for them; other paths to the same file are read once.
+    // Every listed path gets stat()ed for it, so it's left to --fingerprints.
+    if (const auto matches{ m_cliOptions.Fingerprints ? m_database.applyFingerprints(filesToRead) : FingerprintMatches{} };
+        matches.Renamed > 0 || matches.Duplicates > 0) {
+        std::cout << "Moved " << matches.Renamed << " renamed file(s) to their new paths and skipped " << matches.Duplicates << " duplicate path(s)." << std::endl;
+        if (filesToRead.size() == 0) {
+            std::cout << "Nothing left to index." << std::endl;
+            return true;
+        }
+    }
+
+    // Errors about individual files are written by the logger's own thread.
+    auto& logger{ utils::Logger::instance() };
+    logger.resetCounts();
+    logger.start(utils::parseLogLevel(m_cliOptions.LogLevel).value_or(utils::LOG_LEVEL::INFO));
+
+    std::optional<utils::ProgressBar> pb;
+    if (!m_cliOptions.NoProgress) {
+        pb.emplace(filesToRead.size());
+    }
+
+    ds::ReadOptions readOptions;
+    readOptions.Timeout = std::chrono::seconds(m_cliOptions.ReadTimeout);
+    readOptions.Workers = m_cliOptions.ReadWorkers;
+
+    // --read-workers is the upper bound; start where the fixed default would have.
+    std::optional<utils::ConcurrencyController> concurrency;
+    if (m_cliOptions.AdaptiveReads && m_cliOptions.ReadTimeout > 0) {
+        concurrency.emplace(m_cliOptions.MinReadWorkers, m_cliOptions.ReadWorkers, 4);
+        readOptions.Concurrency = &(*concurrency);
+    }
+    readOptions.Progress = pb ? &(*pb) : nullptr;
+    readOptions.SpatialExtent = m_cliOptions.SpatialExtent;
+    readOptions.Coordinates = m_cliOptions.Coordinates;
+    readOptions.StorageLayouts = m_cliOptions.StorageLayouts;
+
+    // In WAL mode each batch is inserted and committed before the next one is
+    // read, so readers see the first files (the newest, with --order newest-first)
+    // long before the whole run is done. Otherwise the database is locked until
+    // the end anyway, and one bulk load is fastest.
+    const auto batchSize{ m_cliOptions.WAL ? WAL_BATCH_FILES : filesToRead.size() };
+
+    std::cout << "Building dataset description from  " << filesToRead.size() << " .nc file(s)";
+    if (batchSize < filesToRead.size()) {
+        std::cout << ", inserting every " << batchSize << " file(s)";
+    }
+    std::cout << '.' << std::endl;
+
+    std::vector<fs::path> failedFiles;
+    std::size_t timedOutFiles{ 0 };
+    std::size_t filesRead{ 0 };
+    std::optional<ds::DatasetDesc> datasetDesc;
+
+    for (std::size_t begin = 0; begin < filesToRead.size(); begin += batchSize) {
+        const auto end{ std::min(begin + batchSize, filesToRead.size()) };
+        // Only the batch being read is ever held as fs::paths.
+        const auto batch{ filesToRead.toPaths(begin, end - begin) };
+
+        if (m_progressCallback) {
+            readOptions.OnProgress = [this, begin, total{ filesToRead.size() }](const std::size_t filesDone, const std::size_t) {
+                m_progressCallback(begin + filesDone, total);
+            };
+        }
+
+        {
+            const utils::MemoryPhase phase{ "DatasetDesc" };
+            datasetDesc.emplace(batch, m_datasetType, false, readOptions);
+        }
+        m_database.updateQuarantine(*datasetDesc);
+
+        failedFiles.insert(failedFiles.end(), datasetDesc->failedFiles().cbegin(), datasetDesc->failedFiles().cend());
+        timedOutFiles += datasetDesc->timedOutFiles().size();
+        filesRead += batch.size() - datasetDesc->failedFiles().size();
+
+        if (end < filesToRead.size() && *datasetDesc && !m_database.insertData(*datasetDesc)) {
+            if (pb) {
+                pb->endProgressBar();
+            }
+            logger.stop();
+            std::cerr << "Failed to insert the files read so far. The index file was kept." << std::endl;
+            writeFailedFileList(failedFiles);
+            return false;
+        }
+    }
+
+    if (pb) {
+        pb->endProgressBar();
+    }
+    logger.stop();
+    std::cout << filesRead << " of " << filesToRead.size() << " file(s) read";
+    if (timedOutFiles > 0) {
+        std::cout << ", " << timedOutFiles << " timed out";
+    }
+    std::cout << ". " << logger.summary() << std::endl;
+    if (concurrency) {
+        std::cout << concurrency->summary() << std::endl;
+    }
+
+    if (filesRead == 0) {
+        std::cerr << "Failed to find the time dimension in any of the NetCDF files." << std::endl;
+        writeFailedFileList(failedFiles);
+        return false;
+    }
+
+    // The last (or only) batch.
+    if (*datasetDesc) {
+        std::cout << "Inserting new values into database..." << std::endl;
+        if (!m_database.insertData(*datasetDesc)) {
+            std::cerr << "Failed to insert new values into the database. The index file was kept." << std::endl;
+            writeFailedFileList(failedFiles);
+            return false;
+        }
+    }
 
     if (shouldDeleteIndexFile()) {
         std::cout << "Deleting index file." << std::endl;
         deleteIndexFile();
     }
 
+    // After the index file is gone, since it may be the list from the last run.
+    writeFailedFileList(failedFiles);
+
     std::cout << "All done." << std::endl;
 
     return true;
@@ -94,30 +310,81 @@ bool TimestampMapper::createDirectory(const fs::path& path) const noexcept {
 }
 
 /***********************************************************************************/
-std::vector<fs::path> TimestampMapper::createFileList(const fs::path& inputDirOrIndexFile, const std::string& regex, const std::string& engine) const {
+utils::PathStore TimestampMapper::createFileList(const fs::path& inputDirOrIndexFile, const std::string& regex, const std::string& engine, std::ostream& out) const {
+    const utils::TraceSpan span{ "phase", "find files", inputDirOrIndexFile };
 
     // If file_to_index.txt exists, pull the file paths from there.
     const std::unordered_set<std::string> exts{ ".txt", ".diff", ".lst" };
     if (exts.count(inputDirOrIndexFile.extension()) > 0) {
-        std::vector<fs::path> paths;
-        std::ifstream f(inputDirOrIndexFile);
-
-        if (f.is_open()) {
-            const auto& directory{inputDirOrIndexFile.parent_path()};
-            std::string line;
-            while (std::getline(f, line)) {
-                const fs::path p{line};
-                if (supportedFileType(p.extension())) {
-                    paths.emplace_back(directory / p);
-                }
-            }
-            f.close();
+        utils::PathStore store;
+        if (!utils::readFileList(inputDirOrIndexFile, store)) {
+            return utils::PathStore{};
+        }
+        if (store.duplicates() > 0) {
+            out << "Skipped " << store.duplicates() << " duplicate path(s) in " << inputDirOrIndexFile.string() << '.' << std::endl;
+        }
+        if (store.spilledBytes() > 0) {
+            out << "Kept " << store.spilledBytes() / (1024 * 1024) << " MiB of the file list on disk." << std::endl;
+        }
+
+        return store;
+    }
+
+    if (m_cliOptions.NoCrawlCache) {
+        return utils::toPathStore(utils::crawlDirectory(inputDirOrIndexFile, regex, engine));
+    }
+
+    utils::DirectoryCache cache{ crawlCachePath() };
+    cache.load();
+    auto paths{ utils::crawlDirectory(inputDirOrIndexFile, regex, engine, &cache) };
+    out << "Listed " << cache.listedDirectories() << " of " << cache.listedDirectories() + cache.cachedDirectories()
+        << " directories; the rest haven't changed since the last crawl." << std::endl;
+
+    // A dry run leaves the output directory as it was.
+    if (!m_cliOptions.DryRun) {
+        cache.save();
+    }
+
+    return utils::toPathStore(paths);
+}
+
+/***********************************************************************************/
+void TimestampMapper::writeFailedFileList(const std::vector<fs::path>& failedFiles) const {
+    const auto& listPath{ failedFileListPath() };
+
+    if (failedFiles.empty()) {
+        // Don't leave a stale list from an earlier run behind, unless it's
+        // the file list this run was given and still needs.
+        std::error_code e;
+        if (!(m_indexFileExists && fs::equivalent(listPath, m_cliOptions.FileListPath, e))) {
+            fs::remove(listPath, e);
         }
+        return;
+    }
+
+    std::ofstream f(listPath, std::ios::trunc);
+    for (const auto& path : failedFiles) {
+        std::error_code e;
+        const auto& absolute{ fs::absolute(path, e) };
+        f << (e ? path : absolute).string() << '\n';
+    }
 
-        return paths;
+    if (!f) {
+        std::cerr << "Failed to write " << listPath << std::endl;
+        return;
     }
 
-    return utils::crawlDirectory(inputDirOrIndexFile, regex, engine);
+    std::cout << failedFiles.size() << " file(s) couldn't be read. Retry them with --file-list " << listPath.string() << std::endl;
+}
+
+/***********************************************************************************/
+fs::path TimestampMapper::crawlCachePath() const {
+    return fs::path(m_cliOptions.OutputDir) / (m_cliOptions.DatasetName + "_crawl_cache.tsv");
+}
+
+/***********************************************************************************/
+fs::path TimestampMapper::failedFileListPath() const {
+    return fs::path(m_cliOptions.OutputDir) / (m_cliOptions.DatasetName + "_failed_files.lst");
 }
 
 /***********************************************************************************/
@@ -4,10 +4,13 @@
 
 #include <algorithm>
 #include <cctype>
+#include <iostream>
+#include <optional>
 
 #include "CLIOptions.hpp"
 #include "Database.hpp"
 #include "DatasetDesc.hpp"
+#include "Utils/PathStore.hpp"
 
 namespace tsm {
 
@@ -19,6 +22,17 @@ public:
     /// Runs the tool.
     /// Returns true on success, false on failure.
     bool exec();
+    /// First half of exec(): checks the directories and builds the list of files to index.
+    /// Progress goes to out; errors to std::cerr.
+    /// Returns std::nullopt on failure or if there's nothing to index.
+    [[nodiscard]] std::optional<utils::PathStore> findFiles(std::ostream& out = std::cout);
+    /// Second half of exec(): reads the given files and inserts them into the database,
+    /// then adds the database to the --catalog, if any.
+    bool indexFiles(utils::PathStore filePaths);
+    /// Called as files are read by indexFiles().
+    inline void setProgressCallback(ds::ProgressCallback callback) {
+        m_progressCallback = std::move(callback);
+    }
 
 private:
     ///
@@ -34,11 +48,15 @@ private:
     [[nodiscard]] inline auto fileOrDirExists(const fs::path& path) const {
         return fs::exists(path);
     }
+    /// Reads the given files and inserts them into the dataset's database.
+    /// Only the batch being read is taken out of the store as fs::paths.
+    bool insertFiles(utils::PathStore filePaths);
+    /// Replaces the dataset's rows in the --catalog with the contents of its database. Closes the database.
+    bool updateCatalog();
     ///
     [[nodiscard]] bool createDirectory(const fs::path& path) const noexcept;
     ///
-    [[nodiscard]] std::vector<fs::path> 
-                                        createFileList(const fs::path& inputDirOrIndexFile, const std::string& regex, const std::string& engine) const;
+    [[nodiscard]] utils::PathStore createFileList(const fs::path& inputDirOrIndexFile, const std::string& regex, const std::string& engine, std::ostream& out) const;
     ///
     [[nodiscard]] inline auto shouldDeleteIndexFile() const noexcept {
         return m_indexFileExists && !m_cliOptions.KeepIndexFile;
@@ -46,10 +64,18 @@ private:
 
     ///
     void deleteIndexFile();
+    /// Writes the files that couldn't be read to failedFileListPath(), in the format
+    /// createFileList() reads, so they can be retried with --file-list.
+    void writeFailedFileList(const std::vector<fs::path>& failedFiles) const;
+    ///
+    [[nodiscard]] fs::path failedFileListPath() const;
+    /// Where createFileList() keeps the contents of the directories it crawled (see DirectoryCache).
+    [[nodiscard]] fs::path crawlCachePath() const;
 
     const ds::DATASET_TYPE m_datasetType;
     const cli::CLIOptions m_cliOptions;
     bool m_indexFileExists{ false };
+    ds::ProgressCallback m_progressCallback;
 
     Database m_database;
 };
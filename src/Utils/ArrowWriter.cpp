@@ -0,0 +1,477 @@
+#include "ArrowWriter.hpp"
+
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+namespace {
+
+    // Enum values of the Arrow flatbuffer schemas (Schema.fbs, Message.fbs, File.fbs).
+    constexpr std::int16_t METADATA_V5{ 4 };
+    constexpr std::uint8_t HEADER_SCHEMA{ 1 };
+    constexpr std::uint8_t HEADER_DICTIONARY_BATCH{ 2 };
+    constexpr std::uint8_t HEADER_RECORD_BATCH{ 3 };
+    constexpr std::uint8_t TYPE_INT{ 2 };
+    constexpr std::uint8_t TYPE_FLOATING_POINT{ 3 };
+    constexpr std::uint8_t TYPE_UTF8{ 5 };
+    constexpr std::int16_t PRECISION_DOUBLE{ 2 };
+
+    constexpr char MAGIC[]{ "ARROW1" };
+    constexpr std::uint32_t CONTINUATION{ 0xFFFFFFFF };
+
+    /// Builds a flatbuffer front to back: a table is written before what it refers
+    /// to, so every offset points forward, as unsigned offsets have to.
+    class FlatBuilder {
+
+    public:
+        /// A field of a table: a scalar, or a reference to an object written after the table.
+        struct Field {
+            std::uint16_t Slot{ 0 };
+            std::size_t Size{ 0 };
+            std::uint64_t Bits{ 0 };
+            /// Writes the referenced object, returning where it starts.
+            std::function<std::size_t(FlatBuilder&)> Child;
+        };
+
+        template <typename T>
+        static Field scalar(const std::uint16_t slot, const T value) {
+            Field field{ slot, sizeof(T), 0, {} };
+            std::memcpy(&field.Bits, &value, sizeof(T));
+            return field;
+        }
+
+        static Field child(const std::uint16_t slot, std::function<std::size_t(FlatBuilder&)> write) {
+            return { slot, sizeof(std::uint32_t), 0, std::move(write) };
+        }
+
+        /// The finished buffer, with the root table given.
+        static std::vector<std::uint8_t> finish(const std::vector<Field>& root) {
+            FlatBuilder b;
+            const auto rootOffset{ b.put<std::uint32_t>(0) };
+            b.patchOffset(rootOffset, b.table(root));
+            b.align(8);
+
+            return std::move(b.m_bytes);
+        }
+
+        std::size_t table(const std::vector<Field>& fields) {
+            std::uint16_t slots{ 0 };
+            for (const auto& field : fields) {
+                slots = std::max<std::uint16_t>(slots, field.Slot + 1);
+            }
+
+            // The vtable goes first: the table's signed offset to it can point either way.
+            align(4);
+            const auto vtable{ put<std::uint16_t>(static_cast<std::uint16_t>(4 + 2 * slots)) };
+            put<std::uint16_t>(0);
+            for (std::uint16_t i = 0; i < slots; ++i) {
+                put<std::uint16_t>(0);
+            }
+
+            align(4);
+            const auto start{ m_bytes.size() };
+            put<std::int32_t>(static_cast<std::int32_t>(start - vtable));
+
+            std::vector<std::size_t> positions;
+            for (const auto& field : fields) {
+                align(field.Size);
+                const auto position{ m_bytes.size() };
+                m_bytes.resize(position + field.Size);
+                std::memcpy(&m_bytes[position], &field.Bits, field.Size);
+                patch<std::uint16_t>(vtable + 4 + 2 * field.Slot, static_cast<std::uint16_t>(position - start));
+                positions.push_back(position);
+            }
+            patch<std::uint16_t>(vtable + 2, static_cast<std::uint16_t>(m_bytes.size() - start));
+
+            for (std::size_t i = 0; i < fields.size(); ++i) {
+                if (fields[i].Child) {
+                    patchOffset(positions[i], fields[i].Child(*this));
+                }
+            }
+
+            return start;
+        }
+
+        std::size_t tableVector(const std::vector<std::vector<Field>>& tables) {
+            align(4);
+            const auto start{ put<std::uint32_t>(static_cast<std::uint32_t>(tables.size())) };
+            for (std::size_t i = 0; i < tables.size(); ++i) {
+                put<std::uint32_t>(0);
+            }
+            for (std::size_t i = 0; i < tables.size(); ++i) {
+                patchOffset(start + 4 + 4 * i, table(tables[i]));
+            }
+
+            return start;
+        }
+
+        /// Structs of 8-byte alignment, already laid out in bytes.
+        std::size_t structVector(const std::size_t count, const std::vector<std::uint8_t>& bytes) {
+            align(4);
+            if ((m_bytes.size() + 4) % 8 != 0) {
+                put<std::uint32_t>(0);
+            }
+            const auto start{ put<std::uint32_t>(static_cast<std::uint32_t>(count)) };
+            m_bytes.insert(m_bytes.end(), bytes.cbegin(), bytes.cend());
+
+            return start;
+        }
+
+        std::size_t string(const std::string& text) {
+            align(4);
+            const auto start{ put<std::uint32_t>(static_cast<std::uint32_t>(text.size())) };
+            m_bytes.insert(m_bytes.end(), text.cbegin(), text.cend());
+            m_bytes.push_back(0);
+
+            return start;
+        }
+
+    private:
+        void align(const std::size_t n) {
+            while (m_bytes.size() % n != 0) {
+                m_bytes.push_back(0);
+            }
+        }
+
+        template <typename T>
+        std::size_t put(const T value) {
+            align(sizeof(T));
+            const auto position{ m_bytes.size() };
+            m_bytes.resize(position + sizeof(T));
+            std::memcpy(&m_bytes[position], &value, sizeof(T));
+
+            return position;
+        }
+
+        template <typename T>
+        void patch(const std::size_t position, const T value) {
+            std::memcpy(&m_bytes[position], &value, sizeof(T));
+        }
+
+        void patchOffset(const std::size_t position, const std::size_t target) {
+            patch<std::uint32_t>(position, static_cast<std::uint32_t>(target - position));
+        }
+
+        std::vector<std::uint8_t> m_bytes;
+    };
+
+    using Fields = std::vector<FlatBuilder::Field>;
+
+    template <typename T>
+    void appendBytes(std::vector<std::uint8_t>& bytes, const T value) {
+        const auto position{ bytes.size() };
+        bytes.resize(position + sizeof(T));
+        std::memcpy(&bytes[position], &value, sizeof(T));
+    }
+
+    /// Int { bitWidth, is_signed }
+    Fields intType(const std::int32_t bitWidth) {
+        return { FlatBuilder::scalar<std::int32_t>(0, bitWidth), FlatBuilder::scalar<std::uint8_t>(1, 1) };
+    }
+
+    /// Field { name, nullable, type_type, type, dictionary, children }
+    Fields fieldTable(const ArrowField& field, const std::int64_t dictionaryID) {
+        Fields table{
+            FlatBuilder::child(0, [name{ field.Name }](FlatBuilder& b) { return b.string(name); }),
+            FlatBuilder::scalar<std::uint8_t>(1, field.Nullable ? 1 : 0),
+        };
+
+        switch (field.Type) {
+            case ARROW_TYPE::INT64:
+                table.push_back(FlatBuilder::scalar<std::uint8_t>(2, TYPE_INT));
+                table.push_back(FlatBuilder::child(3, [](FlatBuilder& b) { return b.table(intType(64)); }));
+                break;
+            case ARROW_TYPE::FLOAT64:
+                table.push_back(FlatBuilder::scalar<std::uint8_t>(2, TYPE_FLOATING_POINT));
+                table.push_back(FlatBuilder::child(3, [](FlatBuilder& b) {
+                    return b.table({ FlatBuilder::scalar<std::int16_t>(0, PRECISION_DOUBLE) });
+                }));
+                break;
+            case ARROW_TYPE::UTF8:
+                table.push_back(FlatBuilder::scalar<std::uint8_t>(2, TYPE_UTF8));
+                table.push_back(FlatBuilder::child(3, [](FlatBuilder& b) { return b.table({}); }));
+                break;
+        }
+
+        // DictionaryEncoding { id, indexType }
+        if (field.Dictionary) {
+            table.push_back(FlatBuilder::child(4, [dictionaryID](FlatBuilder& b) {
+                return b.table({ FlatBuilder::scalar<std::int64_t>(0, dictionaryID),
+                                 FlatBuilder::child(1, [](FlatBuilder& c) { return c.table(intType(32)); }) });
+            }));
+        }
+
+        // Readers insist on the list, even when it's empty.
+        table.push_back(FlatBuilder::child(5, [](FlatBuilder& b) { return b.tableVector({}); }));
+
+        return table;
+    }
+
+    /// Schema { endianness, fields }
+    Fields schemaTable(const std::vector<ArrowField>& fields) {
+        std::vector<Fields> fieldTables;
+        for (std::size_t i = 0; i < fields.size(); ++i) {
+            fieldTables.push_back(fieldTable(fields[i], static_cast<std::int64_t>(i)));
+        }
+
+        return { FlatBuilder::child(1, [fieldTables{ std::move(fieldTables) }](FlatBuilder& b) { return b.tableVector(fieldTables); }) };
+    }
+
+    /// Message { version, header_type, header, bodyLength }
+    std::vector<std::uint8_t> message(const std::uint8_t headerType, Fields header, const std::size_t bodyLength) {
+        return FlatBuilder::finish({ FlatBuilder::scalar<std::int16_t>(0, METADATA_V5),
+                                     FlatBuilder::scalar<std::uint8_t>(1, headerType),
+                                     FlatBuilder::child(2, [header{ std::move(header) }](FlatBuilder& b) { return b.table(header); }),
+                                     FlatBuilder::scalar<std::int64_t>(3, static_cast<std::int64_t>(bodyLength)) });
+    }
+
+    /// RecordBatch { length, nodes, buffers }
+    Fields recordBatch(const std::int64_t length, const std::size_t columns, std::vector<std::uint8_t> nodes, const std::size_t buffers, std::vector<std::uint8_t> bufferBytes) {
+        return { FlatBuilder::scalar<std::int64_t>(0, length),
+                 FlatBuilder::child(1, [columns, nodes{ std::move(nodes) }](FlatBuilder& b) { return b.structVector(columns, nodes); }),
+                 FlatBuilder::child(2, [buffers, bufferBytes{ std::move(bufferBytes) }](FlatBuilder& b) { return b.structVector(buffers, bufferBytes); }) };
+    }
+}
+
+/***********************************************************************************/
+void ArrowColumn::setValid(const bool valid) {
+    if (m_length % 8 == 0) {
+        m_validity.push_back(0);
+    }
+    if (valid) {
+        m_validity.back() |= static_cast<std::uint8_t>(1u << (m_length % 8));
+    }
+    else {
+        ++m_nullCount;
+    }
+    ++m_length;
+}
+
+/***********************************************************************************/
+void ArrowColumn::append(const std::int64_t value) {
+    appendBytes(m_values, value);
+    setValid(true);
+}
+
+/***********************************************************************************/
+void ArrowColumn::append(const double value) {
+    appendBytes(m_values, value);
+    setValid(true);
+}
+
+/***********************************************************************************/
+void ArrowColumn::append(const std::string_view value) {
+    m_values.insert(m_values.end(), value.cbegin(), value.cend());
+    m_offsets.push_back(static_cast<std::int32_t>(std::min<std::size_t>(m_values.size(), std::numeric_limits<std::int32_t>::max())));
+    setValid(true);
+}
+
+/***********************************************************************************/
+void ArrowColumn::appendIndex(const std::int32_t index) {
+    appendBytes(m_values, index);
+    setValid(true);
+}
+
+/***********************************************************************************/
+void ArrowColumn::appendNull() {
+    if (m_indices) {
+        appendBytes<std::int32_t>(m_values, 0);
+    }
+    else if (m_type == ARROW_TYPE::UTF8) {
+        m_offsets.push_back(m_offsets.back());
+    }
+    else {
+        appendBytes<std::int64_t>(m_values, 0);
+    }
+    setValid(false);
+}
+
+/***********************************************************************************/
+void ArrowColumn::clear() {
+    m_length = 0;
+    m_nullCount = 0;
+    m_validity.clear();
+    m_values.clear();
+    m_offsets.resize(1);
+}
+
+/***********************************************************************************/
+ArrowWriter::ArrowWriter(fs::path path, std::vector<ArrowField> fields) : m_path{ std::move(path) },
+                                                                           m_fields{ std::move(fields) } {}
+
+/***********************************************************************************/
+bool ArrowWriter::open() {
+    m_file.open(m_path, std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open()) {
+        std::cerr << "Failed to create " << m_path << '.' << std::endl;
+        return false;
+    }
+
+    // The magic, padded to 8 bytes.
+    m_file.write(MAGIC, 6);
+    m_file.write("\0\0", 2);
+    m_offset = 8;
+
+    return writeMessage(message(HEADER_SCHEMA, schemaTable(m_fields), 0), {}, nullptr);
+}
+
+/***********************************************************************************/
+bool ArrowWriter::writeDictionary(const std::size_t field, const ArrowColumn& values) {
+    BatchLayout layout;
+    if (!layOut({ &values }, layout)) {
+        return false;
+    }
+
+    // DictionaryBatch { id, data }
+    auto data{ recordBatch(layout.Length, 1, std::move(layout.Nodes), layout.BufferCount, std::move(layout.Buffers)) };
+    const auto& metadata{ message(HEADER_DICTIONARY_BATCH,
+                                  { FlatBuilder::scalar<std::int64_t>(0, static_cast<std::int64_t>(field)),
+                                    FlatBuilder::child(1, [data{ std::move(data) }](FlatBuilder& b) { return b.table(data); }) },
+                                  layout.Body.size()) };
+
+    m_dictionaries.emplace_back();
+    return writeMessage(metadata, layout.Body, &m_dictionaries.back());
+}
+
+/***********************************************************************************/
+bool ArrowWriter::writeBatch(const std::vector<ArrowColumn>& columns) {
+    if (columns.size() != m_fields.size()) {
+        std::cerr << "Arrow record batch has " << columns.size() << " column(s), expected " << m_fields.size() << '.' << std::endl;
+        return false;
+    }
+
+    std::vector<const ArrowColumn*> pointers;
+    for (const auto& column : columns) {
+        pointers.push_back(&column);
+    }
+
+    BatchLayout layout;
+    if (!layOut(pointers, layout)) {
+        return false;
+    }
+
+    auto batch{ recordBatch(layout.Length, columns.size(), std::move(layout.Nodes), layout.BufferCount, std::move(layout.Buffers)) };
+    m_recordBatches.emplace_back();
+    return writeMessage(message(HEADER_RECORD_BATCH, std::move(batch), layout.Body.size()), layout.Body, &m_recordBatches.back());
+}
+
+/***********************************************************************************/
+bool ArrowWriter::close() {
+    // End-of-stream marker, then the footer, so the file can also be read as a stream.
+    const std::uint32_t endOfStream[]{ CONTINUATION, 0 };
+    m_file.write(reinterpret_cast<const char*>(endOfStream), sizeof(endOfStream));
+
+    // Block { offset, metaDataLength, bodyLength }, 24 bytes with padding.
+    const auto blocks = [](const std::vector<Block>& list) {
+        std::vector<std::uint8_t> bytes;
+        for (const auto& block : list) {
+            appendBytes(bytes, block.Offset);
+            appendBytes(bytes, block.MetadataLength);
+            appendBytes<std::int32_t>(bytes, 0);
+            appendBytes(bytes, block.BodyLength);
+        }
+        return bytes;
+    };
+
+    // Footer { version, schema, dictionaries, recordBatches }
+    const auto& footer{ FlatBuilder::finish({
+        FlatBuilder::scalar<std::int16_t>(0, METADATA_V5),
+        FlatBuilder::child(1, [this](FlatBuilder& b) { return b.table(schemaTable(m_fields)); }),
+        FlatBuilder::child(2, [n{ m_dictionaries.size() }, bytes{ blocks(m_dictionaries) }](FlatBuilder& b) { return b.structVector(n, bytes); }),
+        FlatBuilder::child(3, [n{ m_recordBatches.size() }, bytes{ blocks(m_recordBatches) }](FlatBuilder& b) { return b.structVector(n, bytes); }),
+    }) };
+
+    const auto footerLength{ static_cast<std::int32_t>(footer.size()) };
+    m_file.write(reinterpret_cast<const char*>(footer.data()), static_cast<std::streamsize>(footer.size()));
+    m_file.write(reinterpret_cast<const char*>(&footerLength), sizeof(footerLength));
+    m_file.write(MAGIC, 6);
+    m_file.close();
+
+    if (!m_file) {
+        std::cerr << "Failed to write " << m_path << '.' << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/***********************************************************************************/
+std::vector<ArrowColumn> ArrowWriter::makeColumns() const {
+    std::vector<ArrowColumn> columns;
+    columns.reserve(m_fields.size());
+    for (const auto& field : m_fields) {
+        columns.emplace_back(field.Type, field.Dictionary);
+    }
+
+    return columns;
+}
+
+/***********************************************************************************/
+bool ArrowWriter::layOut(const std::vector<const ArrowColumn*>& columns, BatchLayout& layout) {
+    auto& body{ layout.Body };
+    const auto addBuffer = [&layout, &body](const void* data, const std::size_t size) {
+        // Buffer { offset, length }
+        appendBytes<std::int64_t>(layout.Buffers, static_cast<std::int64_t>(body.size()));
+        appendBytes<std::int64_t>(layout.Buffers, static_cast<std::int64_t>(size));
+        const auto bytes{ static_cast<const std::uint8_t*>(data) };
+        body.insert(body.end(), bytes, bytes + size);
+        body.resize((body.size() + 7) / 8 * 8);
+        ++layout.BufferCount;
+    };
+
+    const auto length{ columns.empty() ? 0 : columns.front()->size() };
+    layout.Length = static_cast<std::int64_t>(length);
+    for (const auto* column : columns) {
+        if (column->size() != length) {
+            std::cerr << "Arrow record batch columns differ in length." << std::endl;
+            return false;
+        }
+
+        // FieldNode { length, null_count }
+        appendBytes<std::int64_t>(layout.Nodes, static_cast<std::int64_t>(column->size()));
+        appendBytes<std::int64_t>(layout.Nodes, static_cast<std::int64_t>(column->nullCount()));
+
+        // Validity can be left out when nothing is null.
+        addBuffer(column->m_validity.data(), column->nullCount() > 0 ? column->m_validity.size() : 0);
+        if (column->m_type == ARROW_TYPE::UTF8 && !column->m_indices) {
+            if (column->m_values.size() > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+                std::cerr << "More than 2 GiB of text in one Arrow record batch." << std::endl;
+                return false;
+            }
+            addBuffer(column->m_offsets.data(), column->m_offsets.size() * sizeof(std::int32_t));
+        }
+        addBuffer(column->m_values.data(), column->m_values.size());
+    }
+
+    return true;
+}
+
+/***********************************************************************************/
+bool ArrowWriter::writeMessage(const std::vector<std::uint8_t>& metadata, const std::vector<std::uint8_t>& body, Block* block) {
+    // The metadata is already a multiple of 8 bytes, so the body starts aligned.
+    const std::uint32_t prefix[]{ CONTINUATION, static_cast<std::uint32_t>(metadata.size()) };
+
+    if (block) {
+        block->Offset = m_offset;
+        block->MetadataLength = static_cast<std::int32_t>(sizeof(prefix) + metadata.size());
+        block->BodyLength = static_cast<std::int64_t>(body.size());
+    }
+
+    m_file.write(reinterpret_cast<const char*>(prefix), sizeof(prefix));
+    m_file.write(reinterpret_cast<const char*>(metadata.data()), static_cast<std::streamsize>(metadata.size()));
+    m_file.write(reinterpret_cast<const char*>(body.data()), static_cast<std::streamsize>(body.size()));
+    m_offset += static_cast<std::int64_t>(sizeof(prefix) + metadata.size() + body.size());
+
+    if (!m_file) {
+        std::cerr << "Failed to write " << m_path << '.' << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace tsm::utils
@@ -0,0 +1,143 @@
+#pragma once
+
+// A self-contained writer of Arrow IPC files (the "Feather v2" format read by
+// pyarrow.ipc.open_file, pyarrow.feather, polars.read_ipc and pandas.read_feather),
+// covering the few column types the index needs. Buffers are 8-byte aligned, so the
+// files can be memory-mapped as they are.
+//
+// https://arrow.apache.org/docs/format/Columnar.html#ipc-file-format
+
+#include "../Filesystem.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tsm::utils {
+
+/// Logical type of a column.
+enum class ARROW_TYPE {
+    INT64 = 0,
+    FLOAT64,
+    UTF8
+};
+
+/***********************************************************************************/
+/// A column of the schema. A dictionary-encoded column holds int32 indices into a
+/// dictionary of Type values, which are written once with writeDictionary().
+struct ArrowField {
+    std::string Name;
+    ARROW_TYPE Type{ ARROW_TYPE::INT64 };
+    bool Nullable{ false };
+    bool Dictionary{ false };
+};
+
+/***********************************************************************************/
+/// The values of one column of a record batch (or of a dictionary).
+class ArrowColumn {
+
+public:
+    /// indices: holds dictionary indices of type values.
+    explicit ArrowColumn(const ARROW_TYPE type, const bool indices = false) : m_type{ type },
+                                                                             m_indices{ indices } {}
+
+    /// For INT64 columns.
+    void append(const std::int64_t value);
+    /// For FLOAT64 columns.
+    void append(const double value);
+    /// For UTF8 columns.
+    void append(const std::string_view value);
+    /// For dictionary-encoded columns.
+    void appendIndex(const std::int32_t index);
+    ///
+    void appendNull();
+
+    ///
+    [[nodiscard]] std::size_t size() const noexcept {
+        return m_length;
+    }
+    ///
+    [[nodiscard]] std::size_t nullCount() const noexcept {
+        return m_nullCount;
+    }
+    /// Empties the column for the next batch, keeping its memory.
+    void clear();
+
+private:
+    friend class ArrowWriter;
+
+    void setValid(const bool valid);
+
+    ARROW_TYPE m_type;
+    bool m_indices;
+    std::size_t m_length{ 0 };
+    std::size_t m_nullCount{ 0 };
+    /// One bit per value, least significant first.
+    std::vector<std::uint8_t> m_validity;
+    /// Fixed-width values, or the characters of UTF8 values.
+    std::vector<std::uint8_t> m_values;
+    /// UTF8 only: where each value starts in m_values, plus the end.
+    std::vector<std::int32_t> m_offsets{ 0 };
+};
+
+/***********************************************************************************/
+/// Writes a schema, then dictionaries, then any number of record batches, then the
+/// footer (close()). Only what is being written is held in memory.
+class ArrowWriter {
+
+public:
+    ///
+    ArrowWriter(fs::path path, std::vector<ArrowField> fields);
+
+    ArrowWriter(const ArrowWriter&) = delete;
+    ArrowWriter& operator=(const ArrowWriter&) = delete;
+
+    /// Creates the file and writes the schema. False (and the error on stderr) if it can't.
+    [[nodiscard]] bool open();
+    /// The dictionary of a dictionary-encoded field, before any record batch.
+    [[nodiscard]] bool writeDictionary(const std::size_t field, const ArrowColumn& values);
+    /// One column per field, of the same length.
+    [[nodiscard]] bool writeBatch(const std::vector<ArrowColumn>& columns);
+    /// Writes the footer. The file is incomplete (and unreadable) until then.
+    [[nodiscard]] bool close();
+
+    /// Columns matching the fields, for filling a batch. Dictionary-encoded ones hold indices.
+    [[nodiscard]] std::vector<ArrowColumn> makeColumns() const;
+
+private:
+    /// Where an encapsulated message is in the file, for the footer.
+    struct Block {
+        std::int64_t Offset{ 0 };
+        std::int32_t MetadataLength{ 0 };
+        std::int64_t BodyLength{ 0 };
+    };
+
+    /// The buffers of a record batch, and their description.
+    struct BatchLayout {
+        std::int64_t Length{ 0 };
+        /// FieldNode structs, one per column.
+        std::vector<std::uint8_t> Nodes;
+        /// Buffer structs (offset and length in Body).
+        std::vector<std::uint8_t> Buffers;
+        std::size_t BufferCount{ 0 };
+        std::vector<std::uint8_t> Body;
+    };
+
+    /// Lays out the buffers of columns, 8-byte aligned. False if they differ in
+    /// length, or one holds more text than 32-bit offsets can address.
+    [[nodiscard]] static bool layOut(const std::vector<const ArrowColumn*>& columns, BatchLayout& layout);
+    /// Writes a message with its body; Block of where it went.
+    [[nodiscard]] bool writeMessage(const std::vector<std::uint8_t>& metadata, const std::vector<std::uint8_t>& body, Block* block);
+
+    const fs::path m_path;
+    const std::vector<ArrowField> m_fields;
+    std::ofstream m_file;
+    std::int64_t m_offset{ 0 };
+    std::vector<Block> m_dictionaries;
+    std::vector<Block> m_recordBatches;
+};
+
+} // namespace tsm::utils
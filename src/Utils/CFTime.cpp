@@ -0,0 +1,343 @@
+#include "CFTime.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+namespace {
+
+    constexpr std::int64_t SECONDS_PER_DAY{ 86400 };
+    // Anything further out overflows once scaled, and isn't a date anyway.
+    constexpr double MAX_SECONDS{ 1e17 };
+
+    /// Days since 1970-01-01 (Gregorian) of a Julian calendar date.
+    constexpr std::int64_t daysFromJulian(const std::int64_t y, const unsigned m, const unsigned d) noexcept {
+        const std::int64_t a{ (14 - static_cast<std::int64_t>(m)) / 12 };
+        const auto yy{ y + 4800 - a };
+        const auto mm{ static_cast<std::int64_t>(m) + 12 * a - 3 };
+        const auto julianDay{ d + (153 * mm + 2) / 5 + 365 * yy + yy / 4 - 32083 };
+
+        return julianDay - 2440588;
+    }
+
+    constexpr std::int64_t EPOCH_DAYS{ daysFromCivil(CANONICAL_EPOCH_YEAR, 1, 1) };
+
+    constexpr bool isLeapYear(const std::int64_t y) noexcept {
+        return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    }
+
+    constexpr std::int64_t floorDiv(const std::int64_t a, const std::int64_t b) noexcept {
+        return a / b - (a % b != 0 && (a < 0) != (b < 0));
+    }
+
+    /// Canonical seconds at the start of Gregorian year y.
+    constexpr std::int64_t yearStart(const std::int64_t y) noexcept {
+        return (daysFromCivil(y, 1, 1) - EPOCH_DAYS) * SECONDS_PER_DAY;
+    }
+
+    constexpr unsigned NOLEAP_MONTH_DAYS[]{ 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    constexpr unsigned NOLEAP_DAYS_BEFORE[]{ 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+    std::string lowercase(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](const unsigned char c) { return std::tolower(c); });
+        return s;
+    }
+
+    std::optional<CALENDAR> parseCalendar(const std::string& calendar) {
+        const auto& name{ lowercase(calendar) };
+        if (name.empty() || name == "standard" || name == "gregorian") {
+            return CALENDAR::STANDARD;
+        }
+        if (name == "proleptic_gregorian") {
+            return CALENDAR::PROLEPTIC_GREGORIAN;
+        }
+        if (name == "julian") {
+            return CALENDAR::JULIAN;
+        }
+        if (name == "noleap" || name == "365_day") {
+            return CALENDAR::NOLEAP;
+        }
+        if (name == "360_day") {
+            return CALENDAR::DAY_360;
+        }
+
+        return std::nullopt;
+    }
+
+    /// Seconds per unit; 0 if unknown.
+    double parseUnit(const std::string& unit) {
+        if (unit == "seconds" || unit == "second" || unit == "secs" || unit == "sec" || unit == "s") {
+            return 1.0;
+        }
+        if (unit == "minutes" || unit == "minute" || unit == "mins" || unit == "min") {
+            return 60.0;
+        }
+        if (unit == "hours" || unit == "hour" || unit == "hrs" || unit == "hr" || unit == "h") {
+            return 3600.0;
+        }
+        if (unit == "days" || unit == "day" || unit == "d") {
+            return 86400.0;
+        }
+        if (unit == "milliseconds" || unit == "millisecond" || unit == "msecs" || unit == "msec" || unit == "ms") {
+            return 0.001;
+        }
+
+        return 0.0;
+    }
+
+    /// Reads up to maxDigits digits at pos. False if there are none.
+    bool readNumber(const std::string& s, std::size_t& pos, const std::size_t maxDigits, std::int64_t& value) {
+        const auto begin{ pos };
+        value = 0;
+        while (pos < s.size() && pos - begin < maxDigits && std::isdigit(static_cast<unsigned char>(s[pos]))) {
+            value = value * 10 + (s[pos++] - '0');
+        }
+
+        return pos > begin;
+    }
+
+    bool skip(const std::string& s, std::size_t& pos, const char c) {
+        if (pos < s.size() && s[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    void skipSpaces(const std::string& s, std::size_t& pos) {
+        while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos]))) {
+            ++pos;
+        }
+    }
+
+    /// Days since the canonical epoch, counted in calendar. std::nullopt if the date doesn't exist in it.
+    std::optional<std::int64_t> daysInCalendar(const CALENDAR calendar, const std::int64_t y, const unsigned m, const unsigned d) {
+        if (m < 1 || m > 12 || d < 1) {
+            return std::nullopt;
+        }
+
+        switch (calendar) {
+            case CALENDAR::DAY_360:
+                if (d > 30) {
+                    return std::nullopt;
+                }
+                return (y - CANONICAL_EPOCH_YEAR) * 360 + (m - 1) * 30 + (d - 1);
+            case CALENDAR::NOLEAP:
+                if (d > NOLEAP_MONTH_DAYS[m - 1]) {
+                    return std::nullopt;
+                }
+                return (y - CANONICAL_EPOCH_YEAR) * 365 + NOLEAP_DAYS_BEFORE[m - 1] + (d - 1);
+            default:
+                break;
+        }
+
+        // Standard: the Julian calendar up to 1582-10-04, followed by 1582-10-15 (Gregorian).
+        const auto date{ y * 10000 + m * 100 + d };
+        if (calendar == CALENDAR::STANDARD && date > 15821004 && date < 15821015) {
+            return std::nullopt;
+        }
+        const auto julian{ calendar == CALENDAR::JULIAN || (calendar == CALENDAR::STANDARD && date < 15821015) };
+
+        const auto leap{ julian ? y % 4 == 0 : isLeapYear(y) };
+        if (d > NOLEAP_MONTH_DAYS[m - 1] + (m == 2 && leap ? 1 : 0)) {
+            return std::nullopt;
+        }
+
+        return (julian ? daysFromJulian(y, m, d) : daysFromCivil(y, m, d)) - EPOCH_DAYS;
+    }
+
+    /// Maps seconds counted in a calendar without a Gregorian counterpart to canonical seconds.
+    void mapCalendar(const CALENDAR calendar, std::int64_t* seconds, const std::size_t count) {
+        if (calendar == CALENDAR::NOLEAP) {
+            constexpr auto YEAR{ 365 * SECONDS_PER_DAY };
+            // Same date: a day later from March 1st of leap years on.
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto year{ floorDiv(seconds[i], YEAR) };
+                const auto rem{ seconds[i] - year * YEAR };
+                const auto y{ CANONICAL_EPOCH_YEAR + year };
+                seconds[i] = yearStart(y) + rem + (isLeapYear(y) && rem >= 59 * SECONDS_PER_DAY ? SECONDS_PER_DAY : 0);
+            }
+        }
+        else if (calendar == CALENDAR::DAY_360) {
+            constexpr auto YEAR{ 360 * SECONDS_PER_DAY };
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto year{ floorDiv(seconds[i], YEAR) };
+                const auto rem{ seconds[i] - year * YEAR };
+                const auto y{ CANONICAL_EPOCH_YEAR + year };
+                seconds[i] = yearStart(y) + rem * (isLeapYear(y) ? 366 : 365) / 360;
+            }
+        }
+    }
+
+    /// Checks and narrows seconds to out, after mapping them to the Gregorian calendar if need be.
+    bool finish(const TimeUnits& units, std::int64_t* seconds, const std::size_t count, ds::timestamp_t* out) {
+        mapCalendar(units.Calendar, seconds, count);
+
+        std::int64_t lowest{ 0 };
+        for (std::size_t i = 0; i < count; ++i) {
+            lowest = std::min(lowest, seconds[i]);
+        }
+        if (lowest < 0) {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<ds::timestamp_t>(seconds[i]);
+        }
+
+        return true;
+    }
+}
+
+/***********************************************************************************/
+std::optional<TimeUnits> parseTimeUnits(const std::string& units, const std::string& calendar) {
+    TimeUnits result;
+
+    if (const auto& parsed{ parseCalendar(calendar) }; parsed) {
+        result.Calendar = *parsed;
+    }
+    else {
+        return std::nullopt;
+    }
+
+    const auto& text{ lowercase(units) };
+    const auto since{ text.find(" since ") };
+    if (since == std::string::npos) {
+        return std::nullopt;
+    }
+
+    auto unitBegin{ text.find_first_not_of(" \t") };
+    result.Scale = parseUnit(text.substr(unitBegin, text.find_last_not_of(" \t", since) + 1 - unitBegin));
+    if (result.Scale <= 0.0) {
+        return std::nullopt;
+    }
+    result.IntegerScale = result.Scale >= 1.0 ? static_cast<std::int64_t>(result.Scale) : 0;
+
+    // <date>: Y-M-D
+    std::size_t pos{ since + 7 };
+    skipSpaces(text, pos);
+    const auto negative{ skip(text, pos, '-') };
+    std::int64_t year{ 0 }, month{ 0 }, day{ 0 };
+    if (!readNumber(text, pos, 6, year) || !skip(text, pos, '-') || !readNumber(text, pos, 2, month) ||
+        !skip(text, pos, '-') || !readNumber(text, pos, 2, day)) {
+        return std::nullopt;
+    }
+    if (negative) {
+        year = -year;
+    }
+
+    // [T| ]<time>: H[:M[:S[.fff]]]
+    std::int64_t secondOfDay{ 0 };
+    if (!skip(text, pos, 't')) {
+        skipSpaces(text, pos);
+    }
+    if (std::int64_t hour{ 0 }; readNumber(text, pos, 2, hour)) {
+        std::int64_t minute{ 0 }, second{ 0 };
+        if (skip(text, pos, ':') && readNumber(text, pos, 2, minute) && skip(text, pos, ':') && readNumber(text, pos, 2, second)) {
+            // Fractions of a second in the reference date are dropped.
+            if (skip(text, pos, '.')) {
+                std::int64_t fraction{ 0 };
+                readNumber(text, pos, 32, fraction);
+            }
+        }
+        if (hour > 23 || minute > 59 || second > 60) {
+            return std::nullopt;
+        }
+        secondOfDay = hour * 3600 + minute * 60 + second;
+    }
+
+    // [<zone>]: Z, UTC, GMT or +/-H[H][[:]MM]
+    skipSpaces(text, pos);
+    std::int64_t zoneOffset{ 0 };
+    if (text.compare(pos, 3, "utc") == 0 || text.compare(pos, 3, "gmt") == 0) {
+        pos += 3;
+    }
+    else if (!skip(text, pos, 'z') && pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+        const auto sign{ text[pos++] == '-' ? -1 : 1 };
+        std::int64_t hours{ 0 }, minutes{ 0 };
+        if (!readNumber(text, pos, 2, hours)) {
+            return std::nullopt;
+        }
+        skip(text, pos, ':');
+        readNumber(text, pos, 2, minutes);
+        zoneOffset = sign * (hours * 3600 + minutes * 60);
+    }
+    skipSpaces(text, pos);
+    if (pos != text.size()) {
+        return std::nullopt;
+    }
+
+    const auto& days{ daysInCalendar(result.Calendar, year, static_cast<unsigned>(month), static_cast<unsigned>(day)) };
+    if (!days) {
+        return std::nullopt;
+    }
+    result.Reference = *days * SECONDS_PER_DAY + secondOfDay - zoneOffset;
+
+    return result;
+}
+
+/***********************************************************************************/
+std::optional<TimeUnits> cachedTimeUnits(const std::string& units, const std::string& calendar) {
+    static std::mutex mutex;
+    static std::map<std::pair<std::string, std::string>, std::optional<TimeUnits>> cache;
+
+    std::lock_guard<std::mutex> lock{ mutex };
+    auto key{ std::make_pair(units, calendar) };
+    if (const auto it{ cache.find(key) }; it != cache.cend()) {
+        return it->second;
+    }
+
+    return cache.emplace(std::move(key), parseTimeUnits(units, calendar)).first->second;
+}
+
+/***********************************************************************************/
+bool toCanonicalTimestamps(const TimeUnits& units, const double* values, const std::size_t count, ds::timestamp_t* out) {
+    std::vector<std::int64_t> seconds(count);
+
+    // Branch-free, so it vectorizes; NaN fails both comparisons.
+    const auto scale{ units.Scale };
+    const auto reference{ static_cast<double>(units.Reference) };
+    auto inRange{ true };
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto s{ std::floor(values[i] * scale + 0.5) + reference };
+        inRange &= s >= -MAX_SECONDS && s <= MAX_SECONDS;
+        seconds[i] = static_cast<std::int64_t>(inRange ? s : 0.0);
+    }
+    if (!inRange) {
+        return false;
+    }
+
+    return finish(units, seconds.data(), count, out);
+}
+
+/***********************************************************************************/
+bool toCanonicalTimestamps(const TimeUnits& units, const std::int64_t* values, const std::size_t count, ds::timestamp_t* out) {
+    if (units.IntegerScale == 0) {
+        const std::vector<double> asDouble(values, values + count);
+        return toCanonicalTimestamps(units, asDouble.data(), count, out);
+    }
+
+    std::vector<std::int64_t> seconds(count);
+
+    const auto scale{ units.IntegerScale };
+    const auto limit{ static_cast<std::int64_t>(MAX_SECONDS) / scale };
+    auto inRange{ true };
+    for (std::size_t i = 0; i < count; ++i) {
+        inRange &= values[i] >= -limit && values[i] <= limit;
+        seconds[i] = units.Reference + (inRange ? values[i] : 0) * scale;
+    }
+    if (!inRange) {
+        return false;
+    }
+
+    return finish(units, seconds.data(), count, out);
+}
+
+} // namespace tsm::utils
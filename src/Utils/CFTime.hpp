@@ -0,0 +1,79 @@
+#pragma once
+
+// Decoding of CF time coordinates ("days since 1950-01-01", calendar "noleap", ...)
+// into one canonical timestamp, so timestamps of datasets with different units and
+// calendars compare and range-query directly.
+
+#include "../TypeTimestamp.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace tsm::utils {
+
+/// Calendars of the CF conventions that can be decoded.
+enum class CALENDAR {
+    /// "standard" / "gregorian": Julian before 1582-10-15, Gregorian from then on.
+    STANDARD = 0,
+    PROLEPTIC_GREGORIAN,
+    JULIAN,
+    /// "noleap" / "365_day".
+    NOLEAP,
+    /// "360_day": twelve months of 30 days.
+    DAY_360
+};
+
+/// The canonical timestamp is seconds since this Gregorian date, 00:00:00 UTC.
+/// Only files whose times were already in seconds since then keep the values they
+/// were indexed with before; the rest change (see TIMESTAMP_FORMAT_VERSION).
+constexpr int CANONICAL_EPOCH_YEAR{ 1950 };
+
+/***********************************************************************************/
+/// Days since 1970-01-01 of a proleptic Gregorian date.
+/// http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+constexpr std::int64_t daysFromCivil(std::int64_t y, const unsigned m, const unsigned d) noexcept {
+    y -= m <= 2;
+    const std::int64_t era{ (y >= 0 ? y : y - 399) / 400 };
+    const auto yoe{ static_cast<unsigned>(y - era * 400) };
+    const auto doy{ (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1 };
+    const auto doe{ yoe * 365 + yoe / 4 - yoe / 100 + doy };
+
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+/***********************************************************************************/
+/// A parsed units attribute, e.g. "hours since 1900-01-01 00:00:00 +01:00".
+struct TimeUnits {
+    CALENDAR Calendar{ CALENDAR::STANDARD };
+    /// Seconds per unit (0.001 for milliseconds).
+    double Scale{ 1.0 };
+    /// Seconds per unit when that's a whole number, so integer values are converted exactly.
+    std::int64_t IntegerScale{ 1 };
+    /// The reference date, as seconds since CANONICAL_EPOCH_YEAR-01-01 counted in Calendar.
+    std::int64_t Reference{ 0 };
+};
+
+/***********************************************************************************/
+/// Parses "<unit> since <date>[ <time>][ <zone>]" and a calendar attribute (empty means
+/// standard). Units are seconds, minutes, hours, days or milliseconds; months and
+/// years aren't, being ambiguous in CF. std::nullopt if either can't be decoded.
+[[nodiscard]] std::optional<TimeUnits> parseTimeUnits(const std::string& units, const std::string& calendar);
+
+/***********************************************************************************/
+/// parseTimeUnits(), parsed only once per distinct pair (files of a dataset share one).
+/// Thread-safe.
+[[nodiscard]] std::optional<TimeUnits> cachedTimeUnits(const std::string& units, const std::string& calendar);
+
+/***********************************************************************************/
+/// Converts count time values to canonical timestamps, rounded to the nearest second.
+/// Dates of the noleap and 360_day calendars don't all exist in the Gregorian one:
+/// noleap dates map to the same Gregorian date, and 360_day years are stretched over
+/// the Gregorian year, so both stay in order and distinct.
+/// False (and out unspecified) if a value isn't finite or is before the canonical epoch.
+[[nodiscard]] bool toCanonicalTimestamps(const TimeUnits& units, const double* values, const std::size_t count, ds::timestamp_t* out);
+/// As above, exact for integer values with whole-second units.
+[[nodiscard]] bool toCanonicalTimestamps(const TimeUnits& units, const std::int64_t* values, const std::size_t count, ds::timestamp_t* out);
+
+} // namespace tsm::utils
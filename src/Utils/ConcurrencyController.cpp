@@ -0,0 +1,116 @@
+#include "ConcurrencyController.hpp"
+
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+ConcurrencyController::ConcurrencyController(const std::size_t minimum, const std::size_t maximum, const std::size_t initial) :
+                                                                                        m_min{ std::max<std::size_t>(1, minimum) },
+                                                                                        m_max{ std::max(m_min, maximum) },
+                                                                                        m_initial{ std::clamp(initial, m_min, m_max) },
+                                                                                        m_start{ Clock::now() },
+                                                                                        m_limit{ m_initial },
+                                                                                        m_peak{ m_initial },
+                                                                                        m_windowStart{ m_start } {}
+
+/***********************************************************************************/
+void ConcurrencyController::onComplete(const std::chrono::microseconds latency, const Clock::time_point now /* = Clock::now() */) {
+    m_windowLatency += latency;
+    if (++m_windowReads < std::max(MIN_WINDOW_READS, m_limit)) {
+        return;
+    }
+
+    const auto meanLatencyMs{ static_cast<double>(m_windowLatency.count()) / 1000.0 / static_cast<double>(m_windowReads) };
+    const std::chrono::duration<double> seconds{ now - m_windowStart };
+    const auto filesPerSecond{ seconds.count() > 0.0 ? static_cast<double>(m_windowReads) / seconds.count() : 0.0 };
+
+    m_recentLatencies.push_back(meanLatencyMs);
+    if (m_recentLatencies.size() > BASELINE_WINDOWS) {
+        m_recentLatencies.pop_front();
+    }
+    const auto baselineMs{ *std::min_element(m_recentLatencies.cbegin(), m_recentLatencies.cend()) };
+
+    // Compared before the limit changes, then remembered for the next window.
+    const auto lastLimit{ m_lastLimit };
+    const auto lastFilesPerSecond{ m_lastFilesPerSecond };
+    m_lastLimit = m_limit;
+    m_lastFilesPerSecond = filesPerSecond;
+
+    if (meanLatencyMs > baselineMs * LATENCY_TOLERANCE && m_limit > m_min) {
+        const auto cut{ static_cast<std::size_t>(static_cast<double>(m_limit) * DECREASE_FACTOR) };
+        change(std::clamp(cut, m_min, m_limit - 1), REASON::LATENCY_HIGH, now, meanLatencyMs, filesPerSecond);
+    }
+    // 5% leeway, or noise alone would keep undoing every step.
+    else if (lastLimit > 0 && m_limit > lastLimit && filesPerSecond < lastFilesPerSecond * 0.95) {
+        change(std::max(lastLimit, m_min), REASON::NO_GAIN, now, meanLatencyMs, filesPerSecond);
+    }
+    else if (m_limit < m_max) {
+        change(m_limit + 1, REASON::LATENCY_OK, now, meanLatencyMs, filesPerSecond);
+    }
+    else {
+        change(m_limit, REASON::LATENCY_OK, now, meanLatencyMs, filesPerSecond);
+    }
+}
+
+/***********************************************************************************/
+void ConcurrencyController::onTimeout(const Clock::time_point now /* = Clock::now() */) {
+    const auto cut{ static_cast<std::size_t>(static_cast<double>(m_limit) * DECREASE_FACTOR) };
+    change(m_limit > m_min ? std::clamp(cut, m_min, m_limit - 1) : m_limit, REASON::TIMEOUT, now, 0.0, 0.0);
+
+    // The window it cut short says nothing about the new limit.
+    m_lastLimit = 0;
+}
+
+/***********************************************************************************/
+std::string ConcurrencyController::summary() const {
+    const auto increases{ std::count_if(m_decisions.cbegin(), m_decisions.cend(), [](const auto& d) { return d.To > d.From; }) };
+
+    std::ostringstream s;
+    s << "Read concurrency: " << m_initial << " -> " << m_limit << " (" << m_min << '-' << m_max << ", peak " << m_peak << "), "
+      << increases << " increase(s), " << m_decisions.size() - static_cast<std::size_t>(increases) << " decrease(s).";
+
+    return s.str();
+}
+
+/***********************************************************************************/
+const char* ConcurrencyController::reasonName(const REASON reason) noexcept {
+    switch (reason) {
+        case REASON::LATENCY_OK:
+            return "latency ok";
+        case REASON::LATENCY_HIGH:
+            return "latency high";
+        case REASON::NO_GAIN:
+            return "no throughput gain";
+        case REASON::TIMEOUT:
+            return "timeout";
+    }
+    return "";
+}
+
+/***********************************************************************************/
+void ConcurrencyController::change(const std::size_t limit, const REASON reason, const Clock::time_point now, const double latencyMs, const double filesPerSecond) {
+    if (limit != m_limit) {
+        std::ostringstream s;
+        s << std::fixed << std::setprecision(1) << "Read concurrency " << m_limit << " -> " << limit << " (" << reasonName(reason);
+        if (reason != REASON::TIMEOUT) {
+            s << ": mean latency " << latencyMs << " ms, " << filesPerSecond << " files/s";
+        }
+        s << ").";
+        logDebug(s.str());
+
+        m_decisions.push_back({ std::chrono::duration_cast<std::chrono::milliseconds>(now - m_start), m_limit, limit, reason, latencyMs, filesPerSecond });
+        m_limit = limit;
+        m_peak = std::max(m_peak, m_limit);
+    }
+
+    m_windowStart = now;
+    m_windowReads = 0;
+    m_windowLatency = std::chrono::microseconds{ 0 };
+}
+
+} // namespace tsm::utils
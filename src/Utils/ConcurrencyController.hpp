@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+/// Picks how many files to read at once (--adaptive-reads), between a minimum and
+/// a maximum, from how long the reads take.
+///
+/// AIMD, like TCP congestion control: after each window of reads (at least as many
+/// as the current limit) the limit goes up by one while the window's mean latency
+/// stays within LATENCY_TOLERANCE of the best recent one. Once it doesn't, the storage
+/// is queueing our requests, so the limit is cut to DECREASE_FACTOR of itself. A window
+/// that finished fewer files per second than the last one despite the higher limit
+/// takes the last step back. A timed out read cuts the limit right away: the metadata
+/// server of a network filesystem is the usual reason.
+class ConcurrencyController {
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Mean window latency over the best recent one above which the limit is cut.
+    static constexpr double LATENCY_TOLERANCE{ 2.0 };
+    ///
+    static constexpr double DECREASE_FACTOR{ 0.75 };
+    /// Windows are at least this many reads long, so one slow file can't decide.
+    static constexpr std::size_t MIN_WINDOW_READS{ 4 };
+    /// The best latency is taken from this many recent windows, so it follows the storage if it slows down for good.
+    static constexpr std::size_t BASELINE_WINDOWS{ 16 };
+
+    enum class REASON {
+        /// Latency held up: one more.
+        LATENCY_OK = 0,
+        /// Latency went past LATENCY_TOLERANCE.
+        LATENCY_HIGH,
+        /// More at once didn't read more files per second.
+        NO_GAIN,
+        /// A read timed out.
+        TIMEOUT
+    };
+
+    /// A change of the limit.
+    struct Decision {
+        /// Since the controller was made.
+        std::chrono::milliseconds Elapsed{ 0 };
+        std::size_t From{ 0 };
+        std::size_t To{ 0 };
+        REASON Reason{ REASON::LATENCY_OK };
+        /// Of the window that led to it (0 for a timeout).
+        double MeanLatencyMs{ 0.0 };
+        double FilesPerSecond{ 0.0 };
+    };
+
+    /// Starts at initial, clamped to [minimum, maximum]. minimum is at least 1.
+    ConcurrencyController(const std::size_t minimum, const std::size_t maximum, const std::size_t initial);
+
+    /// Reads to have in flight at most.
+    [[nodiscard]] std::size_t limit() const noexcept {
+        return m_limit;
+    }
+
+    /// A read took latency and finished at now.
+    void onComplete(const std::chrono::microseconds latency, const Clock::time_point now = Clock::now());
+    /// A read missed its deadline at now.
+    void onTimeout(const Clock::time_point now = Clock::now());
+
+    /// Every change of the limit so far, oldest first.
+    [[nodiscard]] const std::vector<Decision>& decisions() const noexcept {
+        return m_decisions;
+    }
+    /// Highest limit reached.
+    [[nodiscard]] std::size_t peak() const noexcept {
+        return m_peak;
+    }
+    /// One line for the end of the run, e.g.
+    /// "Read concurrency: 4 -> 11 (1-16, peak 12), 9 increase(s), 2 decrease(s)."
+    [[nodiscard]] std::string summary() const;
+
+    ///
+    [[nodiscard]] static const char* reasonName(const REASON reason) noexcept;
+
+private:
+    /// Records the change (if any) and starts a new window at now.
+    void change(const std::size_t limit, const REASON reason, const Clock::time_point now, const double latencyMs, const double filesPerSecond);
+
+    const std::size_t m_min;
+    const std::size_t m_max;
+    const std::size_t m_initial;
+    const Clock::time_point m_start;
+    std::size_t m_limit;
+    std::size_t m_peak;
+
+    Clock::time_point m_windowStart;
+    std::size_t m_windowReads{ 0 };
+    std::chrono::microseconds m_windowLatency{ 0 };
+
+    /// Mean latency of the last BASELINE_WINDOWS windows.
+    std::deque<double> m_recentLatencies;
+    /// Of the last window, and the limit it ran with (0 before the first).
+    double m_lastFilesPerSecond{ 0.0 };
+    std::size_t m_lastLimit{ 0 };
+
+    std::vector<Decision> m_decisions;
+};
+
+} // namespace tsm::utils
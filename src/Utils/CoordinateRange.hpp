@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+/// Smallest and largest of the values in [lowest, highest], or nothing if there are none.
+/// Values outside (fill values, NaN) are skipped. Values above wrapAbove have 360
+/// subtracted first, e.g. to bring 0..360 longitudes into -180..180.
+///
+/// Coordinate arrays of curvilinear grids run to millions of points, so this keeps
+/// LANES independent branch-free accumulators that the compiler turns into vector
+/// min/max; a single accumulator is a loop-carried dependency it won't vectorize.
+[[nodiscard]] inline std::optional<std::pair<double, double>> coordinateRange(const std::vector<double>& values,
+                                                                             const double lowest,
+                                                                             const double highest,
+                                                                             const double wrapAbove = std::numeric_limits<double>::infinity()) {
+    constexpr std::size_t LANES{ 8 };
+    constexpr auto INF{ std::numeric_limits<double>::infinity() };
+
+    const auto accumulate = [&](const double raw, double& min, double& max) {
+        const auto value{ raw > wrapAbove ? raw - 360.0 : raw };
+        const auto valid{ raw >= lowest && raw <= highest };
+        min = valid && value < min ? value : min;
+        max = valid && value > max ? value : max;
+    };
+
+    std::array<double, LANES> mins;
+    std::array<double, LANES> maxs;
+    mins.fill(INF);
+    maxs.fill(-INF);
+
+    std::size_t i{ 0 };
+    for (; i + LANES <= values.size(); i += LANES) {
+        for (std::size_t lane = 0; lane < LANES; ++lane) {
+            accumulate(values[i + lane], mins[lane], maxs[lane]);
+        }
+    }
+
+    auto min{ INF };
+    auto max{ -INF };
+    for (; i < values.size(); ++i) {
+        accumulate(values[i], min, max);
+    }
+    for (std::size_t lane = 0; lane < LANES; ++lane) {
+        min = mins[lane] < min ? mins[lane] : min;
+        max = maxs[lane] > max ? maxs[lane] : max;
+    }
+
+    if (min > max) {
+        return std::nullopt;
+    }
+
+    return std::make_pair(min, max);
+}
+
+} // namespace tsm::utils
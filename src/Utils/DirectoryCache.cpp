@@ -0,0 +1,230 @@
+#include "DirectoryCache.hpp"
+
+#include "Logger.hpp"
+#include "Trace.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <set>
+#include <utility>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+namespace {
+
+    constexpr auto CACHE_HEADER{ "tsm-crawl-cache 1" };
+
+    /// A directory modified this close to the crawl may change again within the same
+    /// mtime tick without its mtime changing, so it isn't trusted next time.
+    constexpr std::int64_t RACY_WINDOW_NS{ 2'000'000'000 };
+
+    std::int64_t nanoseconds(const timespec& time) {
+        return static_cast<std::int64_t>(time.tv_sec) * 1'000'000'000 + time.tv_nsec;
+    }
+
+    bool isStorable(const std::string& name) {
+        return name.find_first_of("\t\n") == std::string::npos;
+    }
+}
+
+/***********************************************************************************/
+DirectoryCache::DirectoryCache(fs::path cachePath) : m_cachePath{ std::move(cachePath) } {}
+
+/***********************************************************************************/
+void DirectoryCache::load() {
+    m_entries.clear();
+
+    std::ifstream f(m_cachePath);
+    if (!f.is_open()) {
+        return;
+    }
+
+    std::string line;
+    if (!std::getline(f, line) || line != CACHE_HEADER) {
+        logWarning("Ignoring crawl cache " + m_cachePath.string() + ": unknown format.");
+        return;
+    }
+
+    const auto damaged = [this] {
+        logWarning("Ignoring damaged crawl cache " + m_cachePath.string() + '.');
+        m_entries.clear();
+    };
+
+    while (std::getline(f, line)) {
+        // D <tab> mtime <tab> files <tab> subdirectories <tab> path
+        std::size_t fields[4];
+        auto pos{ std::size_t{ 0 } };
+        for (auto& field : fields) {
+            pos = line.find('\t', pos);
+            if (pos == std::string::npos) {
+                damaged();
+                return;
+            }
+            field = ++pos;
+        }
+        if (line.compare(0, 2, "D\t") != 0) {
+            damaged();
+            return;
+        }
+
+        Entry entry;
+        std::size_t fileCount{ 0 };
+        std::size_t subdirectoryCount{ 0 };
+        try {
+            entry.ModifiedNs = std::stoll(line.substr(fields[0], fields[1] - fields[0] - 1));
+            fileCount = std::stoull(line.substr(fields[1], fields[2] - fields[1] - 1));
+            subdirectoryCount = std::stoull(line.substr(fields[2], fields[3] - fields[2] - 1));
+        }
+        catch (const std::exception&) {
+            damaged();
+            return;
+        }
+
+        const auto readNames = [&f, &line](const char kind, const std::size_t count, std::vector<std::string>& names) {
+            names.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                if (!std::getline(f, line) || line.size() < 2 || line[0] != kind || line[1] != '\t') {
+                    return false;
+                }
+                names.emplace_back(line, 2);
+            }
+            return true;
+        };
+        const auto path{ line.substr(fields[3]) };
+        if (!readNames('F', fileCount, entry.Files) || !readNames('S', subdirectoryCount, entry.Subdirectories)) {
+            damaged();
+            return;
+        }
+
+        m_entries.emplace(path, std::move(entry));
+    }
+}
+
+/***********************************************************************************/
+bool DirectoryCache::save() const {
+    const auto tempPath{ m_cachePath.string() + ".tmp" };
+    {
+        std::ofstream f(tempPath, std::ios::trunc);
+        if (!f.is_open()) {
+            logWarning("Failed to write crawl cache " + tempPath + '.');
+            return false;
+        }
+
+        f << CACHE_HEADER << '\n';
+        for (const auto& [path, entry] : m_seen) {
+            // Names with tabs or line breaks can't be written; those directories just get listed next time.
+            if (!isStorable(path) || !std::all_of(entry.Files.cbegin(), entry.Files.cend(), isStorable) ||
+                !std::all_of(entry.Subdirectories.cbegin(), entry.Subdirectories.cend(), isStorable)) {
+                continue;
+            }
+            f << "D\t" << entry.ModifiedNs << '\t' << entry.Files.size() << '\t' << entry.Subdirectories.size() << '\t' << path << '\n';
+            for (const auto& name : entry.Files) {
+                f << "F\t" << name << '\n';
+            }
+            for (const auto& name : entry.Subdirectories) {
+                f << "S\t" << name << '\n';
+            }
+        }
+
+        if (!f.flush()) {
+            logWarning("Failed to write crawl cache " + tempPath + '.');
+            return false;
+        }
+    }
+
+    std::error_code e;
+    fs::rename(tempPath, m_cachePath, e);
+    if (e) {
+        logWarning("Failed to replace crawl cache " + m_cachePath.string() + ": " + e.message());
+        fs::remove(tempPath, e);
+        return false;
+    }
+
+    return true;
+}
+
+/***********************************************************************************/
+std::vector<fs::path> DirectoryCache::crawl(const fs::path& root) {
+    m_seen.clear();
+    m_listed = 0;
+    m_cached = 0;
+
+    const auto crawlStartNs{ std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count() };
+
+    std::vector<fs::path> files;
+    // (device, inode) of every directory visited, so symlinks can't make it list one twice or loop.
+    std::set<std::pair<dev_t, ino_t>> visited;
+    std::vector<fs::path> stack{ root };
+
+    while (!stack.empty()) {
+        const auto directory{ std::move(stack.back()) };
+        stack.pop_back();
+
+        struct stat st{};
+        if (stat(directory.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) || !visited.emplace(st.st_dev, st.st_ino).second) {
+            continue;
+        }
+        const auto modifiedNs{ nanoseconds(st.st_mtim) };
+
+        const auto& key{ directory.string() };
+        Entry entry;
+        if (const auto cached{ m_entries.find(key) }; cached != m_entries.cend() && cached->second.ModifiedNs == modifiedNs && modifiedNs != 0) {
+            entry = cached->second;
+            ++m_cached;
+        }
+        else {
+            const TraceSpan span{ "crawl", "list directory", directory };
+            if (!list(directory, entry)) {
+                continue;
+            }
+            entry.ModifiedNs = crawlStartNs - modifiedNs < RACY_WINDOW_NS ? 0 : modifiedNs;
+            ++m_listed;
+        }
+
+        for (const auto& name : entry.Files) {
+            files.emplace_back(directory / name);
+        }
+        // Reversed so they come off the stack in listing order.
+        for (auto it = entry.Subdirectories.crbegin(); it != entry.Subdirectories.crend(); ++it) {
+            stack.emplace_back(directory / *it);
+        }
+
+        m_seen.emplace(key, std::move(entry));
+    }
+
+    return files;
+}
+
+/***********************************************************************************/
+bool DirectoryCache::list(const fs::path& path, Entry& entry) {
+    std::error_code e;
+    fs::directory_iterator it(path, fs::directory_options::follow_directory_symlink, e);
+    if (e) {
+        logWarning("Failed to list " + path.string() + ": " + e.message());
+        return false;
+    }
+
+    for (const fs::directory_iterator end{}; it != end; it.increment(e)) {
+        if (e) {
+            logWarning("Failed to list " + path.string() + ": " + e.message());
+            return false;
+        }
+
+        const auto& name{ it->path().filename().string() };
+        // Follows symlinks, like the crawl always has.
+        if (it->is_directory(e)) {
+            entry.Subdirectories.push_back(name);
+        }
+        else if (it->path().extension() == ".nc") {
+            entry.Files.push_back(name);
+        }
+    }
+
+    return true;
+}
+
+} // namespace tsm::utils
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../Filesystem.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+/// Remembers what each directory of a crawl held, so the next crawl only lists
+/// the directories that changed since.
+///
+/// A directory's mtime changes whenever an entry is added to, removed from or
+/// renamed in it (but not when a subdirectory's contents change), so a directory
+/// whose mtime is the same as last time still has the same files and subdirectories.
+/// Those get reused from the cache; only the subdirectories still have to be
+/// stat()ed, which is much cheaper than listing them.
+///
+/// Saved as a text file, one block per directory:
+///   D <tab> mtime (ns) <tab> file count <tab> subdirectory count <tab> path
+///   F <tab> name        (once per .nc file)
+///   S <tab> name        (once per subdirectory)
+class DirectoryCache {
+
+public:
+    ///
+    explicit DirectoryCache(fs::path cachePath);
+
+    /// Reads the cache written by the last save(). A missing or damaged cache is an empty one.
+    void load();
+    /// Writes what the last crawl() saw, replacing the cache file atomically.
+    bool save() const;
+
+    /// Every .nc file under root (following directory symlinks, each directory once),
+    /// listing only directories that changed since the loaded cache.
+    [[nodiscard]] std::vector<fs::path> crawl(const fs::path& root);
+
+    /// Directories crawl() had to list.
+    [[nodiscard]] std::size_t listedDirectories() const noexcept {
+        return m_listed;
+    }
+    /// Directories crawl() took from the cache.
+    [[nodiscard]] std::size_t cachedDirectories() const noexcept {
+        return m_cached;
+    }
+
+private:
+    struct Entry {
+        /// 0 if the entry must not be trusted next time.
+        std::int64_t ModifiedNs{ 0 };
+        std::vector<std::string> Files;
+        std::vector<std::string> Subdirectories;
+    };
+
+    /// Lists path into entry. False if it couldn't be listed.
+    [[nodiscard]] static bool list(const fs::path& path, Entry& entry);
+
+    const fs::path m_cachePath;
+    /// By directory path, as loaded.
+    std::unordered_map<std::string, Entry> m_entries;
+    /// By directory path, as seen by the last crawl(); what save() writes.
+    std::unordered_map<std::string, Entry> m_seen;
+    std::size_t m_listed{ 0 };
+    std::size_t m_cached{ 0 };
+};
+
+} // namespace tsm::utils
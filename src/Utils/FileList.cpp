@@ -0,0 +1,168 @@
+#include "FileList.hpp"
+
+#include "../FileReaders/SupportedFileTypes.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+namespace {
+
+    /// pos if a line starts there, or else where the next one does (size if none).
+    std::size_t nextLine(const char* data, const std::size_t size, const std::size_t pos) {
+        if (pos == 0 || pos >= size) {
+            return std::min(pos, size);
+        }
+        const auto* newline{ static_cast<const char*>(std::memchr(data + pos - 1, '\n', size - pos + 1)) };
+        return newline ? static_cast<std::size_t>(newline - data) + 1 : size;
+    }
+
+    /// The lines of [begin, end) naming supported files, as views into data.
+    void parseChunk(const char* data, const std::size_t begin, const std::size_t end, std::vector<std::string_view>& lines) {
+        for (auto pos{ begin }; pos < end;) {
+            const auto* newline{ static_cast<const char*>(std::memchr(data + pos, '\n', end - pos)) };
+            const auto lineEnd{ newline ? static_cast<std::size_t>(newline - data) : end };
+
+            std::string_view line{ data + pos, lineEnd - pos };
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (supportedFileType(pathExtension(line))) {
+                lines.push_back(line);
+            }
+
+            pos = lineEnd + 1;
+        }
+    }
+}
+
+/***********************************************************************************/
+std::string_view pathExtension(const std::string_view path) noexcept {
+    const auto slash{ path.rfind('/') };
+    const auto filename{ slash == std::string_view::npos ? path : path.substr(slash + 1) };
+
+    const auto dot{ filename.rfind('.') };
+    // No dot, a leading one (".bashrc"), or "..".
+    if (dot == std::string_view::npos || dot == 0 || filename == "..") {
+        return {};
+    }
+
+    return filename.substr(dot);
+}
+
+/***********************************************************************************/
+bool readFileList(const fs::path& listPath, PathStore& store, std::size_t threads) {
+    const auto fd{ open(listPath.c_str(), O_RDONLY | O_CLOEXEC) };
+    if (fd < 0) {
+        std::cerr << "Failed to open " << listPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        std::cerr << "Failed to read " << listPath << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+    const auto size{ static_cast<std::size_t>(st.st_size) };
+    if (size == 0) {
+        close(fd);
+        return true;
+    }
+
+    auto* mapped{ mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) };
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map " << listPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    const auto* data{ static_cast<const char*>(mapped) };
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::string directory{ listPath.parent_path().string() };
+    if (!directory.empty() && directory.back() != '/') {
+        directory += '/';
+    }
+    std::string joined{ directory };
+
+    // A wave of chunks is parsed in parallel, then added in order, so only one
+    // wave's worth of line views is held at a time.
+    std::vector<std::vector<std::string_view>> chunks(threads);
+    const auto pageSize{ static_cast<std::size_t>(sysconf(_SC_PAGESIZE)) };
+    std::size_t released{ 0 };
+    for (std::size_t wave = 0; wave < size;) {
+        const auto waveEnd{ nextLine(data, size, wave + threads * FILE_LIST_CHUNK_BYTES) };
+        const auto chunkBytes{ (waveEnd - wave + threads - 1) / threads };
+
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < threads; ++i) {
+            const auto begin{ std::max(wave, nextLine(data, waveEnd, wave + i * chunkBytes)) };
+            const auto end{ i + 1 == threads ? waveEnd : nextLine(data, waveEnd, wave + (i + 1) * chunkBytes) };
+            chunks[i].clear();
+            if (begin >= end) {
+                continue;
+            }
+            // Not worth a thread for the last few lines of a small list.
+            if (end - begin < FILE_LIST_CHUNK_BYTES / 8 || threads == 1) {
+                parseChunk(data, begin, end, chunks[i]);
+            }
+            else {
+                workers.emplace_back(parseChunk, data, begin, end, std::ref(chunks[i]));
+            }
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        for (const auto& lines : chunks) {
+            for (const auto& line : lines) {
+                if (line.front() == '/' || directory.empty()) {
+                    store.add(line);
+                    continue;
+                }
+                joined.resize(directory.size());
+                joined.append(line);
+                store.add(joined);
+            }
+        }
+
+        // The rest of the list is much like what's been read so far.
+        if (wave == 0 && waveEnd < size) {
+            const auto listed{ std::accumulate(chunks.cbegin(), chunks.cend(), std::size_t{ 0 }, [](const auto total, const auto& lines) {
+                return total + lines.size();
+            }) };
+            store.reserve(static_cast<std::size_t>(static_cast<double>(listed) * static_cast<double>(size) / static_cast<double>(waveEnd)));
+        }
+
+        // Those pages won't be needed again.
+        if (const auto consumed{ waveEnd / pageSize * pageSize }; consumed > released) {
+            madvise(static_cast<char*>(mapped) + released, consumed - released, MADV_DONTNEED);
+            released = consumed;
+        }
+
+        wave = waveEnd;
+    }
+
+    munmap(mapped, size);
+
+    return true;
+}
+
+} // namespace tsm::utils
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../Filesystem.hpp"
+#include "PathStore.hpp"
+
+#include <cstddef>
+#include <string_view>
+
+namespace tsm::utils {
+
+/// Bytes of a file list each thread parses at a time.
+constexpr std::size_t FILE_LIST_CHUNK_BYTES{ 8 * 1024 * 1024 };
+
+/***********************************************************************************/
+/// The extension of the last component of path, as fs::path::extension() has it,
+/// without building a path.
+[[nodiscard]] std::string_view pathExtension(const std::string_view path) noexcept;
+
+/***********************************************************************************/
+/// Adds the paths of supported files listed in listPath (.txt, .diff or .lst: one
+/// per line) to store, in order and without duplicates. Relative paths are taken
+/// relative to the directory of the list.
+///
+/// The list is memory-mapped and split at line boundaries into chunks that are
+/// parsed in parallel, FILE_LIST_CHUNK_BYTES per thread at a time, so neither
+/// the list nor its lines are ever copied as a whole. False (and the error on
+/// stderr) if it can't be read. threads: 0 for one per hardware thread.
+[[nodiscard]] bool readFileList(const fs::path& listPath, PathStore& store, std::size_t threads = 0);
+
+} // namespace tsm::utils
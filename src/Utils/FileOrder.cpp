@@ -0,0 +1,140 @@
+#include "FileOrder.hpp"
+#include "CFTime.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+namespace {
+
+    unsigned toNumber(const std::string& s, const std::size_t pos, const std::size_t count) {
+        unsigned value{ 0 };
+        for (auto i = pos; i < pos + count; ++i) {
+            value = value * 10 + static_cast<unsigned>(s[i] - '0');
+        }
+
+        return value;
+    }
+
+    bool isDigits(const std::string& s, const std::size_t pos, const std::size_t count) {
+        return pos + count <= s.size() && std::all_of(s.cbegin() + pos, s.cbegin() + pos + count, [](const unsigned char c) {
+            return std::isdigit(c);
+        });
+    }
+
+    std::optional<std::int64_t> makeTimestamp(const unsigned year, const unsigned month, const unsigned day,
+                                              const unsigned hour = 0, const unsigned minute = 0, const unsigned second = 0) {
+        // Anything else is more likely a run number or a resolution than a date.
+        if (year < 1900 || year > 2200 || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59) {
+            return std::nullopt;
+        }
+
+        return daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    }
+
+    std::int64_t modificationTime(const fs::path& path) {
+        struct stat st{};
+        if (stat(path.c_str(), &st) != 0) {
+            return 0;
+        }
+
+        return static_cast<std::int64_t>(st.st_mtim.tv_sec);
+    }
+}
+
+/***********************************************************************************/
+std::optional<FILE_ORDER> parseFileOrder(const std::string& name) {
+    if (name.empty()) {
+        return FILE_ORDER::AS_FOUND;
+    }
+    if (name == "newest-first") {
+        return FILE_ORDER::NEWEST_FIRST;
+    }
+    if (name == "oldest-first") {
+        return FILE_ORDER::OLDEST_FIRST;
+    }
+    if (name == "path") {
+        return FILE_ORDER::PATH;
+    }
+
+    return std::nullopt;
+}
+
+/***********************************************************************************/
+std::optional<std::int64_t> timestampFromFileName(const std::string& fileName) {
+    for (std::size_t pos = 0; pos < fileName.size(); ++pos) {
+        if (!std::isdigit(static_cast<unsigned char>(fileName[pos])) ||
+            (pos > 0 && std::isdigit(static_cast<unsigned char>(fileName[pos - 1])))) {
+            continue;
+        }
+
+        // YYYY-MM-DD
+        if (isDigits(fileName, pos, 4) && pos + 10 <= fileName.size() && fileName[pos + 4] == '-' && fileName[pos + 7] == '-' &&
+            isDigits(fileName, pos + 5, 2) && isDigits(fileName, pos + 8, 2)) {
+            if (const auto timestamp{ makeTimestamp(toNumber(fileName, pos, 4), toNumber(fileName, pos + 5, 2), toNumber(fileName, pos + 8, 2)) }; timestamp) {
+                return timestamp;
+            }
+        }
+
+        // YYYYMMDD[HH[MM[SS]]], as a whole run of digits.
+        auto length{ std::size_t{ 0 } };
+        while (pos + length < fileName.size() && std::isdigit(static_cast<unsigned char>(fileName[pos + length]))) {
+            ++length;
+        }
+        if (length != 8 && length != 10 && length != 12 && length != 14) {
+            continue;
+        }
+
+        const auto timestamp{ makeTimestamp(toNumber(fileName, pos, 4), toNumber(fileName, pos + 4, 2), toNumber(fileName, pos + 6, 2),
+                                            length >= 10 ? toNumber(fileName, pos + 8, 2) : 0,
+                                            length >= 12 ? toNumber(fileName, pos + 10, 2) : 0,
+                                            length >= 14 ? toNumber(fileName, pos + 12, 2) : 0) };
+        if (timestamp) {
+            return timestamp;
+        }
+    }
+
+    return std::nullopt;
+}
+
+/***********************************************************************************/
+void orderFiles(std::vector<fs::path>& paths, const FILE_ORDER order) {
+    if (order == FILE_ORDER::AS_FOUND) {
+        return;
+    }
+
+    if (order == FILE_ORDER::PATH) {
+        std::sort(paths.begin(), paths.end());
+        return;
+    }
+
+    // Work out every key once; stat() is slow on network storage.
+    std::vector<std::int64_t> keys(paths.size());
+    std::transform(paths.cbegin(), paths.cend(), keys.begin(), [](const auto& path) {
+        const auto& timestamp{ timestampFromFileName(path.filename().string()) };
+        return timestamp ? *timestamp : modificationTime(path);
+    });
+
+    std::vector<std::size_t> indices(paths.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    std::sort(indices.begin(), indices.end(), [&](const std::size_t lhs, const std::size_t rhs) {
+        if (keys[lhs] != keys[rhs]) {
+            return order == FILE_ORDER::NEWEST_FIRST ? keys[lhs] > keys[rhs] : keys[lhs] < keys[rhs];
+        }
+        return paths[lhs] < paths[rhs];
+    });
+
+    std::vector<fs::path> sorted;
+    sorted.reserve(paths.size());
+    for (const auto i : indices) {
+        sorted.emplace_back(std::move(paths[i]));
+    }
+    paths.swap(sorted);
+}
+
+} // namespace tsm::utils
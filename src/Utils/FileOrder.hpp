@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../Filesystem.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tsm::utils {
+
+/// Order in which files get read and inserted (--order).
+enum class FILE_ORDER {
+    /// Directory iteration (or file list) order.
+    AS_FOUND = 0,
+    NEWEST_FIRST,
+    OLDEST_FIRST,
+    PATH
+};
+
+/***********************************************************************************/
+/// Parses "newest-first", "oldest-first" or "path". An empty name is AS_FOUND.
+[[nodiscard]] std::optional<FILE_ORDER> parseFileOrder(const std::string& name);
+
+/***********************************************************************************/
+/// First date in a file name, as seconds since the epoch (UTC).
+/// Understands YYYYMMDD, optionally followed by HH, HHMM or HHMMSS, and YYYY-MM-DD.
+[[nodiscard]] std::optional<std::int64_t> timestampFromFileName(const std::string& fileName);
+
+/***********************************************************************************/
+/// Sorts paths by the date in their file name, or their mtime if there's none.
+/// Ties (and PATH) are broken by path.
+void orderFiles(std::vector<fs::path>& paths, const FILE_ORDER order);
+
+} // namespace tsm::utils
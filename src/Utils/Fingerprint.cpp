@@ -0,0 +1,67 @@
+#include "Fingerprint.hpp"
+
+#include "HashString.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <vector>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+std::optional<Fingerprint> fingerprint(const fs::path& path, const bool withHeaderHash) {
+    struct stat st{};
+    if (stat(path.c_str(), &st) != 0) {
+        return std::nullopt;
+    }
+
+    Fingerprint fp;
+    fp.Device = static_cast<std::uint64_t>(st.st_dev);
+    fp.Inode = static_cast<std::uint64_t>(st.st_ino);
+    fp.Size = static_cast<std::int64_t>(st.st_size);
+    fp.ModifiedNs = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+
+    if (withHeaderHash) {
+        const auto hash{ headerHash(path) };
+        if (!hash) {
+            return std::nullopt;
+        }
+        fp.HeaderHash = *hash;
+    }
+
+    return fp;
+}
+
+/***********************************************************************************/
+std::optional<std::uint64_t> headerHash(const fs::path& path) {
+    const auto fd{ open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+    if (fd < 0) {
+        return std::nullopt;
+    }
+
+    std::vector<unsigned char> header(FINGERPRINT_HEADER_BYTES);
+    std::size_t size{ 0 };
+    while (size < header.size()) {
+        const auto n{ read(fd, header.data() + size, header.size() - size) };
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            close(fd);
+            return std::nullopt;
+        }
+        if (n == 0) {
+            break;
+        }
+        size += static_cast<std::size_t>(n);
+    }
+    close(fd);
+    header.resize(size);
+
+    return hashValues(header);
+}
+
+} // namespace tsm::utils
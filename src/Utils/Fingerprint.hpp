@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../Filesystem.hpp"
+
+#include <cstdint>
+#include <optional>
+
+namespace tsm::utils {
+
+/// Bytes at the start of a file that go into its header hash. Enough for the
+/// netCDF-3 header or the HDF5 superblock and root group of most files.
+constexpr std::size_t FINGERPRINT_HEADER_BYTES{ 4096 };
+
+/***********************************************************************************/
+/// Cheap identity of a file's contents, for telling renames and duplicates
+/// apart from new files without reading them.
+struct [[nodiscard]] Fingerprint {
+    std::uint64_t Device{ 0 };
+    std::uint64_t Inode{ 0 };
+    std::int64_t Size{ 0 };
+    std::int64_t ModifiedNs{ 0 };
+    /// Of the first FINGERPRINT_HEADER_BYTES bytes. 0 unless asked for.
+    std::uint64_t HeaderHash{ 0 };
+
+    /// Same file: (device, inode). Only meaningful while both paths exist.
+    [[nodiscard]] bool sameInode(const Fingerprint& other) const noexcept {
+        return Device == other.Device && Inode == other.Inode;
+    }
+};
+
+/***********************************************************************************/
+/// stat()s path (following symlinks) and, if withHeaderHash, hashes its first bytes.
+/// std::nullopt if it can't be stat()ed or read.
+[[nodiscard]] std::optional<Fingerprint> fingerprint(const fs::path& path, const bool withHeaderHash);
+/// Hash of the first FINGERPRINT_HEADER_BYTES bytes of path.
+[[nodiscard]] std::optional<std::uint64_t> headerHash(const fs::path& path);
+
+} // namespace tsm::utils
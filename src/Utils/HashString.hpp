@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
 // Robbed from: https://stackoverflow.com/a/23683218/2231969
 
 namespace tsm::utils {
@@ -70,5 +75,23 @@ struct MM<size, size, dummy>{
 
 #define HASH_STR_CRC32(x) (MM<sizeof(x)-1>::crc32(x))
 
+/***********************************************************************************/
+/// FNV-1a over whole 64-bit words, with a shift so high bits mix down too.
+/// For telling arrays apart by content (e.g. coordinate variables shared by
+/// many files); chain calls through seed to hash several arrays as one.
+template<typename T>
+[[nodiscard]] std::uint64_t hashValues(const std::vector<T>& values, std::uint64_t seed = 0xcbf29ce484222325ULL) noexcept {
+    static_assert(std::is_arithmetic_v<T> && sizeof(T) <= sizeof(std::uint64_t));
+
+    for (const auto value : values) {
+        std::uint64_t word{ 0 };
+        std::memcpy(&word, &value, sizeof(T));
+        seed = (seed ^ word) * 0x100000001b3ULL;
+        seed ^= seed >> 29;
+    }
+
+    return seed;
+}
+
 
 } // namespace tsm::utils
@@ -0,0 +1,34 @@
+#include "IOCounters.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+std::uint64_t threadBytesRead() noexcept {
+    // Plain read(), like MemoryProfiler::residentBytes().
+    const auto fd{ ::open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC) };
+    if (fd < 0) {
+        return 0;
+    }
+    char buffer[256]{};
+    const auto n{ ::read(fd, buffer, sizeof(buffer) - 1) };
+    ::close(fd);
+    if (n <= 0) {
+        return 0;
+    }
+
+    // "rchar: <bytes>" is the first line.
+    const auto* rchar{ std::strstr(buffer, "rchar:") };
+    if (!rchar) {
+        return 0;
+    }
+
+    return std::strtoull(rchar + 6, nullptr, 10);
+}
+
+} // namespace tsm::utils
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+/// Bytes the calling thread has read so far (rchar of /proc/thread-self/io):
+/// everything its read() and pread() calls returned, from disk, the page cache
+/// or the network. 0 if the kernel doesn't report it.
+///
+/// Taken before and after a file is read, it tells how much reading the file took
+/// without another stat() of it.
+[[nodiscard]] std::uint64_t threadBytesRead() noexcept;
+
+} // namespace tsm::utils
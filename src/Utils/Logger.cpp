@@ -0,0 +1,220 @@
+#include "Logger.hpp"
+
+#include <unistd.h>
+
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+std::optional<LOG_LEVEL> parseLogLevel(const std::string& name) {
+    if (name == "debug") {
+        return LOG_LEVEL::DEBUG;
+    }
+    if (name == "info") {
+        return LOG_LEVEL::INFO;
+    }
+    if (name == "warning") {
+        return LOG_LEVEL::WARNING;
+    }
+    if (name == "error") {
+        return LOG_LEVEL::ERROR;
+    }
+
+    return std::nullopt;
+}
+
+/***********************************************************************************/
+std::string logLevelName(const LOG_LEVEL level) {
+    switch (level) {
+        case LOG_LEVEL::DEBUG:
+            return "DEBUG";
+        case LOG_LEVEL::INFO:
+            return "INFO";
+        case LOG_LEVEL::WARNING:
+            return "WARNING";
+        case LOG_LEVEL::ERROR:
+            return "ERROR";
+    }
+
+    return "UNKNOWN";
+}
+
+/***********************************************************************************/
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+/***********************************************************************************/
+Logger::~Logger() {
+    stop();
+}
+
+/***********************************************************************************/
+void Logger::start(const LOG_LEVEL minLevel /* = LOG_LEVEL::INFO */, std::ostream* sink /* = nullptr */) {
+    stop();
+
+    {
+        std::lock_guard<std::mutex> sinkLock(m_sinkMutex);
+        m_sink = sink;
+        // The progress bar shares the terminal; its line gets cleared before each message.
+        m_sinkIsTerminal = sink == nullptr && isatty(STDERR_FILENO) == 1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_minLevel = minLevel;
+    m_stopWriter = false;
+    m_running = true;
+    m_writer = std::thread(&Logger::runWriter, this);
+}
+
+/***********************************************************************************/
+void Logger::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_stopWriter = true;
+    }
+    m_wakeUp.notify_one();
+    m_writer.join();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+
+    std::lock_guard<std::mutex> sinkLock(m_sinkMutex);
+    m_sink = nullptr;
+    m_sinkIsTerminal = false;
+}
+
+/***********************************************************************************/
+void Logger::log(const LOG_LEVEL level, std::string message) {
+    Message entry{ level, std::chrono::system_clock::now(), std::move(message) };
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_capturing) {
+            // Counted and filtered by whoever logs it for real.
+            m_captured.emplace_back(level, std::move(entry.Text));
+            return;
+        }
+
+        ++m_counts[static_cast<std::size_t>(level)];
+        if (level < m_minLevel) {
+            return;
+        }
+
+        if (m_running) {
+            m_queue.emplace_back(std::move(entry));
+            m_wakeUp.notify_one();
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_sinkMutex);
+    write(entry);
+}
+
+/***********************************************************************************/
+std::size_t Logger::count(const LOG_LEVEL level) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_counts[static_cast<std::size_t>(level)];
+}
+
+/***********************************************************************************/
+void Logger::resetCounts() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_counts.fill(0);
+}
+
+/***********************************************************************************/
+std::string Logger::summary() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::ostringstream ss;
+    ss << "Log summary: " << m_counts[static_cast<std::size_t>(LOG_LEVEL::ERROR)] << " error(s), "
+       << m_counts[static_cast<std::size_t>(LOG_LEVEL::WARNING)] << " warning(s).";
+
+    return ss.str();
+}
+
+/***********************************************************************************/
+void Logger::detachAfterFork() {
+    // Another thread of the parent may have held these at the time of the fork,
+    // and the writer thread is gone, so start over with fresh ones.
+    new (&m_mutex) std::mutex;
+    new (&m_sinkMutex) std::mutex;
+    new (&m_wakeUp) std::condition_variable;
+    new (&m_writer) std::thread;
+
+    m_queue.clear();
+    m_running = false;
+    m_stopWriter = false;
+    m_capturing = true;
+}
+
+/***********************************************************************************/
+std::vector<std::pair<LOG_LEVEL, std::string>> Logger::takeCaptured() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<std::pair<LOG_LEVEL, std::string>> captured;
+    captured.swap(m_captured);
+
+    return captured;
+}
+
+/***********************************************************************************/
+void Logger::runWriter() {
+    std::vector<Message> batch;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wakeUp.wait(lock, [this] { return m_stopWriter || !m_queue.empty(); });
+
+        // Take everything queued so far and write it without holding up log().
+        batch.swap(m_queue);
+        const auto stopping{ m_stopWriter };
+        lock.unlock();
+
+        {
+            std::lock_guard<std::mutex> sinkLock(m_sinkMutex);
+            for (const auto& message : batch) {
+                write(message);
+            }
+        }
+        batch.clear();
+
+        lock.lock();
+        if (stopping && m_queue.empty()) {
+            return;
+        }
+    }
+}
+
+/***********************************************************************************/
+void Logger::write(const Message& message) {
+    auto& out{ m_sink ? *m_sink : std::cerr };
+
+    const auto time{ std::chrono::system_clock::to_time_t(message.Time) };
+    const auto millis{ std::chrono::duration_cast<std::chrono::milliseconds>(message.Time.time_since_epoch()).count() % 1000 };
+    std::tm local{};
+    localtime_r(&time, &local);
+
+    if (m_sinkIsTerminal) {
+        out << "\r\033[K";
+    }
+    out << std::put_time(&local, "%Y-%m-%d %H:%M:%S") << '.' << std::setfill('0') << std::setw(3) << millis << std::setfill(' ')
+        << ' ' << std::left << std::setw(7) << logLevelName(message.Level) << std::right
+        << ' ' << message.Text << '\n';
+    out.flush();
+}
+
+} // namespace tsm::utils
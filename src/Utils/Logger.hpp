@@ -0,0 +1,123 @@
+#pragma once
+
+// Messages are queued by the caller and written by a background thread, so
+// reporting a bad file never blocks the loop that is reading the others.
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <iosfwd>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace tsm::utils {
+
+enum class LOG_LEVEL {
+    DEBUG = 0,
+    INFO,
+    WARNING,
+    ERROR
+};
+
+/***********************************************************************************/
+/// Parses "debug", "info", "warning" or "error".
+[[nodiscard]] std::optional<LOG_LEVEL> parseLogLevel(const std::string& name);
+///
+[[nodiscard]] std::string logLevelName(const LOG_LEVEL level);
+
+/***********************************************************************************/
+/// Process-wide leveled logger.
+///
+/// Until start() is called (and after stop()), messages are written as they
+/// come in. In between, log() only queues the message and the writer thread
+/// formats and writes it. Messages below the minimum level are dropped, but
+/// every message is counted for the summary.
+class Logger {
+
+public:
+    ///
+    [[nodiscard]] static Logger& instance();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /// Starts the writer thread. Messages go to sink (std::cerr by default),
+    /// which must stay valid until stop().
+    void start(const LOG_LEVEL minLevel = LOG_LEVEL::INFO, std::ostream* sink = nullptr);
+    /// Writes whatever is still queued and stops the writer thread.
+    void stop();
+
+    /// Safe to call from any thread.
+    void log(const LOG_LEVEL level, std::string message);
+
+    /// Number of messages logged at the given level since the last resetCounts().
+    [[nodiscard]] std::size_t count(const LOG_LEVEL level) const;
+    ///
+    void resetCounts();
+    /// One line, e.g. "Log summary: 0 error(s), 2 warning(s)."
+    [[nodiscard]] std::string summary() const;
+
+    /// Call first thing in a forked child. The parent's writer thread doesn't
+    /// exist there, so from now on messages are only kept for takeCaptured().
+    void detachAfterFork();
+    /// Messages captured since the last call (see detachAfterFork()).
+    [[nodiscard]] std::vector<std::pair<LOG_LEVEL, std::string>> takeCaptured();
+
+private:
+    struct Message {
+        LOG_LEVEL Level;
+        std::chrono::system_clock::time_point Time;
+        std::string Text;
+    };
+
+    Logger() = default;
+    ~Logger();
+
+    /// Body of the writer thread.
+    void runWriter();
+    /// m_sinkMutex must be held.
+    void write(const Message& message);
+
+    LOG_LEVEL m_minLevel{ LOG_LEVEL::INFO };
+    std::array<std::size_t, 4> m_counts{};
+
+    // Guards the queue, the counters and the writer's state.
+    mutable std::mutex m_mutex;
+    // Guards m_sink and m_sinkIsTerminal, and writes to the sink, so direct
+    // writes and the writer thread don't interleave. Never taken with m_mutex held.
+    std::mutex m_sinkMutex;
+    std::ostream* m_sink{ nullptr };
+    bool m_sinkIsTerminal{ false };
+    std::condition_variable m_wakeUp;
+    std::vector<Message> m_queue;
+    bool m_running{ false };
+    bool m_stopWriter{ false };
+    std::thread m_writer;
+
+    bool m_capturing{ false };
+    std::vector<std::pair<LOG_LEVEL, std::string>> m_captured;
+};
+
+/***********************************************************************************/
+inline void logDebug(std::string message) {
+    Logger::instance().log(LOG_LEVEL::DEBUG, std::move(message));
+}
+///
+inline void logInfo(std::string message) {
+    Logger::instance().log(LOG_LEVEL::INFO, std::move(message));
+}
+///
+inline void logWarning(std::string message) {
+    Logger::instance().log(LOG_LEVEL::WARNING, std::move(message));
+}
+///
+inline void logError(std::string message) {
+    Logger::instance().log(LOG_LEVEL::ERROR, std::move(message));
+}
+
+} // namespace tsm::utils
@@ -0,0 +1,310 @@
+#include "MemoryProfile.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+#ifdef TSM_ALLOC_STATS
+#include <malloc.h>
+#endif
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+namespace {
+
+    // Only ever move in TSM_ALLOC_STATS builds.
+    std::atomic<std::uint64_t> g_allocations{ 0 };
+    std::atomic<std::uint64_t> g_allocatedBytes{ 0 };
+    std::atomic<std::int64_t> g_liveBytes{ 0 };
+    std::atomic<std::int64_t> g_peakLiveBytes{ 0 };
+
+    void raise(std::atomic<std::int64_t>& peak, const std::int64_t value) noexcept {
+        auto current{ peak.load(std::memory_order_relaxed) };
+        while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    double toMiB(const std::int64_t bytes) {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+}
+
+#ifdef TSM_ALLOC_STATS
+/***********************************************************************************/
+namespace {
+
+    void* allocate(const std::size_t size, const bool nothrow) {
+        void* p{ nullptr };
+        while (!(p = std::malloc(size > 0 ? size : 1))) {
+            const auto handler{ std::get_new_handler() };
+            if (!handler) {
+                if (nothrow) {
+                    return nullptr;
+                }
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        // What malloc actually set aside, so deallocate() can take back the same amount.
+        const auto usable{ static_cast<std::int64_t>(malloc_usable_size(p)) };
+        raise(g_peakLiveBytes, g_liveBytes.fetch_add(usable, std::memory_order_relaxed) + usable);
+
+        return p;
+    }
+
+    void deallocate(void* p) noexcept {
+        if (p) {
+            g_liveBytes.fetch_sub(static_cast<std::int64_t>(malloc_usable_size(p)), std::memory_order_relaxed);
+            std::free(p);
+        }
+    }
+}
+#endif
+
+/***********************************************************************************/
+MemoryProfiler& MemoryProfiler::instance() {
+    static MemoryProfiler profiler;
+    return profiler;
+}
+
+/***********************************************************************************/
+void MemoryProfiler::start() {
+    stop();
+
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_phases.clear();
+        m_depth = 0;
+        m_peakRSS = residentBytes();
+        m_enabled = true;
+    }
+
+    m_sampler = std::thread([this]() {
+        std::unique_lock<std::mutex> lock{ m_mutex };
+        while (enabled()) {
+            m_stopSampling.wait_for(lock, RSS_SAMPLE_INTERVAL, [this]() { return !enabled(); });
+            sample();
+        }
+    });
+}
+
+/***********************************************************************************/
+void MemoryProfiler::stop() {
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_enabled = false;
+    }
+    m_stopSampling.notify_all();
+
+    if (m_sampler.joinable()) {
+        m_sampler.join();
+    }
+}
+
+/***********************************************************************************/
+bool MemoryProfiler::countsAllocations() noexcept {
+#ifdef TSM_ALLOC_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/***********************************************************************************/
+std::vector<PhaseMemory> MemoryProfiler::phases() const {
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    return m_phases;
+}
+
+/***********************************************************************************/
+std::string MemoryProfiler::table() const {
+    const auto& rows{ phases() };
+
+    std::size_t nameWidth{ 5 };
+    for (const auto& row : rows) {
+        nameWidth = std::max(nameWidth, row.Name.size() + 2 * row.Depth);
+    }
+
+    std::ostringstream s;
+    s << std::left << std::setw(static_cast<int>(nameWidth)) << "Phase" << std::right
+      << std::setw(6) << "Runs" << std::setw(10) << "Time (s)";
+    if (countsAllocations()) {
+        s << std::setw(14) << "Allocations" << std::setw(14) << "Alloc (MiB)" << std::setw(16) << "Heap peak (MiB)";
+    }
+    s << std::setw(15) << "RSS peak (MiB)" << std::setw(17) << "RSS growth (MiB)" << '\n';
+
+    s << std::fixed;
+    for (const auto& row : rows) {
+        s << std::left << std::setw(static_cast<int>(nameWidth)) << std::string(2 * row.Depth, ' ') + row.Name << std::right
+          << std::setw(6) << row.Runs << std::setw(10) << std::setprecision(2) << row.Time.count() << std::setprecision(1);
+        if (countsAllocations()) {
+            s << std::setw(14) << row.Allocations << std::setw(14) << toMiB(static_cast<std::int64_t>(row.AllocatedBytes))
+              << std::setw(16) << toMiB(row.PeakHeapGrowth);
+        }
+        s << std::setw(15) << toMiB(row.PeakRSS) << std::setw(17) << toMiB(row.RSSGrowth) << '\n';
+    }
+
+    return s.str();
+}
+
+/***********************************************************************************/
+std::int64_t MemoryProfiler::residentBytes() noexcept {
+    // Plain read(): this runs on the sampler thread and must not allocate.
+    const auto fd{ ::open("/proc/self/statm", O_RDONLY | O_CLOEXEC) };
+    if (fd < 0) {
+        return 0;
+    }
+    char buffer[128]{};
+    const auto n{ ::read(fd, buffer, sizeof(buffer) - 1) };
+    ::close(fd);
+    if (n <= 0) {
+        return 0;
+    }
+
+    // "size resident shared ...", in pages.
+    char* end{ nullptr };
+    std::strtoll(buffer, &end, 10);
+    const auto pages{ std::strtoll(end, nullptr, 10) };
+
+    return static_cast<std::int64_t>(pages) * static_cast<std::int64_t>(::sysconf(_SC_PAGESIZE));
+}
+
+/***********************************************************************************/
+MemoryProfiler::Mark MemoryProfiler::enter(const char* name) {
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    auto phase{ std::find_if(m_phases.begin(), m_phases.end(), [name](const auto& p) { return p.Name == name; }) };
+    if (phase == m_phases.end()) {
+        phase = m_phases.insert(m_phases.end(), PhaseMemory{});
+        phase->Name = name;
+        phase->Depth = m_depth;
+    }
+    ++m_depth;
+
+    Mark mark;
+    mark.Phase = static_cast<std::size_t>(phase - m_phases.begin());
+    mark.Begin = std::chrono::steady_clock::now();
+    mark.Allocations = g_allocations.load(std::memory_order_relaxed);
+    mark.AllocatedBytes = g_allocatedBytes.load(std::memory_order_relaxed);
+    mark.LiveBytes = g_liveBytes.load(std::memory_order_relaxed);
+    mark.RSS = residentBytes();
+    // The peaks restart from here, so they're this phase's alone.
+    mark.OuterPeakLiveBytes = g_peakLiveBytes.exchange(mark.LiveBytes, std::memory_order_relaxed);
+    mark.OuterPeakRSS = m_peakRSS.exchange(mark.RSS, std::memory_order_relaxed);
+
+    return mark;
+}
+
+/***********************************************************************************/
+void MemoryProfiler::leave(const Mark& mark) {
+    const auto end{ std::chrono::steady_clock::now() };
+    const auto rss{ residentBytes() };
+    raise(m_peakRSS, rss);
+
+    const auto peakLiveBytes{ g_peakLiveBytes.load(std::memory_order_relaxed) };
+    const auto peakRSS{ m_peakRSS.load(std::memory_order_relaxed) };
+
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    auto& phase{ m_phases[mark.Phase] };
+    ++phase.Runs;
+    phase.Time += end - mark.Begin;
+    phase.Allocations += g_allocations.load(std::memory_order_relaxed) - mark.Allocations;
+    phase.AllocatedBytes += g_allocatedBytes.load(std::memory_order_relaxed) - mark.AllocatedBytes;
+    phase.PeakHeapGrowth = std::max(phase.PeakHeapGrowth, peakLiveBytes - mark.LiveBytes);
+    phase.PeakRSS = std::max(phase.PeakRSS, peakRSS);
+    phase.RSSGrowth += rss - mark.RSS;
+    --m_depth;
+
+    // The enclosing phase's peaks cover this one's too.
+    g_peakLiveBytes.store(std::max(mark.OuterPeakLiveBytes, peakLiveBytes), std::memory_order_relaxed);
+    m_peakRSS.store(std::max(mark.OuterPeakRSS, peakRSS), std::memory_order_relaxed);
+}
+
+/***********************************************************************************/
+void MemoryProfiler::sample() noexcept {
+    raise(m_peakRSS, residentBytes());
+}
+
+/***********************************************************************************/
+MemoryPhase::MemoryPhase(const char* name) {
+    auto& profiler{ MemoryProfiler::instance() };
+    if (profiler.enabled()) {
+        m_mark = profiler.enter(name);
+        m_active = true;
+    }
+}
+
+/***********************************************************************************/
+MemoryPhase::~MemoryPhase() {
+    if (m_active) {
+        MemoryProfiler::instance().leave(m_mark);
+    }
+}
+
+} // namespace tsm::utils
+
+#ifdef TSM_ALLOC_STATS
+/***********************************************************************************/
+// Replacements of the global allocation functions (TSM_ALLOC_STATS builds only).
+// The aligned (std::align_val_t) ones are left alone; they're rare here.
+void* operator new(std::size_t size) {
+    return tsm::utils::allocate(size, false);
+}
+
+void* operator new[](std::size_t size) {
+    return tsm::utils::allocate(size, false);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return tsm::utils::allocate(size, true);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return tsm::utils::allocate(size, true);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept {
+    tsm::utils::deallocate(p);
+}
+
+void operator delete[](void* p) noexcept {
+    tsm::utils::deallocate(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    tsm::utils::deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    tsm::utils::deallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    tsm::utils::deallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    tsm::utils::deallocate(p);
+}
+#endif
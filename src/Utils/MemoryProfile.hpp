@@ -0,0 +1,128 @@
+#pragma once
+
+// Memory used by each phase of a run (--memory-profile). Resident set size is sampled
+// from /proc/self/statm in every build. Heap allocations are only counted when built
+// with -DTSM_ALLOC_STATS (make memprofile), which replaces the global operator new and
+// delete; otherwise those columns are left out of the table.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tsm::utils {
+
+/// How often resident set size is sampled while profiling.
+constexpr std::chrono::milliseconds RSS_SAMPLE_INTERVAL{ 5 };
+
+/***********************************************************************************/
+/// Totals of every run of one phase. A phase includes the phases nested in it.
+struct PhaseMemory {
+    std::string Name;
+    /// Nesting depth the first time the phase ran.
+    std::size_t Depth{ 0 };
+    std::size_t Runs{ 0 };
+    std::chrono::duration<double> Time{ 0.0 };
+    /// Only counted with TSM_ALLOC_STATS.
+    std::uint64_t Allocations{ 0 };
+    std::uint64_t AllocatedBytes{ 0 };
+    /// Most heap held at once above what was held when the phase began (TSM_ALLOC_STATS).
+    std::int64_t PeakHeapGrowth{ 0 };
+    /// Highest sampled resident set size.
+    std::int64_t PeakRSS{ 0 };
+    /// Resident set size at the end minus at the start, summed over runs.
+    std::int64_t RSSGrowth{ 0 };
+};
+
+/***********************************************************************************/
+/// Attributes memory use to the MemoryPhases entered while it runs. Phases are meant
+/// for the main thread; allocations of other threads count towards whichever phase
+/// is current.
+class MemoryProfiler {
+
+public:
+    ///
+    [[nodiscard]] static MemoryProfiler& instance();
+
+    MemoryProfiler(const MemoryProfiler&) = delete;
+    MemoryProfiler& operator=(const MemoryProfiler&) = delete;
+
+    /// Clears earlier results and starts sampling RSS.
+    void start();
+    /// Stops sampling. The results stay until the next start().
+    void stop();
+
+    ///
+    [[nodiscard]] bool enabled() const noexcept {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// True if built with TSM_ALLOC_STATS.
+    [[nodiscard]] static bool countsAllocations() noexcept;
+
+    /// Phases in the order they first ran.
+    [[nodiscard]] std::vector<PhaseMemory> phases() const;
+    /// phases() as a table for the terminal.
+    [[nodiscard]] std::string table() const;
+
+    /// Resident set size of this process in bytes, or 0 if /proc/self/statm can't be read.
+    [[nodiscard]] static std::int64_t residentBytes() noexcept;
+
+private:
+    friend class MemoryPhase;
+
+    /// Where a phase started, kept by its MemoryPhase.
+    struct Mark {
+        std::size_t Phase{ 0 };
+        std::chrono::steady_clock::time_point Begin;
+        std::uint64_t Allocations{ 0 };
+        std::uint64_t AllocatedBytes{ 0 };
+        std::int64_t LiveBytes{ 0 };
+        std::int64_t RSS{ 0 };
+        /// The enclosing phase's peaks, restored (raised by this phase's) on leave.
+        std::int64_t OuterPeakLiveBytes{ 0 };
+        std::int64_t OuterPeakRSS{ 0 };
+    };
+
+    MemoryProfiler() = default;
+
+    [[nodiscard]] Mark enter(const char* name);
+    void leave(const Mark& mark);
+    void sample() noexcept;
+
+    std::atomic<bool> m_enabled{ false };
+    std::atomic<std::int64_t> m_peakRSS{ 0 };
+
+    mutable std::mutex m_mutex;
+    std::vector<PhaseMemory> m_phases;
+    std::size_t m_depth{ 0 };
+
+    std::thread m_sampler;
+    std::condition_variable m_stopSampling;
+};
+
+/***********************************************************************************/
+/// Attributes what happens between its construction and destruction to the phase name.
+/// Does nothing unless the profiler is enabled.
+class MemoryPhase {
+
+public:
+    /// name must be a string literal.
+    explicit MemoryPhase(const char* name);
+    ///
+    ~MemoryPhase();
+
+    MemoryPhase(const MemoryPhase&) = delete;
+    MemoryPhase& operator=(const MemoryPhase&) = delete;
+
+private:
+    bool m_active{ false };
+    MemoryProfiler::Mark m_mark;
+};
+
+} // namespace tsm::utils
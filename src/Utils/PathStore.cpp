@@ -0,0 +1,349 @@
+#include "PathStore.hpp"
+
+#include "Logger.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace tsm::utils {
+
+/// How much of the spill file forEach() reads at once.
+constexpr std::uint64_t PATH_STORE_READ_BYTES{ 1024 * 1024 };
+/// Initial size of the hash table.
+constexpr std::size_t PATH_STORE_MIN_SLOTS{ 1024 };
+
+/***********************************************************************************/
+namespace {
+
+    void putVarint(std::vector<std::uint8_t>& out, std::size_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    /// False if bytes ends first.
+    bool getVarint(const std::vector<std::uint8_t>& bytes, std::size_t& pos, std::size_t& value) {
+        value = 0;
+        for (unsigned shift = 0; pos < bytes.size() && shift < 64; shift += 7) {
+            const auto byte{ bytes[pos++] };
+            value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::uint64_t hashPath(const std::string_view path) {
+        const auto hash{ static_cast<std::uint64_t>(std::hash<std::string_view>{}(path)) };
+        // 0 marks an empty slot.
+        return hash == 0 ? 1 : hash;
+    }
+}
+
+/***********************************************************************************/
+PathStore::PathStore(const std::size_t memoryBudget, fs::path spillDirectory) : m_memoryBudget{ memoryBudget },
+                                                                                 m_spillDirectory{ std::move(spillDirectory) } {}
+
+/***********************************************************************************/
+PathStore::~PathStore() {
+    if (m_spillFile >= 0) {
+        close(m_spillFile);
+    }
+}
+
+/***********************************************************************************/
+PathStore::PathStore(PathStore&& other) noexcept : m_memoryBudget{ other.m_memoryBudget },
+                                                  m_spillDirectory{ std::move(other.m_spillDirectory) },
+                                                  m_spillFile{ std::exchange(other.m_spillFile, -1) },
+                                                  m_spillFailed{ other.m_spillFailed },
+                                                  m_spilledBytes{ std::exchange(other.m_spilledBytes, 0) },
+                                                  m_buffer{ std::move(other.m_buffer) },
+                                                  m_blockOffsets{ std::move(other.m_blockOffsets) },
+                                                  m_last{ std::move(other.m_last) },
+                                                  m_size{ std::exchange(other.m_size, 0) },
+                                                  m_duplicates{ std::exchange(other.m_duplicates, 0) },
+                                                  m_slots{ std::move(other.m_slots) } {}
+
+/***********************************************************************************/
+PathStore& PathStore::operator=(PathStore&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+    if (m_spillFile >= 0) {
+        close(m_spillFile);
+    }
+
+    m_memoryBudget = other.m_memoryBudget;
+    m_spillDirectory = std::move(other.m_spillDirectory);
+    m_spillFile = std::exchange(other.m_spillFile, -1);
+    m_spillFailed = other.m_spillFailed;
+    m_spilledBytes = std::exchange(other.m_spilledBytes, 0);
+    m_buffer = std::move(other.m_buffer);
+    m_blockOffsets = std::move(other.m_blockOffsets);
+    m_last = std::move(other.m_last);
+    m_size = std::exchange(other.m_size, 0);
+    m_duplicates = std::exchange(other.m_duplicates, 0);
+    m_slots = std::move(other.m_slots);
+
+    return *this;
+}
+
+/***********************************************************************************/
+bool PathStore::add(const std::string_view path) {
+    if ((m_size + 1) * 2 > m_slots.size()) {
+        growSlots(std::max(PATH_STORE_MIN_SLOTS, m_slots.size() * 2));
+    }
+
+    // Probed once: the empty slot the search ends on is where a new path goes.
+    const auto hash{ hashPath(path) };
+    const auto mask{ m_slots.size() - 1 };
+    auto slot{ hash & mask };
+    for (; m_slots[slot].Hash != 0; slot = (slot + 1) & mask) {
+        if (m_slots[slot].Hash == hash && at(m_slots[slot].Index) == path) {
+            ++m_duplicates;
+            return false;
+        }
+    }
+    m_slots[slot] = { hash, static_cast<std::uint32_t>(m_size) };
+
+    if (m_size % PATH_STORE_BLOCK_SIZE == 0) {
+        // Only whole blocks go to disk, so a block is never split between the two.
+        if (m_buffer.size() >= m_memoryBudget && !m_spillFailed) {
+            spill();
+        }
+        m_blockOffsets.push_back(encodedBytes());
+        putVarint(m_buffer, path.size());
+        m_buffer.insert(m_buffer.end(), path.cbegin(), path.cend());
+    }
+    else {
+        const auto shared{ static_cast<std::size_t>(std::mismatch(m_last.cbegin(), m_last.cend(), path.cbegin(), path.cend()).first - m_last.cbegin()) };
+        putVarint(m_buffer, shared);
+        putVarint(m_buffer, path.size() - shared);
+        m_buffer.insert(m_buffer.end(), path.cbegin() + static_cast<std::ptrdiff_t>(shared), path.cend());
+    }
+    m_last.assign(path);
+    ++m_size;
+
+    return true;
+}
+
+/***********************************************************************************/
+void PathStore::reserve(const std::size_t count) {
+    auto slots{ std::max(PATH_STORE_MIN_SLOTS, m_slots.size()) };
+    while (slots < count * 2) {
+        slots *= 2;
+    }
+    if (slots > m_slots.size()) {
+        growSlots(slots);
+    }
+}
+
+/***********************************************************************************/
+void PathStore::growSlots(const std::size_t size) {
+    std::vector<Slot> slots(size);
+    const auto mask{ slots.size() - 1 };
+    for (const auto& s : m_slots) {
+        if (s.Hash == 0) {
+            continue;
+        }
+        auto slot{ s.Hash & mask };
+        while (slots[slot].Hash != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = s;
+    }
+    m_slots.swap(slots);
+}
+
+/***********************************************************************************/
+void PathStore::spill() {
+    if (m_spillFile < 0) {
+        if (m_spillDirectory.empty()) {
+            std::error_code e;
+            m_spillDirectory = fs::temp_directory_path(e);
+            if (e) {
+                m_spillDirectory = "/tmp";
+            }
+        }
+        auto name{ (m_spillDirectory / "tsm-paths-XXXXXX").string() };
+        m_spillFile = mkstemp(name.data());
+        if (m_spillFile < 0) {
+            logWarning("Failed to create a file in " + m_spillDirectory.string() + " for the file list: " + std::strerror(errno) +
+                       ". Keeping it in memory.");
+            m_spillFailed = true;
+            return;
+        }
+        unlink(name.c_str());
+    }
+
+    std::size_t written{ 0 };
+    while (written < m_buffer.size()) {
+        const auto n{ pwrite(m_spillFile, m_buffer.data() + written, m_buffer.size() - written,
+                             static_cast<off_t>(m_spilledBytes + written)) };
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            // Nothing past m_spilledBytes is ever read back, so the partial write is harmless.
+            logWarning(std::string("Failed to spill the file list to disk: ") + std::strerror(errno) + ". Keeping it in memory.");
+            m_spillFailed = true;
+            return;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+
+    m_spilledBytes += m_buffer.size();
+    m_buffer.clear();
+}
+
+/***********************************************************************************/
+bool PathStore::readRange(const std::uint64_t begin, const std::uint64_t end, std::vector<std::uint8_t>& out) const {
+    out.resize(static_cast<std::size_t>(end - begin));
+
+    std::size_t done{ 0 };
+    const auto spilledEnd{ std::min(end, m_spilledBytes) };
+    while (begin + done < spilledEnd) {
+        const auto n{ pread(m_spillFile, out.data() + done, static_cast<std::size_t>(spilledEnd - begin) - done,
+                            static_cast<off_t>(begin + done)) };
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            logError(std::string("Failed to read the file list back from disk: ") + std::strerror(errno));
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+
+    if (begin + done < end) {
+        const auto from{ static_cast<std::size_t>(begin + done - m_spilledBytes) };
+        std::memcpy(out.data() + done, m_buffer.data() + from, out.size() - done);
+    }
+
+    return true;
+}
+
+/***********************************************************************************/
+void PathStore::decodeBlocks(const std::vector<std::uint8_t>& bytes, const std::function<bool(std::string_view)>& fn) {
+    std::string path;
+    std::size_t pos{ 0 };
+    for (std::size_t i = 0; pos < bytes.size(); ++i) {
+        std::size_t shared{ 0 };
+        std::size_t length;
+        if (i % PATH_STORE_BLOCK_SIZE != 0 && !getVarint(bytes, pos, shared)) {
+            return;
+        }
+        if (!getVarint(bytes, pos, length) || shared > path.size() || length > bytes.size() - pos) {
+            return;
+        }
+
+        path.resize(shared);
+        path.append(reinterpret_cast<const char*>(bytes.data() + pos), length);
+        pos += length;
+
+        if (!fn(path)) {
+            return;
+        }
+    }
+}
+
+/***********************************************************************************/
+void PathStore::forEach(const std::function<void(std::string_view)>& fn) const {
+    forEach(0, m_size, fn);
+}
+
+/***********************************************************************************/
+void PathStore::forEach(const std::size_t first, const std::size_t count, const std::function<void(std::string_view)>& fn) const {
+    const auto last{ std::min(m_size, first + count) };
+    if (first >= last) {
+        return;
+    }
+
+    auto skip{ first % PATH_STORE_BLOCK_SIZE };
+    auto remaining{ last - first };
+    const auto lastBlock{ (last - 1) / PATH_STORE_BLOCK_SIZE + 1 };
+
+    std::vector<std::uint8_t> bytes;
+    for (auto begin{ first / PATH_STORE_BLOCK_SIZE }; begin < lastBlock;) {
+        auto end{ begin + 1 };
+        while (end < lastBlock && m_blockOffsets[end] - m_blockOffsets[begin] < PATH_STORE_READ_BYTES) {
+            ++end;
+        }
+
+        if (!readRange(m_blockOffsets[begin], end < m_blockOffsets.size() ? m_blockOffsets[end] : encodedBytes(), bytes)) {
+            return;
+        }
+        decodeBlocks(bytes, [&fn, &skip, &remaining](const std::string_view path) {
+            if (skip > 0) {
+                --skip;
+                return true;
+            }
+            fn(path);
+            return --remaining > 0;
+        });
+
+        begin = end;
+    }
+}
+
+/***********************************************************************************/
+std::string PathStore::at(const std::size_t i) const {
+    const auto block{ i / PATH_STORE_BLOCK_SIZE };
+    if (i >= m_size) {
+        return {};
+    }
+
+    const auto end{ block + 1 < m_blockOffsets.size() ? m_blockOffsets[block + 1] : encodedBytes() };
+    std::vector<std::uint8_t> bytes;
+    if (!readRange(m_blockOffsets[block], end, bytes)) {
+        return {};
+    }
+
+    std::string path;
+    auto remaining{ i % PATH_STORE_BLOCK_SIZE };
+    decodeBlocks(bytes, [&path, &remaining](const std::string_view p) {
+        if (remaining-- > 0) {
+            return true;
+        }
+        path.assign(p);
+        return false;
+    });
+
+    return path;
+}
+
+/***********************************************************************************/
+std::vector<fs::path> PathStore::toPaths() const {
+    return toPaths(0, m_size);
+}
+
+/***********************************************************************************/
+std::vector<fs::path> PathStore::toPaths(const std::size_t first, const std::size_t count) const {
+    std::vector<fs::path> paths;
+    paths.reserve(first < m_size ? std::min(count, m_size - first) : 0);
+    forEach(first, count, [&paths](const std::string_view path) {
+        paths.emplace_back(path);
+    });
+
+    return paths;
+}
+
+/***********************************************************************************/
+PathStore toPathStore(const std::vector<fs::path>& paths) {
+    PathStore store;
+    for (const auto& path : paths) {
+        store.add(path.native());
+    }
+
+    return store;
+}
+
+} // namespace tsm::utils
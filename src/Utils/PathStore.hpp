@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../Filesystem.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tsm::utils {
+
+/// Paths per front-coded block: the first is stored whole, the rest as the length
+/// of the prefix they share with the one before plus the remaining characters.
+constexpr std::size_t PATH_STORE_BLOCK_SIZE{ 16 };
+/// Encoded bytes a PathStore keeps in memory before spilling to disk.
+constexpr std::size_t PATH_STORE_MEMORY_BUDGET{ 256 * 1024 * 1024 };
+
+/***********************************************************************************/
+/// Append-only set of paths in insertion order, for lists with millions of entries.
+///
+/// Paths of a dataset share long directory prefixes, so front coding brings them
+/// down to a few bytes each instead of an allocation (or several, for fs::path)
+/// apiece. Duplicates are dropped on add() through an open-addressing table of
+/// hashes, verified against the stored path. Once the encoded paths outgrow the
+/// memory budget, whole blocks are moved to an anonymous temporary file; only the
+/// block offsets and the hash table (16 to 32 bytes per path) stay in memory.
+class PathStore {
+
+public:
+    /// spillDirectory: the system's temporary directory if empty.
+    explicit PathStore(const std::size_t memoryBudget = PATH_STORE_MEMORY_BUDGET, fs::path spillDirectory = {});
+    ~PathStore();
+
+    PathStore(const PathStore&) = delete;
+    PathStore& operator=(const PathStore&) = delete;
+    PathStore(PathStore&& other) noexcept;
+    PathStore& operator=(PathStore&& other) noexcept;
+
+    /// False if path is already in the store.
+    bool add(const std::string_view path);
+    /// Sizes the hash table for count paths, saving the rehashes on the way there.
+    void reserve(const std::size_t count);
+
+    /// Calls fn with every path, in the order they were added. The view is only
+    /// valid during the call.
+    void forEach(const std::function<void(std::string_view)>& fn) const;
+    /// Same, for the count paths from the first-th on.
+    void forEach(const std::size_t first, const std::size_t count, const std::function<void(std::string_view)>& fn) const;
+    /// The i-th path added.
+    [[nodiscard]] std::string at(const std::size_t i) const;
+    /// Materializes the store, for stages that need the whole list at once.
+    [[nodiscard]] std::vector<fs::path> toPaths() const;
+    /// Materializes count paths from the first-th on, e.g. a batch for the readers.
+    [[nodiscard]] std::vector<fs::path> toPaths(const std::size_t first, const std::size_t count) const;
+
+    /// Distinct paths stored.
+    [[nodiscard]] std::size_t size() const noexcept {
+        return m_size;
+    }
+    /// Paths add() turned away.
+    [[nodiscard]] std::size_t duplicates() const noexcept {
+        return m_duplicates;
+    }
+    /// Size of the encoded paths, in memory and on disk.
+    [[nodiscard]] std::uint64_t encodedBytes() const noexcept {
+        return m_spilledBytes + m_buffer.size();
+    }
+    /// Encoded bytes that were moved to disk.
+    [[nodiscard]] std::uint64_t spilledBytes() const noexcept {
+        return m_spilledBytes;
+    }
+
+private:
+    /// Writes the in-memory blocks to the spill file.
+    void spill();
+    /// Reads encoded bytes [begin, end) from wherever they are. False (and logs) if it can't.
+    [[nodiscard]] bool readRange(const std::uint64_t begin, const std::uint64_t end, std::vector<std::uint8_t>& out) const;
+    /// Decodes the paths of whole, consecutive blocks held in bytes, until fn returns false.
+    static void decodeBlocks(const std::vector<std::uint8_t>& bytes, const std::function<bool(std::string_view)>& fn);
+    /// Rehashes into a table of slots slots, a power of two.
+    void growSlots(const std::size_t slots);
+
+    /// A path in the hash table.
+    struct Slot {
+        /// 0 if the slot is empty.
+        std::uint64_t Hash{ 0 };
+        std::uint32_t Index{ 0 };
+    };
+
+    std::size_t m_memoryBudget;
+    fs::path m_spillDirectory;
+    /// Unlinked on creation, so it goes away with the descriptor.
+    int m_spillFile{ -1 };
+    /// Set if the spill file couldn't be made; everything stays in memory then.
+    bool m_spillFailed{ false };
+    std::uint64_t m_spilledBytes{ 0 };
+    /// Encoded bytes after the spilled ones.
+    std::vector<std::uint8_t> m_buffer;
+    /// Where each block starts among the encoded bytes.
+    std::vector<std::uint64_t> m_blockOffsets;
+    /// The path added last, the base of the next one's prefix.
+    std::string m_last;
+    std::size_t m_size{ 0 };
+    std::size_t m_duplicates{ 0 };
+    /// Open addressing with linear probing, at most half full. A power of two in size.
+    std::vector<Slot> m_slots;
+};
+
+/***********************************************************************************/
+/// paths, in order, in a PathStore of the default budget.
+[[nodiscard]] PathStore toPathStore(const std::vector<fs::path>& paths);
+
+} // namespace tsm::utils
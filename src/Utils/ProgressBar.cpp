@@ -1,11 +1,19 @@
 #include "ProgressBar.hpp"
 
+#include <unistd.h>
+
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <stdexcept>
 
-const std::size_t LENGTH_OF_PROGRESS_BAR{ 55 };
+const std::size_t LENGTH_OF_PROGRESS_BAR{ 40 };
 const float PERCENTAGE_BIN_SIZE{ 100.0/LENGTH_OF_PROGRESS_BAR };
+// How often the bar is redrawn on a terminal...
+const std::chrono::milliseconds REDRAW_INTERVAL{ 250 };
+// ...and how often a log line is written otherwise.
+const std::chrono::seconds LOG_LINE_INTERVAL{ 30 };
 
 namespace tsm::utils {
 
@@ -20,7 +28,7 @@ namespace {
         std::string bar("[" + std::string(LENGTH_OF_PROGRESS_BAR-2, ' ') + "]");
 
         const auto numberOfSymbols = std::min(
-                std::max(std::size_t(0), progress - 1),
+                progress > 0 ? progress - 1 : std::size_t(0),
                 LENGTH_OF_PROGRESS_BAR - 2);
 
         bar.replace(1, numberOfSymbols, std::string(numberOfSymbols, '|'));
@@ -28,18 +36,33 @@ namespace {
         ss << bar;
         return ss.str();
     }
+
+    std::string formatDuration(const double seconds) {
+        const auto total{ static_cast<long long>(seconds) };
+
+        std::ostringstream ss;
+        ss << std::setfill('0') << std::setw(2) << total / 3600 << ':'
+           << std::setw(2) << (total / 60) % 60 << ':'
+           << std::setw(2) << total % 60;
+
+        return ss.str();
+    }
 }
 
 /***********************************************************************************/
 ProgressBar::ProgressBar(
             std::size_t expectedIterations, const std::string& initialMessage)
     : mTotalIterations(expectedIterations),
-      mNumberOfTicks(0),
-      mEnded(false)
+      mIsTerminal(isatty(STDOUT_FILENO) == 1),
+      mStartTime(std::chrono::steady_clock::now())
 {
     std::cout << initialMessage << "\n";
     mLengthOfLastPrintedMessage = initialMessage.size();
-    std::cout << generateProgressBar(0) << "\r" << std::flush;
+    if (mIsTerminal) {
+        std::cout << generateProgressBar(0) << "\r" << std::flush;
+    }
+
+    mTicker = std::thread(&ProgressBar::runTicker, this);
 }
 
 /***********************************************************************************/
@@ -55,11 +78,17 @@ void ProgressBar::operator++() {
                 "Attempted to use progress bar after having terminated it");
     }
 
-    mNumberOfTicks = std::min(mTotalIterations, mNumberOfTicks+1);
-    const unsigned int percentage = static_cast<unsigned int>(
-            mNumberOfTicks*100.0/mTotalIterations);
+    ++mNumberOfTicks;
+}
 
-    std::cout << generateProgressBar(percentage) << "\r" << std::flush;
+/***********************************************************************************/
+void ProgressBar::addBytes(std::size_t bytes) noexcept {
+    mNumberOfBytes += bytes;
+}
+
+/***********************************************************************************/
+std::size_t ProgressBar::ticks() const noexcept {
+    return mNumberOfTicks;
 }
 
 /***********************************************************************************/
@@ -70,16 +99,15 @@ void ProgressBar::printNewMessage(const std::string& message) {
                 "Attempted to use progress bar after having terminated it");
     }
 
+    std::lock_guard<std::mutex> lock(mOutputMutex);
+
     std::cout << "\r"
         << std::left
         << std::setw(LENGTH_OF_PROGRESS_BAR + 6)
         << message << "\n";
     mLengthOfLastPrintedMessage = message.size();
-    const unsigned int percentage = static_cast<unsigned int>(
-            mNumberOfTicks*100.0/mTotalIterations);
-
-    std::cout << generateProgressBar(percentage) << "\r" << std::flush;
 
+    draw();
 }
 
 /***********************************************************************************/
@@ -90,6 +118,13 @@ void ProgressBar::updateLastPrintedMessage(const std::string& message) {
                 "Attempted to use progress bar after having terminated it");
     }
 
+    std::lock_guard<std::mutex> lock(mOutputMutex);
+
+    if (!mIsTerminal) {
+        std::cout << message << std::endl;
+        return;
+    }
+
     std::cout << "\r\033[F"
         << std::left
         << std::setw(mLengthOfLastPrintedMessage)
@@ -99,11 +134,93 @@ void ProgressBar::updateLastPrintedMessage(const std::string& message) {
 
 /***********************************************************************************/
 void ProgressBar::endProgressBar() {
-    if (!mEnded)
+    if (mEnded.exchange(true)) {
+        return;
+    }
+
     {
-        std::cout << std::string(2, '\n');
+        std::lock_guard<std::mutex> lock(mOutputMutex);
+        mStopTicker = true;
     }
-    mEnded = true;
+    mTickerWakeUp.notify_one();
+    if (mTicker.joinable()) {
+        mTicker.join();
+    }
+
+    // Final state, so the last thing on screen (or in the log) is accurate.
+    std::lock_guard<std::mutex> lock(mOutputMutex);
+    if (mIsTerminal) {
+        draw();
+        std::cout << std::string(2, '\n') << std::flush;
+    }
+    else {
+        std::cout << statusLine() << std::endl;
+    }
+}
+
+/***********************************************************************************/
+void ProgressBar::runTicker() {
+    const auto interval{ mIsTerminal ? std::chrono::duration_cast<std::chrono::milliseconds>(REDRAW_INTERVAL)
+                                     : std::chrono::duration_cast<std::chrono::milliseconds>(LOG_LINE_INTERVAL) };
+
+    std::unique_lock<std::mutex> lock(mOutputMutex);
+    while (!mTickerWakeUp.wait_for(lock, interval, [this] { return mStopTicker; })) {
+        if (mIsTerminal) {
+            draw();
+        }
+        else {
+            std::cout << statusLine() << std::endl;
+        }
+    }
+}
+
+/***********************************************************************************/
+std::string ProgressBar::statusLine() const {
+    const std::size_t ticks{ mNumberOfTicks };
+    const std::size_t done{ std::min(mTotalIterations, ticks) };
+    const unsigned int percentage = mTotalIterations == 0 ? 100 : static_cast<unsigned int>(
+            done*100.0/mTotalIterations);
+
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - mStartTime };
+    const auto seconds{ std::max(elapsed.count(), 1e-3) };
+    const auto filesPerSecond{ ticks / seconds };
+    const auto megabytesPerSecond{ mNumberOfBytes / seconds / (1024.0 * 1024.0) };
+
+    std::ostringstream ss;
+    if (mIsTerminal) {
+        ss << generateProgressBar(percentage) << ' ';
+    }
+    else {
+        ss << "Progress: " << percentage << "% ";
+    }
+
+    ss << done << '/' << mTotalIterations
+       << std::fixed << std::setprecision(1)
+       << "  " << filesPerSecond << " files/s"
+       << "  " << megabytesPerSecond << " MB/s"
+       << "  ETA ";
+
+    if (done == mTotalIterations) {
+        ss << formatDuration(0);
+    }
+    else if (filesPerSecond > 0.0) {
+        ss << formatDuration((mTotalIterations - done) / filesPerSecond);
+    }
+    else {
+        ss << "--:--:--";
+    }
+
+    return ss.str();
+}
+
+/***********************************************************************************/
+void ProgressBar::draw() {
+    if (!mIsTerminal) {
+        return;
+    }
+
+    // \033[K clears whatever was left over from a longer previous line.
+    std::cout << statusLine() << "\033[K\r" << std::flush;
 }
 
 
@@ -1,8 +1,16 @@
 #pragma once
 
 // Stolen from: https://stackoverflow.com/a/46734192/2231969
+// Counting is lock-free so any worker thread can tick the bar; drawing is done
+// by a ticker thread a few times per second (or as a periodic log line when
+// stdout isn't a terminal, e.g. under cron).
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
 namespace tsm::utils {
 
@@ -51,15 +59,41 @@ public:
 
     /**
      * Overloaded prefix operator, used to indicate that the has been a new
-     * iteration.
+     * iteration. Safe to call from any thread; it never writes to the terminal.
      */
     void operator++();
 
+    /**
+     * Adds to the number of bytes processed, used for the MB/s figure.
+     * Safe to call from any thread.
+     */
+    void addBytes(std::size_t bytes) noexcept;
+
+    /**
+     * Number of iterations so far.
+     */
+    [[nodiscard]] std::size_t ticks() const noexcept;
+
 private:
-    std::size_t mTotalIterations;
-    std::size_t mNumberOfTicks;
-    bool mEnded;
+    /// Body of the ticker thread.
+    void runTicker();
+    /// Builds the bar (or log line) for the current counters.
+    [[nodiscard]] std::string statusLine() const;
+    /// Draws the bar. mOutputMutex must be held.
+    void draw();
+
+    const std::size_t mTotalIterations;
+    std::atomic_size_t mNumberOfTicks{ 0 };
+    std::atomic_size_t mNumberOfBytes{ 0 };
+    std::atomic_bool mEnded{ false };
     std::size_t mLengthOfLastPrintedMessage;
+    const bool mIsTerminal;
+    const std::chrono::steady_clock::time_point mStartTime;
+
+    std::mutex mOutputMutex;
+    std::condition_variable mTickerWakeUp;
+    bool mStopTicker{ false };
+    std::thread mTicker;
 };
 
 } // namespace tsm::utils
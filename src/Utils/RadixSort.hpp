@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+/// Number of bits needed to store value.
+[[nodiscard]] constexpr unsigned int bitWidth(std::uint64_t value) noexcept {
+    unsigned int bits{ 0 };
+    while (value > 0) {
+        value >>= 1;
+        ++bits;
+    }
+
+    return bits;
+}
+
+/***********************************************************************************/
+/// LSD radix sort of unsigned 64-bit keys, one byte per pass.
+/// Only the low keyBits bits are looked at, so narrow keys take fewer passes.
+inline void radixSort(std::vector<std::uint64_t>& keys, const unsigned int keyBits = 64) {
+    if (keys.size() < 2) {
+        return;
+    }
+
+    std::vector<std::uint64_t> buffer(keys.size());
+
+    for (unsigned int shift = 0; shift < keyBits; shift += 8) {
+        std::array<std::size_t, 257> offsets{};
+        for (const auto key : keys) {
+            ++offsets[((key >> shift) & 0xFF) + 1];
+        }
+
+        // Every key has the same digit: this pass wouldn't move anything.
+        if (offsets[((keys.front() >> shift) & 0xFF) + 1] == keys.size()) {
+            continue;
+        }
+
+        for (std::size_t i = 1; i < offsets.size(); ++i) {
+            offsets[i] += offsets[i - 1];
+        }
+
+        for (const auto key : keys) {
+            buffer[offsets[(key >> shift) & 0xFF]++] = key;
+        }
+
+        keys.swap(buffer);
+    }
+}
+
+} // namespace tsm::utils
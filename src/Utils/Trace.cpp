@@ -0,0 +1,220 @@
+#include "Trace.hpp"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <iostream>
+
+namespace tsm::utils {
+
+/***********************************************************************************/
+namespace {
+
+    void writeEscaped(std::ostream& out, const std::string& text) {
+        constexpr char HEX[]{ "0123456789abcdef" };
+        for (const auto c : text) {
+            switch (c) {
+                case '"':
+                    out << "\\\"";
+                    break;
+                case '\\':
+                    out << "\\\\";
+                    break;
+                case '\n':
+                    out << "\\n";
+                    break;
+                case '\t':
+                    out << "\\t";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        out << "\\u00" << HEX[(c >> 4) & 0xf] << HEX[c & 0xf];
+                    }
+                    else {
+                        out << c;
+                    }
+            }
+        }
+    }
+}
+
+/***********************************************************************************/
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+/***********************************************************************************/
+void Tracer::start(const fs::path& path) {
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    m_path = path;
+    m_start = Clock::now();
+    m_enabled = true;
+}
+
+/***********************************************************************************/
+bool Tracer::stop() {
+    if (!m_enabled.exchange(false)) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    const auto tempPath{ m_path.string() + ".tmp" };
+    std::ofstream f(tempPath, std::ios::trunc);
+    if (!f.is_open()) {
+        std::cerr << "Failed to write trace " << tempPath << '.' << std::endl;
+        return false;
+    }
+
+    const auto pid{ static_cast<std::int64_t>(getpid()) };
+    std::size_t dropped{ 0 };
+    auto first{ true };
+    const auto separator = [&f, &first]() -> std::ostream& {
+        f << (first ? "\n" : ",\n");
+        first = false;
+        return f;
+    };
+
+    f << "{\"traceEvents\":[";
+
+    for (const auto& [lane, name] : m_laneNames) {
+        separator() << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << lane << ",\"args\":{\"name\":\"";
+        writeEscaped(f, name);
+        f << "\"}}";
+    }
+
+    // Buffers stay allocated after this: a thread may still hold on to its own.
+    for (auto& buffer : m_buffers) {
+        std::lock_guard<std::mutex> bufferLock{ buffer->Mutex };
+
+        separator() << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << buffer->ThreadID << ",\"args\":{\"name\":\"";
+        writeEscaped(f, buffer->Name);
+        f << "\"}}";
+
+        // Oldest first, starting after the slot written last once the ring has wrapped.
+        const auto size{ buffer->Events.size() };
+        const auto oldest{ buffer->Recorded > size ? buffer->Recorded % size : 0 };
+        dropped += buffer->Recorded - size;
+        for (std::size_t i = 0; i < size; ++i) {
+            const auto& event{ buffer->Events[(oldest + i) % size] };
+            separator() << "{\"ph\":\"X\",\"cat\":\"" << event.Category << "\",\"name\":\"" << event.Name << "\",\"pid\":" << pid
+                        << ",\"tid\":" << (event.Lane != 0 ? event.Lane : buffer->ThreadID)
+                        << ",\"ts\":" << event.BeginUs << ",\"dur\":" << event.DurationUs;
+            if (!event.Detail.empty()) {
+                f << ",\"args\":{\"detail\":\"";
+                writeEscaped(f, event.Detail);
+                f << "\"}";
+            }
+            f << '}';
+        }
+
+        buffer->Events.clear();
+        buffer->Recorded = 0;
+    }
+
+    f << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+    m_laneNames.clear();
+
+    if (!f.flush()) {
+        std::cerr << "Failed to write trace " << tempPath << '.' << std::endl;
+        return false;
+    }
+    f.close();
+
+    std::error_code e;
+    fs::rename(tempPath, m_path, e);
+    if (e) {
+        std::cerr << "Failed to write trace " << m_path << ": " << e.message() << std::endl;
+        return false;
+    }
+
+    std::cout << "Trace written to " << m_path.string() << (dropped > 0 ? " (" + std::to_string(dropped) + " oldest event(s) overwritten)" : "") << '.' << std::endl;
+
+    return true;
+}
+
+/***********************************************************************************/
+void Tracer::complete(const char* category, const char* name, const Clock::time_point begin, const Clock::time_point end,
+                      std::string detail /* = {} */, const std::optional<std::int64_t> lane /* = std::nullopt */) {
+    if (!enabled()) {
+        return;
+    }
+
+    auto& buffer{ threadBuffer() };
+    std::lock_guard<std::mutex> lock{ buffer.Mutex };
+
+    Event event{ category, name,
+                 std::chrono::duration_cast<std::chrono::microseconds>(begin - m_start).count(),
+                 std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count(),
+                 lane.value_or(0), std::move(detail) };
+
+    if (buffer.Events.size() < TRACE_EVENTS_PER_THREAD) {
+        buffer.Events.push_back(std::move(event));
+    }
+    else {
+        buffer.Events[buffer.Recorded % TRACE_EVENTS_PER_THREAD] = std::move(event);
+    }
+    ++buffer.Recorded;
+}
+
+/***********************************************************************************/
+void Tracer::setThreadName(std::string name) {
+    auto& buffer{ threadBuffer() };
+    std::lock_guard<std::mutex> lock{ buffer.Mutex };
+    buffer.Name = std::move(name);
+}
+
+/***********************************************************************************/
+void Tracer::setLaneName(const std::int64_t lane, std::string name) {
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    m_laneNames.emplace_back(lane, std::move(name));
+}
+
+/***********************************************************************************/
+Tracer::ThreadBuffer& Tracer::threadBuffer() {
+    // Never freed (see stop()), so it can't dangle.
+    static thread_local ThreadBuffer* t_buffer{ nullptr };
+    if (!t_buffer) {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        auto buffer{ std::make_unique<ThreadBuffer>() };
+        // Small ids, so they can't collide with the pids used as lanes.
+        buffer->ThreadID = static_cast<std::int64_t>(m_buffers.size()) + 1;
+        buffer->Name = "thread " + std::to_string(buffer->ThreadID);
+        t_buffer = buffer.get();
+        m_buffers.push_back(std::move(buffer));
+    }
+
+    return *t_buffer;
+}
+
+/***********************************************************************************/
+TraceSpan::TraceSpan(const char* category, const char* name) noexcept : m_category{ category },
+                                                                        m_name{ name } {
+    if (Tracer::instance().enabled()) {
+        m_begin = Tracer::Clock::now();
+    }
+}
+
+/***********************************************************************************/
+TraceSpan::TraceSpan(const char* category, const char* name, const std::string& detail) : TraceSpan(category, name) {
+    if (m_begin) {
+        m_detail = detail;
+    }
+}
+
+/***********************************************************************************/
+TraceSpan::TraceSpan(const char* category, const char* name, const fs::path& detail) : TraceSpan(category, name) {
+    if (m_begin) {
+        m_detail = detail.string();
+    }
+}
+
+/***********************************************************************************/
+TraceSpan::~TraceSpan() {
+    if (m_begin) {
+        Tracer::instance().complete(m_category, m_name, *m_begin, Tracer::Clock::now(), std::move(m_detail));
+    }
+}
+
+} // namespace tsm::utils
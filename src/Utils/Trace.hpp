@@ -0,0 +1,121 @@
+#pragma once
+
+// Timeline of a run (--trace) in the Chrome trace event format, for chrome://tracing
+// or https://ui.perfetto.dev. Off unless Tracer::start() was called; a disabled span
+// costs one relaxed atomic load.
+
+#include "../Filesystem.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tsm::utils {
+
+/// Events kept per thread. Once a thread has recorded more, its oldest ones are overwritten.
+constexpr std::size_t TRACE_EVENTS_PER_THREAD{ std::size_t{ 1 } << 16 };
+
+/***********************************************************************************/
+/// Collects complete ("X") events into a ring buffer per thread and writes them all
+/// out when stopped. Each thread only ever touches its own buffer while recording,
+/// so the buffer's lock is never contended until stop().
+class Tracer {
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ///
+    [[nodiscard]] static Tracer& instance();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    /// Starts recording; stop() writes the events to path.
+    void start(const fs::path& path);
+    /// Stops recording and writes what was recorded. False if it couldn't be written.
+    /// Does nothing (and returns true) if not started.
+    bool stop();
+
+    ///
+    [[nodiscard]] bool enabled() const noexcept {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// Records a span of the calling thread, or of lane if given: a timeline of its
+    /// own for work done elsewhere (e.g. a reader process, by its pid).
+    /// category and name must be string literals (they're kept as pointers).
+    void complete(const char* category, const char* name, const Clock::time_point begin, const Clock::time_point end,
+                  std::string detail = {}, const std::optional<std::int64_t> lane = std::nullopt);
+
+    /// Names the calling thread's timeline.
+    void setThreadName(std::string name);
+    /// Names a lane given to complete().
+    void setLaneName(const std::int64_t lane, std::string name);
+
+private:
+    struct Event {
+        const char* Category{ nullptr };
+        const char* Name{ nullptr };
+        std::int64_t BeginUs{ 0 };
+        std::int64_t DurationUs{ 0 };
+        /// 0 for the recording thread's own timeline.
+        std::int64_t Lane{ 0 };
+        std::string Detail;
+    };
+
+    struct ThreadBuffer {
+        std::mutex Mutex;
+        std::int64_t ThreadID{ 0 };
+        std::string Name;
+        std::vector<Event> Events;
+        /// Total recorded; Events[Recorded % size] is the next slot.
+        std::size_t Recorded{ 0 };
+    };
+
+    Tracer() = default;
+
+    /// The calling thread's buffer, made on first use.
+    [[nodiscard]] ThreadBuffer& threadBuffer();
+
+    std::atomic<bool> m_enabled{ false };
+    Clock::time_point m_start;
+    fs::path m_path;
+
+    /// Guards the two below. Buffers outlive their threads, so nothing is lost when one exits.
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::vector<std::pair<std::int64_t, std::string>> m_laneNames;
+};
+
+/***********************************************************************************/
+/// Records the time between its construction and destruction as a span of the calling thread.
+class TraceSpan {
+
+public:
+    ///
+    TraceSpan(const char* category, const char* name) noexcept;
+    /// detail shows up in the event's args.
+    TraceSpan(const char* category, const char* name, const std::string& detail);
+    /// Only converts the path to text when tracing.
+    TraceSpan(const char* category, const char* name, const fs::path& detail);
+    ///
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_category;
+    const char* m_name;
+    /// Unset when tracing is off.
+    std::optional<Tracer::Clock::time_point> m_begin;
+    std::string m_detail;
+};
+
+} // namespace tsm::utils
@@ -1,22 +1,39 @@
 #pragma once
 
+#include <cstddef>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace tsm::ds {
 
+/// How a variable is stored in its file, for planning reads of it.
+struct [[nodiscard]] StorageLayout {
+    /// "contiguous", "chunked" or "compact".
+    std::string Storage;
+    /// Chunk length along each dimension; empty unless chunked.
+    std::vector<std::size_t> ChunkSizes;
+    /// zlib level, 0 when not deflated.
+    int DeflateLevel{ 0 };
+    bool Shuffle{ false };
+    /// _FillValue, if the variable overrides the netCDF default.
+    std::optional<double> FillValue;
+};
+
 struct [[nodiscard]] VariableDesc {
     VariableDesc(const std::string& name,
                 const std::string& units,
                 const std::string& longName,
                 const float min,
                 const float max,
-                const std::vector<std::string>& dims) :  Name{name},
-                                                         Units{units},
-                                                         LongName{longName},
-                                                         ValidMin{min},
-                                                         ValidMax{max},
-                                                         Dimensions{dims} {}
+                const std::vector<std::string>& dims,
+                const std::optional<StorageLayout>& layout = std::nullopt) :  Name{name},
+                                                                               Units{units},
+                                                                               LongName{longName},
+                                                                               ValidMin{min},
+                                                                               ValidMax{max},
+                                                                               Dimensions{dims},
+                                                                               Layout{layout} {}
 
     inline auto operator==(const VariableDesc& rhs) const noexcept {
         return Name == rhs.Name;
@@ -28,6 +45,8 @@ struct [[nodiscard]] VariableDesc {
     const float ValidMin{ 0.0f };
     const float ValidMax{ 0.0f };
     const std::vector<std::string> Dimensions;
+    /// Layout in this particular file; only set by the readers.
+    const std::optional<StorageLayout> Layout;
 };
 
 } // namespace tsm::dds
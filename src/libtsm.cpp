@@ -0,0 +1,308 @@
+#include "libtsm.h"
+
+#include "Database.hpp"
+#include "TimestampMapper.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct tsm_db {
+    std::unique_ptr<tsm::Database> Database;
+};
+
+/***********************************************************************************/
+namespace {
+
+    thread_local std::string lastError;
+
+    /// Size of the version 1 tsm_index_options, up to progress_user_data. Callers
+    /// built against an older header pass a struct this long or longer.
+    constexpr std::size_t INDEX_OPTIONS_V1_SIZE{ offsetof(tsm_index_options, spatial_extent) };
+
+    /// Owns what a tsm_result points to.
+    struct ResultBuffers {
+        std::vector<std::int64_t> Values;
+        std::string Strings;
+        std::vector<std::uint64_t> Offsets;
+    };
+
+    tsm_status fail(const tsm_status status, std::string message) {
+        lastError = std::move(message);
+        return status;
+    }
+
+    void publish(std::unique_ptr<ResultBuffers> buffers, tsm_result* result) {
+        result->values = buffers->Values.empty() ? nullptr : buffers->Values.data();
+        result->count = buffers->Values.size();
+        if (!buffers->Offsets.empty()) {
+            result->strings = buffers->Strings.data();
+            result->offsets = buffers->Offsets.data();
+            result->count = buffers->Offsets.size() - 1;
+        }
+        result->internal = buffers.release();
+    }
+
+    tsm_status publishStrings(const std::vector<std::string>& strings, tsm_result* result) {
+        auto buffers{ std::make_unique<ResultBuffers>() };
+
+        std::size_t bytes{ 0 };
+        for (const auto& s : strings) {
+            bytes += s.size() + 1;
+        }
+        buffers->Strings.reserve(bytes);
+        buffers->Offsets.reserve(strings.size() + 1);
+
+        for (const auto& s : strings) {
+            buffers->Offsets.push_back(buffers->Strings.size());
+            buffers->Strings.append(s);
+            buffers->Strings.push_back('\0');
+        }
+        buffers->Offsets.push_back(buffers->Strings.size());
+
+        publish(std::move(buffers), result);
+
+        return TSM_OK;
+    }
+
+    /// Runs body, turning exceptions into TSM_ERROR_INTERNAL so none cross into C.
+    template<typename Body>
+    tsm_status guarded(Body&& body) noexcept {
+        try {
+            lastError.clear();
+            return body();
+        }
+        catch (const std::exception& e) {
+            return fail(TSM_ERROR_INTERNAL, e.what());
+        }
+        catch (...) {
+            return fail(TSM_ERROR_INTERNAL, "Unknown exception.");
+        }
+    }
+}
+
+/***********************************************************************************/
+int tsm_api_version(void) {
+    return TSM_API_VERSION;
+}
+
+/***********************************************************************************/
+const char* tsm_last_error(void) {
+    return lastError.c_str();
+}
+
+/***********************************************************************************/
+void tsm_index_options_init(tsm_index_options* options) {
+    if (!options) {
+        return;
+    }
+
+    const tsm::cli::CLIOptions defaults;
+
+    *options = tsm_index_options{};
+    options->size = sizeof(tsm_index_options);
+    options->transaction_size = defaults.TransactionSize;
+    options->memory_budget_mb = defaults.MemoryBudgetMB;
+    options->read_timeout_s = static_cast<unsigned int>(defaults.ReadTimeout);
+    options->read_workers = defaults.ReadWorkers;
+}
+
+/***********************************************************************************/
+tsm_status tsm_index_files(const tsm_index_options* options, const char* const* paths, size_t count) {
+    return guarded([&] {
+        if (!options || options->size < INDEX_OPTIONS_V1_SIZE) {
+            return fail(TSM_ERROR_INVALID_ARGUMENT, "Options must be set up with tsm_index_options_init().");
+        }
+        // Fields the caller's version of the struct doesn't have keep their defaults.
+        tsm_index_options given;
+        tsm_index_options_init(&given);
+        std::memcpy(&given, options, std::min(options->size, sizeof(given)));
+        given.size = sizeof(given);
+        options = &given;
+        if (!options->output_dir || !options->dataset_name || (!paths && count > 0)) {
+            return fail(TSM_ERROR_INVALID_ARGUMENT, "output_dir, dataset_name and paths are required.");
+        }
+
+        tsm::cli::CLIOptions opts;
+        opts.DatasetName = options->dataset_name;
+        opts.OutputDir = tsm::cli::sanitizeDirectoryPath(options->output_dir);
+        opts.Historical = true;
+        opts.WAL = options->wal != 0;
+        opts.TransactionSize = options->transaction_size;
+        opts.InMemory = options->in_memory != 0;
+        opts.MemoryBudgetMB = options->memory_budget_mb;
+        opts.ClusteredJoinTable = options->clustered_join_table != 0;
+        opts.ReadTimeout = options->read_timeout_s;
+        opts.ReadWorkers = options->read_workers;
+        opts.NoProgress = options->show_progress == 0;
+        opts.SpatialExtent = options->spatial_extent != 0;
+
+        if (opts.DatasetName.empty() || (opts.WAL && opts.TransactionSize == 0) || (opts.WAL && opts.InMemory) ||
+            (opts.ReadTimeout > 0 && opts.ReadWorkers == 0)) {
+            return fail(TSM_ERROR_INVALID_ARGUMENT, "Invalid combination of options.");
+        }
+
+        std::error_code e;
+        fs::create_directories(opts.OutputDir, e);
+        if (e) {
+            return fail(TSM_ERROR_OPEN, "Failed to create " + opts.OutputDir + ": " + e.message());
+        }
+
+        tsm::utils::PathStore filePaths;
+        for (std::size_t i = 0; i < count; ++i) {
+            filePaths.add(paths[i]);
+        }
+
+        tsm::TimestampMapper mapper{ opts };
+        if (options->progress) {
+            const auto callback{ options->progress };
+            auto* userData{ options->progress_user_data };
+            mapper.setProgressCallback([callback, userData](const std::size_t filesDone, const std::size_t filesTotal) {
+                callback(filesDone, filesTotal, userData);
+            });
+        }
+
+        if (!mapper.indexFiles(std::move(filePaths))) {
+            return fail(TSM_ERROR_INDEX, "Indexing failed; see stderr and " + opts.OutputDir + opts.DatasetName + "_failed_files.lst.");
+        }
+
+        return TSM_OK;
+    });
+}
+
+/***********************************************************************************/
+tsm_status tsm_open(const char* output_dir, const char* dataset_name, tsm_db** db) {
+    return guarded([&] {
+        if (!output_dir || !dataset_name || !db) {
+            return fail(TSM_ERROR_INVALID_ARGUMENT, "output_dir, dataset_name and db are required.");
+        }
+        *db = nullptr;
+
+        tsm::DatabaseOptions options;
+        options.ReadOnly = true;
+
+        auto handle{ std::make_unique<tsm_db>() };
+        handle->Database = std::make_unique<tsm::Database>(output_dir, dataset_name, options);
+        if (!handle->Database->open()) {
+            return fail(TSM_ERROR_OPEN, std::string("Failed to open ") + dataset_name + ".sqlite3 in " + output_dir + '.');
+        }
+
+        *db = handle.release();
+
+        return TSM_OK;
+    });
+}
+
+/***********************************************************************************/
+void tsm_close(tsm_db* db) {
+    delete db;
+}
+
+/***********************************************************************************/
+tsm_status tsm_find_files(tsm_db* db, const char* variable, int64_t timestamp, tsm_result* result) {
+    return guarded([&] {
+        if (!db || !variable || !result) {
+            return fail(TSM_ERROR_INVALID_ARGUMENT, "db, variable and result are required.");
+        }
+        *result = tsm_result{};
+
+        const auto& filepaths{ db->Database->selectFilepaths(variable, timestamp) };
+        if (!filepaths) {
+            return fail(TSM_ERROR_QUERY, "Failed to look up files.");
+        }
+
+        return publishStrings(*filepaths, result);
+    });
+}
+
+/***********************************************************************************/
+tsm_status tsm_find_files_in_region(tsm_db* db, const char* variable, int64_t timestamp,
+                                    double min_lat, double max_lat, double min_lon, double max_lon, tsm_result* result) {
+    return guarded([&] {
+        if (!db || !variable || !result) {
+            return fail(TSM_ERROR_INVALID_ARGUMENT, "db, variable and result are required.");
+        }
+        *result = tsm_result{};
+
+        const auto& filepaths{ db->Database->selectFilepaths(variable, timestamp, { min_lat, max_lat, min_lon, max_lon }) };
+        if (!filepaths) {
+            return fail(TSM_ERROR_QUERY, "Failed to look up files; was the database indexed with spatial_extent?");
+        }
+
+        return publishStrings(*filepaths, result);
+    });
+}
+
+/***********************************************************************************/
+tsm_status tsm_timestamps(tsm_db* db, const char* variable, tsm_result* result) {
+    return guarded([&] {
+        if (!db || !variable || !result) {
+            return fail(TSM_ERROR_INVALID_ARGUMENT, "db, variable and result are required.");
+        }
+        *result = tsm_result{};
+
+        auto timestamps{ db->Database->selectTimestamps(variable) };
+        if (!timestamps) {
+            return fail(TSM_ERROR_QUERY, "Failed to look up timestamps.");
+        }
+
+        auto buffers{ std::make_unique<ResultBuffers>() };
+        buffers->Values = std::move(*timestamps);
+        publish(std::move(buffers), result);
+
+        return TSM_OK;
+    });
+}
+
+/***********************************************************************************/
+tsm_status tsm_time_coverage(tsm_db* db, const char* variable, tsm_coverage* coverage) {
+    return guarded([&] {
+        if (!db || !variable || !coverage) {
+            return fail(TSM_ERROR_INVALID_ARGUMENT, "db, variable and coverage are required.");
+        }
+        *coverage = tsm_coverage{};
+
+        const auto& variableCoverage{ db->Database->selectCoverage(variable) };
+        if (!variableCoverage) {
+            return fail(TSM_ERROR_QUERY, std::string("No time coverage for ") + variable + '.');
+        }
+
+        coverage->min = variableCoverage->Min;
+        coverage->max = variableCoverage->Max;
+        coverage->count = variableCoverage->Count;
+        coverage->step = variableCoverage->Step.value_or(0);
+
+        return TSM_OK;
+    });
+}
+
+/***********************************************************************************/
+tsm_status tsm_variables(tsm_db* db, tsm_result* result) {
+    return guarded([&] {
+        if (!db || !result) {
+            return fail(TSM_ERROR_INVALID_ARGUMENT, "db and result are required.");
+        }
+        *result = tsm_result{};
+
+        const auto& variables{ db->Database->selectVariables() };
+        if (!variables) {
+            return fail(TSM_ERROR_QUERY, "Failed to look up variables.");
+        }
+
+        return publishStrings(*variables, result);
+    });
+}
+
+/***********************************************************************************/
+void tsm_result_free(tsm_result* result) {
+    if (!result) {
+        return;
+    }
+
+    delete static_cast<ResultBuffers*>(result->internal);
+    *result = tsm_result{};
+}
@@ -0,0 +1,135 @@
+#ifndef LIBTSM_H
+#define LIBTSM_H
+
+/*
+ * C interface of libtsm.so (built with `make lib`), for indexing netCDF files
+ * and looking up the resulting databases in-process, e.g. from Python through
+ * ctypes or cffi.
+ *
+ * Conventions:
+ *  - Every function returns a tsm_status. On failure tsm_last_error() tells
+ *    what went wrong (per thread).
+ *  - Results are handed out in a tsm_result whose buffers belong to the
+ *    library and stay valid until tsm_result_free(). They can be wrapped
+ *    without copying (e.g. numpy.frombuffer over values).
+ *  - Structs only ever grow at the end; set their size member with the
+ *    matching *_init() function. Fields past the size a caller passes get
+ *    their defaults.
+ *  - A tsm_db handle must not be used by two threads at once.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define TSM_API __attribute__((visibility("default")))
+#else
+#define TSM_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TSM_API_VERSION 3
+
+typedef enum tsm_status {
+    TSM_OK = 0,
+    TSM_ERROR_INVALID_ARGUMENT,
+    /* The database couldn't be opened. */
+    TSM_ERROR_OPEN,
+    /* None of the given files could be read, or the database couldn't be written. */
+    TSM_ERROR_INDEX,
+    /* The lookup failed, e.g. the database has no index yet. */
+    TSM_ERROR_QUERY,
+    /* Anything unexpected. */
+    TSM_ERROR_INTERNAL
+} tsm_status;
+
+/* Called on the indexing thread after each file is read. */
+typedef void (*tsm_progress_callback)(size_t files_done, size_t files_total, void* user_data);
+
+typedef struct tsm_index_options {
+    /* sizeof(tsm_index_options), set by tsm_index_options_init(). */
+    size_t size;
+    /* Directory of the database; created if missing. */
+    const char* output_dir;
+    /* The database is <output_dir>/<dataset_name>.sqlite3. */
+    const char* dataset_name;
+    /* Same as the command-line options of the same names. 0/1 for flags. */
+    int wal;
+    size_t transaction_size;
+    int in_memory;
+    size_t memory_budget_mb;
+    int clustered_join_table;
+    unsigned int read_timeout_s;
+    size_t read_workers;
+    /* Draw the progress bar on stdout as well. */
+    int show_progress;
+    tsm_progress_callback progress;
+    void* progress_user_data;
+    /* Also index each file's lat/lon bounding box (since version 3). */
+    int spatial_extent;
+} tsm_index_options;
+
+/* Results: either integers (values) or strings (strings + offsets). */
+typedef struct tsm_result {
+    size_t count;
+    /* count integers, or NULL. */
+    const int64_t* values;
+    /* count NUL-terminated strings back to back, or NULL. String i starts at
+       strings + offsets[i] and is offsets[i + 1] - offsets[i] - 1 bytes long. */
+    const char* strings;
+    const uint64_t* offsets;
+    /* Owned by the library. */
+    void* internal;
+} tsm_result;
+
+/* Time axis of a variable. */
+typedef struct tsm_coverage {
+    int64_t min;
+    int64_t max;
+    /* Distinct timestamps. */
+    uint64_t count;
+    /* Set when the timestamps are exactly min, min + step, ..., max; 0 otherwise. */
+    int64_t step;
+} tsm_coverage;
+
+typedef struct tsm_db tsm_db;
+
+/* TSM_API_VERSION of the loaded library. */
+TSM_API int tsm_api_version(void);
+/* Message for the last failed call on this thread, or "". */
+TSM_API const char* tsm_last_error(void);
+
+/* Fills in the defaults (historical dataset, 4 read workers, no deadline, ...). */
+TSM_API void tsm_index_options_init(tsm_index_options* options);
+/* Indexes count files into the options' database. Blocks until done. */
+TSM_API tsm_status tsm_index_files(const tsm_index_options* options, const char* const* paths, size_t count);
+
+/* Opens <output_dir>/<dataset_name>.sqlite3 read-only. */
+TSM_API tsm_status tsm_open(const char* output_dir, const char* dataset_name, tsm_db** db);
+TSM_API void tsm_close(tsm_db* db);
+
+/* Files holding variable at timestamp (strings, sorted). */
+TSM_API tsm_status tsm_find_files(tsm_db* db, const char* variable, int64_t timestamp, tsm_result* result);
+/* Files holding variable at timestamp whose lat/lon bounding box intersects
+   the region (strings, sorted). Longitudes in [-180, 180]. TSM_ERROR_QUERY
+   unless the database was indexed with spatial_extent (since version 3). */
+TSM_API tsm_status tsm_find_files_in_region(tsm_db* db, const char* variable, int64_t timestamp,
+                                            double min_lat, double max_lat, double min_lon, double max_lon, tsm_result* result);
+/* Every timestamp of variable (values, ascending). */
+TSM_API tsm_status tsm_timestamps(tsm_db* db, const char* variable, tsm_result* result);
+/* Time range of variable, without scanning the index (since version 2).
+   TSM_ERROR_QUERY if the variable isn't covered. */
+TSM_API tsm_status tsm_time_coverage(tsm_db* db, const char* variable, tsm_coverage* coverage);
+/* Every variable (strings, sorted). */
+TSM_API tsm_status tsm_variables(tsm_db* db, tsm_result* result);
+/* Releases the result's buffers and zeroes it. Safe on a zeroed result. */
+TSM_API void tsm_result_free(tsm_result* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBTSM_H */
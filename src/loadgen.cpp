@@ -0,0 +1,173 @@
+// tsm-loadgen (make loadgen): load generator for nc-timestamp-mapper --serve.
+// Sends FILES requests for random (variable, timestamp) pairs of a dataset from
+// several connections at once and reports throughput and latency percentiles.
+
+#include "LookupClient.hpp"
+
+#include <cxxopts/include/cxxopts.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    /// Per connection.
+    struct Results {
+        /// Microseconds, one per successful request.
+        std::vector<double> Latencies;
+        std::size_t Errors{ 0 };
+    };
+
+    double percentile(const std::vector<double>& sorted, const double p) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+        const auto rank{ static_cast<std::size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5) };
+        return sorted[std::min(rank, sorted.size() - 1)];
+    }
+
+    /// Every (variable, timestamp) pair of the dataset, or of the given variable.
+    bool collectQueries(const std::string& socket, const std::string& dataset, const std::string& variable,
+                        std::vector<std::pair<std::string, std::string>>& queries) {
+        tsm::LookupClient client;
+        if (!client.connect(socket)) {
+            std::cerr << client.lastError() << std::endl;
+            return false;
+        }
+
+        std::vector<std::string> variables{ variable };
+        if (variable.empty()) {
+            const auto& names{ client.request("VARIABLES " + dataset) };
+            if (!names) {
+                std::cerr << client.lastError() << std::endl;
+                return false;
+            }
+            variables = *names;
+        }
+
+        for (const auto& name : variables) {
+            const auto& timestamps{ client.request("TIMESTAMPS " + dataset + ' ' + name) };
+            if (!timestamps) {
+                std::cerr << client.lastError() << std::endl;
+                return false;
+            }
+            for (const auto& timestamp : *timestamps) {
+                queries.emplace_back(name, timestamp);
+            }
+        }
+
+        return true;
+    }
+}
+
+/***********************************************************************************/
+int main(int argc, char** argv) {
+    std::string socket, dataset, variable;
+    std::size_t connections{ 4 };
+    std::size_t seconds{ 10 };
+
+    try {
+        cxxopts::Options options("tsm-loadgen", "Load generator for nc-timestamp-mapper --serve.");
+        options.add_options()
+        ("s,socket", "Socket the server listens on.", cxxopts::value<std::string>())
+        ("n,dataset-name", "Dataset to query.", cxxopts::value<std::string>())
+        ("variable", "Only query this variable (default: all of them).", cxxopts::value<std::string>())
+        ("c,connections", "Number of connections sending requests at once (default 4).", cxxopts::value<std::size_t>())
+        ("d,duration", "Seconds to run for (default 10).", cxxopts::value<std::size_t>())
+        ("help", "Print help.")
+        ;
+
+        const auto result{ options.parse(argc, argv) };
+        if (result.count("help") || result.count("socket") == 0 || result.count("dataset-name") == 0) {
+            std::cout << options.help({""}) << std::endl;
+            return result.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        socket = result["socket"].as<std::string>();
+        dataset = result["dataset-name"].as<std::string>();
+        variable = result.count("variable") > 0 ? result["variable"].as<std::string>() : "";
+        connections = std::max<std::size_t>(1, result.count("connections") > 0 ? result["connections"].as<std::size_t>() : connections);
+        seconds = result.count("duration") > 0 ? result["duration"].as<std::size_t>() : seconds;
+    }
+    catch (const cxxopts::OptionException& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::pair<std::string, std::string>> queries;
+    if (!collectQueries(socket, dataset, variable, queries)) {
+        return EXIT_FAILURE;
+    }
+    if (queries.empty()) {
+        std::cerr << "Nothing to query in " << dataset << '.' << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Results> results(connections);
+    std::atomic<bool> failed{ false };
+    const auto deadline{ Clock::now() + std::chrono::seconds(seconds) };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < connections; ++i) {
+        threads.emplace_back([&, i] {
+            tsm::LookupClient client;
+            if (!client.connect(socket)) {
+                std::cerr << client.lastError() << std::endl;
+                failed = true;
+                return;
+            }
+
+            std::mt19937_64 random{ i };
+            std::uniform_int_distribution<std::size_t> pick{ 0, queries.size() - 1 };
+            auto& own{ results[i] };
+
+            while (Clock::now() < deadline) {
+                const auto& [name, timestamp]{ queries[pick(random)] };
+
+                const auto start{ Clock::now() };
+                const auto& files{ client.request("FILES " + dataset + ' ' + name + ' ' + timestamp) };
+                const std::chrono::duration<double, std::micro> elapsed{ Clock::now() - start };
+
+                if (!files) {
+                    ++own.Errors;
+                    continue;
+                }
+                own.Latencies.push_back(elapsed.count());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (failed) {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<double> latencies;
+    std::size_t errors{ 0 };
+    for (const auto& own : results) {
+        latencies.insert(latencies.end(), own.Latencies.cbegin(), own.Latencies.cend());
+        errors += own.Errors;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Requests:    " << latencies.size() << " (" << errors << " errors) over " << connections << " connections in " << seconds << " s\n"
+              << "Throughput:  " << static_cast<double>(latencies.size()) / std::max<double>(1.0, static_cast<double>(seconds)) << " requests/s\n"
+              << "Latency p50: " << percentile(latencies, 50.0) << " us\n"
+              << "Latency p99: " << percentile(latencies, 99.0) << " us\n"
+              << "Latency max: " << (latencies.empty() ? 0.0 : latencies.back()) << " us" << std::endl;
+
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,6 +1,16 @@
 #include "TimestampMapper.hpp"
 
+#include "ArrowExport.hpp"
+#include "BatchConfig.hpp"
+#include "BatchMapper.hpp"
 #include "CLIOptions.hpp"
+#include "Catalog.hpp"
+#include "LookupServer.hpp"
+#include "Utils/Logger.hpp"
+#include "Utils/Trace.hpp"
+
+#include <cstdlib>
+#include <sstream>
 
 /***********************************************************************************/
 int main(int argc, char** argv) {
@@ -17,6 +27,59 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
 
+    if (!opts.TracePath.empty()) {
+        auto& tracer{ tsm::utils::Tracer::instance() };
+        tracer.start(opts.TracePath);
+        tracer.setThreadName("main");
+        // Forked children leave through _exit(), so only this process writes the file.
+        std::atexit([]() { tsm::utils::Tracer::instance().stop(); });
+    }
+
+    if (!opts.ConfigPath.empty()) {
+        const auto& config{ tsm::cli::readBatchConfig(opts.ConfigPath) };
+        if (!config) {
+            return EXIT_FAILURE;
+        }
+
+        tsm::BatchMapper batch{ *config, opts.Jobs };
+
+        return batch.exec() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (!opts.ServeSocket.empty()) {
+        tsm::ServeOptions serveOptions;
+        serveOptions.SocketPath = opts.ServeSocket;
+        serveOptions.OutputDir = opts.OutputDir;
+        std::istringstream names{ opts.DatasetName };
+        for (std::string name; std::getline(names, name, ',');) {
+            serveOptions.DatasetNames.push_back(name);
+        }
+
+        auto& logger{ tsm::utils::Logger::instance() };
+        logger.start(tsm::utils::parseLogLevel(opts.LogLevel).value_or(tsm::utils::LOG_LEVEL::INFO));
+
+        tsm::LookupServer server{ serveOptions };
+        server.stopOnSignals();
+        const auto served{ server.run() };
+
+        logger.stop();
+
+        return served ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (opts.Export) {
+        return tsm::exportArrow(opts.OutputDir, opts.DatasetName) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (opts.ExportFromCatalog) {
+        tsm::Catalog catalog{ opts.CatalogPath, true };
+        if (!catalog.open()) {
+            return EXIT_FAILURE;
+        }
+
+        return catalog.exportDataset(opts.DatasetName, opts.OutputDir) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     tsm::TimestampMapper mapper{ opts };
 
     return mapper.exec();
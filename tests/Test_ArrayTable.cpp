@@ -0,0 +1,96 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/ArrayTable.hpp"
+
+#include <sqlite3.h>
+
+#include <vector>
+
+using namespace tsm;
+
+namespace {
+    sqlite3* openMemoryDB() {
+        sqlite3* db{ nullptr };
+        sqlite3_open(":memory:", &db);
+
+        return db;
+    }
+
+    /// Runs sql with rows bound to its first parameter and returns the first row, or nothing.
+    std::vector<sqlite3_int64> queryRow(sqlite3* db, const char* sql, const ArrayTableRows* rows) {
+        sqlite3_stmt* stmt{ nullptr };
+        std::vector<sqlite3_int64> result;
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            return result;
+        }
+
+        if (rows) {
+            sqlite3_bind_pointer(stmt, 1, const_cast<ArrayTableRows*>(rows), ARRAY_TABLE_POINTER_TYPE, nullptr);
+        }
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            for (auto i = 0; i < sqlite3_column_count(stmt); ++i) {
+                result.push_back(sqlite3_column_type(stmt, i) == SQLITE_NULL ? -1 : sqlite3_column_int64(stmt, i));
+            }
+        }
+        sqlite3_finalize(stmt);
+
+        return result;
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("1: int64_array exposes a bound block of rows to SQL.") {
+    auto* db{ openMemoryDB() };
+    REQUIRE( registerArrayTable(db) );
+
+    const std::vector<std::int64_t> data{ 1, 10, 100,
+                                          2, 20, 200,
+                                          3, 30, 300,
+                                          4, 40, 400 };
+    const ArrayTableRows rows{ data.data(), 4, 3 };
+
+    REQUIRE( queryRow(db, "SELECT COUNT(*), SUM(c0), SUM(c1), SUM(c2) FROM int64_array(?);", &rows) == std::vector<sqlite3_int64>{ 4, 10, 100, 1000 } );
+
+    // Bulk insert through the table, the way the Database uses it.
+    REQUIRE( sqlite3_exec(db, "CREATE TABLE T(a INTEGER, b INTEGER, c INTEGER);", nullptr, nullptr, nullptr) == SQLITE_OK );
+    sqlite3_stmt* insertStmt{ nullptr };
+    REQUIRE( sqlite3_prepare_v2(db, "INSERT INTO T(a, b, c) SELECT c0, c1, c2 FROM int64_array(?);", -1, &insertStmt, nullptr) == SQLITE_OK );
+    sqlite3_bind_pointer(insertStmt, 1, const_cast<ArrayTableRows*>(&rows), ARRAY_TABLE_POINTER_TYPE, nullptr);
+    REQUIRE( sqlite3_step(insertStmt) == SQLITE_DONE );
+    sqlite3_finalize(insertStmt);
+
+    REQUIRE( queryRow(db, "SELECT COUNT(*), MAX(c) FROM T;", nullptr) == std::vector<sqlite3_int64>{ 4, 400 } );
+
+    sqlite3_close(db);
+}
+
+/***********************************************************************************/
+TEST_CASE("2: int64_array reads columns past the bound width as NULL.") {
+    auto* db{ openMemoryDB() };
+    REQUIRE( registerArrayTable(db) );
+
+    const std::vector<std::int64_t> data{ 7, 8 };
+    const ArrayTableRows rows{ data.data(), data.size(), 1 };
+
+    REQUIRE( queryRow(db, "SELECT c0, c1, c2 FROM int64_array(?) ORDER BY c0 DESC;", &rows) == std::vector<sqlite3_int64>{ 8, -1, -1 } );
+
+    sqlite3_close(db);
+}
+
+/***********************************************************************************/
+TEST_CASE("3: int64_array yields nothing without a bound block.") {
+    auto* db{ openMemoryDB() };
+    REQUIRE( registerArrayTable(db) );
+
+    // Unbound, or bound with the wrong pointer type.
+    REQUIRE( queryRow(db, "SELECT c0 FROM int64_array(?);", nullptr).empty() );
+
+    const std::vector<std::int64_t> data{ 1 };
+    const ArrayTableRows rows{ data.data(), data.size(), 1 };
+    sqlite3_stmt* stmt{ nullptr };
+    REQUIRE( sqlite3_prepare_v2(db, "SELECT c0 FROM int64_array(?);", -1, &stmt, nullptr) == SQLITE_OK );
+    sqlite3_bind_pointer(stmt, 1, const_cast<ArrayTableRows*>(&rows), "some_other_type", nullptr);
+    REQUIRE( sqlite3_step(stmt) != SQLITE_ROW );
+    sqlite3_finalize(stmt);
+
+    sqlite3_close(db);
+}
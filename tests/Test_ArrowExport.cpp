@@ -0,0 +1,141 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/ArrowExport.hpp"
+#include "../src/Database.hpp"
+#include "../src/DatasetDesc.hpp"
+#include "../src/Utils/ArrowWriter.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace tsm;
+
+namespace {
+    std::string readFile(const fs::path& path) {
+        std::ifstream f(path, std::ios::binary);
+        std::stringstream ss;
+        ss << f.rdbuf();
+
+        return ss.str();
+    }
+
+    template <typename T>
+    T readAt(const std::string& bytes, const std::size_t position) {
+        T value;
+        std::memcpy(&value, bytes.data() + position, sizeof(T));
+        return value;
+    }
+
+    /// Checks the framing of an Arrow IPC file; the number of encapsulated messages before the footer.
+    std::size_t checkArrowFile(const std::string& bytes) {
+        REQUIRE( bytes.size() > 24 );
+        REQUIRE( bytes.compare(0, 6, "ARROW1") == 0 );
+        REQUIRE( bytes.compare(bytes.size() - 6, 6, "ARROW1") == 0 );
+
+        const auto footerLength{ readAt<std::int32_t>(bytes, bytes.size() - 10) };
+        const auto footerStart{ bytes.size() - 10 - static_cast<std::size_t>(footerLength) };
+        REQUIRE( footerStart % 8 == 0 );
+
+        // Continuation marker, metadata length, metadata, body; up to the end-of-stream marker.
+        std::size_t messages{ 0 };
+        std::size_t position{ 8 };
+        while (true) {
+            REQUIRE( readAt<std::uint32_t>(bytes, position) == 0xFFFFFFFF );
+            const auto metadataLength{ readAt<std::int32_t>(bytes, position + 4) };
+            if (metadataLength == 0) {
+                break;
+            }
+            REQUIRE( metadataLength % 8 == 0 );
+
+            // Message.bodyLength: the root table's last field.
+            const auto metadata{ position + 8 };
+            const auto root{ metadata + readAt<std::uint32_t>(bytes, metadata) };
+            const auto vtable{ root - static_cast<std::size_t>(readAt<std::int32_t>(bytes, root)) };
+            const auto bodyLength{ readAt<std::int64_t>(bytes, root + readAt<std::uint16_t>(bytes, vtable + 4 + 2 * 3)) };
+            REQUIRE( bodyLength % 8 == 0 );
+
+            position = metadata + static_cast<std::size_t>(metadataLength) + static_cast<std::size_t>(bodyLength);
+            ++messages;
+        }
+        REQUIRE( position + 8 == footerStart );
+
+        return messages;
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("1: ArrowColumn tracks nulls and ArrowWriter frames every message.") {
+    utils::ArrowColumn column{ utils::ARROW_TYPE::UTF8 };
+    column.append(std::string_view{ "a" });
+    column.appendNull();
+    column.append(std::string_view{ "bc" });
+    REQUIRE( column.size() == 3 );
+    REQUIRE( column.nullCount() == 1 );
+    column.clear();
+    REQUIRE( column.size() == 0 );
+
+    const fs::path path{ "./test_arrow_writer.arrow" };
+    utils::ArrowWriter writer{ path, { { "value", utils::ARROW_TYPE::FLOAT64, true }, { "name", utils::ARROW_TYPE::UTF8, false, true } } };
+    REQUIRE( writer.open() );
+
+    utils::ArrowColumn names{ utils::ARROW_TYPE::UTF8 };
+    names.append(std::string_view{ "first" });
+    names.append(std::string_view{ "second" });
+    REQUIRE( writer.writeDictionary(1, names) );
+
+    auto columns{ writer.makeColumns() };
+    for (auto batch = 0; batch < 2; ++batch) {
+        columns[0].append(1.5);
+        columns[0].appendNull();
+        columns[1].appendIndex(1);
+        columns[1].appendIndex(0);
+        REQUIRE( writer.writeBatch(columns) );
+        for (auto& c : columns) {
+            c.clear();
+        }
+    }
+    columns[0].append(2.5);
+    REQUIRE_FALSE( writer.writeBatch(columns) );
+    REQUIRE( writer.close() );
+
+    // Schema, dictionary, two record batches.
+    REQUIRE( checkArrowFile(readFile(path)) == 4 );
+
+    fs::remove(path);
+}
+
+/***********************************************************************************/
+TEST_CASE("2: exportArrow writes the tables and the join rows of a database.") {
+    const ds::VariableDesc votemper{ "votemper", "K", "Temperature", 0.0f, 40.0f, { "time", "depth" } };
+    const ds::VariableDesc vosaline{ "vosaline", "PSU", "Salinity", 0.0f, 45.0f, { "time", "depth" } };
+    std::vector<ds::DataFileDesc> files;
+    files.emplace_back(std::vector<ds::timestamp_t>{ 3600, 7200 }, std::vector<ds::VariableDesc>{ votemper, vosaline }, "/test_arrow/1.nc");
+    files.emplace_back(std::vector<ds::timestamp_t>{ 10800 }, std::vector<ds::VariableDesc>{ votemper }, "/test_arrow/2.nc");
+
+    fs::remove("./test_arrow.sqlite3");
+    {
+        Database db{ "./", "test_arrow" };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(ds::DatasetDesc{ std::move(files), ds::DATASET_TYPE::HISTORICAL }) );
+    }
+
+    REQUIRE( exportArrow("./", "test_arrow") );
+
+    for (const auto& table : { "filepaths", "variables", "timestamps" }) {
+        const fs::path path{ std::string{ "./test_arrow_" } + table + ".arrow" };
+        // Schema and one record batch.
+        REQUIRE( checkArrowFile(readFile(path)) == 2 );
+        fs::remove(path);
+    }
+
+    // Schema, the variable and filepath dictionaries, and one record batch.
+    const auto& index{ readFile("./test_arrow_index.arrow") };
+    REQUIRE( checkArrowFile(index) == 4 );
+    REQUIRE( index.find("/test_arrow/2.nc") != std::string::npos );
+    REQUIRE( index.find("vosaline") != std::string::npos );
+    fs::remove("./test_arrow_index.arrow");
+
+    REQUIRE_FALSE( exportArrow("./", "test_arrow_missing") );
+
+    fs::remove("./test_arrow.sqlite3");
+}
@@ -0,0 +1,90 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/BatchConfig.hpp"
+
+#include <fstream>
+
+using namespace tsm::cli;
+
+/***********************************************************************************/
+TEST_CASE("1: parseJSONConfig reads top-level defaults and per-dataset settings.") {
+    const std::string json{ R"({
+        "output-dir": "/db",
+        "jobs": 4,
+        "datasets": [
+            { "dataset-name": "giops_day", "input-dir": "/data/giops/day", "historical": true },
+            { "dataset-name": "riops", "file-list": "/data/riops.lst", "output-dir": "/other\/db" }
+        ]
+    })" };
+
+    ConfigEntry defaults;
+    const auto& datasets{ parseJSONConfig(json, defaults) };
+
+    REQUIRE( datasets );
+    REQUIRE( datasets->size() == 2 );
+    REQUIRE( defaults.at("output-dir") == "/db" );
+    REQUIRE( defaults.at("jobs") == "4" );
+    REQUIRE( datasets->at(0).at("historical") == "true" );
+    REQUIRE( datasets->at(1).at("output-dir") == "/other/db" );
+}
+
+/***********************************************************************************/
+TEST_CASE("2: parseJSONConfig rejects malformed documents.") {
+    ConfigEntry defaults;
+
+    REQUIRE_FALSE( parseJSONConfig(R"({ "datasets": [ { "dataset-name": "a" } )", defaults) );
+    REQUIRE_FALSE( parseJSONConfig(R"({ "datasets": [ { "dataset-name": { "nested": 1 } } ] })", defaults) );
+    REQUIRE_FALSE( parseJSONConfig(R"({ "jobs": 4 } trailing)", defaults) );
+}
+
+/***********************************************************************************/
+TEST_CASE("3: parseYAMLConfig reads top-level defaults and per-dataset settings.") {
+    const std::string yaml{
+        "# nightly run\n"
+        "output-dir: /db\n"
+        "jobs: 4\n"
+        "datasets:\n"
+        "  - dataset-name: giops_day\n"
+        "    input-dir: \"/data/giops/day\"\n"
+        "    historical: true  # comment\n"
+        "  -\n"
+        "    dataset-name: riops\n"
+        "    file-list: '/data/riops.lst'\n"
+    };
+
+    ConfigEntry defaults;
+    const auto& datasets{ parseYAMLConfig(yaml, defaults) };
+
+    REQUIRE( datasets );
+    REQUIRE( datasets->size() == 2 );
+    REQUIRE( defaults.at("output-dir") == "/db" );
+    REQUIRE( datasets->at(0).at("input-dir") == "/data/giops/day" );
+    REQUIRE( datasets->at(0).at("historical") == "true" );
+    REQUIRE( datasets->at(1).at("file-list") == "/data/riops.lst" );
+}
+
+/***********************************************************************************/
+TEST_CASE("4: readBatchConfig applies defaults and rejects unknown options.") {
+    {
+        std::ofstream f("./test_batch.json");
+        f << R"({ "output-dir": "/db", "historical": true, "jobs": 3,
+                  "datasets": [ { "dataset-name": "a", "input-dir": "/data/a" },
+                                { "dataset-name": "b", "input-dir": "/data/b", "output-dir": "/b" } ] })";
+    }
+
+    const auto& config{ readBatchConfig("./test_batch.json") };
+    REQUIRE( config );
+    REQUIRE( config->Jobs == 3 );
+    REQUIRE( config->Datasets.size() == 2 );
+    REQUIRE( config->Datasets[0].OutputDir == "/db/" );
+    REQUIRE( config->Datasets[0].InputDir == "/data/a/" );
+    REQUIRE( config->Datasets[0].Historical );
+    REQUIRE( config->Datasets[1].OutputDir == "/b/" );
+
+    {
+        std::ofstream f("./test_batch.json");
+        f << R"({ "datasets": [ { "dataset-name": "a", "not-an-option": 1 } ] })";
+    }
+    REQUIRE_FALSE( readBatchConfig("./test_batch.json") );
+
+    fs::remove("./test_batch.json");
+}
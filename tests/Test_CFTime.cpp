@@ -0,0 +1,106 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Utils/CFTime.hpp"
+
+#include <limits>
+#include <vector>
+
+using namespace tsm::utils;
+
+namespace {
+    constexpr std::int64_t DAY{ 86400 };
+    // 2000-01-01 00:00:00 in seconds since 1950-01-01.
+    constexpr std::int64_t Y2000{ 1577836800 };
+
+    std::int64_t reference(const std::string& units, const std::string& calendar = "") {
+        const auto& parsed{ parseTimeUnits(units, calendar) };
+        REQUIRE( parsed );
+        return parsed->Reference;
+    }
+
+    std::vector<tsm::ds::timestamp_t> convert(const std::string& units, const std::string& calendar, const std::vector<double>& values) {
+        const auto& parsed{ parseTimeUnits(units, calendar) };
+        REQUIRE( parsed );
+        std::vector<tsm::ds::timestamp_t> out(values.size());
+        REQUIRE( toCanonicalTimestamps(*parsed, values.data(), values.size(), out.data()) );
+        return out;
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("1: parseTimeUnits decodes CF units, reference dates and calendars.") {
+    const auto& days{ parseTimeUnits("days since 1950-01-01", "") };
+    REQUIRE( days );
+    REQUIRE( days->Calendar == CALENDAR::STANDARD );
+    REQUIRE( days->Scale == 86400.0 );
+    REQUIRE( days->IntegerScale == 86400 );
+    REQUIRE( days->Reference == 0 );
+
+    REQUIRE( reference("seconds since 1970-01-01 00:00:00") == 631152000 );
+    REQUIRE( reference("Hours since 1950-01-01T06:00:00Z") == 6 * 3600 );
+    REQUIRE( reference("hours since 1950-01-01 00:00:00.0 +01:00") == -3600 );
+    REQUIRE( reference("minutes since 1950-1-1 12:30 UTC") == 12 * 3600 + 30 * 60 );
+    REQUIRE( parseTimeUnits("milliseconds since 1950-01-01", "")->IntegerScale == 0 );
+
+    // The standard calendar skips from 1582-10-04 (Julian) to 1582-10-15 (Gregorian).
+    REQUIRE( reference("days since 1582-10-15") - reference("days since 1582-10-04") == DAY );
+    REQUIRE( reference("days since 1582-10-15", "proleptic_gregorian") - reference("days since 1582-10-04", "proleptic_gregorian") == 11 * DAY );
+    REQUIRE( reference("days since 1949-12-19", "julian") == 0 );
+    REQUIRE( reference("days since 1950-02-30", "360_day") == (30 + 29) * DAY );
+    REQUIRE( reference("days since 1951-01-01", "365_day") == 365 * DAY );
+
+    REQUIRE_FALSE( parseTimeUnits("months since 1950-01-01", "") );
+    REQUIRE_FALSE( parseTimeUnits("days", "") );
+    REQUIRE_FALSE( parseTimeUnits("days since yesterday", "") );
+    REQUIRE_FALSE( parseTimeUnits("days since 1950-02-30", "") );
+    REQUIRE_FALSE( parseTimeUnits("days since 2000-02-29", "noleap") );
+    REQUIRE_FALSE( parseTimeUnits("days since 1582-10-10", "standard") );
+    REQUIRE_FALSE( parseTimeUnits("days since 1950-01-01", "all_leap") );
+
+    REQUIRE( cachedTimeUnits("days since 1950-01-01", "noleap")->Calendar == CALENDAR::NOLEAP );
+    REQUIRE( cachedTimeUnits("days since 1950-01-01", "noleap")->Reference == 0 );
+    REQUIRE_FALSE( cachedTimeUnits("fortnights since 1950-01-01", "") );
+}
+
+/***********************************************************************************/
+TEST_CASE("2: toCanonicalTimestamps converts every calendar to seconds since 1950-01-01.") {
+    // Fractional days are rounded to the nearest second, not truncated.
+    REQUIRE( convert("days since 1950-01-01", "", { 0.0, 18262.5, 0.999999999 }) ==
+             std::vector<tsm::ds::timestamp_t>{ 0, Y2000 + DAY / 2, DAY } );
+    REQUIRE( convert("hours since 2000-01-01", "gregorian", { 1.5 }) == std::vector<tsm::ds::timestamp_t>{ Y2000 + 5400 } );
+
+    const std::vector<std::int64_t> seconds{ 0, 3600 };
+    const auto& epoch1970{ parseTimeUnits("seconds since 1970-01-01", "") };
+    std::vector<tsm::ds::timestamp_t> out(seconds.size());
+    REQUIRE( toCanonicalTimestamps(*epoch1970, seconds.data(), seconds.size(), out.data()) );
+    REQUIRE( out == std::vector<tsm::ds::timestamp_t>{ 631152000, 631152000 + 3600 } );
+
+    // noleap: the same date, so a day later from March 1st of a leap year.
+    const auto noleap2000{ 50.0 * 365 };
+    REQUIRE( convert("days since 1950-01-01", "noleap", { noleap2000, noleap2000 + 58, noleap2000 + 59 }) ==
+             std::vector<tsm::ds::timestamp_t>{ Y2000, Y2000 + 58 * DAY, Y2000 + 60 * DAY } );
+
+    // 360_day: years line up, and the days between are stretched over the Gregorian year.
+    const auto day360{ 50.0 * 360 };
+    const auto& stretched{ convert("days since 1950-01-01", "360_day", { day360, day360 + 180, day360 + 359, day360 + 360 }) };
+    REQUIRE( stretched[0] == Y2000 );
+    REQUIRE( stretched[1] == Y2000 + 183 * DAY );
+    REQUIRE( stretched[2] > stretched[1] );
+    REQUIRE( stretched[2] < stretched[3] );
+    REQUIRE( stretched[3] == Y2000 + 366 * DAY );
+
+    // Before the canonical epoch, or not a number.
+    const auto& days{ parseTimeUnits("days since 1950-01-01", "") };
+    const std::vector<double> bad{ 1.0, -1.0 };
+    REQUIRE_FALSE( toCanonicalTimestamps(*days, bad.data(), bad.size(), out.data()) );
+    const std::vector<double> nan{ std::numeric_limits<double>::quiet_NaN(), 1.0 };
+    REQUIRE_FALSE( toCanonicalTimestamps(*days, nan.data(), nan.size(), out.data()) );
+}
+
+/***********************************************************************************/
+TEST_CASE("3: daysFromCivil counts proleptic Gregorian days from 1970-01-01.") {
+    STATIC_REQUIRE( daysFromCivil(1970, 1, 1) == 0 );
+    REQUIRE( daysFromCivil(1950, 1, 1) == -7305 );
+    REQUIRE( daysFromCivil(2000, 3, 1) == 11017 );
+    REQUIRE( daysFromCivil(1600, 2, 29) - daysFromCivil(1600, 2, 28) == 1 );
+    REQUIRE( daysFromCivil(1900, 3, 1) - daysFromCivil(1900, 2, 28) == 1 );
+}
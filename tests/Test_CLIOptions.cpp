@@ -42,4 +42,78 @@ TEST_CASE("2. CLIOptions::verify returns false on invalid options.") {
     opts.OutputDir = "./";
     opts.RegexEngine = "fake_regex";
     REQUIRE_FALSE( opts.verify() );
-}
\ No newline at end of file
+}
+TEST_CASE("3. CLIOptions::verify rejects an empty transaction size in WAL mode.") {
+    tsm::cli::CLIOptions opts;
+    opts.InputDir = "./Fixtures/";
+    opts.DatasetName = "my-dataset";
+    opts.OutputDir = "./";
+    opts.Historical = true;
+    opts.WAL = true;
+
+    REQUIRE( opts.verify() );
+
+    opts.TransactionSize = 0;
+    REQUIRE_FALSE( opts.verify() );
+}
+
+TEST_CASE("4. CLIOptions::verify rejects --in-memory together with --wal.") {
+    tsm::cli::CLIOptions opts;
+    opts.InputDir = "./Fixtures/";
+    opts.DatasetName = "my-dataset";
+    opts.OutputDir = "./";
+    opts.Historical = true;
+    opts.InMemory = true;
+
+    REQUIRE( opts.verify() );
+
+    opts.WAL = true;
+    REQUIRE_FALSE( opts.verify() );
+}
+
+TEST_CASE("5. CLIOptions::verify rejects an unknown log level.") {
+    tsm::cli::CLIOptions opts;
+    opts.InputDir = "./Fixtures/";
+    opts.DatasetName = "my-dataset";
+    opts.OutputDir = "./";
+    opts.Historical = true;
+
+    REQUIRE( opts.set("log-level", "warning") );
+    REQUIRE( opts.verify() );
+
+    opts.LogLevel = "loud";
+    REQUIRE_FALSE( opts.verify() );
+}
+
+TEST_CASE("6. CLIOptions::verify rejects an unknown file order.") {
+    tsm::cli::CLIOptions opts;
+    opts.InputDir = "./Fixtures/";
+    opts.DatasetName = "my-dataset";
+    opts.OutputDir = "./";
+    opts.Historical = true;
+
+    REQUIRE( opts.set("order", "newest-first") );
+    REQUIRE( opts.verify() );
+
+    opts.Order = "random";
+    REQUIRE_FALSE( opts.verify() );
+}
+
+TEST_CASE("7. CLIOptions::verify rejects --adaptive-reads without a read timeout or with bad bounds.") {
+    tsm::cli::CLIOptions opts;
+    opts.InputDir = "./Fixtures/";
+    opts.DatasetName = "my-dataset";
+    opts.OutputDir = "./";
+    opts.Historical = true;
+
+    REQUIRE( opts.set("adaptive-reads", "true") );
+    REQUIRE_FALSE( opts.verify() );
+
+    REQUIRE( opts.set("read-timeout", "60") );
+    REQUIRE( opts.set("read-workers", "16") );
+    REQUIRE( opts.set("min-read-workers", "2") );
+    REQUIRE( opts.verify() );
+
+    opts.MinReadWorkers = 32;
+    REQUIRE_FALSE( opts.verify() );
+}
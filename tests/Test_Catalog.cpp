@@ -0,0 +1,155 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Catalog.hpp"
+#include "../src/Database.hpp"
+#include "../src/DatasetDesc.hpp"
+
+#include <sqlite3.h>
+
+using namespace tsm;
+
+namespace {
+    /// Indexes one file per timestamp under /<datasetName>/, each holding the given variables.
+    void createDatabase(const std::string& datasetName, const std::vector<ds::timestamp_t>& timestamps, const std::vector<ds::VariableDesc>& variables) {
+        std::vector<ds::DataFileDesc> files;
+        for (const auto timestamp : timestamps) {
+            files.emplace_back(std::vector<ds::timestamp_t>{ timestamp }, variables, "/" + datasetName + "/" + std::to_string(timestamp) + ".nc");
+        }
+
+        fs::remove("./" + datasetName + ".sqlite3");
+        Database db{ "./", datasetName };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(ds::DatasetDesc{ std::move(files), ds::DATASET_TYPE::HISTORICAL }) );
+    }
+
+    std::string queryText(const fs::path& dbPath, const std::string& query) {
+        sqlite3* db{ nullptr };
+        sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+
+        sqlite3_stmt* stmt{ nullptr };
+        sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
+
+        std::string result;
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            result = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        }
+
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+
+        return result;
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("1: The catalog shares variables between datasets and answers across them.") {
+    const fs::path catalogPath{ "./test_catalog.sqlite3" };
+    fs::remove(catalogPath);
+
+    const ds::VariableDesc votemper{ "votemper", "K", "Temperature", 0.0f, 40.0f, { "time", "depth" } };
+    const ds::VariableDesc vosaline{ "vosaline", "PSU", "Salinity", 0.0f, 45.0f, { "time", "depth" } };
+    createDatabase("test_catalog_giops", { 3600, 7200 }, { votemper, vosaline });
+    createDatabase("test_catalog_riops", { 7200, 10800 }, { votemper });
+
+    {
+        Catalog catalog{ catalogPath };
+        REQUIRE( catalog.open() );
+        REQUIRE( catalog.importDataset("giops", ds::DATASET_TYPE::HISTORICAL, "./test_catalog_giops.sqlite3") );
+        REQUIRE( catalog.importDataset("riops", ds::DATASET_TYPE::HISTORICAL, "./test_catalog_riops.sqlite3") );
+        // Unchanged since: skipped. Changed: replaced, not added to.
+        REQUIRE( catalog.importDataset("riops", ds::DATASET_TYPE::HISTORICAL, "./test_catalog_riops.sqlite3") );
+        createDatabase("test_catalog_riops", { 7200, 10800, 14400 }, { votemper });
+        REQUIRE( catalog.importDataset("riops", ds::DATASET_TYPE::HISTORICAL, "./test_catalog_riops.sqlite3") );
+        REQUIRE_FALSE( catalog.importDataset("missing", ds::DATASET_TYPE::HISTORICAL, "./test_catalog_missing.sqlite3") );
+
+        REQUIRE( catalog.selectDatasets() == std::vector<std::string>{ "giops", "riops" } );
+        REQUIRE( catalog.selectDatasets("votemper", 7200) == std::vector<std::string>{ "giops", "riops" } );
+        REQUIRE( catalog.selectDatasets("votemper", 14000, 500) == std::vector<std::string>{ "riops" } );
+        REQUIRE( catalog.selectDatasets("vosaline", 7200) == std::vector<std::string>{ "giops" } );
+        REQUIRE( catalog.selectDatasets("votemper", 20000, 500)->empty() );
+
+        const auto matches{ catalog.selectFilepaths("votemper", 7200) };
+        REQUIRE( matches );
+        REQUIRE( matches->size() == 2 );
+        REQUIRE( matches->front().Dataset == "giops" );
+        REQUIRE( matches->front().Filepath == "/test_catalog_giops/7200.nc" );
+        REQUIRE( matches->back().Dataset == "riops" );
+    }
+
+    REQUIRE( queryText(catalogPath, "SELECT COUNT(*) FROM Variables;") == "2" );
+    REQUIRE( queryText(catalogPath, "SELECT COUNT(*) FROM Dimensions;") == "2" );
+    REQUIRE( queryText(catalogPath, "SELECT COUNT(*) FROM Filepaths;") == "5" );
+    REQUIRE( queryText(catalogPath, "SELECT COUNT(*) FROM TimestampVariableFilepath;") == "7" );
+    REQUIRE( queryText(catalogPath, "SELECT max_timestamp FROM DatasetVariables dv INNER JOIN Datasets d ON d.id = dv.dataset_id WHERE d.name = 'riops';") == "14400" );
+
+    // Exported back out, giops reads the same as the database it came from.
+    fs::rename("./test_catalog_giops.sqlite3", "./test_catalog_giops_original.sqlite3");
+    {
+        Catalog catalog{ catalogPath, true };
+        REQUIRE( catalog.open() );
+        REQUIRE( catalog.exportDataset("giops", "./") );
+        REQUIRE_FALSE( catalog.exportDataset("missing", "./") );
+    }
+
+    {
+        DatabaseOptions options;
+        options.ReadOnly = true;
+        Database original{ "./", "test_catalog_giops_original", options };
+        REQUIRE( original.open() );
+        Database exported{ "./", "giops", options };
+        REQUIRE( exported.open() );
+        for (const auto* variable : { "votemper", "vosaline" }) {
+            REQUIRE( exported.selectTimestamps(variable) == original.selectTimestamps(variable) );
+            for (const auto timestamp : { 3600, 7200 }) {
+                REQUIRE( exported.selectFilepaths(variable, timestamp) == original.selectFilepaths(variable, timestamp) );
+            }
+        }
+        REQUIRE( exported.selectVariables() == std::vector<std::string>{ "vosaline", "votemper" } );
+    }
+    REQUIRE( queryText("./giops.sqlite3", "SELECT units FROM Variables WHERE variable = 'vosaline';") == "PSU" );
+
+    for (const auto* path : { "./test_catalog.sqlite3", "./test_catalog.sqlite3-wal", "./test_catalog.sqlite3-shm", "./giops.sqlite3",
+                              "./test_catalog_giops_original.sqlite3", "./test_catalog_riops.sqlite3" }) {
+        fs::remove(path);
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("2: Datasets sharing a variable keep their own dimensions.") {
+    const fs::path catalogPath{ "./test_catalog_dims.sqlite3" };
+    fs::remove(catalogPath);
+
+    createDatabase("test_catalog_dims_3d", { 3600 }, { { "votemper", "K", "Temperature", 0.0f, 40.0f, { "time", "depth", "y", "x" } } });
+    createDatabase("test_catalog_dims_2d", { 3600 }, { { "votemper", "K", "Temperature", 0.0f, 40.0f, { "time", "y", "x" } } });
+
+    {
+        Catalog catalog{ catalogPath };
+        REQUIRE( catalog.open() );
+        REQUIRE( catalog.importDataset("dims_3d", ds::DATASET_TYPE::HISTORICAL, "./test_catalog_dims_3d.sqlite3") );
+        REQUIRE( catalog.importDataset("dims_2d", ds::DATASET_TYPE::HISTORICAL, "./test_catalog_dims_2d.sqlite3") );
+        REQUIRE( catalog.exportDataset("dims_3d", "./") );
+        REQUIRE( catalog.exportDataset("dims_2d", "./") );
+    }
+
+    // A dataset indexed before timestamps were decoded from their units stays out.
+    {
+        sqlite3* raw{ nullptr };
+        sqlite3_open_v2("./test_catalog_dims_2d.sqlite3", &raw, SQLITE_OPEN_READWRITE, nullptr);
+        sqlite3_exec(raw, "PRAGMA user_version = 0;", nullptr, nullptr, nullptr);
+        sqlite3_close(raw);
+
+        Catalog catalog{ catalogPath };
+        REQUIRE( catalog.open() );
+        REQUIRE_FALSE( catalog.importDataset("dims_old", ds::DATASET_TYPE::HISTORICAL, "./test_catalog_dims_2d.sqlite3") );
+        REQUIRE( catalog.selectDatasets() == std::vector<std::string>{ "dims_2d", "dims_3d" } );
+    }
+
+    REQUIRE( queryText(catalogPath, "SELECT COUNT(*) FROM Variables;") == "1" );
+    REQUIRE( queryText("./dims_3d.sqlite3", "SELECT COUNT(*) FROM VarsDims;") == "4" );
+    REQUIRE( queryText("./dims_2d.sqlite3", "SELECT COUNT(*) FROM VarsDims;") == "3" );
+    REQUIRE( queryText("./dims_2d.sqlite3", "SELECT COUNT(*) FROM Dimensions WHERE name = 'depth';") == "0" );
+
+    for (const auto* path : { "./test_catalog_dims.sqlite3", "./test_catalog_dims.sqlite3-wal", "./test_catalog_dims.sqlite3-shm",
+                              "./dims_3d.sqlite3", "./dims_2d.sqlite3", "./test_catalog_dims_3d.sqlite3", "./test_catalog_dims_2d.sqlite3" }) {
+        fs::remove(path);
+    }
+}
@@ -0,0 +1,74 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Utils/ConcurrencyController.hpp"
+
+#include <chrono>
+
+using namespace tsm::utils;
+using namespace std::chrono_literals;
+
+namespace {
+    /// Completes one window of reads at the current limit, each taking latency, spread over duration.
+    void completeWindow(ConcurrencyController& controller, ConcurrencyController::Clock::time_point& now,
+                        const std::chrono::microseconds latency, const std::chrono::milliseconds duration) {
+        const auto reads{ std::max(ConcurrencyController::MIN_WINDOW_READS, controller.limit()) };
+        for (std::size_t i = 0; i < reads; ++i) {
+            now += duration / reads;
+            controller.onComplete(latency, now);
+        }
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("1: ConcurrencyController grows while latency holds and stays within bounds.") {
+    ConcurrencyController controller{ 2, 6, 4 };
+    REQUIRE( controller.limit() == 4 );
+
+    auto now{ ConcurrencyController::Clock::now() };
+    // Twice the files per second at each step: the storage keeps up.
+    for (auto i = 0; i < 10; ++i) {
+        completeWindow(controller, now, 10ms, 100ms);
+    }
+
+    REQUIRE( controller.limit() == 6 );
+    REQUIRE( controller.peak() == 6 );
+    REQUIRE( controller.decisions().size() == 2 );
+    REQUIRE( controller.decisions().front().From == 4 );
+    REQUIRE( controller.decisions().front().To == 5 );
+    REQUIRE( controller.decisions().front().Reason == ConcurrencyController::REASON::LATENCY_OK );
+
+    REQUIRE( ConcurrencyController{ 0, 0, 4 }.limit() == 1 );
+    REQUIRE( ConcurrencyController{ 3, 8, 1 }.limit() == 3 );
+}
+
+/***********************************************************************************/
+TEST_CASE("2: ConcurrencyController backs off on high latency, timeouts and no throughput gain.") {
+    ConcurrencyController controller{ 1, 16, 8 };
+    auto now{ ConcurrencyController::Clock::now() };
+
+    completeWindow(controller, now, 10ms, 100ms);
+    REQUIRE( controller.limit() == 9 );
+
+    // Latency more than doubled: cut to three quarters.
+    completeWindow(controller, now, 30ms, 100ms);
+    REQUIRE( controller.limit() == 6 );
+    REQUIRE( controller.decisions().back().Reason == ConcurrencyController::REASON::LATENCY_HIGH );
+
+    controller.onTimeout(now);
+    REQUIRE( controller.limit() == 4 );
+    REQUIRE( controller.decisions().back().Reason == ConcurrencyController::REASON::TIMEOUT );
+
+    // 4 -> 5, then 5 reads files slower than 4 did: back to 4.
+    completeWindow(controller, now, 10ms, 100ms);
+    REQUIRE( controller.limit() == 5 );
+    completeWindow(controller, now, 12ms, 400ms);
+    REQUIRE( controller.limit() == 4 );
+    REQUIRE( controller.decisions().back().Reason == ConcurrencyController::REASON::NO_GAIN );
+
+    REQUIRE( controller.summary() == "Read concurrency: 8 -> 4 (1-16, peak 9), 2 increase(s), 3 decrease(s)." );
+
+    // Never below the minimum.
+    ConcurrencyController floor{ 2, 4, 2 };
+    floor.onTimeout(now);
+    REQUIRE( floor.limit() == 2 );
+    REQUIRE( floor.decisions().empty() );
+}
@@ -0,0 +1,34 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Utils/CoordinateRange.hpp"
+
+#include <cmath>
+
+using namespace tsm::utils;
+
+/***********************************************************************************/
+TEST_CASE("1: coordinateRange skips fill values and NaN.") {
+    // Long enough for both the lanes and the remainder.
+    std::vector<double> latitudes;
+    for (auto i = 0; i < 37; ++i) {
+        latitudes.push_back(-45.0 + i);
+    }
+    latitudes[3] = 1e20;
+    latitudes[20] = -999.0;
+    latitudes[36] = std::nan("");
+
+    const auto range{ coordinateRange(latitudes, -90.0, 90.0) };
+    REQUIRE( range );
+    REQUIRE( range->first == -45.0 );
+    REQUIRE( range->second == -10.0 );
+
+    REQUIRE_FALSE( coordinateRange({ 1e20, -999.0 }, -90.0, 90.0) );
+    REQUIRE_FALSE( coordinateRange({}, -90.0, 90.0) );
+}
+
+/***********************************************************************************/
+TEST_CASE("2: coordinateRange brings 0..360 longitudes into -180..180.") {
+    const auto range{ coordinateRange({ 10.0, 90.0, 200.0, 350.0 }, -180.0, 360.0, 180.0) };
+    REQUIRE( range );
+    REQUIRE( range->first == -160.0 );
+    REQUIRE( range->second == 90.0 );
+}
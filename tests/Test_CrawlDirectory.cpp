@@ -1,6 +1,10 @@
 #include <catch2/single_include/catch2/catch.hpp>
 #include "../src/CrawlDirectory.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
 using namespace tsm::utils;
 
 TEST_CASE( "1. Crawl returns expected files with wildcard regex against all supported engines." ) {
@@ -15,3 +19,52 @@ TEST_CASE( "1. Crawl returns expected files with wildcard regex against all supp
     }
 
 }
+
+TEST_CASE( "2. Crawl cache lists only the directories that changed." ) {
+
+    const fs::path root{ "./crawl_cache_test" };
+    const fs::path cachePath{ "./crawl_cache_test.tsv" };
+    fs::remove_all(root);
+    fs::remove(cachePath);
+
+    for (const auto& year : { "2018", "2019", "2020" }) {
+        fs::create_directories(root / year);
+        std::ofstream(root / year / (std::string(year) + "0101.nc"));
+        std::ofstream(root / year / "notes.txt");
+    }
+
+    // Back-date everything, so none of it is too recent to be trusted.
+    const auto past{ fs::file_time_type::clock::now() - std::chrono::hours(1) };
+    for (const auto& directory : { root, root / "2018", root / "2019", root / "2020" }) {
+        fs::last_write_time(directory, past);
+    }
+
+    const auto crawl = [&] {
+        DirectoryCache cache{ cachePath };
+        cache.load();
+        auto files{ crawlDirectory(root, ".*", "egrep", &cache) };
+        cache.save();
+        std::sort(files.begin(), files.end());
+        return std::make_pair(files, cache.listedDirectories());
+    };
+
+    const auto& [first, firstListed]{ crawl() };
+    REQUIRE( first.size() == 3 );
+    REQUIRE( firstListed == 4 );
+
+    const auto& [second, secondListed]{ crawl() };
+    REQUIRE( second == first );
+    REQUIRE( secondListed == 0 );
+
+    // A new file changes its directory's mtime; only that directory is listed again.
+    std::ofstream(root / "2020" / "20200102.nc");
+    fs::last_write_time(root / "2020", past + std::chrono::minutes(1));
+
+    const auto& [third, thirdListed]{ crawl() };
+    REQUIRE( third.size() == 4 );
+    REQUIRE( thirdListed == 1 );
+    REQUIRE( std::find(third.cbegin(), third.cend(), root / "2020" / "20200102.nc") != third.cend() );
+
+    fs::remove_all(root);
+    fs::remove(cachePath);
+}
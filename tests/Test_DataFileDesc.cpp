@@ -38,9 +38,16 @@ TEST_CASE( "4: DataFileDesc::operator bool is marked noexcept." ) {
 }
 
 /***********************************************************************************/
-TEST_CASE( "5: All DataFileDesc members are const-qualified." ) {
-    
-    REQUIRE( std::is_const_v<decltype(DataFileDesc::Timestamps)> );
-    REQUIRE( std::is_const_v<decltype(DataFileDesc::Variables)> );
-    REQUIRE( std::is_const_v<decltype(DataFileDesc::NCFilePath)> );
+TEST_CASE( "5: DataFileDesc members are moved, not copied." ) {
+    REQUIRE_FALSE( std::is_const_v<decltype(DataFileDesc::Timestamps)> );
+    REQUIRE_FALSE( std::is_const_v<decltype(DataFileDesc::Variables)> );
+    REQUIRE_FALSE( std::is_const_v<decltype(DataFileDesc::NCFilePath)> );
+    REQUIRE_FALSE( std::is_const_v<decltype(DataFileDesc::Coordinates)> );
+    REQUIRE( std::is_nothrow_move_constructible_v<DataFileDesc> );
+
+    DataFileDesc d1{ { 1, 2, 3 }, {}, "" };
+    const auto* timestamps{ d1.Timestamps.data() };
+    const DataFileDesc d2{ std::move(d1) };
+
+    REQUIRE( d2.Timestamps.data() == timestamps );
 }
\ No newline at end of file
@@ -0,0 +1,794 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Database.hpp"
+#include "../src/DatasetDesc.hpp"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace tsm;
+
+namespace {
+
+/***********************************************************************************/
+ds::DatasetDesc makeDataset(const std::size_t numFiles, const std::size_t timestampsPerFile, const std::size_t numVariables = 2) {
+    std::vector<ds::VariableDesc> variables{
+        { "votemper", "K", "Temperature", 0.0f, 0.0f, { "time", "depth" } },
+        { "vosaline", "PSU", "Salinity", 0.0f, 0.0f, { "time", "depth" } }
+    };
+    for (auto i{ variables.size() }; i < numVariables; ++i) {
+        variables.emplace_back("var" + std::to_string(i), "", "", 0.0f, 0.0f, std::vector<std::string>{ "time" });
+    }
+
+    std::vector<ds::DataFileDesc> files;
+    files.reserve(numFiles);
+    for (std::size_t i = 0; i < numFiles; ++i) {
+        std::vector<ds::timestamp_t> timestamps(timestampsPerFile);
+        for (std::size_t t = 0; t < timestampsPerFile; ++t) {
+            timestamps[t] = 2208816000ULL + (i * timestampsPerFile + t) * 3600ULL;
+        }
+        files.emplace_back(timestamps, variables, "/data/file_" + std::to_string(i) + ".nc");
+    }
+
+    return { std::move(files), ds::DATASET_TYPE::HISTORICAL };
+}
+
+/***********************************************************************************/
+std::string queryText(const fs::path& dbPath, const std::string& query) {
+    sqlite3* db{ nullptr };
+    sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+
+    sqlite3_stmt* stmt{ nullptr };
+    sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
+
+    std::string result;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        result = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    }
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+
+    return result;
+}
+
+/***********************************************************************************/
+/// Average latency (in microseconds) of running query once per bound timestamp.
+double averageQueryLatencyUs(const fs::path& dbPath, const std::string& query, const std::size_t numTimestamps) {
+    sqlite3* db{ nullptr };
+    sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+
+    sqlite3_stmt* stmt{ nullptr };
+    sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
+
+    const auto start{ std::chrono::steady_clock::now() };
+    for (std::size_t i = 0; i < numTimestamps; ++i) {
+        sqlite3_bind_int64(stmt, 1, 2208816000LL + ((i * 7919) % numTimestamps) * 3600LL);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {}
+        sqlite3_reset(stmt);
+    }
+    const std::chrono::duration<double, std::micro> elapsed{ std::chrono::steady_clock::now() - start };
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+
+    return elapsed.count() / numTimestamps;
+}
+
+/***********************************************************************************/
+void reportJoinTableLayout(const std::string& label, const bool clustered) {
+    const fs::path dbPath{ "./test_join_layout.sqlite3" };
+    fs::remove(dbPath);
+
+    const auto& dataset{ makeDataset(5000, 24, 4) };
+
+    DatabaseOptions options;
+    options.ClusteredJoinTable = clustered;
+
+    const auto start{ std::chrono::steady_clock::now() };
+    {
+        Database db{ "./", "test_join_layout", options };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(dataset) );
+    }
+    const std::chrono::duration<double> insertTime{ std::chrono::steady_clock::now() - start };
+
+    const auto& varAndTime{ averageQueryLatencyUs(dbPath,
+        "SELECT filepath FROM TimestampVariableFilepath tvf "
+        "INNER JOIN Filepaths fp ON tvf.filepath_id = fp.id "
+        "WHERE tvf.variable_id = (SELECT id FROM Variables WHERE variable = 'vosaline') "
+        "AND tvf.timestamp_id = (SELECT id FROM Timestamps WHERE timestamp = ?);", 5000 * 24) };
+
+    const auto& timeOnly{ averageQueryLatencyUs(dbPath,
+        "SELECT DISTINCT filepath FROM TimestampVariableFilepath tvf "
+        "INNER JOIN Filepaths fp ON tvf.filepath_id = fp.id "
+        "WHERE tvf.timestamp_id = (SELECT id FROM Timestamps WHERE timestamp = ?);", 5000 * 24) };
+
+    std::cout << label << ": " << fs::file_size(dbPath) / 1024 << " KiB, insert " << insertTime.count() << " s"
+              << ", variable+timestamp query " << varAndTime << " us"
+              << ", timestamp query " << timeOnly << " us" << std::endl;
+
+    fs::remove(dbPath);
+}
+
+/***********************************************************************************/
+struct ReaderStats {
+    std::vector<double> LatenciesMs;
+    std::size_t BusyErrors{ 0 };
+};
+
+/***********************************************************************************/
+/// Runs "files for timestamp" lookups against dbPath until done is set.
+ReaderStats runReaderLoop(const fs::path& dbPath, const std::atomic_bool& done, const unsigned int seed) {
+    ReaderStats stats;
+
+    sqlite3* db{ nullptr };
+    while (!done && sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        sqlite3_close(db);
+        db = nullptr;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sqlite3_busy_timeout(db, 5000);
+
+    const auto query{
+        "SELECT filepath FROM TimestampVariableFilepath tvf "
+        "INNER JOIN Filepaths fp ON tvf.filepath_id = fp.id "
+        "WHERE tvf.timestamp_id = (SELECT id FROM Timestamps WHERE timestamp = ?);"
+    };
+
+    auto ts{ seed };
+    while (!done) {
+        const auto start{ std::chrono::steady_clock::now() };
+
+        sqlite3_stmt* stmt{ nullptr };
+        auto res{ sqlite3_prepare_v2(db, query, -1, &stmt, nullptr) };
+        if (res == SQLITE_OK) {
+            ts = ts * 1103515245u + 12345u;
+            sqlite3_bind_int64(stmt, 1, 2208816000LL + (ts % 48000) * 3600LL);
+            while ((res = sqlite3_step(stmt)) == SQLITE_ROW) {}
+        }
+        sqlite3_finalize(stmt);
+
+        const std::chrono::duration<double, std::milli> elapsed{ std::chrono::steady_clock::now() - start };
+        if (res == SQLITE_DONE) {
+            stats.LatenciesMs.push_back(elapsed.count());
+        }
+        else if (res == SQLITE_BUSY || res == SQLITE_LOCKED) {
+            ++stats.BusyErrors;
+        }
+        else {
+            // Schema isn't there yet.
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    sqlite3_close(db);
+
+    return stats;
+}
+
+/***********************************************************************************/
+void reportReaderLatency(const std::string& label, const bool wal) {
+    const fs::path dbPath{ "./test_concurrent_readers.sqlite3" };
+    fs::remove(dbPath);
+    fs::remove("./test_concurrent_readers.sqlite3-wal");
+    fs::remove("./test_concurrent_readers.sqlite3-shm");
+
+    const auto& dataset{ makeDataset(2000, 24) };
+
+    std::atomic_bool done{ false };
+    std::vector<ReaderStats> stats(4);
+    std::vector<std::thread> readers;
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+        readers.emplace_back([&, i] { stats[i] = runReaderLoop(dbPath, done, static_cast<unsigned int>(i)); });
+    }
+
+    {
+        Database db{ "./", "test_concurrent_readers", { wal, wal ? 5000u : 0u } };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(dataset) );
+    }
+    done = true;
+
+    std::vector<double> latencies;
+    std::size_t busy{ 0 };
+    for (std::size_t i = 0; i < readers.size(); ++i) {
+        readers[i].join();
+        latencies.insert(latencies.end(), stats[i].LatenciesMs.cbegin(), stats[i].LatenciesMs.cend());
+        busy += stats[i].BusyErrors;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    const auto percentile = [&](const double p) {
+        return latencies.empty() ? 0.0 : latencies[static_cast<std::size_t>(p * (latencies.size() - 1))];
+    };
+
+    std::cout << label << ": " << latencies.size() << " reads, " << busy << " busy/locked"
+              << ", p50 " << percentile(0.50) << " ms"
+              << ", p99 " << percentile(0.99) << " ms"
+              << ", max " << percentile(1.0) << " ms" << std::endl;
+
+    fs::remove(dbPath);
+    fs::remove("./test_concurrent_readers.sqlite3-wal");
+    fs::remove("./test_concurrent_readers.sqlite3-shm");
+}
+
+} // namespace
+
+/***********************************************************************************/
+TEST_CASE("1: Database in WAL mode inserts every row across bounded transactions.") {
+    const fs::path dbPath{ "./test_wal.sqlite3" };
+    fs::remove(dbPath);
+
+    {
+        Database db{ "./", "test_wal", { true, 100 } };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(makeDataset(50, 12)) );
+    }
+
+    REQUIRE( queryText(dbPath, "PRAGMA journal_mode;") == "wal" );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM TimestampVariableFilepath;") == "1200" );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM Timestamps;") == "600" );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM Filepaths;") == "50" );
+
+    // The final truncating checkpoint leaves nothing behind in the log.
+    REQUIRE( (!fs::exists("./test_wal.sqlite3-wal") || fs::file_size("./test_wal.sqlite3-wal") == 0) );
+
+    fs::remove(dbPath);
+    fs::remove("./test_wal.sqlite3-wal");
+    fs::remove("./test_wal.sqlite3-shm");
+}
+
+/***********************************************************************************/
+// Local harness, run with: ./build/tests "[benchmark]"
+TEST_CASE("2: Reader latency while indexing.", "[.][benchmark]") {
+    reportReaderLatency("exclusive", false);
+    reportReaderLatency("wal", true);
+}
+
+/***********************************************************************************/
+TEST_CASE("3: In-memory build is published over the output file and keeps existing rows.") {
+    const fs::path dbPath{ "./test_in_memory.sqlite3" };
+    fs::remove(dbPath);
+
+    DatabaseOptions options;
+    options.InMemory = true;
+
+    {
+        Database db{ "./", "test_in_memory", options };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(makeDataset(10, 4)) );
+    }
+    // Empty leftovers of the old database's WAL go.
+    std::ofstream{ "./test_in_memory.sqlite3-wal" };
+    std::ofstream{ "./test_in_memory.sqlite3-shm" };
+    {
+        Database db{ "./", "test_in_memory", options };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(makeDataset(20, 4)) );
+    }
+
+    REQUIRE_FALSE( fs::exists("./test_in_memory.sqlite3.tmp") );
+    REQUIRE_FALSE( fs::exists("./test_in_memory.sqlite3-wal") );
+    REQUIRE_FALSE( fs::exists("./test_in_memory.sqlite3-shm") );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM Filepaths;") == "20" );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM TimestampVariableFilepath;") == "160" );
+    REQUIRE( queryText(dbPath, "PRAGMA integrity_check;") == "ok" );
+
+    fs::remove(dbPath);
+}
+
+/***********************************************************************************/
+TEST_CASE("4: In-memory build falls back to disk when over the memory budget.") {
+    const fs::path dbPath{ "./test_over_budget.sqlite3" };
+    fs::remove(dbPath);
+
+    DatabaseOptions options;
+    options.InMemory = true;
+    options.MemoryBudgetMB = 0;
+
+    {
+        Database db{ "./", "test_over_budget", options };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(makeDataset(20000, 1)) );
+    }
+
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM Filepaths;") == "20000" );
+
+    fs::remove(dbPath);
+}
+
+/***********************************************************************************/
+TEST_CASE("5: Clustered join table is created WITHOUT ROWID with a single secondary index.") {
+    const fs::path dbPath{ "./test_clustered.sqlite3" };
+    fs::remove(dbPath);
+
+    DatabaseOptions options;
+    options.ClusteredJoinTable = true;
+
+    {
+        Database db{ "./", "test_clustered", options };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(makeDataset(10, 4)) );
+    }
+
+    REQUIRE( queryText(dbPath, "SELECT sql FROM sqlite_master WHERE name = 'TimestampVariableFilepath';").find("WITHOUT ROWID") != std::string::npos );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND tbl_name = 'TimestampVariableFilepath' AND sql IS NOT NULL;") == "1" );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM TimestampVariableFilepath;") == "80" );
+
+    fs::remove(dbPath);
+}
+
+/***********************************************************************************/
+TEST_CASE("6: Existing rowid join table is migrated to the clustered layout.") {
+    const fs::path dbPath{ "./test_migrate.sqlite3" };
+    fs::remove(dbPath);
+
+    {
+        Database db{ "./", "test_migrate" };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(makeDataset(10, 4)) );
+    }
+    REQUIRE( queryText(dbPath, "SELECT sql FROM sqlite_master WHERE name = 'TimestampVariableFilepath';").find("WITHOUT ROWID") == std::string::npos );
+
+    DatabaseOptions options;
+    options.ClusteredJoinTable = true;
+    {
+        Database db{ "./", "test_migrate", options };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(makeDataset(20, 4)) );
+    }
+
+    REQUIRE( queryText(dbPath, "SELECT sql FROM sqlite_master WHERE name = 'TimestampVariableFilepath';").find("WITHOUT ROWID") != std::string::npos );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND tbl_name = 'TimestampVariableFilepath' AND sql IS NOT NULL;") == "1" );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM TimestampVariableFilepath;") == "160" );
+    REQUIRE( queryText(dbPath, "PRAGMA foreign_key_check;").empty() );
+
+    // Reopening without the option keeps the clustered layout.
+    {
+        Database db{ "./", "test_migrate" };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(makeDataset(21, 4)) );
+    }
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND tbl_name = 'TimestampVariableFilepath' AND sql IS NOT NULL;") == "1" );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM TimestampVariableFilepath;") == "168" );
+
+    fs::remove(dbPath);
+}
+
+/***********************************************************************************/
+TEST_CASE("7: Sorted bulk load stores the same rows as the file-at-a-time load.") {
+    const auto contents = [](const fs::path& dbPath) {
+        return queryText(dbPath, "SELECT group_concat(row, ';') FROM ("
+                                 "SELECT fp.filepath || ',' || v.variable || ',' || t.timestamp AS row "
+                                 "FROM TimestampVariableFilepath tvf "
+                                 "INNER JOIN Filepaths fp ON tvf.filepath_id = fp.id "
+                                 "INNER JOIN Variables v ON tvf.variable_id = v.id "
+                                 "INNER JOIN Timestamps t ON tvf.timestamp_id = t.id "
+                                 "ORDER BY row);");
+    };
+
+    for (const auto clustered : { false, true }) {
+        fs::remove("./test_by_file.sqlite3");
+        fs::remove("./test_sorted.sqlite3");
+
+        DatabaseOptions byFile;
+        byFile.WAL = true;
+        byFile.ClusteredJoinTable = clustered;
+
+        DatabaseOptions sorted;
+        sorted.ClusteredJoinTable = clustered;
+
+        for (const auto numFiles : { 30, 45 }) {
+            {
+                Database db{ "./", "test_by_file", byFile };
+                REQUIRE( db.open() );
+                REQUIRE( db.insertData(makeDataset(numFiles, 6, 3)) );
+            }
+            {
+                Database db{ "./", "test_sorted", sorted };
+                REQUIRE( db.open() );
+                REQUIRE( db.insertData(makeDataset(numFiles, 6, 3)) );
+            }
+        }
+
+        const auto& expected{ contents("./test_by_file.sqlite3") };
+        REQUIRE_FALSE( expected.empty() );
+        REQUIRE( contents("./test_sorted.sqlite3") == expected );
+        REQUIRE( queryText("./test_sorted.sqlite3", "SELECT COUNT(*) FROM TimestampVariableFilepath;") == "810" );
+    }
+
+    fs::remove("./test_by_file.sqlite3");
+    fs::remove("./test_by_file.sqlite3-wal");
+    fs::remove("./test_by_file.sqlite3-shm");
+    fs::remove("./test_sorted.sqlite3");
+}
+
+/***********************************************************************************/
+TEST_CASE("8: Join table layout size, insert time and query latency.", "[.][benchmark]") {
+    reportJoinTableLayout("rowid", false);
+    reportJoinTableLayout("clustered", true);
+}
+
+/***********************************************************************************/
+TEST_CASE("9: Files that keep failing are quarantined until they change.") {
+    const fs::path dbPath{ "./test_quarantine.sqlite3" };
+    const fs::path dataDir{ "./test_quarantine_data" };
+    fs::remove(dbPath);
+    fs::remove_all(dataDir);
+    fs::create_directory(dataDir);
+
+    // Not netCDF, so every read fails.
+    const std::vector<fs::path> files{ dataDir / "broken_a.nc", dataDir / "broken_b.nc" };
+    for (const auto& file : files) {
+        std::ofstream(file) << "not a netcdf file";
+    }
+
+    Database db{ "./", "test_quarantine" };
+    REQUIRE( db.open() );
+
+    for (auto run = 0; run < 3; ++run) {
+        REQUIRE( db.selectQuarantinedFiles().empty() );
+
+        const ds::DatasetDesc datasetDesc{ files, ds::DATASET_TYPE::HISTORICAL, false };
+        REQUIRE( datasetDesc.failedFiles().size() == 2 );
+        db.updateQuarantine(datasetDesc);
+    }
+    REQUIRE( db.selectQuarantinedFiles().size() == 2 );
+
+    // A rewritten file is read again; its count starts over.
+    fs::last_write_time(files[0], fs::last_write_time(files[0]) + std::chrono::hours(1));
+    REQUIRE( db.selectQuarantinedFiles() == std::unordered_set<std::string>{ files[1].string() } );
+
+    // Reading a quarantined file successfully releases it.
+    std::vector<ds::DataFileDesc> readFiles;
+    readFiles.emplace_back(std::vector<ds::timestamp_t>{ 2208816000ULL }, std::vector<ds::VariableDesc>{ { "votemper", "K", "Temperature", 0.0f, 0.0f, { "time" } } }, files[1]);
+    db.updateQuarantine(ds::DatasetDesc{ std::move(readFiles), ds::DATASET_TYPE::HISTORICAL });
+    REQUIRE( db.selectQuarantinedFiles().empty() );
+
+    fs::remove(dbPath);
+    fs::remove_all(dataDir);
+}
+
+/***********************************************************************************/
+TEST_CASE("10: VariableCoverage follows batches, gaps and existing databases.") {
+    const fs::path dbPath{ "./test_coverage.sqlite3" };
+    fs::remove(dbPath);
+
+    const auto insertFile = [](Database& db, const std::vector<ds::timestamp_t>& timestamps, const std::string& path) {
+        std::vector<ds::DataFileDesc> files;
+        files.emplace_back(timestamps, std::vector<ds::VariableDesc>{ { "votemper", "K", "Temperature", 0.0f, 0.0f, { "time" } } }, path);
+        REQUIRE( db.insertData(ds::DatasetDesc{ std::move(files), ds::DATASET_TYPE::HISTORICAL }) );
+    };
+
+    {
+        Database db{ "./", "test_coverage" };
+        REQUIRE( db.open() );
+        REQUIRE_FALSE( db.selectCoverage("votemper") );
+
+        insertFile(db, { 3600, 7200 }, "/data/a.nc");
+        auto coverage{ db.selectCoverage("votemper") };
+        REQUIRE( coverage );
+        REQUIRE( coverage->Min == 3600 );
+        REQUIRE( coverage->Max == 7200 );
+        REQUIRE( coverage->Count == 2 );
+        REQUIRE( coverage->Step == 3600 );
+
+        // Already indexed timestamps from another file don't count twice; a gap makes it irregular.
+        insertFile(db, { 7200, 14400 }, "/data/b.nc");
+        coverage = db.selectCoverage("votemper");
+        REQUIRE( coverage->Count == 3 );
+        REQUIRE_FALSE( coverage->Step );
+        REQUIRE( db.selectTimestamps("votemper") == std::vector<std::int64_t>{ 3600, 7200, 14400 } );
+
+        // Filling the gap makes it regular again.
+        insertFile(db, { 10800 }, "/data/c.nc");
+        coverage = db.selectCoverage("votemper");
+        REQUIRE( coverage->Min == 3600 );
+        REQUIRE( coverage->Max == 14400 );
+        REQUIRE( coverage->Count == 4 );
+        REQUIRE( coverage->Step == 3600 );
+        REQUIRE( db.selectTimestamps("votemper") == std::vector<std::int64_t>{ 3600, 7200, 10800, 14400 } );
+    }
+
+    // A database from before the table existed gets it built on the next insert.
+    const auto expected{ queryText(dbPath, "SELECT min_timestamp || ',' || max_timestamp || ',' || timestamp_count || ',' || step FROM VariableCoverage;") };
+    {
+        sqlite3* raw{ nullptr };
+        sqlite3_open_v2(dbPath.c_str(), &raw, SQLITE_OPEN_READWRITE, nullptr);
+        sqlite3_exec(raw, "DROP TABLE VariableCoverage;", nullptr, nullptr, nullptr);
+        sqlite3_close(raw);
+    }
+    {
+        Database db{ "./", "test_coverage" };
+        REQUIRE( db.open() );
+        insertFile(db, { 14400 }, "/data/d.nc");
+    }
+    REQUIRE( queryText(dbPath, "SELECT min_timestamp || ',' || max_timestamp || ',' || timestamp_count || ',' || step FROM VariableCoverage;") == expected );
+
+    fs::remove(dbPath);
+}
+
+/***********************************************************************************/
+TEST_CASE("11: Files are looked up by region through the FileExtents R*Tree.") {
+    const fs::path dbPath{ "./test_extents.sqlite3" };
+    fs::remove(dbPath);
+
+    const std::vector<ds::VariableDesc> variables{ { "votemper", "K", "Temperature", 0.0f, 0.0f, { "time" } } };
+    std::vector<ds::DataFileDesc> files;
+    files.emplace_back(std::vector<ds::timestamp_t>{ 3600 }, variables, "/data/atlantic.nc", ds::BoundingBox{ 40.0, 60.0, -70.0, -40.0 });
+    files.emplace_back(std::vector<ds::timestamp_t>{ 3600 }, variables, "/data/pacific.nc", ds::BoundingBox{ 45.0, 55.0, -150.0, -125.0 });
+    files.emplace_back(std::vector<ds::timestamp_t>{ 3600 }, variables, "/data/no_coords.nc");
+
+    Database db{ "./", "test_extents" };
+    REQUIRE( db.open() );
+    REQUIRE_FALSE( db.selectFilepaths("votemper", 3600, ds::BoundingBox{ -90.0, 90.0, -180.0, 180.0 }) );
+
+    REQUIRE( db.insertData(ds::DatasetDesc{ std::move(files), ds::DATASET_TYPE::HISTORICAL }) );
+
+    REQUIRE( db.selectFilepaths("votemper", 3600, ds::BoundingBox{ 44.0, 46.0, -64.0, -62.0 }) == std::vector<std::string>{ "/data/atlantic.nc" } );
+    REQUIRE( db.selectFilepaths("votemper", 3600, ds::BoundingBox{ 50.0, 50.0, -180.0, 180.0 }) == std::vector<std::string>{ "/data/atlantic.nc", "/data/pacific.nc" } );
+    REQUIRE( db.selectFilepaths("votemper", 3600, ds::BoundingBox{ -10.0, 10.0, -180.0, 180.0 })->empty() );
+    REQUIRE( db.selectFilepaths("votemper", 7200, ds::BoundingBox{ 44.0, 46.0, -64.0, -62.0 })->empty() );
+
+    fs::remove(dbPath);
+}
+
+/***********************************************************************************/
+TEST_CASE("12: Dimension sizes are kept per file and shared coordinate arrays once.") {
+    const fs::path dbPath{ "./test_coordinates.sqlite3" };
+    fs::remove(dbPath);
+
+    const std::vector<ds::VariableDesc> variables{ { "votemper", "K", "Temperature", 0.0f, 0.0f, { "time", "depth" } } };
+    const auto depths{ std::make_shared<const std::vector<double>>(std::vector<double>{ 0.5, 1.5, 2.6 }) };
+    const auto otherDepths{ std::make_shared<const std::vector<double>>(std::vector<double>{ 0.5, 10.0 }) };
+    // Same hash as depths, different values.
+    const auto collidingDepths{ std::make_shared<const std::vector<double>>(std::vector<double>{ 0.5, 1.5, 2.7 }) };
+
+    std::vector<ds::DataFileDesc> files;
+    for (auto i = 0; i < 3; ++i) {
+        files.emplace_back(std::vector<ds::timestamp_t>{ 3600 }, variables, "/data/file_" + std::to_string(i) + ".nc", std::nullopt,
+                           std::vector<ds::DimensionDesc>{ { "depth", 3 }, { "time", 1 } },
+                           std::vector<ds::CoordinateDesc>{ { "depth", { "depth" }, 1, depths } });
+    }
+    files.emplace_back(std::vector<ds::timestamp_t>{ 3600 }, variables, "/data/other.nc", std::nullopt,
+                       std::vector<ds::DimensionDesc>{ { "depth", 2 }, { "time", 1 } },
+                       std::vector<ds::CoordinateDesc>{ { "depth", { "depth" }, 2, otherDepths } });
+    files.emplace_back(std::vector<ds::timestamp_t>{ 3600 }, variables, "/data/colliding.nc", std::nullopt,
+                       std::vector<ds::DimensionDesc>{ { "depth", 3 }, { "time", 1 } },
+                       std::vector<ds::CoordinateDesc>{ { "depth", { "depth" }, 1, collidingDepths } });
+
+    {
+        Database db{ "./", "test_coordinates" };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(ds::DatasetDesc{ std::move(files), ds::DATASET_TYPE::HISTORICAL }) );
+    }
+
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM CoordinateArrays;") == "3" );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM FileCoordinates;") == "5" );
+
+    // A later run finds the arrays stored by this one.
+    {
+        std::vector<ds::DataFileDesc> moreFiles;
+        moreFiles.emplace_back(std::vector<ds::timestamp_t>{ 7200 }, variables, "/data/file_3.nc", std::nullopt,
+                               std::vector<ds::DimensionDesc>{ { "depth", 3 }, { "time", 1 } },
+                               std::vector<ds::CoordinateDesc>{ { "depth", { "depth" }, 1, std::make_shared<const std::vector<double>>(*collidingDepths) } });
+
+        Database db{ "./", "test_coordinates" };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(ds::DatasetDesc{ std::move(moreFiles), ds::DATASET_TYPE::HISTORICAL }) );
+    }
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM CoordinateArrays;") == "3" );
+
+    DatabaseOptions options;
+    options.ReadOnly = true;
+    Database db{ "./", "test_coordinates", options };
+    REQUIRE( db.open() );
+
+    const auto dimensions{ db.selectDimensionSizes("/data/other.nc") };
+    REQUIRE( dimensions );
+    REQUIRE( dimensions->size() == 2 );
+    REQUIRE( dimensions->front().Name == "depth" );
+    REQUIRE( dimensions->front().Size == 2 );
+
+    REQUIRE( db.selectCoordinateValues("/data/file_1.nc", "depth") == *depths );
+    REQUIRE( db.selectCoordinateValues("/data/other.nc", "depth") == *otherDepths );
+    REQUIRE( db.selectCoordinateValues("/data/colliding.nc", "depth") == *collidingDepths );
+    REQUIRE( db.selectCoordinateValues("/data/file_3.nc", "depth") == *collidingDepths );
+    REQUIRE_FALSE( db.selectCoordinateValues("/data/other.nc", "latitude") );
+
+    fs::remove(dbPath);
+}
+
+/***********************************************************************************/
+TEST_CASE("13: Storage layouts are stored once per schema.") {
+    const fs::path dbPath{ "./test_layouts.sqlite3" };
+    fs::remove(dbPath);
+
+    const ds::StorageLayout chunked{ "chunked", { 1, 50, 400, 300 }, 4, true, 1e20 };
+    const ds::StorageLayout contiguous{ "contiguous", {}, 0, false, std::nullopt };
+    const std::vector<ds::VariableDesc> variables{ { "votemper", "K", "Temperature", 0.0f, 0.0f, { "time", "depth", "y", "x" }, chunked },
+                                                   { "nav_lat", "degrees_north", "Latitude", 0.0f, 0.0f, { "y", "x" }, contiguous } };
+    const std::vector<ds::VariableDesc> otherVariables{ { "votemper", "K", "Temperature", 0.0f, 0.0f, { "time", "depth", "y", "x" }, contiguous } };
+
+    std::vector<ds::DataFileDesc> files;
+    for (ds::timestamp_t i = 0; i < 3; ++i) {
+        files.emplace_back(std::vector<ds::timestamp_t>{ 3600 * i }, variables, "/data/file_" + std::to_string(i) + ".nc",
+                           std::nullopt, std::vector<ds::DimensionDesc>{}, std::vector<ds::CoordinateDesc>{}, "netCDF-4");
+    }
+    files.emplace_back(std::vector<ds::timestamp_t>{ 3600 }, otherVariables, "/data/other.nc",
+                       std::nullopt, std::vector<ds::DimensionDesc>{}, std::vector<ds::CoordinateDesc>{}, "classic");
+
+    {
+        Database db{ "./", "test_layouts" };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(ds::DatasetDesc{ std::move(files), ds::DATASET_TYPE::HISTORICAL }) );
+    }
+
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM Schemas;") == "2" );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM SchemaLayouts;") == "3" );
+    REQUIRE( queryText(dbPath, "SELECT COUNT(*) FROM FileSchemas;") == "4" );
+
+    DatabaseOptions options;
+    options.ReadOnly = true;
+    Database db{ "./", "test_layouts", options };
+    REQUIRE( db.open() );
+
+    const auto layout{ db.selectStorageLayout("/data/file_2.nc", "votemper") };
+    REQUIRE( layout );
+    REQUIRE( layout->Storage == "chunked" );
+    REQUIRE( layout->ChunkSizes == chunked.ChunkSizes );
+    REQUIRE( layout->DeflateLevel == 4 );
+    REQUIRE( layout->Shuffle );
+    REQUIRE( layout->FillValue == 1e20 );
+
+    const auto otherLayout{ db.selectStorageLayout("/data/other.nc", "votemper") };
+    REQUIRE( otherLayout );
+    REQUIRE( otherLayout->Storage == "contiguous" );
+    REQUIRE( otherLayout->ChunkSizes.empty() );
+    REQUIRE_FALSE( otherLayout->FillValue );
+
+    REQUIRE_FALSE( db.selectStorageLayout("/data/other.nc", "nav_lat") );
+
+    fs::remove(dbPath);
+}
+
+/***********************************************************************************/
+TEST_CASE("14: Renamed files keep their rows and duplicate paths are skipped.") {
+    const fs::path dbPath{ "./test_fingerprints.sqlite3" };
+    const fs::path dataDir{ "./test_fingerprints" };
+    fs::remove(dbPath);
+    fs::remove_all(dataDir);
+    fs::create_directory(dataDir);
+
+    const auto writeFile = [](const fs::path& path, const std::string& contents) {
+        std::ofstream f(path, std::ios::binary);
+        f << contents;
+    };
+    writeFile(dataDir / "a.nc", "CDF\x01 file a");
+    writeFile(dataDir / "b.nc", "CDF\x01 file b");
+
+    const std::vector<ds::VariableDesc> variables{ { "votemper", "K", "Temperature", 0.0f, 0.0f, { "time" } } };
+    std::vector<ds::DataFileDesc> files;
+    files.emplace_back(std::vector<ds::timestamp_t>{ 3600 }, variables, dataDir / "a.nc");
+    files.emplace_back(std::vector<ds::timestamp_t>{ 7200 }, variables, dataDir / "b.nc");
+
+    DatabaseOptions options;
+    options.Fingerprints = true;
+
+    Database db{ "./", "test_fingerprints", options };
+    REQUIRE( db.open() );
+    REQUIRE( db.insertData(ds::DatasetDesc{ std::move(files), ds::DATASET_TYPE::HISTORICAL }) );
+
+    fs::rename(dataDir / "a.nc", dataDir / "renamed.nc");
+    fs::create_hard_link(dataDir / "b.nc", dataDir / "b_link.nc");
+    writeFile(dataDir / "new.nc", "CDF\x01 file new");
+
+    std::vector<fs::path> paths{ dataDir / "b.nc", dataDir / "b_link.nc", dataDir / "new.nc", dataDir / "renamed.nc", dataDir / "new.nc" };
+    const auto matches{ db.applyFingerprints(paths) };
+    REQUIRE( matches.Renamed == 1 );
+    REQUIRE( matches.Duplicates == 2 );
+    REQUIRE( paths == std::vector<fs::path>{ dataDir / "b.nc", dataDir / "new.nc" } );
+
+    REQUIRE( db.selectFilepaths("votemper", 3600) == std::vector<std::string>{ (dataDir / "renamed.nc").string() } );
+    REQUIRE( db.selectFilepaths("votemper", 7200) == std::vector<std::string>{ (dataDir / "b.nc").string() } );
+
+    fs::remove(dbPath);
+    fs::remove_all(dataDir);
+}
+
+/***********************************************************************************/
+TEST_CASE("15: Nothing is added to a database whose timestamps are in another format.") {
+    const fs::path dbPath{ "./test_timestamp_format.sqlite3" };
+    fs::remove(dbPath);
+
+    {
+        Database db{ "./", "test_timestamp_format" };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(makeDataset(10, 4)) );
+    }
+    REQUIRE( queryText(dbPath, "PRAGMA user_version;") == std::to_string(TIMESTAMP_FORMAT_VERSION) );
+
+    // As left by a version that stored the raw time values.
+    const auto setVersion = [&dbPath](const int version) {
+        sqlite3* raw{ nullptr };
+        sqlite3_open_v2(dbPath.c_str(), &raw, SQLITE_OPEN_READWRITE, nullptr);
+        sqlite3_exec(raw, ("PRAGMA user_version = " + std::to_string(version) + ';').c_str(), nullptr, nullptr, nullptr);
+        sqlite3_close(raw);
+    };
+    setVersion(0);
+    {
+        Database db{ "./", "test_timestamp_format" };
+        REQUIRE_FALSE( db.open() );
+    }
+    {
+        DatabaseOptions options;
+        options.ReadOnly = true;
+        Database db{ "./", "test_timestamp_format", options };
+        REQUIRE( db.open() );
+        REQUIRE( db.selectVariables() );
+    }
+
+    setVersion(TIMESTAMP_FORMAT_VERSION);
+    {
+        Database db{ "./", "test_timestamp_format" };
+        REQUIRE( db.open() );
+    }
+
+    // Copied over by the in-memory build.
+    fs::remove(dbPath);
+    DatabaseOptions options;
+    options.InMemory = true;
+    {
+        Database db{ "./", "test_timestamp_format", options };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(makeDataset(10, 4)) );
+    }
+    REQUIRE( queryText(dbPath, "PRAGMA user_version;") == std::to_string(TIMESTAMP_FORMAT_VERSION) );
+
+    fs::remove(dbPath);
+}
+
+/***********************************************************************************/
+TEST_CASE("16: The database isn't locked while files are being read.") {
+    const fs::path dbPath{ "./test_read_phase_lock.sqlite3" };
+    fs::remove(dbPath);
+
+    const auto canWrite = [&dbPath] {
+        sqlite3* other{ nullptr };
+        sqlite3_open_v2(dbPath.c_str(), &other, SQLITE_OPEN_READWRITE, nullptr);
+        const auto rc{ sqlite3_exec(other, "BEGIN IMMEDIATE; COMMIT;", nullptr, nullptr, nullptr) };
+        sqlite3_close(other);
+        return rc == SQLITE_OK;
+    };
+
+    DatabaseOptions options;
+    options.Fingerprints = true;
+    {
+        Database db{ "./", "test_read_phase_lock", options };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(makeDataset(10, 4)) );
+    }
+
+    Database db{ "./", "test_read_phase_lock", options };
+    REQUIRE( db.open() );
+
+    // What insertFiles writes before reading.
+    REQUIRE( db.selectQuarantinedFiles().empty() );
+    std::vector<fs::path> paths{ "./no_such_file.nc" };
+    REQUIRE( db.applyFingerprints(paths).Renamed == 0 );
+    REQUIRE( canWrite() );
+
+    REQUIRE( db.insertData(makeDataset(10, 4)) );
+    REQUIRE_FALSE( canWrite() );
+
+    db.closeConnection();
+    REQUIRE( canWrite() );
+
+    fs::remove(dbPath);
+}
@@ -0,0 +1,65 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Utils/FileOrder.hpp"
+
+#include <chrono>
+#include <fstream>
+
+using namespace tsm::utils;
+
+/***********************************************************************************/
+TEST_CASE("1: parseFileOrder accepts the three orders and an empty name.") {
+    REQUIRE( parseFileOrder("") == FILE_ORDER::AS_FOUND );
+    REQUIRE( parseFileOrder("newest-first") == FILE_ORDER::NEWEST_FIRST );
+    REQUIRE( parseFileOrder("oldest-first") == FILE_ORDER::OLDEST_FIRST );
+    REQUIRE( parseFileOrder("path") == FILE_ORDER::PATH );
+    REQUIRE_FALSE( parseFileOrder("newest") );
+}
+
+/***********************************************************************************/
+TEST_CASE("2: timestampFromFileName finds the date in common file names.") {
+    REQUIRE( timestampFromFileName("ORCA025-CMC-ANAL_1d_grid_T_2019010100.nc") == 1546300800 );
+    REQUIRE( timestampFromFileName("giops_20190101.nc") == 1546300800 );
+    REQUIRE( timestampFromFileName("wind_2019-01-01.nc") == 1546300800 );
+    REQUIRE( timestampFromFileName("CMC_hrdps_20190101123000_P001.nc") == 1546345800 );
+
+    // Not dates.
+    REQUIRE_FALSE( timestampFromFileName("run_12345678.nc") );
+    REQUIRE_FALSE( timestampFromFileName("grid_025.nc") );
+    REQUIRE_FALSE( timestampFromFileName("201901011.nc") );
+}
+
+/***********************************************************************************/
+TEST_CASE("3: orderFiles sorts by file name date, then mtime, then path.") {
+    const auto dir{ fs::temp_directory_path() / "tsm_file_order" };
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    const auto touch = [&dir](const std::string& name, const std::chrono::hours age) {
+        const auto path{ dir / name };
+        std::ofstream{ path } << name;
+        fs::last_write_time(path, fs::file_time_type::clock::now() - age);
+        return path;
+    };
+
+    // Dated names are far older than any mtime here.
+    const auto dated{ touch("a_20190101.nc", std::chrono::hours(0)) };
+    const auto old{ touch("b.nc", std::chrono::hours(48)) };
+    const auto recent{ touch("c.nc", std::chrono::hours(1)) };
+
+    std::vector<fs::path> paths{ old, dated, recent };
+
+    orderFiles(paths, FILE_ORDER::NEWEST_FIRST);
+    REQUIRE( paths == std::vector<fs::path>{ recent, old, dated } );
+
+    orderFiles(paths, FILE_ORDER::OLDEST_FIRST);
+    REQUIRE( paths == std::vector<fs::path>{ dated, old, recent } );
+
+    orderFiles(paths, FILE_ORDER::PATH);
+    REQUIRE( paths == std::vector<fs::path>{ dated, old, recent } );
+
+    paths = { recent, dated };
+    orderFiles(paths, FILE_ORDER::AS_FOUND);
+    REQUIRE( paths == std::vector<fs::path>{ recent, dated } );
+
+    fs::remove_all(dir);
+}
@@ -6,3 +6,12 @@ using namespace tsm::utils;
 TEST_CASE("1. Hash macro computes correct hash.") {
     REQUIRE(HASH_STR_CRC32("my_string") == 47936178);
 }
+
+TEST_CASE("2. hashValues tells arrays apart by content and shape.") {
+    const std::vector<double> depths{ 0.5, 1.5, 2.6, 3.8 };
+
+    REQUIRE( hashValues(depths) == hashValues(std::vector<double>{ 0.5, 1.5, 2.6, 3.8 }) );
+    REQUIRE( hashValues(depths) != hashValues(std::vector<double>{ 0.5, 1.5, 2.6, 3.9 }) );
+    REQUIRE( hashValues(depths) != hashValues(std::vector<double>{ 1.5, 0.5, 2.6, 3.8 }) );
+    REQUIRE( hashValues(depths, hashValues(std::vector<std::size_t>{ 2, 2 })) != hashValues(depths, hashValues(std::vector<std::size_t>{ 4, 1 })) );
+}
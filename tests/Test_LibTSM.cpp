@@ -0,0 +1,133 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/libtsm.h"
+#include "../src/Database.hpp"
+#include "../src/DatasetDesc.hpp"
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    void createDatabase(const std::string& datasetName) {
+        const std::vector<tsm::ds::VariableDesc> variables{ { "vosaline", "PSU", "Salinity", 0.0f, 0.0f, { "time" } },
+                                        { "votemper", "K", "Temperature", 0.0f, 0.0f, { "time" } } };
+
+        std::vector<tsm::ds::DataFileDesc> files;
+        files.emplace_back(std::vector<tsm::ds::timestamp_t>{ 100, 200 }, variables, "/data/b.nc");
+        files.emplace_back(std::vector<tsm::ds::timestamp_t>{ 200, 300 }, variables, "/data/a.nc");
+
+        tsm::Database db{ "./", datasetName };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(tsm::ds::DatasetDesc{ std::move(files), tsm::ds::DATASET_TYPE::HISTORICAL }) );
+    }
+
+    std::vector<std::string> strings(const tsm_result& result) {
+        std::vector<std::string> values;
+        for (std::size_t i = 0; i < result.count; ++i) {
+            values.emplace_back(result.strings + result.offsets[i], result.offsets[i + 1] - result.offsets[i] - 1);
+        }
+
+        return values;
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("1: C API looks up files, timestamps and variables.") {
+    fs::remove("./test_libtsm.sqlite3");
+    createDatabase("test_libtsm");
+
+    REQUIRE( tsm_api_version() == TSM_API_VERSION );
+
+    tsm_db* db{ nullptr };
+    REQUIRE( tsm_open("./", "test_libtsm", &db) == TSM_OK );
+
+    tsm_result result{};
+    REQUIRE( tsm_find_files(db, "votemper", 200, &result) == TSM_OK );
+    REQUIRE( strings(result) == std::vector<std::string>{ "/data/a.nc", "/data/b.nc" } );
+    tsm_result_free(&result);
+    REQUIRE( result.internal == nullptr );
+
+    REQUIRE( tsm_timestamps(db, "vosaline", &result) == TSM_OK );
+    REQUIRE( std::vector<std::int64_t>(result.values, result.values + result.count) == std::vector<std::int64_t>{ 100, 200, 300 } );
+    REQUIRE( result.strings == nullptr );
+    tsm_result_free(&result);
+
+    REQUIRE( tsm_variables(db, &result) == TSM_OK );
+    REQUIRE( strings(result) == std::vector<std::string>{ "vosaline", "votemper" } );
+    tsm_result_free(&result);
+
+    tsm_coverage coverage{};
+    REQUIRE( tsm_time_coverage(db, "votemper", &coverage) == TSM_OK );
+    REQUIRE( coverage.min == 100 );
+    REQUIRE( coverage.max == 300 );
+    REQUIRE( coverage.count == 3 );
+    REQUIRE( coverage.step == 100 );
+    REQUIRE( tsm_time_coverage(db, "unknown", &coverage) == TSM_ERROR_QUERY );
+
+    REQUIRE( tsm_find_files(db, "unknown", 200, &result) == TSM_OK );
+    REQUIRE( result.count == 0 );
+    tsm_result_free(&result);
+
+    tsm_close(db);
+    fs::remove("./test_libtsm.sqlite3");
+}
+
+/***********************************************************************************/
+TEST_CASE("2: C API reports bad arguments and missing databases.") {
+    tsm_db* db{ nullptr };
+    REQUIRE( tsm_open("./", "no_such_dataset", &db) == TSM_ERROR_OPEN );
+    REQUIRE( db == nullptr );
+    REQUIRE( std::string(tsm_last_error()).find("no_such_dataset") != std::string::npos );
+
+    REQUIRE( tsm_open(nullptr, "x", &db) == TSM_ERROR_INVALID_ARGUMENT );
+
+    tsm_index_options options{};
+    REQUIRE( tsm_index_files(&options, nullptr, 0) == TSM_ERROR_INVALID_ARGUMENT );
+
+    // A caller built against version 2, without spatial_extent, is still accepted.
+    tsm_index_options_init(&options);
+    options.size = offsetof(tsm_index_options, spatial_extent);
+    options.output_dir = "./";
+    options.dataset_name = "test_libtsm_v2_options";
+    options.spatial_extent = 1;
+    REQUIRE( tsm_index_files(&options, nullptr, 0) != TSM_ERROR_INVALID_ARGUMENT );
+    options.size = offsetof(tsm_index_options, progress_user_data);
+    REQUIRE( tsm_index_files(&options, nullptr, 0) == TSM_ERROR_INVALID_ARGUMENT );
+    fs::remove("./test_libtsm_v2_options.sqlite3");
+
+    // Freeing a zeroed result is fine.
+    tsm_result result{};
+    tsm_result_free(&result);
+}
+
+/***********************************************************************************/
+TEST_CASE("3: C API indexing reports progress for every file.") {
+    const fs::path outputDir{ "./test_libtsm_index" };
+    fs::remove_all(outputDir);
+    fs::create_directory(outputDir);
+
+    // Not netCDF, so nothing gets indexed, but every file is still reported.
+    const std::vector<std::string> files{ (outputDir / "a.nc").string(), (outputDir / "b.nc").string() };
+    for (const auto& file : files) {
+        std::ofstream(file) << "not a netcdf file";
+    }
+    const std::vector<const char*> paths{ files[0].c_str(), files[1].c_str() };
+
+    std::vector<std::size_t> progress;
+    tsm_index_options options;
+    tsm_index_options_init(&options);
+    options.output_dir = "./test_libtsm_index";
+    options.dataset_name = "broken";
+    options.progress = [](size_t filesDone, size_t filesTotal, void* userData) {
+        REQUIRE( filesTotal == 2 );
+        static_cast<std::vector<std::size_t>*>(userData)->push_back(filesDone);
+    };
+    options.progress_user_data = &progress;
+
+    REQUIRE( tsm_index_files(&options, paths.data(), paths.size()) == TSM_ERROR_INDEX );
+    REQUIRE( progress == std::vector<std::size_t>{ 1, 2 } );
+    REQUIRE( fs::exists(outputDir / "broken_failed_files.lst") );
+
+    fs::remove_all(outputDir);
+}
@@ -0,0 +1,89 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Utils/Logger.hpp"
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace tsm::utils;
+
+namespace {
+    std::vector<std::string> lines(const std::string& text) {
+        std::vector<std::string> result;
+        std::istringstream ss(text);
+        for (std::string line; std::getline(ss, line);) {
+            result.emplace_back(line);
+        }
+
+        return result;
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("1: parseLogLevel accepts the four level names.") {
+    REQUIRE( parseLogLevel("debug") == LOG_LEVEL::DEBUG );
+    REQUIRE( parseLogLevel("info") == LOG_LEVEL::INFO );
+    REQUIRE( parseLogLevel("warning") == LOG_LEVEL::WARNING );
+    REQUIRE( parseLogLevel("error") == LOG_LEVEL::ERROR );
+    REQUIRE_FALSE( parseLogLevel("ERROR") );
+    REQUIRE_FALSE( parseLogLevel("") );
+}
+
+/***********************************************************************************/
+TEST_CASE("2: Logger writes every message from concurrent threads once stopped.") {
+    auto& logger{ Logger::instance() };
+    std::ostringstream sink;
+
+    logger.resetCounts();
+    logger.start(LOG_LEVEL::WARNING, &sink);
+
+    std::vector<std::thread> threads;
+    for (auto i = 0; i < 4; ++i) {
+        threads.emplace_back([] {
+            for (auto j = 0; j < 250; ++j) {
+                logError("bad file " + std::to_string(j));
+                logInfo("filtered out");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    logWarning("last");
+
+    logger.stop();
+
+    const auto& written{ lines(sink.str()) };
+    REQUIRE( written.size() == 1001 );
+    REQUIRE( written.back().find("WARNING") != std::string::npos );
+    REQUIRE( written.back().find(" last") != std::string::npos );
+
+    // Filtered messages still show up in the counts.
+    REQUIRE( logger.count(LOG_LEVEL::ERROR) == 1000 );
+    REQUIRE( logger.count(LOG_LEVEL::INFO) == 1000 );
+    REQUIRE( logger.summary() == "Log summary: 1000 error(s), 1 warning(s)." );
+
+    logger.resetCounts();
+    REQUIRE( logger.count(LOG_LEVEL::ERROR) == 0 );
+}
+
+/***********************************************************************************/
+TEST_CASE("3: Logger can be restarted with a different sink.") {
+    auto& logger{ Logger::instance() };
+
+    std::ostringstream first;
+    logger.start(LOG_LEVEL::DEBUG, &first);
+    logDebug("one");
+    logger.stop();
+
+    std::ostringstream second;
+    logger.start(LOG_LEVEL::DEBUG, &second);
+    logDebug("two");
+    logger.stop();
+
+    REQUIRE( lines(first.str()).size() == 1 );
+    REQUIRE( second.str().find("two") != std::string::npos );
+    REQUIRE( second.str().find("one") == std::string::npos );
+
+    logger.resetCounts();
+}
@@ -0,0 +1,163 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Database.hpp"
+#include "../src/DatasetDesc.hpp"
+#include "../src/LookupClient.hpp"
+#include "../src/LookupIndex.hpp"
+#include "../src/LookupServer.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+using namespace tsm;
+
+namespace {
+    /// Indexes files_0.nc ... files_<count - 1>.nc, each holding votemper at 3600 and 7200.
+    void createDatabase(const std::string& datasetName, const int count) {
+        const std::vector<ds::VariableDesc> variables{ { "votemper", "K", "Temperature", 0.0f, 0.0f, { "time" } } };
+
+        std::vector<ds::DataFileDesc> files;
+        for (auto i = count - 1; i >= 0; --i) {
+            files.emplace_back(std::vector<ds::timestamp_t>{ 3600, 7200 }, variables, "/data/file_" + std::to_string(i) + ".nc");
+        }
+
+        Database db{ "./", datasetName };
+        REQUIRE( db.open() );
+        REQUIRE( db.insertData(ds::DatasetDesc{ std::move(files), ds::DATASET_TYPE::HISTORICAL }) );
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("1: LookupIndex answers the same as the database.") {
+    fs::remove("./test_lookup_index.sqlite3");
+    createDatabase("test_lookup_index", 3);
+
+    const auto index{ LookupIndex::load("./", "test_lookup_index") };
+    REQUIRE( index );
+    REQUIRE( index->size() == 6 );
+    REQUIRE( index->variables() == std::vector<std::string>{ "votemper" } );
+    REQUIRE( index->timestamps("votemper") == std::vector<std::int64_t>{ 3600, 7200 } );
+    REQUIRE( index->timestamps("vosaline").empty() );
+
+    const auto& files{ index->findFiles("votemper", 7200) };
+    REQUIRE( std::vector<std::string>(files.cbegin(), files.cend()) ==
+             std::vector<std::string>{ "/data/file_0.nc", "/data/file_1.nc", "/data/file_2.nc" } );
+    REQUIRE( index->findFiles("votemper", 10800).empty() );
+
+    REQUIRE_FALSE( LookupIndex::load("./", "test_lookup_missing") );
+
+    fs::remove("./test_lookup_index.sqlite3");
+}
+
+/***********************************************************************************/
+TEST_CASE("2: LookupServer answers over its socket and reloads a replaced database.") {
+    fs::remove("./test_serve.sqlite3");
+    fs::remove("./test_serve_next.sqlite3");
+    createDatabase("test_serve", 2);
+
+    ServeOptions options;
+    options.SocketPath = "./test_serve.sock";
+    options.OutputDir = "./";
+    options.DatasetNames = { "test_serve" };
+    options.ReloadInterval = std::chrono::milliseconds(50);
+
+    LookupServer server{ options };
+    auto served{ false };
+    std::thread thread{ [&] { served = server.run(); } };
+
+    LookupClient client;
+    for (auto attempt = 0; attempt < 100 && !client.connect(options.SocketPath); ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    REQUIRE( client.request("DATASETS") == std::vector<std::string>{ "test_serve" } );
+    REQUIRE( client.request("VARIABLES test_serve") == std::vector<std::string>{ "votemper" } );
+    REQUIRE( client.request("TIMESTAMPS test_serve votemper") == std::vector<std::string>{ "3600", "7200" } );
+    REQUIRE( client.request("FILES test_serve votemper 3600") == std::vector<std::string>{ "/data/file_0.nc", "/data/file_1.nc" } );
+    REQUIRE_FALSE( client.request("FILES test_serve votemper") );
+    REQUIRE_FALSE( client.request("FILES other votemper 3600") );
+    REQUIRE( client.lastError() == "Unknown dataset other." );
+
+    // Replaced the way --in-memory publishes a database.
+    createDatabase("test_serve_next", 3);
+    fs::rename("./test_serve_next.sqlite3", "./test_serve.sqlite3");
+
+    std::optional<std::vector<std::string>> files;
+    for (auto attempt = 0; attempt < 100; ++attempt) {
+        files = client.request("FILES test_serve votemper 3600");
+        if (!files || files->size() == 3) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    REQUIRE( files );
+    REQUIRE( files->size() == 3 );
+
+    server.stop();
+    thread.join();
+
+    REQUIRE( served );
+    REQUIRE_FALSE( fs::exists(options.SocketPath) );
+
+    fs::remove("./test_serve.sqlite3");
+}
+
+/***********************************************************************************/
+TEST_CASE("3: LookupServer only replaces a socket nothing listens on.") {
+    fs::remove("./test_serve_stale.sqlite3");
+    createDatabase("test_serve_stale", 1);
+
+    ServeOptions options;
+    options.SocketPath = "./test_serve_stale.sock";
+    options.OutputDir = "./";
+    options.DatasetNames = { "test_serve_stale" };
+    fs::remove(options.SocketPath);
+
+    // Not a socket: left alone.
+    std::ofstream{ options.SocketPath } << "keep me";
+    {
+        LookupServer server{ options };
+        REQUIRE_FALSE( server.run() );
+    }
+    REQUIRE( fs::is_regular_file(options.SocketPath) );
+    REQUIRE( fs::file_size(options.SocketPath) == 7 );
+    fs::remove(options.SocketPath);
+
+    // Left behind by a server that's gone: replaced.
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, options.SocketPath.c_str(), sizeof(address.sun_path) - 1);
+    const auto stale{ socket(AF_UNIX, SOCK_STREAM, 0) };
+    REQUIRE( bind(stale, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0 );
+    close(stale);
+
+    LookupServer server{ options };
+    auto served{ false };
+    std::thread thread{ [&] { served = server.run(); } };
+
+    LookupClient client;
+    for (auto attempt = 0; attempt < 100 && !client.connect(options.SocketPath); ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    REQUIRE( client.request("DATASETS") == std::vector<std::string>{ "test_serve_stale" } );
+
+    // In use: a second server leaves it to the first.
+    {
+        LookupServer second{ options };
+        REQUIRE_FALSE( second.run() );
+    }
+    REQUIRE( client.request("DATASETS") );
+
+    server.stop();
+    thread.join();
+
+    REQUIRE( served );
+    REQUIRE_FALSE( fs::exists(options.SocketPath) );
+
+    fs::remove("./test_serve_stale.sqlite3");
+}
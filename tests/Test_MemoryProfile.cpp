@@ -0,0 +1,58 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Utils/MemoryProfile.hpp"
+
+#include <cstring>
+#include <memory>
+
+using namespace tsm::utils;
+
+/***********************************************************************************/
+TEST_CASE("1: MemoryProfiler attributes memory to nested phases.") {
+    auto& profiler{ MemoryProfiler::instance() };
+    REQUIRE( MemoryProfiler::residentBytes() > 0 );
+
+    // Nothing is recorded while stopped.
+    {
+        const MemoryPhase phase{ "ignored" };
+    }
+
+    constexpr std::size_t SIZE{ 64 * 1024 * 1024 };
+    profiler.start();
+    for (auto i = 0; i < 2; ++i) {
+        const MemoryPhase outer{ "outer" };
+        {
+            const MemoryPhase inner{ "inner" };
+            const auto block{ std::make_unique<char[]>(SIZE) };
+            // Touched, so it's resident.
+            std::memset(block.get(), 1, SIZE);
+        }
+    }
+    profiler.stop();
+
+    const auto& phases{ profiler.phases() };
+    REQUIRE( phases.size() == 2 );
+    REQUIRE( phases[0].Name == "outer" );
+    REQUIRE( phases[0].Depth == 0 );
+    REQUIRE( phases[0].Runs == 2 );
+    REQUIRE( phases[1].Name == "inner" );
+    REQUIRE( phases[1].Depth == 1 );
+    REQUIRE( phases[1].Runs == 2 );
+
+    // The outer phase includes what the inner one held.
+    REQUIRE( phases[1].PeakRSS >= static_cast<std::int64_t>(SIZE) );
+    REQUIRE( phases[0].PeakRSS >= phases[1].PeakRSS );
+
+    if (MemoryProfiler::countsAllocations()) {
+        REQUIRE( phases[1].Allocations >= 2 );
+        REQUIRE( phases[1].AllocatedBytes >= 2 * SIZE );
+        REQUIRE( phases[1].PeakHeapGrowth >= static_cast<std::int64_t>(SIZE) );
+        REQUIRE( phases[0].PeakHeapGrowth >= phases[1].PeakHeapGrowth );
+    }
+
+    const auto& table{ profiler.table() };
+    REQUIRE( table.find("Phase") == 0 );
+    REQUIRE( table.find("\nouter ") != std::string::npos );
+    REQUIRE( table.find("\n  inner ") != std::string::npos );
+    REQUIRE( table.find("ignored") == std::string::npos );
+    REQUIRE( (table.find("Allocations") != std::string::npos) == MemoryProfiler::countsAllocations() );
+}
@@ -0,0 +1,112 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Utils/FileList.hpp"
+#include "../src/Utils/PathStore.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace tsm::utils;
+
+namespace {
+    std::vector<std::string> contents(const PathStore& store) {
+        std::vector<std::string> paths;
+        store.forEach([&paths](const std::string_view path) {
+            paths.emplace_back(path);
+        });
+        return paths;
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("1: PathStore keeps paths in order, drops duplicates and spills past its budget.") {
+    std::vector<std::string> expected;
+    for (int i = 0; i < 1000; ++i) {
+        expected.push_back("/data/hpc/ocean/riops/2019/" + std::to_string(i % 12) + "/riops_" + std::to_string(i) + ".nc");
+    }
+
+    // A small budget, so most blocks go to disk.
+    PathStore store{ 1024 };
+    for (const auto& path : expected) {
+        REQUIRE( store.add(path) );
+    }
+    REQUIRE_FALSE( store.add(expected[3]) );
+    REQUIRE_FALSE( store.add(expected[998]) );
+    REQUIRE( store.add("") );
+    REQUIRE_FALSE( store.add("") );
+    expected.emplace_back();
+
+    REQUIRE( store.size() == expected.size() );
+    REQUIRE( store.duplicates() == 3 );
+    REQUIRE( store.spilledBytes() > 0 );
+    // Front coding: well under the characters of the paths themselves.
+    REQUIRE( store.encodedBytes() < 1000 * 20 );
+
+    REQUIRE( contents(store) == expected );
+    REQUIRE( store.at(0) == expected[0] );
+    REQUIRE( store.at(17) == expected[17] );
+    REQUIRE( store.at(999) == expected[999] );
+    REQUIRE( store.at(expected.size()).empty() );
+
+    const auto& paths{ store.toPaths() };
+    REQUIRE( paths.size() == expected.size() );
+    REQUIRE( paths[500] == fs::path{ expected[500] } );
+
+    // Batches across block boundaries and past the end.
+    REQUIRE( store.toPaths(15, 3) == std::vector<fs::path>{ expected[15], expected[16], expected[17] } );
+    REQUIRE( store.toPaths(999, 10) == std::vector<fs::path>{ expected[999], expected[1000] } );
+    REQUIRE( store.toPaths(2000, 10).empty() );
+
+    // The spill file goes along.
+    PathStore moved{ std::move(store) };
+    REQUIRE( store.size() == 0 );
+    REQUIRE( contents(moved) == expected );
+    store = std::move(moved);
+    REQUIRE( store.add("/data/new.nc") );
+    REQUIRE( store.at(expected.size()) == "/data/new.nc" );
+}
+
+/***********************************************************************************/
+TEST_CASE("2: readFileList parses a list in parallel chunks, in order.") {
+    REQUIRE( pathExtension("/a/b/file.nc") == ".nc" );
+    REQUIRE( pathExtension("file.tar.nc") == ".nc" );
+    REQUIRE( pathExtension("/a.nc/file") == "" );
+    REQUIRE( pathExtension("/a/.nc") == "" );
+    REQUIRE( pathExtension("/a/..") == "" );
+    REQUIRE( pathExtension("/a/b.nc/") == "" );
+
+    const auto directory{ fs::temp_directory_path() / "tsm_test_file_list" };
+    fs::create_directories(directory);
+    const auto listPath{ directory / "files.txt" };
+
+    std::vector<std::string> expected;
+    {
+        std::ofstream list{ listPath };
+        // Big enough for chunks of their own thread at 3 threads.
+        for (int i = 0; i < 200000; ++i) {
+            list << "model/run_" << i << ".nc\n";
+            expected.push_back((directory / ("model/run_" + std::to_string(i) + ".nc")).string());
+            if (i % 1000 == 0) {
+                list << "/absolute/run_" << i << ".nc\r\n"
+                     << "model/run_" << i << ".nc\n"
+                     << "model/run_" << i << ".txt\n\n";
+                expected.push_back("/absolute/run_" + std::to_string(i) + ".nc");
+            }
+        }
+        // No newline at the end.
+        list << "last.nc";
+        expected.push_back((directory / "last.nc").string());
+    }
+
+    for (const std::size_t threads : { 1, 3, 64 }) {
+        PathStore store;
+        REQUIRE( readFileList(listPath, store, threads) );
+        REQUIRE( store.duplicates() == 200 );
+        REQUIRE( contents(store) == expected );
+    }
+
+    PathStore missing;
+    REQUIRE_FALSE( readFileList(directory / "missing.txt", missing) );
+
+    fs::remove_all(directory);
+}
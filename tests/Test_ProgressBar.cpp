@@ -0,0 +1,38 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Utils/ProgressBar.hpp"
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace tsm::utils;
+
+/***********************************************************************************/
+TEST_CASE("1: ProgressBar counts every tick from concurrent workers.") {
+    ProgressBar pb{ 40000 };
+
+    std::vector<std::thread> workers;
+    for (auto i = 0; i < 4; ++i) {
+        workers.emplace_back([&pb] {
+            for (auto j = 0; j < 10000; ++j) {
+                ++pb;
+                pb.addBytes(1024);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    REQUIRE( pb.ticks() == 40000 );
+}
+
+/***********************************************************************************/
+TEST_CASE("2: ProgressBar can't be ticked after it has ended.") {
+    ProgressBar pb{ 10 };
+    ++pb;
+    pb.endProgressBar();
+
+    REQUIRE_THROWS_AS( ++pb, std::runtime_error );
+    REQUIRE_NOTHROW( pb.endProgressBar() );
+}
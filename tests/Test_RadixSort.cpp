@@ -0,0 +1,48 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Utils/RadixSort.hpp"
+
+#include <algorithm>
+#include <random>
+
+using namespace tsm::utils;
+
+/***********************************************************************************/
+TEST_CASE("1: bitWidth returns the number of significant bits.") {
+    REQUIRE( bitWidth(0) == 0 );
+    REQUIRE( bitWidth(1) == 1 );
+    REQUIRE( bitWidth(255) == 8 );
+    REQUIRE( bitWidth(256) == 9 );
+    REQUIRE( bitWidth(~std::uint64_t{ 0 }) == 64 );
+}
+
+/***********************************************************************************/
+TEST_CASE("2: radixSort matches std::sort for full-width and narrow keys.") {
+    std::mt19937_64 rng{ 42 };
+
+    for (const auto keyBits : { 64u, 37u, 12u }) {
+        std::vector<std::uint64_t> keys(10000);
+        const auto mask{ keyBits == 64 ? ~std::uint64_t{ 0 } : (std::uint64_t{ 1 } << keyBits) - 1 };
+        std::generate(keys.begin(), keys.end(), [&] { return rng() & mask; });
+
+        auto expected{ keys };
+        std::sort(expected.begin(), expected.end());
+
+        radixSort(keys, keyBits);
+        REQUIRE( keys == expected );
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("3: radixSort handles empty, single and already sorted input.") {
+    std::vector<std::uint64_t> empty;
+    radixSort(empty);
+    REQUIRE( empty.empty() );
+
+    std::vector<std::uint64_t> single{ 7 };
+    radixSort(single);
+    REQUIRE( single == std::vector<std::uint64_t>{ 7 } );
+
+    std::vector<std::uint64_t> sorted{ 1, 2, 3, 300, 70000 };
+    radixSort(sorted, 17);
+    REQUIRE( sorted == std::vector<std::uint64_t>{ 1, 2, 3, 300, 70000 } );
+}
@@ -0,0 +1,169 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/FileReaders/ReaderPool.hpp"
+#include "../src/Utils/ConcurrencyController.hpp"
+#include "../src/Utils/Logger.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <thread>
+
+using namespace tsm;
+
+namespace {
+    /// Stands in for NCFileReader: the file name says how the read goes.
+    ds::DataFileDesc fakeRead(const fs::path& path) {
+        const auto& name{ path.stem().string() };
+
+        if (name == "hang") {
+            std::this_thread::sleep_for(std::chrono::minutes(1));
+        }
+        if (name == "crash") {
+            // SIGKILL rather than abort(), which Catch's handler would report from the child.
+            std::raise(SIGKILL);
+        }
+        if (name == "bad") {
+            utils::logError("No time dimension in " + path.string());
+            return ds::DataFileDesc();
+        }
+
+        const auto n{ std::stoull(name) };
+        // Odd files have no extent.
+        const auto extent{ n % 2 == 0 ? std::optional<ds::BoundingBox>{ { -1.0 * n, 1.0 * n, -2.0 * n, 2.0 * n } } : std::nullopt };
+        const auto depths{ std::make_shared<const std::vector<double>>(std::vector<double>{ 0.5, 1.5, 1.0 * n }) };
+        const ds::StorageLayout layout{ "chunked", { 1, n }, 4, true, 1e20 };
+        return { { n, n + 1 }, { { "votemper", "K", "Temperature", -2.0f, 40.0f, { "time", "depth" }, layout } }, path, extent,
+                 { { "depth", 3 }, { "time", 2 } }, { { "depth", { "depth" }, n, depths } }, "netCDF-4" };
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("1: ReaderPool reports every file and isn't held up by a hung one.") {
+    const std::vector<fs::path> files{ "/data/1.nc", "/data/hang.nc", "/data/2.nc", "/data/bad.nc",
+                                       "/data/crash.nc", "/data/3.nc", "/data/4.nc" };
+
+    auto& logger{ utils::Logger::instance() };
+    logger.resetCounts();
+
+    std::map<std::size_t, READ_STATUS> statuses;
+    std::map<std::size_t, ds::timestamp_t> firstTimestamps;
+
+    const auto start{ std::chrono::steady_clock::now() };
+    {
+        ReaderPool pool{ 2, std::chrono::milliseconds(300), fakeRead };
+        pool.readAll(files, [&](const std::size_t index, const READ_STATUS status, ds::DataFileDesc&& desc, const std::uint64_t) {
+            REQUIRE( statuses.count(index) == 0 );
+            statuses[index] = status;
+            if (status == READ_STATUS::OK) {
+                REQUIRE( desc.NCFilePath == files[index] );
+                REQUIRE( desc.Variables.size() == 1 );
+                REQUIRE( desc.Variables.front().Dimensions.size() == 2 );
+                REQUIRE( desc.Variables.front().ValidMax == 40.0f );
+                firstTimestamps[index] = desc.Timestamps.front();
+                REQUIRE( desc.Extent.has_value() == (desc.Timestamps.front() % 2 == 0) );
+                REQUIRE( desc.Dimensions.size() == 2 );
+                REQUIRE( desc.Dimensions.front().Size == 3 );
+                REQUIRE( desc.Coordinates.size() == 1 );
+                REQUIRE( desc.Coordinates.front().Hash == desc.Timestamps.front() );
+                REQUIRE( *desc.Coordinates.front().Values == std::vector<double>{ 0.5, 1.5, 1.0 * desc.Timestamps.front() } );
+                REQUIRE( desc.Format == "netCDF-4" );
+                const auto& layout{ desc.Variables.front().Layout };
+                REQUIRE( layout );
+                REQUIRE( layout->Storage == "chunked" );
+                REQUIRE( layout->ChunkSizes == std::vector<std::size_t>{ 1, desc.Timestamps.front() } );
+                REQUIRE( layout->DeflateLevel == 4 );
+                REQUIRE( layout->Shuffle );
+                REQUIRE( layout->FillValue == 1e20 );
+                if (desc.Extent) {
+                    REQUIRE( desc.Extent->MaxLon == 2.0 * desc.Timestamps.front() );
+                }
+            }
+        });
+    }
+    const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start };
+
+    REQUIRE( elapsed.count() < 5.0 );
+    REQUIRE( statuses.size() == files.size() );
+    REQUIRE( statuses[1] == READ_STATUS::TIMED_OUT );
+    REQUIRE( statuses[3] == READ_STATUS::FAILED );
+    REQUIRE( statuses[4] == READ_STATUS::FAILED );
+    for (const auto i : { 0, 2, 5, 6 }) {
+        REQUIRE( statuses[i] == READ_STATUS::OK );
+    }
+    REQUIRE( firstTimestamps[6] == 4 );
+
+    // The worker's own message, plus one each for the timeout and the crash.
+    REQUIRE( logger.count(utils::LOG_LEVEL::ERROR) == 3 );
+    logger.resetCounts();
+}
+
+/***********************************************************************************/
+TEST_CASE("2: ReaderPool reads no more files at once than its controller allows.") {
+    std::vector<fs::path> files;
+    for (auto i = 0; i < 12; ++i) {
+        files.emplace_back("/data/" + std::to_string(i) + ".nc");
+    }
+
+    // Each read marks a file in a shared directory while it's going on.
+    const auto dir{ fs::temp_directory_path() / "tsm_reader_pool_limit" };
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::atomic<std::size_t> maxSeen{ 0 };
+
+    // Fewer than the pool's workers.
+    utils::ConcurrencyController controller{ 1, 3, 2 };
+    ReaderPool pool{ 4, std::chrono::milliseconds(5000), [&dir](const fs::path& path) {
+        const auto marker{ dir / path.filename() };
+        std::ofstream{ marker };
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        const auto inFlight{ static_cast<std::size_t>(std::distance(fs::directory_iterator(dir), fs::directory_iterator{})) };
+        fs::remove(marker);
+        return fakeRead(path.parent_path() / (std::to_string(inFlight) + ".nc"));
+    }, &controller };
+
+    std::size_t ok{ 0 };
+    pool.readAll(files, [&](const std::size_t, const READ_STATUS status, ds::DataFileDesc&& desc, const std::uint64_t) {
+        if (status == READ_STATUS::OK) {
+            ++ok;
+            maxSeen = std::max<std::size_t>(maxSeen, desc.Timestamps.front());
+        }
+    });
+
+    REQUIRE( ok == files.size() );
+    REQUIRE( maxSeen >= 2 );
+    REQUIRE( maxSeen <= 3 );
+    REQUIRE( controller.peak() == 3 );
+
+    fs::remove_all(dir);
+}
+
+/***********************************************************************************/
+TEST_CASE("3: ReaderPool reports how much each worker read.") {
+    const auto path{ fs::temp_directory_path() / "tsm_reader_pool_bytes.nc" };
+    {
+        std::ofstream f{ path, std::ios::binary };
+        f << std::string(64 * 1024, 'x');
+    }
+
+    ReaderPool pool{ 1, std::chrono::milliseconds(5000), [](const fs::path& p) {
+        std::ifstream f{ p, std::ios::binary };
+        const std::string contents{ std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>() };
+        return fakeRead(p.parent_path() / (std::to_string(contents.size()) + ".nc"));
+    } };
+
+    std::uint64_t reported{ 0 };
+    pool.readAll({ path }, [&](const std::size_t, const READ_STATUS status, ds::DataFileDesc&&, const std::uint64_t bytesRead) {
+        REQUIRE( status == READ_STATUS::OK );
+        reported = bytesRead;
+    });
+
+    REQUIRE( reported >= 64 * 1024 );
+    REQUIRE( reported < 128 * 1024 );
+
+    fs::remove(path);
+}
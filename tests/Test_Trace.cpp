@@ -0,0 +1,89 @@
+#include <catch2/single_include/catch2/catch.hpp>
+#include "../src/Utils/Trace.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace tsm::utils;
+
+namespace {
+    std::string readTrace(const fs::path& path) {
+        std::ifstream f(path);
+        std::stringstream ss;
+        ss << f.rdbuf();
+
+        return ss.str();
+    }
+
+    std::size_t count(const std::string& text, const std::string& what) {
+        std::size_t n{ 0 };
+        for (auto pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + what.size())) {
+            ++n;
+        }
+
+        return n;
+    }
+}
+
+/***********************************************************************************/
+TEST_CASE("1: Tracer writes the spans of every thread and lane.") {
+    const auto path{ fs::temp_directory_path() / "tsm_test_trace_1.json" };
+    auto& tracer{ Tracer::instance() };
+
+    tracer.start(path);
+    tracer.setThreadName("main");
+    {
+        const TraceSpan span{ "phase", "outer", std::string{ "a \"quoted\" detail" } };
+
+        std::thread worker([&tracer]() {
+            tracer.setThreadName("worker");
+            const TraceSpan inner{ "phase", "inner" };
+        });
+        worker.join();
+
+        const auto now{ Tracer::Clock::now() };
+        tracer.setLaneName(4242, "reader 4242");
+        tracer.complete("read", "read file", now, now, "file.nc", 4242);
+    }
+    REQUIRE( tracer.stop() );
+    REQUIRE_FALSE( tracer.enabled() );
+
+    const auto trace{ readTrace(path) };
+    REQUIRE( trace.rfind("{\"traceEvents\":[", 0) == 0 );
+    REQUIRE( count(trace, "\"ph\":\"X\"") == 3 );
+    REQUIRE( trace.find("\"name\":\"outer\"") != std::string::npos );
+    REQUIRE( trace.find("a \\\"quoted\\\" detail") != std::string::npos );
+    REQUIRE( trace.find("{\"name\":\"worker\"}") != std::string::npos );
+    REQUIRE( trace.find("\"tid\":4242,\"ts\":") != std::string::npos );
+    REQUIRE( trace.find("{\"name\":\"reader 4242\"}") != std::string::npos );
+    REQUIRE( trace.find("\"droppedEvents\":0") != std::string::npos );
+
+    fs::remove(path);
+}
+
+/***********************************************************************************/
+TEST_CASE("2: Tracer keeps the newest events of a thread once its buffer is full.") {
+    const auto path{ fs::temp_directory_path() / "tsm_test_trace_2.json" };
+    auto& tracer{ Tracer::instance() };
+
+    // Nothing is recorded while stopped.
+    {
+        const TraceSpan span{ "phase", "ignored" };
+    }
+
+    tracer.start(path);
+    const auto now{ Tracer::Clock::now() };
+    for (std::size_t i = 0; i < TRACE_EVENTS_PER_THREAD + 10; ++i) {
+        tracer.complete("test", i < 10 ? "old" : "new", now, now);
+    }
+    REQUIRE( tracer.stop() );
+
+    const auto trace{ readTrace(path) };
+    REQUIRE( trace.find("\"name\":\"ignored\"") == std::string::npos );
+    REQUIRE( trace.find("\"name\":\"old\"") == std::string::npos );
+    REQUIRE( count(trace, "\"name\":\"new\"") == TRACE_EVENTS_PER_THREAD );
+    REQUIRE( trace.find("\"droppedEvents\":10") != std::string::npos );
+
+    fs::remove(path);
+}